@@ -22,6 +22,13 @@ layout(set = 0, binding = 0, std140) uniform GlobalUbo
     int numLights;
 } ubo;
 
+// MaterialParameters in Material.hpp
+layout(set = 1, binding = 0, std140) uniform MaterialUbo
+{
+    vec4 baseColorFactor;
+    vec4 specularFactor; // Highlight color in rgb, Blinn-Phong exponent in w
+} material;
+
 layout(push_constant) uniform Push
 {
     mat4 modelMatrix;
@@ -53,10 +60,13 @@ void main()
         vec3 halfAngle = normalize(directionToLight + viewDirection);
         float blinnTerm = dot(surfaceNormal, halfAngle);
         blinnTerm = clamp(blinnTerm, 0, 1);
-        blinnTerm = pow(blinnTerm, 512.0);
+        blinnTerm = pow(blinnTerm, material.specularFactor.w);
         specularLight += intensity * blinnTerm;
     }
     
-    outColor = vec4(diffuseLight * fragColor + specularLight * fragColor, 1.0);
+    // Highlights keep the vertex color tint, metals get their base color through specularFactor
+    vec3 diffuseColor = fragColor * material.baseColorFactor.rgb;
+    vec3 specularColor = fragColor * material.specularFactor.rgb;
+    outColor = vec4(diffuseLight * diffuseColor + specularLight * specularColor, 1.0);
     //outColor = vec4(1.0, 0.0, 0.0, 1.0);
 }
\ No newline at end of file
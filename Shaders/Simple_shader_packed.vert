@@ -0,0 +1,54 @@
+#version 450
+
+// Simple_shader.vert for Model::VertexFormat::PACKED. Positions arrive as snorm16 relative to the
+// model bounds (the model matrix maps them back), normals are octahedral snorm16.
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec2 octNormal;
+layout(location = 3) in vec2 uv;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+
+struct PointLight
+{
+    vec4 position;
+    vec4 color;
+};
+
+layout(set = 0, binding = 0, std140) uniform GlobalUbo
+{
+    mat4 projection;
+    mat4 view;
+    mat4 invView;
+    vec4 ambientLightColor;
+    PointLight pointLights[10];
+    int numLights;
+} ubo;
+
+layout(push_constant) uniform Push
+{
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+} push;
+
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+void main()
+{
+    vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+    fragNormalWorld = normalize(mat3(push.normalMatrix) * decodeOctahedral(octNormal));
+    fragPosWorld = positionWorld.xyz;
+    fragColor = color;
+
+    gl_Position = ubo.projection * positionWorld;
+}
@@ -0,0 +1,942 @@
+#include "BlockCompressor.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef VOIDENGINE_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace VoidEngine
+{
+    namespace
+    {
+        constexpr int BLOCK_TEXELS = 16;
+
+        // The texels of one block channel by channel, so four texels of a channel fill an SSE register
+        struct alignas(16) Block
+        {
+            float channel[4][BLOCK_TEXELS];
+        };
+
+        // Colors a block can decode to, over the same channels as the texels they are compared with
+        struct Palette
+        {
+            float entry[16][4];
+            int size = 0;
+        };
+
+        struct Settings
+        {
+            int powerIterations;
+            int refinements;
+            bool alternativeModes;
+        };
+
+        Settings settingsFor(CompressionQuality quality)
+        {
+            switch (quality)
+            {
+                case CompressionQuality::FAST: return {1, 0, false};
+                case CompressionQuality::NORMAL: return {4, 2, false};
+                case CompressionQuality::HIGH: return {8, 6, true};
+            }
+            return {4, 2, false};
+        }
+
+        void loadBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY,
+            Block& block)
+        {
+            for (uint32_t y = 0; y < 4; y++)
+            {
+                const uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+                for (uint32_t x = 0; x < 4; x++)
+                {
+                    const uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+                    const uint8_t* texel = pixels + (static_cast<size_t>(sourceY) * width + sourceX) * 4;
+                    for (int c = 0; c < 4; c++) block.channel[c][y * 4 + x] = texel[c];
+                }
+            }
+        }
+
+        // Picks the closest palette entry for every texel over channels [first, first + count) and returns
+        // the summed squared error
+        float fitIndices(const Block& block, int first, int count, const Palette& palette, uint8_t indices[BLOCK_TEXELS])
+        {
+#ifdef VOIDENGINE_SSE2
+            __m128 total = _mm_setzero_ps();
+            for (int group = 0; group < BLOCK_TEXELS; group += 4)
+            {
+                __m128 texels[4];
+                for (int c = 0; c < count; c++) texels[c] = _mm_load_ps(&block.channel[first + c][group]);
+
+                __m128 best = _mm_set1_ps(std::numeric_limits<float>::max());
+                __m128i bestIndex = _mm_setzero_si128();
+                for (int k = 0; k < palette.size; k++)
+                {
+                    __m128 error = _mm_setzero_ps();
+                    for (int c = 0; c < count; c++)
+                    {
+                        const __m128 d = _mm_sub_ps(texels[c], _mm_set1_ps(palette.entry[k][c]));
+                        error = _mm_add_ps(error, _mm_mul_ps(d, d));
+                    }
+
+                    // Strictly closer, so ties keep the lowest index like the scalar path
+                    const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(error, best));
+                    bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)), _mm_andnot_si128(closer, bestIndex));
+                    best = _mm_min_ps(error, best);
+                }
+                total = _mm_add_ps(total, best);
+
+                alignas(16) int32_t lanes[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes), bestIndex);
+                for (int i = 0; i < 4; i++) indices[group + i] = static_cast<uint8_t>(lanes[i]);
+            }
+
+            alignas(16) float sums[4];
+            _mm_store_ps(sums, total);
+            return sums[0] + sums[1] + sums[2] + sums[3];
+#else
+            float total = 0.0f;
+            for (int i = 0; i < BLOCK_TEXELS; i++)
+            {
+                float best = std::numeric_limits<float>::max();
+                for (int k = 0; k < palette.size; k++)
+                {
+                    float error = 0.0f;
+                    for (int c = 0; c < count; c++)
+                    {
+                        const float d = block.channel[first + c][i] - palette.entry[k][c];
+                        error += d * d;
+                    }
+                    if (error < best)
+                    {
+                        best = error;
+                        indices[i] = static_cast<uint8_t>(k);
+                    }
+                }
+                total += best;
+            }
+            return total;
+#endif
+        }
+
+        // Line the endpoints are picked on: through the mean of the texels along their principal axis, found by
+        // power iteration on the covariance. Without iterations it is the bounding box diagonal, which is only
+        // right when every channel grows together.
+        void fitLine(const Block& block, int first, int count, int iterations, float mean[4], float axis[4])
+        {
+            for (int c = 0; c < count; c++)
+            {
+                const float* texels = block.channel[first + c];
+                float sum = 0.0f;
+                float lo = texels[0];
+                float hi = texels[0];
+                for (int i = 0; i < BLOCK_TEXELS; i++)
+                {
+                    sum += texels[i];
+                    lo = std::min(lo, texels[i]);
+                    hi = std::max(hi, texels[i]);
+                }
+                mean[c] = sum / BLOCK_TEXELS;
+                axis[c] = hi - lo;
+            }
+            if (iterations == 0) return;
+
+            float covariance[4][4]{};
+            for (int i = 0; i < BLOCK_TEXELS; i++)
+            {
+                float d[4];
+                for (int c = 0; c < count; c++) d[c] = block.channel[first + c][i] - mean[c];
+                for (int a = 0; a < count; a++)
+                {
+                    for (int b = 0; b < count; b++) covariance[a][b] += d[a] * d[b];
+                }
+            }
+
+            // Start from the row of the widest channel, the diagonal can be orthogonal to the axis when channels
+            // are anti-correlated
+            int widest = 0;
+            for (int c = 1; c < count; c++)
+            {
+                if (covariance[c][c] > covariance[widest][widest]) widest = c;
+            }
+            if (covariance[widest][widest] <= 0.0f) return;
+            for (int c = 0; c < count; c++) axis[c] = covariance[widest][c];
+
+            for (int iteration = 0; iteration < iterations; iteration++)
+            {
+                float next[4]{};
+                float largest = 0.0f;
+                for (int a = 0; a < count; a++)
+                {
+                    for (int b = 0; b < count; b++) next[a] += covariance[a][b] * axis[b];
+                    largest = std::max(largest, std::abs(next[a]));
+                }
+                if (largest <= 0.0f) break;
+                for (int c = 0; c < count; c++) axis[c] = next[c] / largest;
+            }
+        }
+
+        // Extremes of the texels projected onto the line, clamped to the unorm range
+        void lineEndpoints(const Block& block, int first, int count, const float mean[4], const float axis[4],
+            float start[4], float end[4])
+        {
+            float length = 0.0f;
+            for (int c = 0; c < count; c++) length += axis[c] * axis[c];
+
+            float lo = 0.0f;
+            float hi = 0.0f;
+            if (length > 0.0f)
+            {
+                lo = std::numeric_limits<float>::max();
+                hi = -std::numeric_limits<float>::max();
+                for (int i = 0; i < BLOCK_TEXELS; i++)
+                {
+                    float t = 0.0f;
+                    for (int c = 0; c < count; c++) t += (block.channel[first + c][i] - mean[c]) * axis[c];
+                    lo = std::min(lo, t / length);
+                    hi = std::max(hi, t / length);
+                }
+            }
+
+            for (int c = 0; c < count; c++)
+            {
+                start[c] = std::clamp(mean[c] + lo * axis[c], 0.0f, 255.0f);
+                end[c] = std::clamp(mean[c] + hi * axis[c], 0.0f, 255.0f);
+            }
+        }
+
+        // Least squares endpoints for texels reconstructed as start + weight * (end - start). Texels with a
+        // negative weight don't lie on the line and are left out. False if the weights don't pin the endpoints.
+        bool solveEndpoints(const Block& block, int first, int count, const float weights[BLOCK_TEXELS],
+            float start[4], float end[4])
+        {
+            float aa = 0.0f;
+            float ab = 0.0f;
+            float bb = 0.0f;
+            float xa[4]{};
+            float xb[4]{};
+            for (int i = 0; i < BLOCK_TEXELS; i++)
+            {
+                const float b = weights[i];
+                if (b < 0.0f) continue;
+
+                const float a = 1.0f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for (int c = 0; c < count; c++)
+                {
+                    xa[c] += a * block.channel[first + c][i];
+                    xb[c] += b * block.channel[first + c][i];
+                }
+            }
+
+            const float determinant = aa * bb - ab * ab;
+            if (determinant <= 1e-4f) return false;
+
+            for (int c = 0; c < count; c++)
+            {
+                start[c] = std::clamp((bb * xa[c] - ab * xb[c]) / determinant, 0.0f, 255.0f);
+                end[c] = std::clamp((aa * xb[c] - ab * xa[c]) / determinant, 0.0f, 255.0f);
+            }
+            return true;
+        }
+
+        void storeLittleEndian(uint8_t* out, uint64_t value, int bytes)
+        {
+            for (int i = 0; i < bytes; i++) out[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+
+        uint64_t loadLittleEndian(const uint8_t* in, int bytes)
+        {
+            uint64_t value = 0;
+            for (int i = 0; i < bytes; i++) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+            return value;
+        }
+
+        // BC1
+
+        uint16_t packRgb565(const float color[3])
+        {
+            const auto r = static_cast<uint16_t>(std::lround(color[0] * (31.0f / 255.0f)));
+            const auto g = static_cast<uint16_t>(std::lround(color[1] * (63.0f / 255.0f)));
+            const auto b = static_cast<uint16_t>(std::lround(color[2] * (31.0f / 255.0f)));
+            return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        void unpackRgb565(uint16_t value, int color[3])
+        {
+            const int r = value >> 11;
+            const int g = (value >> 5) & 63;
+            const int b = value & 31;
+            color[0] = (r << 3) | (r >> 2);
+            color[1] = (g << 2) | (g >> 4);
+            color[2] = (b << 3) | (b >> 2);
+        }
+
+        // 4 color mode, color0 > color1. Otherwise the block decodes in 3 color mode, see decodeBc1().
+        void bc1Palette(uint16_t color0, uint16_t color1, Palette& palette)
+        {
+            int c0[3];
+            int c1[3];
+            unpackRgb565(color0, c0);
+            unpackRgb565(color1, c1);
+            for (int c = 0; c < 3; c++)
+            {
+                palette.entry[0][c] = static_cast<float>(c0[c]);
+                palette.entry[1][c] = static_cast<float>(c1[c]);
+                palette.entry[2][c] = static_cast<float>((2 * c0[c] + c1[c]) / 3);
+                palette.entry[3][c] = static_cast<float>((c0[c] + 2 * c1[c]) / 3);
+            }
+            palette.size = 4;
+        }
+
+        struct Bc1Block
+        {
+            uint16_t color0;
+            uint16_t color1;
+            uint8_t indices[BLOCK_TEXELS];
+            float error;
+        };
+
+        // Orders the endpoints for 4 color mode and fits indices to them
+        Bc1Block evaluateBc1(const Block& block, uint16_t a, uint16_t b)
+        {
+            Bc1Block result{std::max(a, b), std::min(a, b), {}, 0.0f};
+
+            Palette palette;
+            bc1Palette(result.color0, result.color1, palette);
+            // Equal endpoints decode in 3 color mode where index 3 is black, index 0 is the only safe one
+            if (result.color0 == result.color1) palette.size = 1;
+
+            result.error = fitIndices(block, 0, 3, palette, result.indices);
+            return result;
+        }
+
+        void encodeBc1(const Block& block, const Settings& settings, uint8_t* out)
+        {
+            // Weight of color1 for each index
+            static constexpr float WEIGHTS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+
+            float mean[4];
+            float axis[4];
+            float start[4];
+            float end[4];
+            fitLine(block, 0, 3, settings.powerIterations, mean, axis);
+            lineEndpoints(block, 0, 3, mean, axis, start, end);
+            Bc1Block best = evaluateBc1(block, packRgb565(end), packRgb565(start));
+
+            // The bounding box diagonal sometimes refines to a better pair than the principal axis
+            if (settings.alternativeModes && best.error > 0.0f)
+            {
+                fitLine(block, 0, 3, 0, mean, axis);
+                lineEndpoints(block, 0, 3, mean, axis, start, end);
+                const Bc1Block candidate = evaluateBc1(block, packRgb565(end), packRgb565(start));
+                if (candidate.error < best.error) best = candidate;
+            }
+
+            for (int pass = 0; pass < settings.refinements && best.error > 0.0f; pass++)
+            {
+                float weights[BLOCK_TEXELS];
+                for (int i = 0; i < BLOCK_TEXELS; i++) weights[i] = WEIGHTS[best.indices[i]];
+                if (!solveEndpoints(block, 0, 3, weights, start, end)) break;
+
+                const Bc1Block candidate = evaluateBc1(block, packRgb565(start), packRgb565(end));
+                if (candidate.error >= best.error) break;
+                best = candidate;
+            }
+
+            uint64_t bits = 0;
+            for (int i = 0; i < BLOCK_TEXELS; i++) bits |= static_cast<uint64_t>(best.indices[i]) << (2 * i);
+            storeLittleEndian(out, best.color0, 2);
+            storeLittleEndian(out + 2, best.color1, 2);
+            storeLittleEndian(out + 4, bits, 4);
+        }
+
+        void decodeBc1(const uint8_t* in, uint8_t texels[BLOCK_TEXELS][4])
+        {
+            const auto color0 = static_cast<uint16_t>(loadLittleEndian(in, 2));
+            const auto color1 = static_cast<uint16_t>(loadLittleEndian(in + 2, 2));
+            const uint64_t bits = loadLittleEndian(in + 4, 4);
+
+            int c0[3];
+            int c1[3];
+            unpackRgb565(color0, c0);
+            unpackRgb565(color1, c1);
+
+            uint8_t palette[4][3];
+            for (int c = 0; c < 3; c++)
+            {
+                palette[0][c] = static_cast<uint8_t>(c0[c]);
+                palette[1][c] = static_cast<uint8_t>(c1[c]);
+                if (color0 > color1)
+                {
+                    palette[2][c] = static_cast<uint8_t>((2 * c0[c] + c1[c]) / 3);
+                    palette[3][c] = static_cast<uint8_t>((c0[c] + 2 * c1[c]) / 3);
+                } else
+                {
+                    palette[2][c] = static_cast<uint8_t>((c0[c] + c1[c]) / 2);
+                    palette[3][c] = 0;
+                }
+            }
+
+            for (int i = 0; i < BLOCK_TEXELS; i++)
+            {
+                const uint8_t* color = palette[(bits >> (2 * i)) & 3];
+                texels[i][0] = color[0];
+                texels[i][1] = color[1];
+                texels[i][2] = color[2];
+                texels[i][3] = 255;
+            }
+        }
+
+        // BC4, also the alpha block of BC3 and both halves of BC5
+
+        // 8 interpolated values when value0 > value1, otherwise 6 plus the constants 0 and 255
+        void bc4Palette(int value0, int value1, int palette[8])
+        {
+            palette[0] = value0;
+            palette[1] = value1;
+            if (value0 > value1)
+            {
+                for (int k = 2; k < 8; k++) palette[k] = ((8 - k) * value0 + (k - 1) * value1) / 7;
+            } else
+            {
+                for (int k = 2; k < 6; k++) palette[k] = ((6 - k) * value0 + (k - 1) * value1) / 5;
+                palette[6] = 0;
+                palette[7] = 255;
+            }
+        }
+
+        struct Bc4Block
+        {
+            uint8_t value0;
+            uint8_t value1;
+            uint8_t indices[BLOCK_TEXELS];
+            float error;
+        };
+
+        Bc4Block evaluateBc4(const Block& block, int channel, int value0, int value1)
+        {
+            Bc4Block result{static_cast<uint8_t>(value0), static_cast<uint8_t>(value1), {}, 0.0f};
+
+            int values[8];
+            bc4Palette(value0, value1, values);
+            Palette palette;
+            for (int k = 0; k < 8; k++) palette.entry[k][0] = static_cast<float>(values[k]);
+            palette.size = 8;
+
+            result.error = fitIndices(block, channel, 1, palette, result.indices);
+            return result;
+        }
+
+        // Least squares passes that keep the mode of `best`
+        void refineBc4(const Block& block, int channel, int refinements, Bc4Block& best)
+        {
+            // Weight of value1 for each index, negative for the constants of 6 value mode
+            static constexpr float WEIGHTS_8[8] = {0.0f, 1.0f, 1.0f / 7, 2.0f / 7, 3.0f / 7, 4.0f / 7, 5.0f / 7, 6.0f / 7};
+            static constexpr float WEIGHTS_6[8] = {0.0f, 1.0f, 1.0f / 5, 2.0f / 5, 3.0f / 5, 4.0f / 5, -1.0f, -1.0f};
+
+            const bool eightValues = best.value0 > best.value1;
+            for (int pass = 0; pass < refinements && best.error > 0.0f; pass++)
+            {
+                float weights[BLOCK_TEXELS];
+                for (int i = 0; i < BLOCK_TEXELS; i++)
+                {
+                    weights[i] = eightValues ? WEIGHTS_8[best.indices[i]] : WEIGHTS_6[best.indices[i]];
+                }
+
+                float start;
+                float end;
+                if (!solveEndpoints(block, channel, 1, weights, &start, &end)) break;
+
+                int value0 = static_cast<int>(std::lround(start));
+                int value1 = static_cast<int>(std::lround(end));
+                if ((value0 > value1) != eightValues) std::swap(value0, value1);
+
+                const Bc4Block candidate = evaluateBc4(block, channel, value0, value1);
+                if (candidate.error >= best.error) break;
+                best = candidate;
+            }
+        }
+
+        void encodeBc4(const Block& block, int channel, const Settings& settings, uint8_t* out)
+        {
+            const float* texels = block.channel[channel];
+            const auto [lo, hi] = std::minmax_element(texels, texels + BLOCK_TEXELS);
+
+            Bc4Block best = evaluateBc4(block, channel, static_cast<int>(*hi), static_cast<int>(*lo));
+            refineBc4(block, channel, settings.refinements, best);
+
+            // Blocks that touch 0 or 255 can leave those to the constants of 6 value mode and spend the
+            // interpolated values on the rest
+            if (settings.alternativeModes && best.error > 0.0f)
+            {
+                float innerLo = 255.0f;
+                float innerHi = 0.0f;
+                for (int i = 0; i < BLOCK_TEXELS; i++)
+                {
+                    if (texels[i] == 0.0f || texels[i] == 255.0f) continue;
+                    innerLo = std::min(innerLo, texels[i]);
+                    innerHi = std::max(innerHi, texels[i]);
+                }
+
+                if (innerLo <= innerHi)
+                {
+                    Bc4Block candidate = evaluateBc4(block, channel, static_cast<int>(innerLo), static_cast<int>(innerHi));
+                    refineBc4(block, channel, settings.refinements, candidate);
+                    if (candidate.error < best.error) best = candidate;
+                }
+            }
+
+            uint64_t bits = 0;
+            for (int i = 0; i < BLOCK_TEXELS; i++) bits |= static_cast<uint64_t>(best.indices[i]) << (3 * i);
+            out[0] = best.value0;
+            out[1] = best.value1;
+            storeLittleEndian(out + 2, bits, 6);
+        }
+
+        void decodeBc4(const uint8_t* in, uint8_t values[BLOCK_TEXELS])
+        {
+            int palette[8];
+            bc4Palette(in[0], in[1], palette);
+
+            const uint64_t bits = loadLittleEndian(in + 2, 6);
+            for (int i = 0; i < BLOCK_TEXELS; i++) values[i] = static_cast<uint8_t>(palette[(bits >> (3 * i)) & 7]);
+        }
+
+        // BC7 mode 6: 7-bit RGBA endpoints, each with its own shared lowest bit, and 4-bit indices
+
+        constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        struct Bc7Endpoint
+        {
+            uint8_t value[4]; // Top 7 bits
+            uint8_t pbit;
+        };
+
+        int expandBc7(const Bc7Endpoint& endpoint, int channel)
+        {
+            return (endpoint.value[channel] << 1) | endpoint.pbit;
+        }
+
+        // Rounds to the closest representable endpoint, trying both lowest bits unless `pbit` forces one
+        Bc7Endpoint quantizeBc7(const float color[4], int pbit = -1)
+        {
+            Bc7Endpoint best{};
+            float bestError = std::numeric_limits<float>::max();
+            for (int p = pbit < 0 ? 0 : pbit; p <= (pbit < 0 ? 1 : pbit); p++)
+            {
+                Bc7Endpoint endpoint{};
+                endpoint.pbit = static_cast<uint8_t>(p);
+
+                float error = 0.0f;
+                for (int c = 0; c < 4; c++)
+                {
+                    const long q = std::clamp(std::lround((color[c] - static_cast<float>(p)) * 0.5f), 0L, 127L);
+                    endpoint.value[c] = static_cast<uint8_t>(q);
+                    const float d = static_cast<float>(expandBc7(endpoint, c)) - color[c];
+                    error += d * d;
+                }
+
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = endpoint;
+                }
+            }
+            return best;
+        }
+
+        void bc7Palette(const Bc7Endpoint& endpoint0, const Bc7Endpoint& endpoint1, int palette[16][4])
+        {
+            for (int k = 0; k < 16; k++)
+            {
+                const int w = BC7_WEIGHTS[k];
+                for (int c = 0; c < 4; c++)
+                {
+                    palette[k][c] = ((64 - w) * expandBc7(endpoint0, c) + w * expandBc7(endpoint1, c) + 32) >> 6;
+                }
+            }
+        }
+
+        struct Bc7Block
+        {
+            Bc7Endpoint endpoint[2];
+            uint8_t indices[BLOCK_TEXELS];
+            float error;
+        };
+
+        Bc7Block evaluateBc7(const Block& block, const Bc7Endpoint& endpoint0, const Bc7Endpoint& endpoint1)
+        {
+            Bc7Block result{{endpoint0, endpoint1}, {}, 0.0f};
+
+            int values[16][4];
+            bc7Palette(endpoint0, endpoint1, values);
+            Palette palette;
+            for (int k = 0; k < 16; k++)
+            {
+                for (int c = 0; c < 4; c++) palette.entry[k][c] = static_cast<float>(values[k][c]);
+            }
+            palette.size = 16;
+            result.error = fitIndices(block, 0, 4, palette, result.indices);
+
+            // The first index is stored without its top bit. The weights are symmetric, so swapping the
+            // endpoints and mirroring the indices decodes to the same texels.
+            if (result.indices[0] & 8)
+            {
+                std::swap(result.endpoint[0], result.endpoint[1]);
+                for (uint8_t& index : result.indices) index = static_cast<uint8_t>(15 - index);
+            }
+            return result;
+        }
+
+        // Least significant bit first, the way BC7 blocks are laid out
+        struct BitWriter
+        {
+            uint64_t words[2]{};
+            int position = 0;
+
+            void write(uint64_t value, int count)
+            {
+                const int word = position >> 6;
+                const int shift = position & 63;
+                words[word] |= value << shift;
+                if (shift + count > 64) words[word + 1] |= value >> (64 - shift);
+                position += count;
+            }
+        };
+
+        struct BitReader
+        {
+            uint64_t words[2];
+            int position = 0;
+
+            uint32_t read(int count)
+            {
+                uint32_t value = 0;
+                for (int i = 0; i < count; i++, position++)
+                {
+                    value |= static_cast<uint32_t>((words[position >> 6] >> (position & 63)) & 1) << i;
+                }
+                return value;
+            }
+        };
+
+        void encodeBc7(const Block& block, const Settings& settings, uint8_t* out)
+        {
+            float mean[4];
+            float axis[4];
+            float start[4];
+            float end[4];
+            fitLine(block, 0, 4, settings.powerIterations, mean, axis);
+            lineEndpoints(block, 0, 4, mean, axis, start, end);
+            Bc7Block best = evaluateBc7(block, quantizeBc7(start), quantizeBc7(end));
+
+            for (int pass = 0; pass < settings.refinements && best.error > 0.0f; pass++)
+            {
+                float weights[BLOCK_TEXELS];
+                for (int i = 0; i < BLOCK_TEXELS; i++) weights[i] = BC7_WEIGHTS[best.indices[i]] / 64.0f;
+                if (!solveEndpoints(block, 0, 4, weights, start, end)) break;
+
+                const Bc7Block candidate = evaluateBc7(block, quantizeBc7(start), quantizeBc7(end));
+                if (candidate.error >= best.error) break;
+                best = candidate;
+            }
+
+            // Rounding each endpoint on its own can pick lowest bits that fit the texels worse than another pair
+            if (settings.alternativeModes && best.error > 0.0f)
+            {
+                for (int pbits = 0; pbits < 4; pbits++)
+                {
+                    const Bc7Block candidate = evaluateBc7(block, quantizeBc7(start, pbits & 1), quantizeBc7(end, pbits >> 1));
+                    if (candidate.error < best.error) best = candidate;
+                }
+            }
+
+            BitWriter writer;
+            writer.write(1 << 6, 7);
+            for (int c = 0; c < 4; c++)
+            {
+                writer.write(best.endpoint[0].value[c], 7);
+                writer.write(best.endpoint[1].value[c], 7);
+            }
+            writer.write(best.endpoint[0].pbit, 1);
+            writer.write(best.endpoint[1].pbit, 1);
+            writer.write(best.indices[0], 3);
+            for (int i = 1; i < BLOCK_TEXELS; i++) writer.write(best.indices[i], 4);
+
+            storeLittleEndian(out, writer.words[0], 8);
+            storeLittleEndian(out + 8, writer.words[1], 8);
+        }
+
+        // Only mode 6, the one encodeBc7() writes. Other modes decode to transparent black.
+        void decodeBc7(const uint8_t* in, uint8_t texels[BLOCK_TEXELS][4])
+        {
+            BitReader reader{{loadLittleEndian(in, 8), loadLittleEndian(in + 8, 8)}};
+            if (reader.read(7) != 1 << 6)
+            {
+                std::fill_n(&texels[0][0], BLOCK_TEXELS * 4, uint8_t{0});
+                return;
+            }
+
+            Bc7Endpoint endpoint[2]{};
+            for (int c = 0; c < 4; c++)
+            {
+                endpoint[0].value[c] = static_cast<uint8_t>(reader.read(7));
+                endpoint[1].value[c] = static_cast<uint8_t>(reader.read(7));
+            }
+            endpoint[0].pbit = static_cast<uint8_t>(reader.read(1));
+            endpoint[1].pbit = static_cast<uint8_t>(reader.read(1));
+
+            int palette[16][4];
+            bc7Palette(endpoint[0], endpoint[1], palette);
+            for (int i = 0; i < BLOCK_TEXELS; i++)
+            {
+                const uint32_t index = reader.read(i == 0 ? 3 : 4);
+                for (int c = 0; c < 4; c++) texels[i][c] = static_cast<uint8_t>(palette[index][c]);
+            }
+        }
+
+        void encodeBlock(const Block& block, TextureFormat format, const Settings& settings, uint8_t* out)
+        {
+            switch (format)
+            {
+                case TextureFormat::BC1:
+                    encodeBc1(block, settings, out);
+                    break;
+                case TextureFormat::BC3:
+                    encodeBc4(block, 3, settings, out);
+                    encodeBc1(block, settings, out + 8);
+                    break;
+                case TextureFormat::BC4:
+                    encodeBc4(block, 0, settings, out);
+                    break;
+                case TextureFormat::BC5:
+                    encodeBc4(block, 0, settings, out);
+                    encodeBc4(block, 1, settings, out + 8);
+                    break;
+                case TextureFormat::BC7:
+                    encodeBc7(block, settings, out);
+                    break;
+                case TextureFormat::RGBA8:
+                    break;
+            }
+        }
+
+        void decodeBlock(const uint8_t* in, TextureFormat format, uint8_t texels[BLOCK_TEXELS][4])
+        {
+            uint8_t values[2][BLOCK_TEXELS];
+            switch (format)
+            {
+                case TextureFormat::BC1:
+                    decodeBc1(in, texels);
+                    break;
+                case TextureFormat::BC3:
+                    decodeBc1(in + 8, texels);
+                    decodeBc4(in, values[0]);
+                    for (int i = 0; i < BLOCK_TEXELS; i++) texels[i][3] = values[0][i];
+                    break;
+                case TextureFormat::BC4:
+                    decodeBc4(in, values[0]);
+                    for (int i = 0; i < BLOCK_TEXELS; i++)
+                    {
+                        texels[i][0] = texels[i][1] = texels[i][2] = values[0][i];
+                        texels[i][3] = 255;
+                    }
+                    break;
+                case TextureFormat::BC5:
+                    decodeBc4(in, values[0]);
+                    decodeBc4(in + 8, values[1]);
+                    for (int i = 0; i < BLOCK_TEXELS; i++)
+                    {
+                        texels[i][0] = values[0][i];
+                        texels[i][1] = values[1][i];
+                        texels[i][2] = 0;
+                        texels[i][3] = 255;
+                    }
+                    break;
+                case TextureFormat::BC7:
+                    decodeBc7(in, texels);
+                    break;
+                case TextureFormat::RGBA8:
+                    break;
+            }
+        }
+
+        // One level of a compressed chain as RGBA8
+        std::vector<uint8_t> decodeLevel(const MipChain& chain, size_t level)
+        {
+            const MipChain::Level& source = chain.levels[level];
+            const uint32_t blocksX = (source.width + 3) / 4;
+            const uint32_t blocksY = (source.height + 3) / 4;
+            const size_t blockSize = BlockCompressor::BlockSize(chain.format);
+            if (source.offset + BlockCompressor::LevelSize(chain.format, source.width, source.height) > chain.data.size())
+            {
+                throw std::runtime_error("BlockCompressor: level " + std::to_string(level) + " is truncated");
+            }
+
+            std::vector<uint8_t> pixels(static_cast<size_t>(source.width) * source.height * 4);
+            for (uint32_t blockY = 0; blockY < blocksY; blockY++)
+            {
+                for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+                {
+                    uint8_t texels[BLOCK_TEXELS][4];
+                    decodeBlock(chain.data.data() + source.offset + (static_cast<size_t>(blockY) * blocksX + blockX) * blockSize,
+                        chain.format, texels);
+
+                    // Texels past the edge of the level only exist in the block
+                    for (uint32_t y = 0; y < 4 && blockY * 4 + y < source.height; y++)
+                    {
+                        for (uint32_t x = 0; x < 4 && blockX * 4 + x < source.width; x++)
+                        {
+                            const size_t offset = (static_cast<size_t>(blockY * 4 + y) * source.width + blockX * 4 + x) * 4;
+                            std::copy_n(texels[y * 4 + x], 4, pixels.data() + offset);
+                        }
+                    }
+                }
+            }
+            return pixels;
+        }
+    }
+
+    MipChain BlockCompressor::Compress(const MipChain& chain, TextureFormat format, CompressionQuality quality)
+    {
+        if (chain.format != TextureFormat::RGBA8)
+        {
+            throw std::runtime_error("BlockCompressor: the source chain is already compressed");
+        }
+        if (format == TextureFormat::RGBA8) return chain;
+
+        MipChain result;
+        result.format = format;
+
+        // One job per row of blocks over every level, the small levels are too cheap to split further
+        struct Row
+        {
+            uint32_t level;
+            uint32_t blockY;
+        };
+        std::vector<Row> rows;
+
+        size_t offset = 0;
+        for (uint32_t level = 0; level < chain.levels.size(); level++)
+        {
+            const MipChain::Level& source = chain.levels[level];
+            result.levels.push_back({offset, source.width, source.height});
+            offset += LevelSize(format, source.width, source.height);
+
+            for (uint32_t blockY = 0; blockY < (source.height + 3) / 4; blockY++) rows.push_back({level, blockY});
+        }
+        result.data.resize(offset);
+
+        const Settings settings = settingsFor(quality);
+        const size_t blockSize = BlockSize(format);
+        ThreadPool::getInstance().parallelFor(rows.size(), [&](size_t i)
+        {
+            const MipChain::Level& source = chain.levels[rows[i].level];
+            const uint32_t blocksX = (source.width + 3) / 4;
+            uint8_t* out = result.data.data() + result.levels[rows[i].level].offset +
+                static_cast<size_t>(rows[i].blockY) * blocksX * blockSize;
+
+            Block block;
+            for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+            {
+                loadBlock(chain.data.data() + source.offset, source.width, source.height, blockX, rows[i].blockY, block);
+                encodeBlock(block, format, settings, out + blockX * blockSize);
+            }
+        });
+
+        return result;
+    }
+
+    MipChain BlockCompressor::Decompress(const MipChain& chain)
+    {
+        if (chain.format == TextureFormat::RGBA8) return chain;
+
+        MipChain result;
+        for (size_t level = 0; level < chain.levels.size(); level++)
+        {
+            const std::vector<uint8_t> pixels = decodeLevel(chain, level);
+            result.levels.push_back({result.data.size(), chain.levels[level].width, chain.levels[level].height});
+            result.data.insert(result.data.end(), pixels.begin(), pixels.end());
+        }
+        return result;
+    }
+
+    float BlockCompressor::ComputePsnr(const MipChain& original, const MipChain& compressed)
+    {
+        if (original.format != TextureFormat::RGBA8 || original.levels.empty() || compressed.levels.empty() ||
+            original.levels[0].width != compressed.levels[0].width ||
+            original.levels[0].height != compressed.levels[0].height)
+        {
+            throw std::runtime_error("BlockCompressor: PSNR needs an RGBA8 original of the same size");
+        }
+
+        int channels = 4;
+        if (compressed.format == TextureFormat::BC1) channels = 3;
+        if (compressed.format == TextureFormat::BC4) channels = 1;
+        if (compressed.format == TextureFormat::BC5) channels = 2;
+
+        const std::vector<uint8_t> decoded = compressed.format == TextureFormat::RGBA8
+            ? std::vector<uint8_t>(compressed.data.begin() + compressed.levels[0].offset,
+                compressed.data.begin() + compressed.levels[0].offset + LevelSize(TextureFormat::RGBA8,
+                    compressed.levels[0].width, compressed.levels[0].height))
+            : decodeLevel(compressed, 0);
+
+        const size_t texels = static_cast<size_t>(original.levels[0].width) * original.levels[0].height;
+        const uint8_t* source = original.data.data() + original.levels[0].offset;
+        double squaredError = 0.0;
+        for (size_t i = 0; i < texels; i++)
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                const double d = static_cast<double>(source[i * 4 + c]) - decoded[i * 4 + c];
+                squaredError += d * d;
+            }
+        }
+
+        const double meanSquaredError = squaredError / static_cast<double>(texels * channels);
+        if (meanSquaredError <= 0.0) return MAX_PSNR;
+        return std::min(MAX_PSNR, static_cast<float>(10.0 * std::log10(255.0 * 255.0 / meanSquaredError)));
+    }
+
+    size_t BlockCompressor::BlockSize(TextureFormat format)
+    {
+        switch (format)
+        {
+            case TextureFormat::BC1:
+            case TextureFormat::BC4:
+                return 8;
+            case TextureFormat::BC3:
+            case TextureFormat::BC5:
+            case TextureFormat::BC7:
+                return 16;
+            case TextureFormat::RGBA8:
+                break;
+        }
+        return 0;
+    }
+
+    size_t BlockCompressor::LevelSize(TextureFormat format, uint32_t width, uint32_t height)
+    {
+        if (format == TextureFormat::RGBA8) return static_cast<size_t>(width) * height * 4;
+        return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * BlockSize(format);
+    }
+
+    bool BlockCompressor::IsSimd()
+    {
+#ifdef VOIDENGINE_SSE2
+        return true;
+#else
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Common.hpp"
+#include "MipGenerator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace VoidEngine
+{
+    enum class CompressionQuality : uint32_t
+    {
+        FAST,   // Rough principal axis endpoints, no refinement
+        NORMAL, // Principal axis endpoints refined by least squares
+        HIGH,   // More refinement passes and the alternative block modes
+    };
+
+    // CPU encoder for the BC formats the texture import path uploads. Every level is cut into 4x4 blocks,
+    // texels past the edge of a level repeat the last row or column. Block rows are spread over the
+    // ThreadPool and the endpoint search compares four texels at a time with SSE2 where the compiler targets it.
+    //
+    // BC7 is limited to mode 6 (one subset, RGBA endpoints and 4-bit indices), which is good enough for most
+    // color maps and far cheaper to search than all eight modes.
+    class BlockCompressor
+    {
+    public:
+        // Encodes an RGBA8 chain. BC4 keeps the red channel and BC5 red and green.
+        VOIDENGINE_API static MipChain Compress(const MipChain& chain, TextureFormat format,
+            CompressionQuality quality = CompressionQuality::NORMAL);
+
+        // Expands a chain written by Compress() back to RGBA8, as the sampler would read it through the
+        // view Texture creates: BC4 is replicated to RGB and BC5 has blue 0, both with opaque alpha.
+        VOIDENGINE_API static MipChain Decompress(const MipChain& chain);
+
+        // Peak signal to noise ratio of the first level of `compressed` against the RGBA8 `original`, over
+        // the channels the format keeps. An exact match reports MAX_PSNR.
+        VOIDENGINE_API static float ComputePsnr(const MipChain& original, const MipChain& compressed);
+
+        // Bytes per 4x4 block, 0 for RGBA8
+        VOIDENGINE_API static size_t BlockSize(TextureFormat format);
+        VOIDENGINE_API static size_t LevelSize(TextureFormat format, uint32_t width, uint32_t height);
+
+        // Whether Compress() uses the SSE2 path in this build
+        VOIDENGINE_API static bool IsSimd();
+
+        static constexpr float MAX_PSNR = 100.0f;
+    };
+}
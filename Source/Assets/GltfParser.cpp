@@ -0,0 +1,622 @@
+#include "GltfParser.hpp"
+
+#include "Json.hpp"
+
+#include "External/glm/gtc/matrix_transform.hpp"
+#include "External/glm/gtc/quaternion.hpp"
+#include "External/glm/gtc/type_ptr.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+namespace VoidEngine
+{
+    namespace
+    {
+        constexpr uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+        constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+        constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;  // "BIN\0"
+        constexpr int64_t MODE_TRIANGLES = 4;
+
+        struct BufferRange
+        {
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+        };
+
+        struct BufferView
+        {
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+            size_t stride = 0; // 0 when tightly packed
+        };
+
+        uint32_t readU32(const uint8_t* p)
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        // Validates an index into one of the top level arrays
+        uint32_t checkedIndex(const JsonValue& value, size_t count, const char* what)
+        {
+            const int64_t index = value.AsInt(-1);
+            if (index < 0 || static_cast<size_t>(index) >= count)
+            {
+                throw std::runtime_error(std::string("invalid ") + what + " index");
+            }
+            return static_cast<uint32_t>(index);
+        }
+
+        // Sizes and offsets. Capped well below the point where the range checks could overflow.
+        size_t readSize(const JsonValue& value)
+        {
+            const int64_t size = value.AsInt();
+            if (size < 0 || size > (int64_t{1} << 40)) throw std::runtime_error("invalid size or offset");
+            return static_cast<size_t>(size);
+        }
+
+        int32_t optionalIndex(const JsonValue& value, size_t count, const char* what)
+        {
+            return value.IsNull() ? -1 : static_cast<int32_t>(checkedIndex(value, count, what));
+        }
+
+        uint32_t componentSize(uint32_t componentType)
+        {
+            switch (componentType)
+            {
+                case GltfData::BYTE:
+                case GltfData::UNSIGNED_BYTE: return 1;
+                case GltfData::SHORT:
+                case GltfData::UNSIGNED_SHORT: return 2;
+                case GltfData::UNSIGNED_INT:
+                case GltfData::FLOAT: return 4;
+                default: throw std::runtime_error("invalid accessor componentType " + std::to_string(componentType));
+            }
+        }
+
+        uint32_t componentCount(const std::string& type)
+        {
+            if (type == "SCALAR") return 1;
+            if (type == "VEC2") return 2;
+            if (type == "VEC3") return 3;
+            if (type == "VEC4") return 4;
+            // Matrices are never read as vertex attributes
+            if (type == "MAT2") return 4;
+            if (type == "MAT3") return 9;
+            if (type == "MAT4") return 16;
+            throw std::runtime_error("invalid accessor type " + type);
+        }
+
+        constexpr auto BASE64_TABLE = []()
+        {
+            std::array<int8_t, 256> table{};
+            table.fill(-1);
+            for (int i = 0; i < 26; i++)
+            {
+                table['A' + i] = static_cast<int8_t>(i);
+                table['a' + i] = static_cast<int8_t>(26 + i);
+            }
+            for (int i = 0; i < 10; i++) table['0' + i] = static_cast<int8_t>(52 + i);
+            table['+'] = table['-'] = 62;
+            table['/'] = table['_'] = 63;
+            return table;
+        }();
+
+        std::vector<uint8_t> decodeBase64(std::string_view text)
+        {
+            while (!text.empty() && text.back() == '=') text.remove_suffix(1);
+
+            std::vector<uint8_t> result(text.size() / 4 * 3 + 3);
+            uint8_t* out = result.data();
+
+            auto value = [&](size_t i)
+            {
+                const int8_t v = BASE64_TABLE[static_cast<uint8_t>(text[i])];
+                if (v < 0) throw std::runtime_error("invalid base64 data URI");
+                return static_cast<uint32_t>(v);
+            };
+
+            size_t i = 0;
+            for (; i + 4 <= text.size(); i += 4)
+            {
+                const uint32_t bits = value(i) << 18 | value(i + 1) << 12 | value(i + 2) << 6 | value(i + 3);
+                *out++ = static_cast<uint8_t>(bits >> 16);
+                *out++ = static_cast<uint8_t>(bits >> 8);
+                *out++ = static_cast<uint8_t>(bits);
+            }
+
+            // 2 or 3 trailing characters carry 1 or 2 bytes
+            const size_t remaining = text.size() - i;
+            if (remaining == 1) throw std::runtime_error("invalid base64 data URI");
+            if (remaining >= 2)
+            {
+                uint32_t bits = value(i) << 18 | value(i + 1) << 12;
+                if (remaining == 3) bits |= value(i + 2) << 6;
+                *out++ = static_cast<uint8_t>(bits >> 16);
+                if (remaining == 3) *out++ = static_cast<uint8_t>(bits >> 8);
+            }
+
+            result.resize(static_cast<size_t>(out - result.data()));
+            return result;
+        }
+
+        // Relative URIs are percent-encoded, decode them before touching the file system
+        std::string decodeUri(const std::string& uri)
+        {
+            std::string result;
+            result.reserve(uri.size());
+            for (size_t i = 0; i < uri.size(); i++)
+            {
+                if (uri[i] == '%' && i + 2 < uri.size())
+                {
+                    result += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+                    i += 2;
+                } else
+                {
+                    result += uri[i];
+                }
+            }
+            return result;
+        }
+
+        std::string resolvePath(const std::string& gltfPath, const std::string& uri)
+        {
+            return (std::filesystem::path(gltfPath).parent_path() / decodeUri(uri)).generic_string();
+        }
+
+        BufferRange loadBuffer(GltfData& gltf, const JsonValue& buffer, const std::string& filepath, BufferRange glbChunk)
+        {
+            const std::string& uri = buffer["uri"].AsString();
+            const auto byteLength = readSize(buffer["byteLength"]);
+
+            BufferRange range;
+            if (uri.empty())
+            {
+                // Only the first buffer of a .glb may omit the uri, it refers to the BIN chunk
+                if (glbChunk.data == nullptr) throw std::runtime_error("buffer without uri");
+                range = glbChunk;
+            } else if (uri.starts_with("data:"))
+            {
+                const size_t comma = uri.find(',');
+                if (comma == std::string::npos || uri.rfind(";base64", comma) == std::string::npos)
+                {
+                    throw std::runtime_error("only base64 data URIs are supported");
+                }
+                auto& decoded = gltf.decodedBuffers.emplace_back(decodeBase64(std::string_view(uri).substr(comma + 1)));
+                range = {decoded.data(), decoded.size()};
+            } else
+            {
+                const auto& file = gltf.files.emplace_back(resolvePath(filepath, uri));
+                range = {file.data(), file.size()};
+            }
+
+            if (range.size < byteLength) throw std::runtime_error("buffer is shorter than its byteLength");
+            range.size = byteLength;
+            return range;
+        }
+
+        GltfData::Accessor loadAccessor(const JsonValue& json, const std::vector<BufferView>& views)
+        {
+            if (json.Has("sparse")) throw std::runtime_error("sparse accessors are not supported");
+
+            GltfData::Accessor accessor;
+            accessor.componentType = static_cast<uint32_t>(json["componentType"].AsInt());
+            accessor.components = componentCount(json["type"].AsString());
+            accessor.count = readSize(json["count"]);
+            accessor.normalized = json["normalized"].AsBool();
+
+            const size_t elementSize = componentSize(accessor.componentType) * accessor.components;
+            accessor.stride = elementSize;
+
+            if (!json["bufferView"].IsNull())
+            {
+                const BufferView& view = views[checkedIndex(json["bufferView"], views.size(), "bufferView")];
+                const auto offset = readSize(json["byteOffset"]);
+                if (view.stride != 0)
+                {
+                    if (view.stride < elementSize) throw std::runtime_error("bufferView byteStride is smaller than its elements");
+                    accessor.stride = view.stride;
+                }
+
+                if (accessor.count > 0 && offset + (accessor.count - 1) * accessor.stride + elementSize > view.size)
+                {
+                    throw std::runtime_error("accessor exceeds its bufferView");
+                }
+                accessor.data = view.data + offset;
+            }
+
+            const JsonValue& min = json["min"];
+            const JsonValue& max = json["max"];
+            if (min.Size() >= accessor.components && max.Size() >= accessor.components && accessor.components <= 4)
+            {
+                accessor.hasBounds = true;
+                for (uint32_t c = 0; c < accessor.components; c++)
+                {
+                    accessor.min[c] = min[c].AsFloat();
+                    accessor.max[c] = max[c].AsFloat();
+                }
+            }
+            return accessor;
+        }
+
+        glm::mat4 loadNodeMatrix(const JsonValue& node)
+        {
+            const JsonValue& matrix = node["matrix"];
+            if (matrix.Size() == 16)
+            {
+                float values[16];
+                for (size_t i = 0; i < 16; i++) values[i] = matrix[i].AsFloat();
+                return glm::make_mat4(values); // Column major, like glm
+            }
+
+            glm::vec3 translation{0.0f};
+            glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+            glm::vec3 scale{1.0f};
+
+            const JsonValue& t = node["translation"];
+            const JsonValue& r = node["rotation"];
+            const JsonValue& s = node["scale"];
+            if (t.Size() == 3) translation = {t[0].AsFloat(), t[1].AsFloat(), t[2].AsFloat()};
+            // glTF stores quaternions as xyzw, glm::quat takes wxyz
+            if (r.Size() == 4) rotation = glm::quat(r[3].AsFloat(), r[0].AsFloat(), r[1].AsFloat(), r[2].AsFloat());
+            if (s.Size() == 3) scale = {s[0].AsFloat(), s[1].AsFloat(), s[2].AsFloat()};
+
+            return glm::translate(glm::mat4{1.0f}, translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4{1.0f}, scale);
+        }
+
+        std::string loadTexturePath(const JsonValue& root, const JsonValue& textureInfo, const std::string& filepath)
+        {
+            if (textureInfo.IsNull()) return {};
+
+            const JsonValue& textures = root["textures"];
+            const JsonValue& images = root["images"];
+            const JsonValue& texture = textures[checkedIndex(textureInfo["index"], textures.Size(), "texture")];
+            if (texture["source"].IsNull()) return {};
+
+            const JsonValue& image = images[checkedIndex(texture["source"], images.Size(), "image")];
+            const std::string& uri = image["uri"].AsString();
+            if (uri.empty() || uri.starts_with("data:")) return {};
+
+            return resolvePath(filepath, uri);
+        }
+
+        GltfData parseDocument(const std::string& filepath, MappedFile file)
+        {
+            GltfData gltf;
+
+            const char* json = reinterpret_cast<const char*>(file.data());
+            size_t jsonSize = file.size();
+            BufferRange glbChunk;
+
+            if (file.size() >= 12 && readU32(file.data()) == GLB_MAGIC)
+            {
+                if (readU32(file.data() + 4) != 2) throw std::runtime_error("unsupported GLB version");
+                const size_t length = std::min<size_t>(readU32(file.data() + 8), file.size());
+
+                json = nullptr;
+                for (size_t offset = 12; offset + 8 <= length;)
+                {
+                    const uint32_t chunkLength = readU32(file.data() + offset);
+                    const uint32_t chunkType = readU32(file.data() + offset + 4);
+                    const uint8_t* chunkData = file.data() + offset + 8;
+                    if (offset + 8 + chunkLength > length) throw std::runtime_error("truncated GLB chunk");
+
+                    if (chunkType == GLB_CHUNK_JSON && json == nullptr)
+                    {
+                        json = reinterpret_cast<const char*>(chunkData);
+                        jsonSize = chunkLength;
+                    } else if (chunkType == GLB_CHUNK_BIN && glbChunk.data == nullptr)
+                    {
+                        glbChunk = {chunkData, chunkLength};
+                    }
+                    // Chunks are 4 byte aligned
+                    offset += 8 + ((chunkLength + 3) & ~size_t{3});
+                }
+                if (json == nullptr) throw std::runtime_error("GLB without JSON chunk");
+            }
+
+            const JsonValue root = JsonValue::Parse(json, jsonSize);
+            if (!root["asset"]["version"].AsString().starts_with("2.")) throw std::runtime_error("only glTF 2.x is supported");
+
+            // The .glb itself is the storage of the BIN chunk
+            gltf.files.push_back(std::move(file));
+
+            std::vector<BufferRange> buffers;
+            for (const JsonValue& buffer : root["buffers"].GetArray())
+            {
+                buffers.push_back(loadBuffer(gltf, buffer, filepath, buffers.empty() ? glbChunk : BufferRange{}));
+            }
+
+            std::vector<BufferView> views;
+            for (const JsonValue& view : root["bufferViews"].GetArray())
+            {
+                const BufferRange& buffer = buffers[checkedIndex(view["buffer"], buffers.size(), "buffer")];
+                const auto offset = readSize(view["byteOffset"]);
+                const auto length = readSize(view["byteLength"]);
+                if (offset + length > buffer.size) throw std::runtime_error("bufferView exceeds its buffer");
+
+                views.push_back({buffer.data + offset, length, readSize(view["byteStride"])});
+            }
+
+            for (const JsonValue& accessor : root["accessors"].GetArray())
+            {
+                gltf.accessors.push_back(loadAccessor(accessor, views));
+            }
+
+            for (const JsonValue& material : root["materials"].GetArray())
+            {
+                auto& result = gltf.materials.emplace_back();
+                result.name = material["name"].AsString();
+
+                const JsonValue& pbr = material["pbrMetallicRoughness"];
+                const JsonValue& factor = pbr["baseColorFactor"];
+                if (factor.Size() == 4)
+                {
+                    result.baseColorFactor = {factor[0].AsFloat(), factor[1].AsFloat(), factor[2].AsFloat(), factor[3].AsFloat()};
+                }
+                result.metallicFactor = pbr["metallicFactor"].AsFloat(1.0f);
+                result.roughnessFactor = pbr["roughnessFactor"].AsFloat(1.0f);
+                result.baseColorTexture = loadTexturePath(root, pbr["baseColorTexture"], filepath);
+            }
+
+            for (const JsonValue& mesh : root["meshes"].GetArray())
+            {
+                auto& result = gltf.meshes.emplace_back();
+                result.name = mesh["name"].AsString();
+
+                for (const JsonValue& primitive : mesh["primitives"].GetArray())
+                {
+                    if (primitive["mode"].AsInt(MODE_TRIANGLES) != MODE_TRIANGLES)
+                    {
+                        std::cerr << filepath << ": skipping non-triangle primitive in mesh '" << result.name << "'\n";
+                        continue;
+                    }
+
+                    const JsonValue& attributes = primitive["attributes"];
+                    if (!attributes.Has("POSITION")) continue;
+
+                    const size_t accessorCount = gltf.accessors.size();
+                    GltfData::Primitive p;
+                    p.position = optionalIndex(attributes["POSITION"], accessorCount, "accessor");
+                    p.normal = optionalIndex(attributes["NORMAL"], accessorCount, "accessor");
+                    p.texcoord = optionalIndex(attributes["TEXCOORD_0"], accessorCount, "accessor");
+                    p.color = optionalIndex(attributes["COLOR_0"], accessorCount, "accessor");
+                    p.indices = optionalIndex(primitive["indices"], accessorCount, "accessor");
+                    p.material = optionalIndex(primitive["material"], gltf.materials.size(), "material");
+
+                    const size_t vertexCount = gltf.accessors[p.position].count;
+                    for (const int32_t attribute : {p.normal, p.texcoord, p.color})
+                    {
+                        if (attribute >= 0 && gltf.accessors[attribute].count < vertexCount)
+                        {
+                            throw std::runtime_error("vertex attribute has fewer elements than POSITION");
+                        }
+                    }
+                    result.primitives.push_back(p);
+                }
+            }
+
+            const JsonValue& nodes = root["nodes"];
+            std::vector<uint32_t> parentCount(nodes.Size(), 0);
+            for (const JsonValue& node : nodes.GetArray())
+            {
+                auto& result = gltf.nodes.emplace_back();
+                result.name = node["name"].AsString();
+                result.mesh = optionalIndex(node["mesh"], gltf.meshes.size(), "mesh");
+                result.matrix = loadNodeMatrix(node);
+
+                for (const JsonValue& child : node["children"].GetArray())
+                {
+                    const uint32_t index = checkedIndex(child, nodes.Size(), "node");
+                    // With a single parent per node and roots without any, walking down from the roots always ends
+                    if (++parentCount[index] > 1) throw std::runtime_error("node has more than one parent");
+                    result.children.push_back(index);
+                }
+            }
+
+            const JsonValue& scenes = root["scenes"];
+            if (scenes.Size() > 0)
+            {
+                const int64_t sceneIndex = root["scene"].AsInt(0);
+                if (sceneIndex < 0 || static_cast<size_t>(sceneIndex) >= scenes.Size()) throw std::runtime_error("invalid scene index");
+
+                const JsonValue& scene = scenes[static_cast<size_t>(sceneIndex)];
+                for (const JsonValue& node : scene["nodes"].GetArray())
+                {
+                    const uint32_t index = checkedIndex(node, nodes.Size(), "node");
+                    if (parentCount[index] == 0) gltf.sceneNodes.push_back(index);
+                }
+            } else
+            {
+                for (uint32_t i = 0; i < parentCount.size(); i++)
+                {
+                    if (parentCount[i] == 0) gltf.sceneNodes.push_back(i);
+                }
+            }
+
+            return gltf;
+        }
+    }
+
+    void GltfData::Accessor::ReadFloats(size_t index, float* out, uint32_t count) const
+    {
+        count = std::min(count, components);
+        if (data == nullptr)
+        {
+            std::fill_n(out, count, 0.0f);
+            return;
+        }
+
+        const uint8_t* element = data + index * stride;
+        for (uint32_t c = 0; c < count; c++)
+        {
+            switch (componentType)
+            {
+                case FLOAT:
+                    std::memcpy(&out[c], element + 4 * c, sizeof(float));
+                    break;
+                case UNSIGNED_BYTE:
+                    out[c] = normalized ? element[c] / 255.0f : element[c];
+                    break;
+                case BYTE:
+                {
+                    const auto value = static_cast<int8_t>(element[c]);
+                    out[c] = normalized ? std::max(value / 127.0f, -1.0f) : value;
+                    break;
+                }
+                case UNSIGNED_SHORT:
+                {
+                    uint16_t value;
+                    std::memcpy(&value, element + 2 * c, sizeof(value));
+                    out[c] = normalized ? value / 65535.0f : value;
+                    break;
+                }
+                case SHORT:
+                {
+                    int16_t value;
+                    std::memcpy(&value, element + 2 * c, sizeof(value));
+                    out[c] = normalized ? std::max(value / 32767.0f, -1.0f) : value;
+                    break;
+                }
+                case UNSIGNED_INT:
+                    out[c] = static_cast<float>(readU32(element + 4 * c));
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    uint32_t GltfData::Accessor::ReadIndex(size_t index) const
+    {
+        if (data == nullptr) return 0;
+
+        const uint8_t* element = data + index * stride;
+        switch (componentType)
+        {
+            case UNSIGNED_BYTE:
+                return *element;
+            case UNSIGNED_SHORT:
+            {
+                uint16_t value;
+                std::memcpy(&value, element, sizeof(value));
+                return value;
+            }
+            case UNSIGNED_INT:
+                return readU32(element);
+            default:
+                throw std::runtime_error("invalid index componentType");
+        }
+    }
+
+    GltfData GltfParser::Parse(const std::string& filepath)
+    {
+        try
+        {
+            return parseDocument(filepath, MappedFile(filepath));
+        } catch (const std::exception& e)
+        {
+            throw std::runtime_error(filepath + ": " + e.what());
+        }
+    }
+
+    bool GltfParser::IsGltfPath(const std::string& filepath)
+    {
+        std::string extension = std::filesystem::path(filepath).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+        return extension == ".gltf" || extension == ".glb";
+    }
+
+    size_t GltfParser::GetVertexCount(const GltfData& gltf, const GltfData::Primitive& primitive)
+    {
+        return gltf.accessors[primitive.position].count;
+    }
+
+    size_t GltfParser::GetIndexCount(const GltfData& gltf, const GltfData::Primitive& primitive)
+    {
+        const size_t count = primitive.indices >= 0 ? gltf.accessors[primitive.indices].count : GetVertexCount(gltf, primitive);
+        return count - count % 3;
+    }
+
+    void GltfParser::CopyVertices(const GltfData& gltf, const GltfData::Primitive& primitive,
+        Model::VertexFormat format, const glm::vec3& center,
+        const glm::vec3& inverseHalfExtent, void* destination)
+    {
+        const GltfData::Accessor& positions = gltf.accessors[primitive.position];
+        const GltfData::Accessor* normals = primitive.normal >= 0 ? &gltf.accessors[primitive.normal] : nullptr;
+        const GltfData::Accessor* texcoords = primitive.texcoord >= 0 ? &gltf.accessors[primitive.texcoord] : nullptr;
+        const GltfData::Accessor* colors = primitive.color >= 0 ? &gltf.accessors[primitive.color] : nullptr;
+
+        auto* fullVertices = static_cast<Model::Vertex*>(destination);
+        auto* packedVertices = static_cast<Model::PackedVertex*>(destination);
+
+        // One pass straight from the mapped buffers into `destination`, which is usually mapped staging memory
+        for (size_t i = 0; i < positions.count; i++)
+        {
+            Model::Vertex vertex{};
+            vertex.color = glm::vec3{1.0f};
+
+            positions.ReadFloats(i, &vertex.position.x, 3);
+            if (normals) normals->ReadFloats(i, &vertex.normal.x, 3);
+            if (texcoords) texcoords->ReadFloats(i, &vertex.uv.x, 2);
+            if (colors) colors->ReadFloats(i, &vertex.color.x, 3);
+
+            if (format == Model::VertexFormat::PACKED)
+            {
+                packedVertices[i] = Model::PackedVertex::Pack(vertex, center, inverseHalfExtent);
+            } else
+            {
+                fullVertices[i] = vertex;
+            }
+        }
+    }
+
+    void GltfParser::CopyIndices(const GltfData& gltf, const GltfData::Primitive& primitive, VkIndexType indexType,
+        void* destination)
+    {
+        const size_t count = GetIndexCount(gltf, primitive);
+        const size_t vertexCount = GetVertexCount(gltf, primitive);
+        const bool shortIndices = indexType == VK_INDEX_TYPE_UINT16;
+        auto* shortDestination = static_cast<uint16_t*>(destination);
+        auto* intDestination = static_cast<uint32_t*>(destination);
+
+        if (primitive.indices < 0)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                if (shortIndices) shortDestination[i] = static_cast<uint16_t>(i);
+                else intDestination[i] = static_cast<uint32_t>(i);
+            }
+            return;
+        }
+
+        const GltfData::Accessor& indices = gltf.accessors[primitive.indices];
+        const uint32_t size = shortIndices ? 2 : 4;
+        uint32_t maxIndex = 0;
+
+        if (indices.data != nullptr && indices.stride == size &&
+            indices.componentType == (shortIndices ? GltfData::UNSIGNED_SHORT : GltfData::UNSIGNED_INT))
+        {
+            // Same width as the GPU buffer, copy the whole range and validate from the (cached) source
+            std::memcpy(destination, indices.data, count * size);
+            for (size_t i = 0; i < count; i++) maxIndex = std::max(maxIndex, indices.ReadIndex(i));
+        } else
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                const uint32_t index = indices.ReadIndex(i);
+                maxIndex = std::max(maxIndex, index);
+                if (shortIndices) shortDestination[i] = static_cast<uint16_t>(index);
+                else intDestination[i] = index;
+            }
+        }
+
+        if (count > 0 && maxIndex >= vertexCount) throw std::runtime_error("glTF index out of range");
+    }
+}
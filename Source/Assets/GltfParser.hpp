@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Common.hpp"
+#include "MappedFile.hpp"
+#include "Model.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VoidEngine
+{
+    // The parts of a glTF 2.0 asset Model consumes: triangle meshes, the node hierarchy of the default
+    // scene and metallic-roughness materials.
+    //
+    // Accessors do not own their data. They point straight into the memory mapped .glb / .bin files (or
+    // the decoded data: URIs) held by the GltfData, so nothing is copied until the GPU upload.
+    struct GltfData
+    {
+        // Accessor component types, as numbered by the spec
+        enum ComponentType : uint32_t
+        {
+            BYTE = 5120,
+            UNSIGNED_BYTE = 5121,
+            SHORT = 5122,
+            UNSIGNED_SHORT = 5123,
+            UNSIGNED_INT = 5125,
+            FLOAT = 5126,
+        };
+
+        struct Accessor
+        {
+            const uint8_t* data = nullptr; // First element, nullptr when the accessor has no buffer view (all zeros)
+            size_t count = 0;
+            size_t stride = 0;             // Bytes between elements
+            uint32_t componentType = FLOAT;
+            uint32_t components = 1;       // 1 for SCALAR up to 4 for VEC4
+            bool normalized = false;
+
+            bool hasBounds = false;        // min / max given in the file
+            float min[4] = {};
+            float max[4] = {};
+
+            // Reads up to `count` components of element `index` as floats, converting normalized integers.
+            // Components the accessor does not have are left untouched.
+            VOIDENGINE_API void ReadFloats(size_t index, float* out, uint32_t count) const;
+            VOIDENGINE_API uint32_t ReadIndex(size_t index) const;
+        };
+
+        struct Primitive
+        {
+            int32_t position = -1; // Accessor indices, -1 when absent
+            int32_t normal = -1;
+            int32_t texcoord = -1;
+            int32_t color = -1;
+            int32_t indices = -1;
+            int32_t material = -1;
+        };
+
+        struct Mesh
+        {
+            std::string name;
+            std::vector<Primitive> primitives; // Triangle lists only, other modes are dropped when parsing
+        };
+
+        struct Node
+        {
+            std::string name;
+            int32_t mesh = -1;
+            glm::mat4 matrix{1.0f};        // Local transform, TRS is composed on load
+            std::vector<uint32_t> children;
+        };
+
+        std::vector<Accessor> accessors;
+        std::vector<Mesh> meshes;
+        std::vector<Node> nodes;
+        std::vector<Model::MaterialDesc> materials;
+        std::vector<uint32_t> sceneNodes; // Root nodes of the default scene
+
+        // Storage the accessors point into
+        std::vector<MappedFile> files;
+        std::vector<std::vector<uint8_t>> decodedBuffers;
+    };
+
+    // Loads .gltf (with .bin files or data: URIs) and .glb files.
+    class GltfParser
+    {
+    public:
+        VOIDENGINE_API static GltfData Parse(const std::string& filepath);
+
+        VOIDENGINE_API static bool IsGltfPath(const std::string& filepath);
+
+        // Writes the vertices of `primitive` into `destination` in `format`, the layout Model uploads.
+        // PACKED positions are quantized with `center` and `inverseHalfExtent`, see Model::PackedVertex::Pack.
+        // Vertex colors are COLOR_0, white if absent. The material's base color is applied when shading.
+        VOIDENGINE_API static void CopyVertices(const GltfData& gltf, const GltfData::Primitive& primitive,
+            Model::VertexFormat format, const glm::vec3& center,
+            const glm::vec3& inverseHalfExtent, void* destination);
+
+        // Writes the indices of `primitive` as 16 or 32-bit values. Non-indexed primitives get 0, 1, 2, ...
+        VOIDENGINE_API static void CopyIndices(const GltfData& gltf, const GltfData::Primitive& primitive,
+            VkIndexType indexType, void* destination);
+
+        VOIDENGINE_API static size_t GetVertexCount(const GltfData& gltf, const GltfData::Primitive& primitive);
+        VOIDENGINE_API static size_t GetIndexCount(const GltfData& gltf, const GltfData::Primitive& primitive);
+    };
+}
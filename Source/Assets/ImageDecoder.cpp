@@ -0,0 +1,606 @@
+#include "ImageDecoder.hpp"
+#include "Inflate.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef VOIDENGINE_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace VoidEngine
+{
+    namespace
+    {
+        constexpr uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+        // Keeps a corrupt header from asking for gigabytes
+        constexpr uint64_t MAX_PIXELS = 1ull << 28;
+
+        [[noreturn]] void fail(const std::string& message)
+        {
+            throw std::runtime_error("ImageDecoder: " + message);
+        }
+
+        uint32_t readBigEndian32(const uint8_t* p)
+        {
+            return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+        }
+
+        uint32_t readLittleEndian32(const uint8_t* p)
+        {
+            return p[0] | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+        }
+
+        uint16_t readLittleEndian16(const uint8_t* p)
+        {
+            return static_cast<uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        void checkDimensions(uint64_t width, uint64_t height)
+        {
+            if (width == 0 || height == 0) fail("image has no pixels");
+            if (width * height > MAX_PIXELS) fail("image too large");
+        }
+
+        struct PngInfo
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t bitDepth = 0;
+            uint32_t colorType = 0;
+            uint32_t channels = 0;
+            bool interlaced = false;
+
+            uint8_t palette[256][4];
+            bool hasColorKey = false;
+            uint16_t colorKey[3] = {};
+
+            uint32_t bitsPerPixel() const { return bitDepth * channels; }
+            // Filters work on whole bytes, pixels smaller than a byte use the previous byte
+            uint32_t filterStride() const { return std::max(1u, bitsPerPixel() / 8); }
+            size_t rowBytes(uint32_t pixels) const { return (size_t(pixels) * bitsPerPixel() + 7) / 8; }
+        };
+
+        uint8_t paeth(int a, int b, int c)
+        {
+            const int pa = std::abs(b - c);
+            const int pb = std::abs(a - c);
+            const int pc = std::abs(a + b - 2 * c);
+            // Written as selects so the compiler can avoid unpredictable branches
+            const int bc = pb <= pc ? b : c;
+            return static_cast<uint8_t>(pa <= pb && pa <= pc ? a : bc);
+        }
+
+#ifdef VOIDENGINE_SSE2
+        // Loads and stores of one 3 or 4 byte pixel, the filters of 8-bit RGB and RGBA rows work a pixel at a time
+        template<uint32_t STRIDE>
+        __m128i loadPixel(const uint8_t* p)
+        {
+            int32_t value = 0;
+            std::memcpy(&value, p, STRIDE);
+            return _mm_cvtsi32_si128(value);
+        }
+
+        template<uint32_t STRIDE>
+        void storePixel(uint8_t* p, __m128i v)
+        {
+            const int32_t value = _mm_cvtsi128_si32(v);
+            std::memcpy(p, &value, STRIDE);
+        }
+
+        template<uint32_t STRIDE>
+        void unfilterSub(uint8_t* row, size_t length)
+        {
+            __m128i a = _mm_setzero_si128();
+            for (size_t i = 0; i < length; i += STRIDE)
+            {
+                a = _mm_add_epi8(loadPixel<STRIDE>(row + i), a);
+                storePixel<STRIDE>(row + i, a);
+            }
+        }
+
+        template<uint32_t STRIDE>
+        void unfilterAverage(uint8_t* row, const uint8_t* previous, size_t length)
+        {
+            // _mm_avg_epu8 rounds up, PNG rounds down
+            const __m128i one = _mm_set1_epi8(1);
+            __m128i a = _mm_setzero_si128();
+            for (size_t i = 0; i < length; i += STRIDE)
+            {
+                const __m128i b = loadPixel<STRIDE>(previous + i);
+                const __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+                a = _mm_add_epi8(loadPixel<STRIDE>(row + i), average);
+                storePixel<STRIDE>(row + i, a);
+            }
+        }
+
+        template<uint32_t STRIDE>
+        void unfilterPaeth(uint8_t* row, const uint8_t* previous, size_t length)
+        {
+            // Predictors in 16-bit lanes, where the differences fit
+            const __m128i zero = _mm_setzero_si128();
+            auto abs16 = [&](__m128i v) { return _mm_max_epi16(v, _mm_sub_epi16(zero, v)); };
+            auto select = [](__m128i mask, __m128i a, __m128i b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); };
+
+            __m128i a = zero;
+            __m128i c = zero;
+            for (size_t i = 0; i < length; i += STRIDE)
+            {
+                const __m128i b = _mm_unpacklo_epi8(loadPixel<STRIDE>(previous + i), zero);
+
+                __m128i pa = _mm_sub_epi16(b, c);
+                __m128i pb = _mm_sub_epi16(a, c);
+                __m128i pc = _mm_add_epi16(pa, pb);
+                pa = abs16(pa);
+                pb = abs16(pb);
+                pc = abs16(pc);
+
+                // Same tie breaking as the scalar version: a, then b, then c
+                const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+                const __m128i predictor = select(_mm_cmpeq_epi16(pa, smallest), a,
+                    select(_mm_cmpeq_epi16(pb, smallest), b, c));
+
+                const __m128i result = _mm_add_epi8(loadPixel<STRIDE>(row + i), _mm_packus_epi16(predictor, predictor));
+                storePixel<STRIDE>(row + i, result);
+
+                a = _mm_unpacklo_epi8(result, zero);
+                c = b;
+            }
+        }
+
+        template<uint32_t STRIDE>
+        bool unfilterRowSimd(uint32_t filter, uint8_t* row, const uint8_t* previous, size_t length)
+        {
+            switch (filter)
+            {
+            case 1: unfilterSub<STRIDE>(row, length); return true;
+            case 3: unfilterAverage<STRIDE>(row, previous, length); return true;
+            case 4: unfilterPaeth<STRIDE>(row, previous, length); return true;
+            default: return false;
+            }
+        }
+#endif
+
+        // Undoes the filter of one row in place. `previous` is the already unfiltered row above, or zeros.
+        void unfilterRow(uint32_t filter, uint8_t* row, const uint8_t* previous, size_t length, uint32_t stride)
+        {
+#ifdef VOIDENGINE_SSE2
+            // Sub, Average and Paeth depend on the previous pixel, so the only parallelism is within one pixel.
+            // Rows of 8-bit RGB(A) pixels are always a whole number of pixels long.
+            if (stride == 4 && unfilterRowSimd<4>(filter, row, previous, length)) return;
+            if (stride == 3 && unfilterRowSimd<3>(filter, row, previous, length)) return;
+#endif
+            switch (filter)
+            {
+            case 0:
+                break;
+            case 1: // Sub
+                for (size_t i = stride; i < length; i++) row[i] = static_cast<uint8_t>(row[i] + row[i - stride]);
+                break;
+            case 2: // Up
+                for (size_t i = 0; i < length; i++) row[i] = static_cast<uint8_t>(row[i] + previous[i]);
+                break;
+            case 3: // Average
+                for (size_t i = 0; i < stride && i < length; i++)
+                {
+                    row[i] = static_cast<uint8_t>(row[i] + (previous[i] >> 1));
+                }
+                for (size_t i = stride; i < length; i++)
+                {
+                    row[i] = static_cast<uint8_t>(row[i] + ((row[i - stride] + previous[i]) >> 1));
+                }
+                break;
+            case 4: // Paeth, with a and c zero the predictor is just the byte above
+                for (size_t i = 0; i < stride && i < length; i++)
+                {
+                    row[i] = static_cast<uint8_t>(row[i] + previous[i]);
+                }
+                for (size_t i = stride; i < length; i++)
+                {
+                    row[i] = static_cast<uint8_t>(row[i] + paeth(row[i - stride], previous[i], previous[i - stride]));
+                }
+                break;
+            default:
+                fail("invalid PNG filter type");
+            }
+        }
+
+        // Sample `index` of a row at bit depths other than 8, at its original precision
+        uint32_t sample(const uint8_t* row, size_t index, uint32_t bitDepth)
+        {
+            if (bitDepth == 16) return (uint32_t(row[index * 2]) << 8) | row[index * 2 + 1];
+
+            const size_t bit = index * bitDepth;
+            const uint32_t shift = 8 - bitDepth - static_cast<uint32_t>(bit & 7);
+            return (row[bit / 8] >> shift) & ((1u << bitDepth) - 1);
+        }
+
+        // Converts an unfiltered row to RGBA8
+        void expandRow(const PngInfo& info, const uint8_t* row, uint32_t width, uint8_t* out)
+        {
+            if (info.colorType == 3)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    const uint32_t index = info.bitDepth == 8 ? row[x] : sample(row, x, info.bitDepth);
+                    std::memcpy(out + x * 4, info.palette[index], 4);
+                }
+                return;
+            }
+
+            if (info.bitDepth == 8)
+            {
+                switch (info.colorType)
+                {
+                case 6:
+                    std::memcpy(out, row, size_t(width) * 4);
+                    return;
+                case 2:
+                    for (uint32_t x = 0; x < width; x++)
+                    {
+                        const uint8_t* p = row + x * 3;
+                        out[x * 4 + 0] = p[0];
+                        out[x * 4 + 1] = p[1];
+                        out[x * 4 + 2] = p[2];
+                        out[x * 4 + 3] = info.hasColorKey && p[0] == info.colorKey[0] && p[1] == info.colorKey[1] &&
+                            p[2] == info.colorKey[2] ? 0 : 255;
+                    }
+                    return;
+                case 0:
+                    for (uint32_t x = 0; x < width; x++)
+                    {
+                        out[x * 4 + 0] = out[x * 4 + 1] = out[x * 4 + 2] = row[x];
+                        out[x * 4 + 3] = info.hasColorKey && row[x] == info.colorKey[0] ? 0 : 255;
+                    }
+                    return;
+                case 4:
+                    for (uint32_t x = 0; x < width; x++)
+                    {
+                        out[x * 4 + 0] = out[x * 4 + 1] = out[x * 4 + 2] = row[x * 2];
+                        out[x * 4 + 3] = row[x * 2 + 1];
+                    }
+                    return;
+                }
+            }
+
+            // 16-bit channels keep their high byte, 1 to 4-bit gray is scaled up to the full range
+            const uint32_t maxValue = (1u << info.bitDepth) - 1;
+            auto to8 = [&](uint32_t value)
+            {
+                return static_cast<uint8_t>(info.bitDepth == 16 ? value >> 8 : value * 255 / maxValue);
+            };
+
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint32_t values[4];
+                for (uint32_t c = 0; c < info.channels; c++) values[c] = sample(row, size_t(x) * info.channels + c, info.bitDepth);
+
+                uint8_t* p = out + x * 4;
+                switch (info.colorType)
+                {
+                case 0:
+                    p[0] = p[1] = p[2] = to8(values[0]);
+                    p[3] = info.hasColorKey && values[0] == info.colorKey[0] ? 0 : 255;
+                    break;
+                case 2:
+                    p[0] = to8(values[0]);
+                    p[1] = to8(values[1]);
+                    p[2] = to8(values[2]);
+                    p[3] = info.hasColorKey && values[0] == info.colorKey[0] && values[1] == info.colorKey[1] &&
+                        values[2] == info.colorKey[2] ? 0 : 255;
+                    break;
+                case 4:
+                    p[0] = p[1] = p[2] = to8(values[0]);
+                    p[3] = to8(values[1]);
+                    break;
+                case 6:
+                    p[0] = to8(values[0]);
+                    p[1] = to8(values[1]);
+                    p[2] = to8(values[2]);
+                    p[3] = to8(values[3]);
+                    break;
+                }
+            }
+        }
+
+        // Unfilters a (sub)image of filtered rows in place and hands each finished row to `emit`
+        template<typename F>
+        void unfilterImage(const PngInfo& info, uint8_t* data, uint32_t width, uint32_t height, F&& emit)
+        {
+            const size_t rowBytes = info.rowBytes(width);
+            const std::vector<uint8_t> zeros(rowBytes, 0);
+
+            const uint8_t* previous = zeros.data();
+            for (uint32_t y = 0; y < height; y++)
+            {
+                uint8_t* row = data + y * (rowBytes + 1);
+                unfilterRow(row[0], row + 1, previous, rowBytes, info.filterStride());
+                emit(y, row + 1);
+                previous = row + 1;
+            }
+        }
+
+        void checkPngFormat(const PngInfo& info)
+        {
+            bool valid = false;
+            switch (info.colorType)
+            {
+            case 0: valid = info.bitDepth == 1 || info.bitDepth == 2 || info.bitDepth == 4 || info.bitDepth == 8 || info.bitDepth == 16; break;
+            case 3: valid = info.bitDepth == 1 || info.bitDepth == 2 || info.bitDepth == 4 || info.bitDepth == 8; break;
+            case 2: case 4: case 6: valid = info.bitDepth == 8 || info.bitDepth == 16; break;
+            default: break;
+            }
+            if (!valid) fail("invalid PNG color type and bit depth");
+        }
+
+        Image decodePng(const uint8_t* data, size_t size)
+        {
+            PngInfo info;
+            for (auto& entry : info.palette)
+            {
+                entry[0] = entry[1] = entry[2] = 0;
+                entry[3] = 255;
+            }
+
+            std::vector<std::pair<const uint8_t*, size_t>> idat;
+            size_t idatSize = 0;
+            bool sawHeader = false;
+
+            size_t offset = sizeof(PNG_SIGNATURE);
+            while (true)
+            {
+                if (size - offset < 12) fail("truncated PNG");
+                const uint32_t length = readBigEndian32(data + offset);
+                const uint8_t* type = data + offset + 4;
+                const uint8_t* chunk = data + offset + 8;
+                if (length > size - offset - 12) fail("truncated PNG chunk");
+                offset += size_t(length) + 12;
+
+                if (std::memcmp(type, "IHDR", 4) == 0)
+                {
+                    if (length != 13) fail("invalid IHDR");
+                    info.width = readBigEndian32(chunk);
+                    info.height = readBigEndian32(chunk + 4);
+                    info.bitDepth = chunk[8];
+                    info.colorType = chunk[9];
+                    if (chunk[10] != 0 || chunk[11] != 0) fail("unknown PNG compression or filter method");
+                    if (chunk[12] > 1) fail("unknown PNG interlace method");
+                    info.interlaced = chunk[12] == 1;
+
+                    checkDimensions(info.width, info.height);
+                    checkPngFormat(info);
+                    constexpr uint32_t CHANNELS[7] = {1, 0, 3, 1, 2, 0, 4};
+                    info.channels = CHANNELS[info.colorType];
+                    sawHeader = true;
+                    continue;
+                }
+                if (!sawHeader) fail("PNG does not start with IHDR");
+
+                if (std::memcmp(type, "PLTE", 4) == 0)
+                {
+                    if (length % 3 != 0 || length > 256 * 3) fail("invalid PLTE");
+                    for (uint32_t i = 0; i < length / 3; i++) std::memcpy(info.palette[i], chunk + i * 3, 3);
+                } else if (std::memcmp(type, "tRNS", 4) == 0)
+                {
+                    if (info.colorType == 3)
+                    {
+                        if (length > 256) fail("invalid tRNS");
+                        for (uint32_t i = 0; i < length; i++) info.palette[i][3] = chunk[i];
+                    } else if (info.colorType == 0 || info.colorType == 2)
+                    {
+                        const uint32_t samples = info.colorType == 0 ? 1 : 3;
+                        if (length != samples * 2) fail("invalid tRNS");
+                        for (uint32_t i = 0; i < samples; i++)
+                        {
+                            info.colorKey[i] = static_cast<uint16_t>((chunk[i * 2] << 8) | chunk[i * 2 + 1]);
+                        }
+                        info.hasColorKey = true;
+                    }
+                } else if (std::memcmp(type, "IDAT", 4) == 0)
+                {
+                    idat.emplace_back(chunk, length);
+                    idatSize += length;
+                } else if (std::memcmp(type, "IEND", 4) == 0)
+                {
+                    break;
+                } else if (!(type[0] & 0x20))
+                {
+                    // Lowercase first letter marks chunks that are safe to ignore
+                    fail("unknown critical PNG chunk " + std::string(reinterpret_cast<const char*>(type), 4));
+                }
+            }
+            if (idat.empty()) fail("PNG has no image data");
+
+            // Each row is prefixed by its filter type
+            constexpr uint32_t PASS_X[7] = {0, 4, 0, 2, 0, 1, 0};
+            constexpr uint32_t PASS_Y[7] = {0, 0, 4, 0, 2, 0, 1};
+            constexpr uint32_t PASS_DX[7] = {8, 8, 4, 4, 2, 2, 1};
+            constexpr uint32_t PASS_DY[7] = {8, 8, 8, 4, 4, 2, 2};
+            uint32_t passWidth[7] = {};
+            uint32_t passHeight[7] = {};
+
+            size_t rawSize = 0;
+            if (info.interlaced)
+            {
+                for (int pass = 0; pass < 7; pass++)
+                {
+                    if (info.width > PASS_X[pass]) passWidth[pass] = (info.width - PASS_X[pass] + PASS_DX[pass] - 1) / PASS_DX[pass];
+                    if (info.height > PASS_Y[pass]) passHeight[pass] = (info.height - PASS_Y[pass] + PASS_DY[pass] - 1) / PASS_DY[pass];
+                    // Empty passes have no filter bytes either
+                    if (passWidth[pass] > 0 && passHeight[pass] > 0)
+                    {
+                        rawSize += (info.rowBytes(passWidth[pass]) + 1) * passHeight[pass];
+                    }
+                }
+            } else
+            {
+                rawSize = (info.rowBytes(info.width) + 1) * info.height;
+            }
+
+            // Usually there are several IDAT chunks, inflate wants them back to back
+            std::vector<uint8_t> joined;
+            const uint8_t* compressed = idat[0].first;
+            if (idat.size() > 1)
+            {
+                joined.reserve(idatSize);
+                for (const auto& [chunk, length] : idat) joined.insert(joined.end(), chunk, chunk + length);
+                compressed = joined.data();
+            }
+
+            std::vector<uint8_t> raw(rawSize);
+            if (Inflate::Zlib(compressed, idatSize, raw.data(), raw.size()) != rawSize) fail("PNG image data too short");
+
+            Image image;
+            image.width = info.width;
+            image.height = info.height;
+            image.pixels.resize(size_t(info.width) * info.height * 4);
+
+            if (!info.interlaced)
+            {
+                unfilterImage(info, raw.data(), info.width, info.height, [&](uint32_t y, const uint8_t* row)
+                {
+                    expandRow(info, row, info.width, image.pixels.data() + size_t(y) * info.width * 4);
+                });
+                return image;
+            }
+
+            std::vector<uint8_t> expanded(size_t(info.width) * 4);
+            uint8_t* pass = raw.data();
+            for (int p = 0; p < 7; p++)
+            {
+                if (passWidth[p] == 0 || passHeight[p] == 0) continue;
+
+                unfilterImage(info, pass, passWidth[p], passHeight[p], [&](uint32_t y, const uint8_t* row)
+                {
+                    expandRow(info, row, passWidth[p], expanded.data());
+                    uint8_t* destination = image.pixels.data() + (size_t(PASS_Y[p] + y * PASS_DY[p]) * info.width + PASS_X[p]) * 4;
+                    for (uint32_t x = 0; x < passWidth[p]; x++)
+                    {
+                        std::memcpy(destination + size_t(x) * PASS_DX[p] * 4, expanded.data() + size_t(x) * 4, 4);
+                    }
+                });
+                pass += (info.rowBytes(passWidth[p]) + 1) * passHeight[p];
+            }
+            return image;
+        }
+
+        uint32_t maskShift(uint32_t mask)
+        {
+            uint32_t shift = 0;
+            while (mask != 0 && !(mask & 1))
+            {
+                mask >>= 1;
+                shift++;
+            }
+            return shift;
+        }
+
+        Image decodeBmp(const uint8_t* data, size_t size)
+        {
+            if (size < 54) fail("truncated BMP");
+
+            const uint32_t pixelOffset = readLittleEndian32(data + 10);
+            const uint32_t headerSize = readLittleEndian32(data + 14);
+            const auto width = static_cast<int32_t>(readLittleEndian32(data + 18));
+            const auto height = static_cast<int32_t>(readLittleEndian32(data + 22));
+            const uint32_t bitsPerPixel = readLittleEndian16(data + 28);
+            const uint32_t compression = readLittleEndian32(data + 30);
+
+            if (headerSize < 40) fail("unsupported BMP header");
+            if (bitsPerPixel != 24 && bitsPerPixel != 32) fail("only 24 and 32-bit BMPs are supported");
+
+            // BI_RGB, or BI_BITFIELDS with the masks right after the 40 byte header
+            uint32_t masks[4] = {0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000};
+            if (compression == 3 && bitsPerPixel == 32)
+            {
+                if (size < 14 + 40 + 16) fail("truncated BMP");
+                for (int i = 0; i < 3; i++) masks[i] = readLittleEndian32(data + 54 + i * 4);
+                masks[3] = headerSize >= 56 ? readLittleEndian32(data + 54 + 12) : 0;
+            } else if (compression != 0)
+            {
+                fail("compressed BMPs are not supported");
+            }
+
+            if (width <= 0 || height == 0 || height == INT32_MIN) fail("invalid BMP dimensions");
+            const uint32_t rows = static_cast<uint32_t>(height < 0 ? -height : height);
+            checkDimensions(static_cast<uint32_t>(width), rows);
+
+            const size_t stride = (size_t(width) * bitsPerPixel + 31) / 32 * 4;
+            if (pixelOffset > size || size - pixelOffset < stride * rows) fail("truncated BMP pixel data");
+
+            Image image;
+            image.width = static_cast<uint32_t>(width);
+            image.height = rows;
+            image.pixels.resize(size_t(image.width) * rows * 4);
+
+            uint32_t shifts[4];
+            for (int i = 0; i < 4; i++) shifts[i] = maskShift(masks[i]);
+
+            bool anyAlpha = false;
+            for (uint32_t y = 0; y < rows; y++)
+            {
+                // Positive heights are stored bottom-up
+                const uint8_t* row = data + pixelOffset + stride * (height > 0 ? rows - 1 - y : y);
+                uint8_t* out = image.pixels.data() + size_t(y) * image.width * 4;
+                for (uint32_t x = 0; x < image.width; x++)
+                {
+                    if (bitsPerPixel == 24)
+                    {
+                        out[x * 4 + 0] = row[x * 3 + 2];
+                        out[x * 4 + 1] = row[x * 3 + 1];
+                        out[x * 4 + 2] = row[x * 3 + 0];
+                        out[x * 4 + 3] = 255;
+                        continue;
+                    }
+
+                    const uint32_t value = readLittleEndian32(row + x * 4);
+                    for (int c = 0; c < 4; c++)
+                    {
+                        out[x * 4 + c] = static_cast<uint8_t>((value & masks[c]) >> shifts[c]);
+                    }
+                    anyAlpha |= out[x * 4 + 3] != 0;
+                }
+            }
+
+            // Most writers leave the fourth byte at zero instead of meaning fully transparent
+            if (bitsPerPixel == 32 && !anyAlpha)
+            {
+                for (size_t i = 3; i < image.pixels.size(); i += 4) image.pixels[i] = 255;
+            }
+            return image;
+        }
+    }
+
+    Image ImageDecoder::Load(const std::string& filepath)
+    {
+        const MappedFile file(filepath);
+        try
+        {
+            return Decode(file.data(), file.size());
+        } catch (const std::exception& e)
+        {
+            throw std::runtime_error(filepath + ": " + e.what());
+        }
+    }
+
+    Image ImageDecoder::Decode(const uint8_t* data, size_t size)
+    {
+        if (IsPng(data, size)) return decodePng(data, size);
+        if (IsBmp(data, size)) return decodeBmp(data, size);
+        fail("unknown image format");
+    }
+
+    bool ImageDecoder::IsPng(const uint8_t* data, size_t size)
+    {
+        return size >= sizeof(PNG_SIGNATURE) && std::memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0;
+    }
+
+    bool ImageDecoder::IsBmp(const uint8_t* data, size_t size)
+    {
+        return size >= 2 && data[0] == 'B' && data[1] == 'M';
+    }
+}
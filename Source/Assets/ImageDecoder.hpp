@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Decoded image, always 8-bit RGBA with rows top to bottom
+    struct Image
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    // Decodes PNG and uncompressed BMP images. The format is detected from the data, not the file extension,
+    // some of the sample textures are bitmaps saved as .png.
+    //
+    // PNG: every color type and bit depth, palettes, tRNS transparency and Adam7 interlacing. 16-bit channels
+    // are truncated to 8 bits and gamma/color profile chunks are ignored. Chunk CRCs are not checked.
+    // BMP: 24 and 32-bit uncompressed, bottom-up or top-down.
+    class ImageDecoder
+    {
+    public:
+        VOIDENGINE_API static Image Load(const std::string& filepath);
+        VOIDENGINE_API static Image Decode(const uint8_t* data, size_t size);
+
+        VOIDENGINE_API static bool IsPng(const uint8_t* data, size_t size);
+        VOIDENGINE_API static bool IsBmp(const uint8_t* data, size_t size);
+    };
+}
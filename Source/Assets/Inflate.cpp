@@ -0,0 +1,363 @@
+#include "Inflate.hpp"
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace VoidEngine
+{
+    namespace
+    {
+        static_assert(std::endian::native == std::endian::little, "BitReader loads the stream 8 bytes at a time");
+
+        // Codes up to this length are decoded with a single table lookup, longer ones are rare
+        constexpr uint32_t FAST_BITS = 10;
+        constexpr uint32_t FAST_MASK = (1u << FAST_BITS) - 1;
+        constexpr uint32_t MAX_CODE_LENGTH = 15;
+
+        constexpr uint16_t LENGTH_BASE[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        constexpr uint8_t LENGTH_EXTRA[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        constexpr uint16_t DISTANCE_BASE[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        constexpr uint8_t DISTANCE_EXTRA[30] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+        constexpr uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+        [[noreturn]] void fail(const char* message)
+        {
+            throw std::runtime_error(std::string("Inflate: ") + message);
+        }
+
+        uint32_t reverseBits(uint32_t code, uint32_t length)
+        {
+            uint32_t result = 0;
+            for (uint32_t i = 0; i < length; i++)
+            {
+                result = (result << 1) | (code & 1);
+                code >>= 1;
+            }
+            return result;
+        }
+
+        // Canonical Huffman code. Short codes come from `fast`, indexed by the next FAST_BITS stream bits, which
+        // holds symbol << 4 | length. Longer ones are found by comparing the bit reversed code against the
+        // last code of each length, like stb_image does.
+        struct Huffman
+        {
+            uint16_t fast[1u << FAST_BITS];
+            uint32_t maxCode[MAX_CODE_LENGTH + 2];   // One past the last code of each length, left aligned to 16 bits
+            uint16_t firstCode[MAX_CODE_LENGTH + 1];
+            uint16_t firstSymbol[MAX_CODE_LENGTH + 1];
+            uint16_t symbols[288];                    // Sorted by code
+
+            void build(const uint8_t* lengths, uint32_t count)
+            {
+                uint32_t lengthCounts[MAX_CODE_LENGTH + 1] = {};
+                for (uint32_t i = 0; i < count; i++) lengthCounts[lengths[i]]++;
+                lengthCounts[0] = 0;
+
+                uint32_t nextCode[MAX_CODE_LENGTH + 1] = {};
+                uint32_t code = 0;
+                uint32_t symbol = 0;
+                for (uint32_t length = 1; length <= MAX_CODE_LENGTH; length++)
+                {
+                    nextCode[length] = code;
+                    firstCode[length] = static_cast<uint16_t>(code);
+                    firstSymbol[length] = static_cast<uint16_t>(symbol);
+                    code += lengthCounts[length];
+                    // Incomplete codes are legal, oversubscribed ones are not
+                    if (code > (1u << length)) fail("oversubscribed Huffman code");
+                    maxCode[length] = code << (16 - length);
+                    code <<= 1;
+                    symbol += lengthCounts[length];
+                }
+                maxCode[MAX_CODE_LENGTH + 1] = 0x10000;
+
+                std::memset(fast, 0, sizeof(fast));
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const uint32_t length = lengths[i];
+                    if (length == 0) continue;
+
+                    symbols[nextCode[length] - firstCode[length] + firstSymbol[length]] = static_cast<uint16_t>(i);
+                    if (length <= FAST_BITS)
+                    {
+                        const auto entry = static_cast<uint16_t>((i << 4) | length);
+                        for (uint32_t j = reverseBits(nextCode[length], length); j < (1u << FAST_BITS); j += 1u << length)
+                        {
+                            fast[j] = entry;
+                        }
+                    }
+                    nextCode[length]++;
+                }
+            }
+        };
+
+        class BitReader
+        {
+        public:
+            BitReader(const uint8_t* data, size_t size) : cursor(data), end(data + size) {}
+
+            // Tops the buffer up to at least 56 bits. Past the end of the input zeros are shifted in and counted,
+            // see truncated().
+            void refill()
+            {
+                if (end - cursor >= 8)
+                {
+                    uint64_t word;
+                    std::memcpy(&word, cursor, sizeof(word));
+                    bits |= word << count;
+                    cursor += (63 - count) >> 3;
+                    count |= 56;
+                    return;
+                }
+                while (count <= 56)
+                {
+                    uint64_t byte = 0;
+                    if (cursor < end) byte = *cursor++;
+                    else padding++;
+                    bits |= byte << count;
+                    count += 8;
+                }
+            }
+
+            uint32_t peek(uint32_t n) const { return static_cast<uint32_t>(bits & ((1ull << n) - 1)); }
+
+            void consume(uint32_t n)
+            {
+                bits >>= n;
+                count -= n;
+            }
+
+            // Up to 32 bits, refill() must have been called since enough bits were consumed
+            uint32_t read(uint32_t n)
+            {
+                const uint32_t value = peek(n);
+                consume(n);
+                return value;
+            }
+
+            uint32_t decode(const Huffman& huffman)
+            {
+                const uint32_t entry = huffman.fast[bits & FAST_MASK];
+                if (entry != 0)
+                {
+                    consume(entry & 15);
+                    return entry >> 4;
+                }
+
+                const uint32_t code = reverseBits(peek(16), 16);
+                uint32_t length = FAST_BITS + 1;
+                while (code >= huffman.maxCode[length]) length++;
+                if (length > MAX_CODE_LENGTH) fail("invalid Huffman code");
+
+                consume(length);
+                return huffman.symbols[(code >> (16 - length)) - huffman.firstCode[length] + huffman.firstSymbol[length]];
+            }
+
+            // Drops the bits up to the next byte boundary and returns the unread input from there
+            const uint8_t* alignToByte()
+            {
+                consume(count & 7);
+                // Whole bytes still in the buffer go back to the input
+                const uint32_t buffered = count / 8;
+                const uint32_t real = buffered > padding ? buffered - padding : 0;
+                padding = buffered > padding ? 0 : padding - buffered;
+                cursor -= real;
+                bits = 0;
+                count = 0;
+                return cursor;
+            }
+
+            void skipTo(const uint8_t* position) { cursor = position; }
+
+            size_t remaining() const { return static_cast<size_t>(end - cursor); }
+
+            // True once bits past the end of the input have been consumed
+            bool truncated() const { return padding * 8 > count; }
+
+        private:
+            const uint8_t* cursor;
+            const uint8_t* end;
+            uint64_t bits = 0;
+            uint32_t count = 0;
+            uint32_t padding = 0;
+        };
+
+        void readDynamicCodes(BitReader& reader, Huffman& literals, Huffman& distances)
+        {
+            reader.refill();
+            const uint32_t literalCount = reader.read(5) + 257;
+            const uint32_t distanceCount = reader.read(5) + 1;
+            const uint32_t codeLengthCount = reader.read(4) + 4;
+            if (literalCount > 286 || distanceCount > 30) fail("invalid code counts");
+
+            uint8_t codeLengthLengths[19] = {};
+            for (uint32_t i = 0; i < codeLengthCount; i++)
+            {
+                reader.refill();
+                codeLengthLengths[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(reader.read(3));
+            }
+            Huffman codeLengths;
+            codeLengths.build(codeLengthLengths, 19);
+
+            uint8_t lengths[286 + 30] = {};
+            const uint32_t total = literalCount + distanceCount;
+            for (uint32_t i = 0; i < total;)
+            {
+                reader.refill();
+                const uint32_t symbol = reader.decode(codeLengths);
+                if (symbol < 16)
+                {
+                    lengths[i++] = static_cast<uint8_t>(symbol);
+                    continue;
+                }
+
+                uint32_t repeat;
+                uint8_t value = 0;
+                if (symbol == 16)
+                {
+                    if (i == 0) fail("repeated code length without a previous one");
+                    value = lengths[i - 1];
+                    repeat = 3 + reader.read(2);
+                } else if (symbol == 17)
+                {
+                    repeat = 3 + reader.read(3);
+                } else
+                {
+                    repeat = 11 + reader.read(7);
+                }
+                if (i + repeat > total) fail("code lengths overflow");
+                std::memset(lengths + i, value, repeat);
+                i += repeat;
+            }
+            if (lengths[256] == 0) fail("missing end of block code");
+
+            literals.build(lengths, literalCount);
+            distances.build(lengths + literalCount, distanceCount);
+        }
+
+        void buildFixedCodes(Huffman& literals, Huffman& distances)
+        {
+            uint8_t lengths[288];
+            std::memset(lengths, 8, 144);
+            std::memset(lengths + 144, 9, 112);
+            std::memset(lengths + 256, 7, 24);
+            std::memset(lengths + 280, 8, 8);
+            literals.build(lengths, 288);
+
+            std::memset(lengths, 5, 32);
+            distances.build(lengths, 32);
+        }
+
+        size_t inflateBlocks(BitReader& reader, uint8_t* destination, size_t capacity)
+        {
+            // Big enough to not matter on the stack of a worker thread, and rebuilt per block anyway
+            Huffman literals;
+            Huffman distances;
+            bool fixedBuilt = false;
+
+            size_t written = 0;
+            bool last = false;
+            while (!last)
+            {
+                reader.refill();
+                last = reader.read(1) != 0;
+                const uint32_t type = reader.read(2);
+
+                if (type == 0)
+                {
+                    const uint8_t* input = reader.alignToByte();
+                    if (reader.remaining() < 4) fail("truncated stored block");
+                    const uint32_t length = input[0] | (input[1] << 8);
+                    const uint32_t inverse = input[2] | (input[3] << 8);
+                    if ((length ^ 0xFFFF) != inverse) fail("corrupt stored block length");
+                    if (reader.remaining() - 4 < length) fail("truncated stored block");
+                    if (capacity - written < length) fail("output larger than expected");
+
+                    std::memcpy(destination + written, input + 4, length);
+                    written += length;
+                    reader.skipTo(input + 4 + length);
+                    continue;
+                }
+
+                if (type == 1)
+                {
+                    // The fixed tables are the same for every block, build them once
+                    if (!fixedBuilt) buildFixedCodes(literals, distances);
+                    fixedBuilt = true;
+                } else if (type == 2)
+                {
+                    readDynamicCodes(reader, literals, distances);
+                    fixedBuilt = false;
+                } else
+                {
+                    fail("invalid block type");
+                }
+
+                while (true)
+                {
+                    // 56 bits cover the longest literal/length code, its extra bits, distance code and extra bits
+                    reader.refill();
+                    const uint32_t symbol = reader.decode(literals);
+                    if (symbol < 256)
+                    {
+                        if (written == capacity) fail("output larger than expected");
+                        destination[written++] = static_cast<uint8_t>(symbol);
+                        continue;
+                    }
+                    if (symbol == 256) break;
+                    if (symbol > 285) fail("invalid length code");
+
+                    const uint32_t lengthCode = symbol - 257;
+                    const size_t length = LENGTH_BASE[lengthCode] + reader.read(LENGTH_EXTRA[lengthCode]);
+
+                    const uint32_t distanceCode = reader.decode(distances);
+                    if (distanceCode >= 30) fail("invalid distance code");
+                    const size_t distance = DISTANCE_BASE[distanceCode] + reader.read(DISTANCE_EXTRA[distanceCode]);
+
+                    if (distance > written) fail("distance before the start of the output");
+                    if (capacity - written < length) fail("output larger than expected");
+
+                    uint8_t* out = destination + written;
+                    const uint8_t* from = out - distance;
+                    if (distance >= length)
+                    {
+                        std::memcpy(out, from, length);
+                    } else
+                    {
+                        // Overlapping, repeats the last `distance` bytes
+                        for (size_t i = 0; i < length; i++) out[i] = from[i];
+                    }
+                    written += length;
+                }
+
+                if (reader.truncated()) fail("truncated stream");
+            }
+            return written;
+        }
+    }
+
+    size_t Inflate::Zlib(const uint8_t* data, size_t size, uint8_t* destination, size_t capacity)
+    {
+        if (size < 2) fail("truncated zlib header");
+
+        const uint32_t method = data[0];
+        const uint32_t flags = data[1];
+        if ((method & 15) != 8 || (method >> 4) > 7) fail("unsupported compression method");
+        if ((method * 256 + flags) % 31 != 0) fail("corrupt zlib header");
+        if (flags & 0x20) fail("preset dictionaries are not supported");
+
+        return Raw(data + 2, size - 2, destination, capacity);
+    }
+
+    size_t Inflate::Raw(const uint8_t* data, size_t size, uint8_t* destination, size_t capacity)
+    {
+        BitReader reader(data, size);
+        return inflateBlocks(reader, destination, capacity);
+    }
+}
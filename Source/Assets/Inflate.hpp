@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace VoidEngine
+{
+    // DEFLATE decompressor (RFC 1950/1951) for image data. The output size is known up front for PNG, so it
+    // decodes straight into a caller owned buffer instead of growing one.
+    class Inflate
+    {
+    public:
+        // Decompresses a zlib stream into `destination` and returns the number of bytes written. Throws
+        // std::runtime_error on malformed or truncated data and when the output doesn't fit. The Adler-32
+        // trailer is not verified.
+        VOIDENGINE_API static size_t Zlib(const uint8_t* data, size_t size, uint8_t* destination, size_t capacity);
+
+        // Same for a raw DEFLATE stream without the zlib header
+        VOIDENGINE_API static size_t Raw(const uint8_t* data, size_t size, uint8_t* destination, size_t capacity);
+    };
+}
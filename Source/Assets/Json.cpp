@@ -0,0 +1,282 @@
+#include "Json.hpp"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace VoidEngine
+{
+    namespace
+    {
+        const JsonValue NULL_VALUE{};
+
+        // Nesting deep enough for any sane asset, shallow enough to never overflow the stack
+        constexpr int MAX_DEPTH = 256;
+
+        void appendUtf8(std::string& out, uint32_t codepoint)
+        {
+            if (codepoint < 0x80)
+            {
+                out += static_cast<char>(codepoint);
+            } else if (codepoint < 0x800)
+            {
+                out += static_cast<char>(0xC0 | (codepoint >> 6));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            } else if (codepoint < 0x10000)
+            {
+                out += static_cast<char>(0xE0 | (codepoint >> 12));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            } else
+            {
+                out += static_cast<char>(0xF0 | (codepoint >> 18));
+                out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            }
+        }
+    }
+
+    // Recursive descent over the raw buffer
+    class JsonReader
+    {
+    public:
+        JsonReader(const char* data, size_t size) : begin(data), p(data), end(data + size) {}
+
+        JsonValue ReadDocument()
+        {
+            JsonValue value = readValue(0);
+            skipWhitespace();
+            if (p != end) fail("trailing characters");
+            return value;
+        }
+
+    private:
+        [[noreturn]] void fail(const char* what) const
+        {
+            throw std::runtime_error("JSON: " + std::string(what) + " at offset " + std::to_string(p - begin));
+        }
+
+        void skipWhitespace()
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+        }
+
+        void expect(const char* literal)
+        {
+            for (const char* c = literal; *c; c++, p++)
+            {
+                if (p >= end || *p != *c) fail("invalid literal");
+            }
+        }
+
+        JsonValue readValue(int depth)
+        {
+            if (depth > MAX_DEPTH) fail("nesting too deep");
+
+            skipWhitespace();
+            if (p >= end) fail("unexpected end of input");
+
+            JsonValue value;
+            switch (*p)
+            {
+                case '{':
+                    value.type = JsonValue::Type::OBJECT;
+                    readObject(value, depth);
+                    break;
+                case '[':
+                    value.type = JsonValue::Type::ARRAY;
+                    readArray(value, depth);
+                    break;
+                case '"':
+                    value.type = JsonValue::Type::STRING;
+                    value.string = readString();
+                    break;
+                case 't':
+                    expect("true");
+                    value.type = JsonValue::Type::BOOLEAN;
+                    value.boolean = true;
+                    break;
+                case 'f':
+                    expect("false");
+                    value.type = JsonValue::Type::BOOLEAN;
+                    break;
+                case 'n':
+                    expect("null");
+                    break;
+                default:
+                    value.type = JsonValue::Type::NUMBER;
+                    value.number = readNumber();
+                    break;
+            }
+            return value;
+        }
+
+        void readObject(JsonValue& value, int depth)
+        {
+            p++; // {
+            skipWhitespace();
+            if (p < end && *p == '}')
+            {
+                p++;
+                return;
+            }
+
+            while (true)
+            {
+                skipWhitespace();
+                if (p >= end || *p != '"') fail("expected object key");
+                std::string key = readString();
+
+                skipWhitespace();
+                if (p >= end || *p != ':') fail("expected ':'");
+                p++;
+
+                value.members.emplace_back(std::move(key), readValue(depth + 1));
+
+                skipWhitespace();
+                if (p >= end) fail("unterminated object");
+                if (*p == ',')
+                {
+                    p++;
+                    continue;
+                }
+                if (*p == '}')
+                {
+                    p++;
+                    return;
+                }
+                fail("expected ',' or '}'");
+            }
+        }
+
+        void readArray(JsonValue& value, int depth)
+        {
+            p++; // [
+            skipWhitespace();
+            if (p < end && *p == ']')
+            {
+                p++;
+                return;
+            }
+
+            while (true)
+            {
+                value.array.push_back(readValue(depth + 1));
+
+                skipWhitespace();
+                if (p >= end) fail("unterminated array");
+                if (*p == ',')
+                {
+                    p++;
+                    continue;
+                }
+                if (*p == ']')
+                {
+                    p++;
+                    return;
+                }
+                fail("expected ',' or ']'");
+            }
+        }
+
+        uint32_t readHex4()
+        {
+            if (end - p < 4) fail("truncated \\u escape");
+
+            uint32_t result = 0;
+            for (int i = 0; i < 4; i++, p++)
+            {
+                const char c = *p;
+                result <<= 4;
+                if (c >= '0' && c <= '9') result |= c - '0';
+                else if (c >= 'a' && c <= 'f') result |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F') result |= c - 'A' + 10;
+                else fail("invalid \\u escape");
+            }
+            return result;
+        }
+
+        std::string readString()
+        {
+            p++; // opening quote
+            std::string result;
+
+            while (true)
+            {
+                // Copy unescaped runs in one go, most strings have no escapes at all
+                const char* run = p;
+                while (p < end && *p != '"' && *p != '\\') p++;
+                result.append(run, p);
+
+                if (p >= end) fail("unterminated string");
+                if (*p++ == '"') return result;
+
+                if (p >= end) fail("unterminated string");
+                switch (*p++)
+                {
+                    case '"': result += '"'; break;
+                    case '\\': result += '\\'; break;
+                    case '/': result += '/'; break;
+                    case 'b': result += '\b'; break;
+                    case 'f': result += '\f'; break;
+                    case 'n': result += '\n'; break;
+                    case 'r': result += '\r'; break;
+                    case 't': result += '\t'; break;
+                    case 'u':
+                    {
+                        uint32_t codepoint = readHex4();
+                        // Surrogate pair
+                        if (codepoint >= 0xD800 && codepoint < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u')
+                        {
+                            p += 2;
+                            const uint32_t low = readHex4();
+                            if (low < 0xDC00 || low >= 0xE000) fail("invalid surrogate pair");
+                            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        appendUtf8(result, codepoint);
+                        break;
+                    }
+                    default:
+                        fail("invalid escape");
+                }
+            }
+        }
+
+        double readNumber()
+        {
+            double result = 0.0;
+            const auto [next, error] = std::from_chars(p, end, result);
+            if (error != std::errc() || next == p) fail("invalid value");
+            p = next;
+            return result;
+        }
+
+        const char* begin;
+        const char* p;
+        const char* end;
+    };
+
+    JsonValue JsonValue::Parse(const char* data, size_t size)
+    {
+        return JsonReader(data, size).ReadDocument();
+    }
+
+    bool JsonValue::Has(std::string_view key) const
+    {
+        return !(*this)[key].IsNull();
+    }
+
+    const JsonValue& JsonValue::operator[](std::string_view key) const
+    {
+        for (const auto& [name, value] : members)
+        {
+            if (name == key) return value;
+        }
+        return NULL_VALUE;
+    }
+
+    const JsonValue& JsonValue::operator[](size_t index) const
+    {
+        return index < array.size() ? array[index] : NULL_VALUE;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Minimal JSON document, enough for asset manifests like glTF. Objects keep their keys in file
+    // order and are searched linearly, which is faster than hashing for the handful of keys they hold.
+    //
+    // Lookups never throw: a missing key or index yields a null value, and the As*() getters return
+    // their fallback when the value has another type.
+    class JsonValue
+    {
+    public:
+        enum class Type : uint8_t
+        {
+            NUL,
+            BOOLEAN,
+            NUMBER,
+            STRING,
+            ARRAY,
+            OBJECT,
+        };
+
+        JsonValue() = default;
+
+        // Throws std::runtime_error with the byte offset on malformed input
+        VOIDENGINE_API static JsonValue Parse(const char* data, size_t size);
+
+        Type GetType() const { return type; }
+        bool IsNull() const { return type == Type::NUL; }
+        bool IsArray() const { return type == Type::ARRAY; }
+        bool IsObject() const { return type == Type::OBJECT; }
+
+        VOIDENGINE_API bool Has(std::string_view key) const;
+        VOIDENGINE_API const JsonValue& operator[](std::string_view key) const;
+        VOIDENGINE_API const JsonValue& operator[](size_t index) const;
+
+        // Number of array elements or object members
+        size_t Size() const { return type == Type::ARRAY ? array.size() : type == Type::OBJECT ? members.size() : 0; }
+
+        const std::vector<JsonValue>& GetArray() const { return array; }
+        const std::vector<std::pair<std::string, JsonValue>>& GetMembers() const { return members; }
+
+        bool AsBool(bool fallback = false) const { return type == Type::BOOLEAN ? boolean : fallback; }
+        double AsNumber(double fallback = 0.0) const { return type == Type::NUMBER ? number : fallback; }
+        float AsFloat(float fallback = 0.0f) const { return type == Type::NUMBER ? static_cast<float>(number) : fallback; }
+        int64_t AsInt(int64_t fallback = 0) const { return type == Type::NUMBER ? static_cast<int64_t>(number) : fallback; }
+        const std::string& AsString() const { return string; }
+
+    private:
+        friend class JsonReader;
+
+        Type type = Type::NUL;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<JsonValue> array;
+        std::vector<std::pair<std::string, JsonValue>> members;
+    };
+}
@@ -0,0 +1,155 @@
+#include "Lz4.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace VoidEngine
+{
+    namespace
+    {
+        constexpr size_t MIN_MATCH = 4;
+        // The format requires the last 5 bytes to be literals and the last match to start 12 bytes before the end
+        constexpr size_t LAST_LITERALS = 5;
+        constexpr size_t MATCH_FIND_LIMIT = 12;
+        constexpr size_t MAX_OFFSET = 65535;
+        constexpr uint32_t HASH_BITS = 16;
+
+        uint32_t load32(const uint8_t* p)
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        uint32_t hash(uint32_t sequence)
+        {
+            return (sequence * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        void writeLength(std::vector<uint8_t>& output, size_t length)
+        {
+            for (; length >= 255; length -= 255) output.push_back(255);
+            output.push_back(static_cast<uint8_t>(length));
+        }
+
+        void writeSequence(std::vector<uint8_t>& output, const uint8_t* literals, size_t literalLength,
+            size_t offset, size_t matchLength)
+        {
+            const size_t matchCode = matchLength - MIN_MATCH;
+            output.push_back(static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) |
+                std::min<size_t>(matchCode, 15)));
+            if (literalLength >= 15) writeLength(output, literalLength - 15);
+            output.insert(output.end(), literals, literals + literalLength);
+
+            output.push_back(static_cast<uint8_t>(offset));
+            output.push_back(static_cast<uint8_t>(offset >> 8));
+            if (matchCode >= 15) writeLength(output, matchCode - 15);
+        }
+
+        size_t readLength(const uint8_t*& p, const uint8_t* end)
+        {
+            size_t length = 0;
+            uint8_t byte;
+            do
+            {
+                if (p == end) throw std::runtime_error("LZ4: Truncated length.");
+                byte = *p++;
+                length += byte;
+            } while (byte == 255);
+            return length;
+        }
+    }
+
+    void Lz4::Compress(const uint8_t* data, size_t size, std::vector<uint8_t>& output)
+    {
+        output.reserve(output.size() + Bound(size));
+
+        size_t anchor = 0;
+        if (size > MATCH_FIND_LIMIT)
+        {
+            std::vector<uint32_t> table(size_t{1} << HASH_BITS, UINT32_MAX);
+            const size_t matchEnd = size - LAST_LITERALS;
+            const size_t searchEnd = size - MATCH_FIND_LIMIT;
+
+            size_t position = 0;
+            while (position <= searchEnd)
+            {
+                const uint32_t sequence = load32(data + position);
+                uint32_t& slot = table[hash(sequence)];
+                const size_t candidate = slot;
+                slot = static_cast<uint32_t>(position);
+
+                if (candidate == UINT32_MAX || position - candidate > MAX_OFFSET || load32(data + candidate) != sequence)
+                {
+                    // Skip faster through data that doesn't compress
+                    position += 1 + ((position - anchor) >> 6);
+                    continue;
+                }
+
+                size_t length = MIN_MATCH;
+                while (position + length < matchEnd && data[candidate + length] == data[position + length]) length++;
+
+                writeSequence(output, data + anchor, position - anchor, position - candidate, length);
+                position += length;
+                anchor = position;
+
+                // The position two bytes back is likely the start of the next repeat
+                if (position <= searchEnd) table[hash(load32(data + position - 2))] = static_cast<uint32_t>(position - 2);
+            }
+        }
+
+        // Trailing literals without a match
+        const size_t literalLength = size - anchor;
+        output.push_back(static_cast<uint8_t>(std::min<size_t>(literalLength, 15) << 4));
+        if (literalLength >= 15) writeLength(output, literalLength - 15);
+        output.insert(output.end(), data + anchor, data + size);
+    }
+
+    size_t Lz4::Decompress(const uint8_t* data, size_t size, uint8_t* destination, size_t capacity)
+    {
+        const uint8_t* p = data;
+        const uint8_t* end = data + size;
+        size_t written = 0;
+
+        while (p < end)
+        {
+            const uint8_t token = *p++;
+
+            size_t literalLength = token >> 4;
+            if (literalLength == 15) literalLength += readLength(p, end);
+            if (literalLength > static_cast<size_t>(end - p)) throw std::runtime_error("LZ4: Truncated literals.");
+            if (literalLength > capacity - written) throw std::runtime_error("LZ4: Output overflow.");
+            std::memcpy(destination + written, p, literalLength);
+            p += literalLength;
+            written += literalLength;
+
+            // The last sequence has no match
+            if (p == end) break;
+
+            if (end - p < 2) throw std::runtime_error("LZ4: Truncated offset.");
+            const size_t offset = p[0] | (static_cast<size_t>(p[1]) << 8);
+            p += 2;
+            if (offset == 0 || offset > written) throw std::runtime_error("LZ4: Invalid offset.");
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15) matchLength += readLength(p, end);
+            matchLength += MIN_MATCH;
+            if (matchLength > capacity - written) throw std::runtime_error("LZ4: Output overflow.");
+
+            // Matches may overlap the bytes they produce, which repeats the last `offset` bytes
+            uint8_t* out = destination + written;
+            const uint8_t* match = out - offset;
+            if (offset >= matchLength)
+            {
+                std::memcpy(out, match, matchLength);
+            } else
+            {
+                for (size_t i = 0; i < matchLength; i++) out[i] = match[i];
+            }
+            written += matchLength;
+        }
+
+        return written;
+    }
+}
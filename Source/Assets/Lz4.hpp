@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VoidEngine
+{
+    // LZ4 block format codec for the asset archive. Blocks are small and compressed once when packing, so the
+    // compressor is a plain greedy matcher; the decompressor is the part that runs at load time.
+    class Lz4
+    {
+    public:
+        // Largest possible compressed size of `size` bytes
+        static constexpr size_t Bound(size_t size) { return size + size / 255 + 16; }
+
+        // Appends the compressed block to `output`
+        VOIDENGINE_API static void Compress(const uint8_t* data, size_t size, std::vector<uint8_t>& output);
+
+        // Decompresses a block into `destination` and returns the number of bytes written. Throws
+        // std::runtime_error on malformed data and when the output doesn't fit.
+        VOIDENGINE_API static size_t Decompress(const uint8_t* data, size_t size, uint8_t* destination, size_t capacity);
+    };
+}
@@ -0,0 +1,359 @@
+#include "MeshCache.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace VoidEngine
+{
+    static_assert(std::is_trivially_copyable_v<Model::Vertex>, "Vertex must be trivially copyable to be cached!");
+    static_assert(std::is_trivially_copyable_v<Model::PackedTangent>, "PackedTangent must be trivially copyable to be cached!");
+    static_assert(std::is_trivially_copyable_v<Model::Lod>, "Lod must be trivially copyable to be cached!");
+    static_assert(std::is_trivially_copyable_v<Meshlet>, "Meshlet must be trivially copyable to be cached!");
+    static_assert(std::is_trivially_copyable_v<Model::Submesh>, "Submesh must be trivially copyable to be cached!");
+    static_assert(sizeof(MeshCache::Header) == 24, "MeshCache::Header layout changed, bump MeshCache::VERSION");
+    static_assert(sizeof(MeshCache::Chunk) == 24, "MeshCache::Chunk layout changed, bump MeshCache::VERSION");
+
+    std::string MeshCache::GetCachePath(const std::string& sourcePath, const Model::ImportOptions& options)
+    {
+        std::ostringstream path;
+        path << sourcePath << "." << std::hex << std::setw(16) << std::setfill('0') << HashOptions(options) << ".vmesh";
+        return path.str();
+    }
+
+    uint64_t MeshCache::HashOptions(const Model::ImportOptions& options)
+    {
+        // Options are hashed field by field, the struct may contain padding
+        uint64_t hash = hashBytes(&options.weldEpsilon, sizeof(options.weldEpsilon), VERSION);
+        hash = hashBytes(&options.optimize, sizeof(options.optimize), hash);
+        hash = hashBytes(&options.generateTangents, sizeof(options.generateTangents), hash);
+        hash = hashBytes(&options.lodCount, sizeof(options.lodCount), hash);
+        hash = hashBytes(&options.lodReduction, sizeof(options.lodReduction), hash);
+        hash = hashBytes(&options.lodMaxError, sizeof(options.lodMaxError), hash);
+        return hash;
+    }
+
+    uint64_t MeshCache::HashSource(const MappedFile& source, const Model::ImportOptions& options)
+    {
+        return hashBytes(source.data(), source.size(), HashOptions(options));
+    }
+
+    MeshCache::MeshCache(MappedFile mappedFile) : file(std::move(mappedFile))
+    {
+    }
+
+    std::unique_ptr<MeshCache> MeshCache::Open(const std::string& cachePath, uint64_t sourceHash)
+    {
+        // Caches can be packed into an archive along with their sources
+        if (!MappedFile::Exists(cachePath)) return nullptr;
+
+        std::unique_ptr<MeshCache> cache;
+        try
+        {
+            cache.reset(new MeshCache(MappedFile(cachePath)));
+        } catch (const std::exception& e)
+        {
+            std::cerr << "MeshCache: " << e.what() << "\n";
+            return nullptr;
+        }
+
+        const MappedFile& f = cache->file;
+        if (f.size() < sizeof(Header)) return nullptr;
+
+        Header header{};
+        std::memcpy(&header, f.data(), sizeof(Header));
+
+        if (header.magic != MAGIC || header.version != VERSION) return nullptr;
+        if (header.vertexStride != sizeof(Model::Vertex)) return nullptr;
+        if (header.sourceHash != sourceHash) return nullptr;
+
+        const uint64_t tableEnd = sizeof(Header) + static_cast<uint64_t>(header.chunkCount) * sizeof(Chunk);
+        if (tableEnd > f.size()) return nullptr;
+
+        // Reject truncated files up front so the accessors never read past the mapping
+        const auto* chunks = reinterpret_cast<const Chunk*>(f.data() + sizeof(Header));
+        for (uint32_t i = 0; i < header.chunkCount; i++)
+        {
+            const uint64_t end = chunks[i].offset + chunks[i].count * chunks[i].elementSize;
+            if (chunks[i].offset < tableEnd || end > f.size()) return nullptr;
+        }
+
+        const Chunk* vertexChunk = cache->findChunk(ChunkType::VERTICES);
+        const Chunk* indexChunk = cache->findChunk(ChunkType::INDICES);
+        if (vertexChunk == nullptr || vertexChunk->elementSize != sizeof(Model::Vertex) ||
+            indexChunk == nullptr || indexChunk->elementSize != sizeof(uint32_t))
+        {
+            return nullptr;
+        }
+
+        return cache;
+    }
+
+    namespace
+    {
+        std::vector<char> joinStrings(const std::vector<std::string>& strings)
+        {
+            std::vector<char> joined;
+            for (const auto& string : strings)
+            {
+                joined.insert(joined.end(), string.begin(), string.end());
+                joined.push_back('\0');
+            }
+            return joined;
+        }
+    }
+
+    bool MeshCache::Write(const std::string& cachePath, uint64_t sourceHash, const Model& model,
+        const std::vector<std::string>& materialLibraries, const std::vector<std::string>& materialNames)
+    {
+        struct Payload
+        {
+            ChunkType type;
+            uint32_t elementSize;
+            const void* data;
+            uint64_t count;
+        };
+
+        const VertexCacheStats vertexCacheStats[2] = {model.vertexCacheBefore, model.vertexCacheAfter};
+        const std::vector<char> libraries = joinStrings(materialLibraries);
+        const std::vector<char> names = joinStrings(materialNames);
+
+        const std::vector<Payload> payloads{
+            {ChunkType::VERTICES, sizeof(Model::Vertex), model.vertices.data(), model.vertices.size()},
+            {ChunkType::INDICES, sizeof(uint32_t), model.indices.data(), model.indices.size()},
+            {ChunkType::TANGENTS, sizeof(Model::PackedTangent), model.tangents.data(), model.tangents.size()},
+            {ChunkType::VERTEX_CACHE_STATS, sizeof(VertexCacheStats), vertexCacheStats, 2},
+            {ChunkType::LODS, sizeof(Model::Lod), model.lods.data(), model.lods.size()},
+            {ChunkType::MESHLETS, sizeof(Meshlet), model.meshlets.data(), model.meshlets.size()},
+            {ChunkType::SUBMESHES, sizeof(Model::Submesh), model.submeshes.data(), model.submeshes.size()},
+            {ChunkType::MATERIAL_LIBRARIES, 1, libraries.data(), libraries.size()},
+            {ChunkType::MATERIAL_NAMES, 1, names.data(), names.size()},
+        };
+
+        Header header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.sourceHash = sourceHash;
+        header.vertexStride = sizeof(Model::Vertex);
+        header.chunkCount = static_cast<uint32_t>(payloads.size());
+
+        std::vector<Chunk> chunks(payloads.size());
+        uint64_t offset = sizeof(Header) + chunks.size() * sizeof(Chunk);
+        for (size_t i = 0; i < payloads.size(); i++)
+        {
+            offset = (offset + CHUNK_ALIGNMENT - 1) & ~(CHUNK_ALIGNMENT - 1);
+            chunks[i] = {payloads[i].type, payloads[i].elementSize, offset, payloads[i].count};
+            offset += payloads[i].count * payloads[i].elementSize;
+        }
+
+        // Write to a temporary file first so a crash or a concurrent reader never sees a partial cache. The name
+        // is unique per thread, two threads importing the same mesh each write their own and the last rename wins.
+        const size_t threadId = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        const std::string tmpPath = cachePath + "." + std::to_string(threadId) + ".tmp";
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open())
+            {
+                std::cerr << "MeshCache: Failed to open " << tmpPath << " for writing.\n";
+                return false;
+            }
+
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(chunks.data()), static_cast<std::streamsize>(chunks.size() * sizeof(Chunk)));
+
+            static constexpr char padding[CHUNK_ALIGNMENT]{};
+            for (size_t i = 0; i < payloads.size(); i++)
+            {
+                out.write(padding, static_cast<std::streamsize>(chunks[i].offset - static_cast<uint64_t>(out.tellp())));
+                out.write(static_cast<const char*>(payloads[i].data), static_cast<std::streamsize>(payloads[i].count * payloads[i].elementSize));
+            }
+
+            if (!out.good())
+            {
+                std::cerr << "MeshCache: Failed to write " << tmpPath << ".\n";
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, cachePath, ec);
+        if (ec)
+        {
+            std::cerr << "MeshCache: Failed to replace " << cachePath << ": " << ec.message() << "\n";
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+
+        return true;
+    }
+
+    const MeshCache::Chunk* MeshCache::findChunk(ChunkType type) const
+    {
+        Header header{};
+        std::memcpy(&header, file.data(), sizeof(Header));
+
+        const auto* chunks = reinterpret_cast<const Chunk*>(file.data() + sizeof(Header));
+        for (uint32_t i = 0; i < header.chunkCount; i++)
+        {
+            if (chunks[i].type == type) return &chunks[i];
+        }
+        return nullptr;
+    }
+
+    const void* MeshCache::chunkData(ChunkType type) const
+    {
+        const Chunk* chunk = findChunk(type);
+        return chunk != nullptr ? file.data() + chunk->offset : nullptr;
+    }
+
+    const Model::Vertex* MeshCache::GetVertices() const
+    {
+        return static_cast<const Model::Vertex*>(chunkData(ChunkType::VERTICES));
+    }
+
+    uint32_t MeshCache::GetVertexCount() const
+    {
+        return static_cast<uint32_t>(findChunk(ChunkType::VERTICES)->count);
+    }
+
+    const Model::PackedTangent* MeshCache::GetTangents() const
+    {
+        // A stream that doesn't cover every vertex would be read past its end
+        const Chunk* chunk = findChunk(ChunkType::TANGENTS);
+        if (chunk == nullptr || chunk->elementSize != sizeof(Model::PackedTangent) || chunk->count == 0 ||
+            chunk->count != GetVertexCount())
+        {
+            return nullptr;
+        }
+        return reinterpret_cast<const Model::PackedTangent*>(file.data() + chunk->offset);
+    }
+
+    const uint32_t* MeshCache::GetIndices() const
+    {
+        return static_cast<const uint32_t*>(chunkData(ChunkType::INDICES));
+    }
+
+    uint32_t MeshCache::GetIndexCount() const
+    {
+        return static_cast<uint32_t>(findChunk(ChunkType::INDICES)->count);
+    }
+
+    bool MeshCache::GetVertexCacheStats(VertexCacheStats& before, VertexCacheStats& after) const
+    {
+        const Chunk* chunk = findChunk(ChunkType::VERTEX_CACHE_STATS);
+        if (chunk == nullptr || chunk->elementSize != sizeof(VertexCacheStats) || chunk->count != 2) return false;
+
+        VertexCacheStats stats[2];
+        std::memcpy(stats, file.data() + chunk->offset, sizeof(stats));
+        before = stats[0];
+        after = stats[1];
+        return true;
+    }
+
+    bool MeshCache::GetLods(std::vector<Model::Lod>& lods) const
+    {
+        lods.clear();
+
+        const Chunk* chunk = findChunk(ChunkType::LODS);
+        if (chunk == nullptr || chunk->elementSize != sizeof(Model::Lod)) return false;
+
+        // Ranges outside the index buffer would draw garbage
+        const uint64_t indexCount = GetIndexCount();
+        const Chunk* submeshChunk = findChunk(ChunkType::SUBMESHES);
+        const uint64_t submeshCount = submeshChunk != nullptr ? submeshChunk->count : 0;
+        lods.resize(chunk->count);
+        std::memcpy(lods.data(), file.data() + chunk->offset, chunk->count * sizeof(Model::Lod));
+        for (const auto& lod : lods)
+        {
+            if (static_cast<uint64_t>(lod.firstIndex) + lod.indexCount > indexCount ||
+                static_cast<uint64_t>(lod.firstSubmesh) + lod.submeshCount > submeshCount)
+            {
+                lods.clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool MeshCache::GetMeshlets(std::vector<Meshlet>& meshlets) const
+    {
+        meshlets.clear();
+
+        const Chunk* chunk = findChunk(ChunkType::MESHLETS);
+        if (chunk == nullptr || chunk->elementSize != sizeof(Meshlet)) return false;
+
+        const uint64_t indexCount = GetIndexCount();
+        meshlets.resize(chunk->count);
+        std::memcpy(meshlets.data(), file.data() + chunk->offset, chunk->count * sizeof(Meshlet));
+        for (const auto& meshlet : meshlets)
+        {
+            if (static_cast<uint64_t>(meshlet.firstIndex) + meshlet.indexCount > indexCount)
+            {
+                meshlets.clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool MeshCache::GetSubmeshes(std::vector<Model::Submesh>& submeshes) const
+    {
+        submeshes.clear();
+
+        const Chunk* chunk = findChunk(ChunkType::SUBMESHES);
+        if (chunk == nullptr || chunk->elementSize != sizeof(Model::Submesh)) return false;
+
+        const uint64_t indexCount = GetIndexCount();
+        const Chunk* meshletChunk = findChunk(ChunkType::MESHLETS);
+        const uint64_t meshletCount = meshletChunk != nullptr ? meshletChunk->count : 0;
+        submeshes.resize(chunk->count);
+        std::memcpy(submeshes.data(), file.data() + chunk->offset, chunk->count * sizeof(Model::Submesh));
+        for (const auto& submesh : submeshes)
+        {
+            if (static_cast<uint64_t>(submesh.firstIndex) + submesh.indexCount > indexCount ||
+                static_cast<uint64_t>(submesh.firstMeshlet) + submesh.meshletCount > meshletCount)
+            {
+                submeshes.clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool MeshCache::GetMaterialLibraries(std::vector<std::string>& libraries) const
+    {
+        return getStrings(ChunkType::MATERIAL_LIBRARIES, libraries);
+    }
+
+    bool MeshCache::GetMaterialNames(std::vector<std::string>& names) const
+    {
+        return getStrings(ChunkType::MATERIAL_NAMES, names);
+    }
+
+    bool MeshCache::getStrings(ChunkType type, std::vector<std::string>& strings) const
+    {
+        strings.clear();
+
+        const Chunk* chunk = findChunk(type);
+        if (chunk == nullptr || chunk->elementSize != 1) return false;
+
+        const char* data = reinterpret_cast<const char*>(file.data() + chunk->offset);
+        const char* end = data + chunk->count;
+        while (data < end)
+        {
+            const char* terminator = static_cast<const char*>(std::memchr(data, '\0', end - data));
+            if (terminator == nullptr)
+            {
+                strings.clear();
+                return false;
+            }
+            strings.emplace_back(data, terminator);
+            data = terminator + 1;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Common.hpp"
+#include "MappedFile.hpp"
+#include "Model.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Versioned binary cache of an imported mesh, written next to the source file the first
+    // time it is imported and memory mapped on later loads. The vertex and index chunks are
+    // laid out exactly like Model::Vertex / uint32_t so they can be copied straight into a
+    // staging buffer without touching individual vertices.
+    //
+    // File layout:
+    //   Header | Chunk[chunkCount] | chunk payloads (each aligned to CHUNK_ALIGNMENT)
+    class MeshCache
+    {
+    public:
+        static constexpr uint32_t MAGIC = 0x48534D56; // "VMSH"
+        static constexpr uint32_t VERSION = 6;
+        static constexpr uint64_t CHUNK_ALIGNMENT = 64;
+
+        enum class ChunkType : uint32_t
+        {
+            VERTICES = 1,
+            INDICES = 2,
+            VERTEX_CACHE_STATS = 3, // Model::vertexCacheBefore, Model::vertexCacheAfter
+            LODS = 4,               // Model::Lod ranges into INDICES
+            MESHLETS = 5,           // Meshlets of the first LOD
+            SUBMESHES = 6,          // Model::Submesh ranges into INDICES, material is an index into MATERIAL_NAMES
+            MATERIAL_LIBRARIES = 7, // mtllib file names, each terminated by a 0 byte
+            MATERIAL_NAMES = 8,     // usemtl names, each terminated by a 0 byte
+            TANGENTS = 9,           // Model::PackedTangent per vertex, empty when the model has none
+        };
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t sourceHash;    // hashBytes() of the source file contents
+            uint32_t vertexStride;  // sizeof(Model::Vertex) when the cache was written
+            uint32_t chunkCount;
+        };
+
+        struct Chunk
+        {
+            ChunkType type;
+            uint32_t elementSize;
+            uint64_t offset;        // From the start of the file
+            uint64_t count;         // Number of elements
+        };
+
+        // Every option set gets a file of its own, so a mesh imported with different options doesn't keep
+        // replacing a single cache
+        VOIDENGINE_API static std::string GetCachePath(const std::string& sourcePath,
+            const Model::ImportOptions& options);
+        VOIDENGINE_API static uint64_t HashOptions(const Model::ImportOptions& options);
+        VOIDENGINE_API static uint64_t HashSource(const MappedFile& source, const Model::ImportOptions& options);
+
+        // Returns nullptr if the cache is missing, was written by another version or no
+        // longer matches the source file.
+        VOIDENGINE_API static std::unique_ptr<MeshCache> Open(const std::string& cachePath, uint64_t sourceHash);
+        // Material definitions are not cached, they are read from the libraries again on every load so editing
+        // an .mtl file takes effect. The model's Submesh::material still indexes `materialNames` here.
+        VOIDENGINE_API static bool Write(const std::string& cachePath, uint64_t sourceHash, const Model& model,
+            const std::vector<std::string>& materialLibraries, const std::vector<std::string>& materialNames);
+
+        const Model::Vertex* GetVertices() const;
+        uint32_t GetVertexCount() const;
+        // nullptr when the model has no tangents
+        const Model::PackedTangent* GetTangents() const;
+        const uint32_t* GetIndices() const;
+        uint32_t GetIndexCount() const;
+        bool GetVertexCacheStats(VertexCacheStats& before, VertexCacheStats& after) const;
+        bool GetLods(std::vector<Model::Lod>& lods) const;
+        bool GetMeshlets(std::vector<Meshlet>& meshlets) const;
+        bool GetSubmeshes(std::vector<Model::Submesh>& submeshes) const;
+        bool GetMaterialLibraries(std::vector<std::string>& libraries) const;
+        bool GetMaterialNames(std::vector<std::string>& names) const;
+
+    private:
+        explicit MeshCache(MappedFile mappedFile);
+
+        const Chunk* findChunk(ChunkType type) const;
+        const void* chunkData(ChunkType type) const;
+        bool getStrings(ChunkType type, std::vector<std::string>& strings) const;
+
+        MappedFile file;
+    };
+}
@@ -0,0 +1,346 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace VoidEngine
+{
+    namespace
+    {
+        // FIFO cache simulation: a vertex is cached while fewer than cacheSize vertices were added after it.
+        // Advancing time by more than cacheSize empties the cache without touching the timestamps.
+        struct CacheSimulation
+        {
+            CacheSimulation(size_t vertexCount, uint32_t cacheSize)
+                : timestamps(vertexCount, 0), cacheSize(cacheSize), time(cacheSize + 1)
+            {
+            }
+
+            bool access(uint32_t vertex)
+            {
+                if (time - timestamps[vertex] > cacheSize)
+                {
+                    timestamps[vertex] = time++;
+                    return false;
+                }
+                return true;
+            }
+
+            uint32_t accessTriangle(const uint32_t* triangle)
+            {
+                return !access(triangle[0]) + !access(triangle[1]) + !access(triangle[2]);
+            }
+
+            void flush() { time += cacheSize + 1; }
+
+            std::vector<uint32_t> timestamps;
+            uint32_t cacheSize;
+            uint32_t time;
+        };
+
+        struct Vec3
+        {
+            float x, y, z;
+        };
+
+        Vec3 position(const float* positions, size_t positionStride, uint32_t vertex)
+        {
+            const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + vertex * positionStride);
+            return {p[0], p[1], p[2]};
+        }
+    }
+
+    VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+        uint32_t cacheSize)
+    {
+        assert(indexCount % 3 == 0);
+
+        VertexCacheStats stats{};
+        if (indexCount == 0) return stats;
+
+        CacheSimulation cache(vertexCount, cacheSize);
+        size_t misses = 0;
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            misses += !cache.access(indices[i]);
+        }
+
+        // Only vertices the index buffer uses count towards ATVR
+        const size_t referenced = std::count_if(cache.timestamps.begin(), cache.timestamps.end(),
+            [](uint32_t timestamp) { return timestamp != 0; });
+
+        stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+        stats.atvr = static_cast<float>(misses) / static_cast<float>(referenced);
+        return stats;
+    }
+
+    void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+    {
+        assert(indexCount % 3 == 0);
+
+        const size_t faceCount = indexCount / 3;
+        if (faceCount == 0) return;
+
+        // Vertex to triangle adjacency, and how many unemitted triangles each vertex still has
+        std::vector<uint32_t> liveCount(vertexCount, 0);
+        for (size_t i = 0; i < indexCount; i++) liveCount[indices[i]]++;
+
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + liveCount[v];
+
+        std::vector<uint32_t> adjacency(indexCount);
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indexCount; i++)
+            {
+                adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<uint32_t> timestamps(vertexCount, 0);
+        std::vector<bool> emitted(faceCount, false);
+        std::vector<uint32_t> deadEnd;
+        deadEnd.reserve(indexCount);
+        std::vector<uint32_t> candidates;
+
+        std::vector<uint32_t> result;
+        result.reserve(indexCount);
+
+        uint32_t time = cacheSize + 1;
+        size_t restartCursor = 0;
+
+        auto nextRestart = [&]() -> int64_t
+        {
+            // Most recently touched vertices first, then the first unfinished vertex in input order
+            while (!deadEnd.empty())
+            {
+                const uint32_t vertex = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveCount[vertex] > 0) return vertex;
+            }
+            for (; restartCursor < vertexCount; restartCursor++)
+            {
+                if (liveCount[restartCursor] > 0) return static_cast<int64_t>(restartCursor);
+            }
+            return -1;
+        };
+
+        int64_t fanning = nextRestart();
+        while (fanning >= 0)
+        {
+            candidates.clear();
+
+            // Emit every remaining triangle around the fanning vertex
+            for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+            {
+                const uint32_t face = adjacency[a];
+                if (emitted[face]) continue;
+                emitted[face] = true;
+
+                for (size_t k = 0; k < 3; k++)
+                {
+                    const uint32_t vertex = indices[face * 3 + k];
+                    result.push_back(vertex);
+                    deadEnd.push_back(vertex);
+                    candidates.push_back(vertex);
+                    liveCount[vertex]--;
+
+                    if (time - timestamps[vertex] > cacheSize)
+                    {
+                        timestamps[vertex] = time++;
+                    }
+                }
+            }
+
+            // Prefer the oldest candidate that will still be in the cache after its own triangles are emitted
+            int64_t best = -1;
+            int64_t bestPriority = -1;
+            for (const uint32_t vertex : candidates)
+            {
+                if (liveCount[vertex] == 0) continue;
+
+                int64_t priority = 0;
+                if (time - timestamps[vertex] + 2 * liveCount[vertex] <= cacheSize)
+                {
+                    priority = time - timestamps[vertex];
+                }
+                if (priority > bestPriority)
+                {
+                    best = vertex;
+                    bestPriority = priority;
+                }
+            }
+
+            fanning = best >= 0 ? best : nextRestart();
+        }
+
+        assert(result.size() == indexCount);
+        std::copy(result.begin(), result.end(), indices);
+    }
+
+    void MeshOptimizer::OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions,
+        size_t vertexCount, size_t positionStride, float threshold, uint32_t cacheSize)
+    {
+        assert(indexCount % 3 == 0);
+
+        const size_t faceCount = indexCount / 3;
+        if (faceCount == 0) return;
+
+        CacheSimulation cache(vertexCount, cacheSize);
+
+        // Hard boundaries: a triangle missing all three vertices starts a new patch of the mesh
+        std::vector<uint32_t> hardClusters;
+        for (size_t face = 0; face < faceCount; face++)
+        {
+            if (cache.accessTriangle(&indices[face * 3]) == 3 || face == 0)
+            {
+                hardClusters.push_back(static_cast<uint32_t>(face));
+            }
+        }
+        hardClusters.push_back(static_cast<uint32_t>(faceCount));
+
+        // Soft boundaries: split patches wherever the part so far is already within threshold of the patch ACMR
+        std::vector<uint32_t> clusters;
+        for (size_t c = 0; c + 1 < hardClusters.size(); c++)
+        {
+            const uint32_t start = hardClusters[c];
+            const uint32_t end = hardClusters[c + 1];
+
+            cache.flush();
+            uint32_t clusterMisses = 0;
+            for (uint32_t face = start; face < end; face++)
+            {
+                clusterMisses += cache.accessTriangle(&indices[face * 3]);
+            }
+            const float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+            clusters.push_back(start);
+            cache.flush();
+
+            uint32_t runningMisses = 0;
+            uint32_t runningFaces = 0;
+            for (uint32_t face = start; face < end; face++)
+            {
+                runningMisses += cache.accessTriangle(&indices[face * 3]);
+                runningFaces++;
+
+                if (static_cast<float>(runningMisses) <= clusterThreshold * static_cast<float>(runningFaces))
+                {
+                    clusters.push_back(face + 1);
+                    cache.flush();
+                    runningMisses = 0;
+                    runningFaces = 0;
+                }
+            }
+
+            // The last split lands on the next patch's start
+            if (clusters.back() == end) clusters.pop_back();
+        }
+        clusters.push_back(static_cast<uint32_t>(faceCount));
+
+        const size_t clusterCount = clusters.size() - 1;
+
+        // Area weighted centroids and normals per cluster
+        std::vector<Vec3> clusterCentroids(clusterCount, Vec3{0, 0, 0});
+        std::vector<Vec3> clusterNormals(clusterCount, Vec3{0, 0, 0});
+        std::vector<float> clusterAreas(clusterCount, 0.0f);
+        Vec3 meshCentroid{0, 0, 0};
+        float meshArea = 0.0f;
+
+        for (size_t c = 0; c < clusterCount; c++)
+        {
+            for (uint32_t face = clusters[c]; face < clusters[c + 1]; face++)
+            {
+                const Vec3 p0 = position(positions, positionStride, indices[face * 3 + 0]);
+                const Vec3 p1 = position(positions, positionStride, indices[face * 3 + 1]);
+                const Vec3 p2 = position(positions, positionStride, indices[face * 3 + 2]);
+
+                const Vec3 e1{p1.x - p0.x, p1.y - p0.y, p1.z - p0.z};
+                const Vec3 e2{p2.x - p0.x, p2.y - p0.y, p2.z - p0.z};
+                const Vec3 normal{e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x};
+                const float area = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+
+                const Vec3 centroid{(p0.x + p1.x + p2.x) / 3.0f, (p0.y + p1.y + p2.y) / 3.0f, (p0.z + p1.z + p2.z) / 3.0f};
+
+                Vec3& clusterCentroid = clusterCentroids[c];
+                clusterCentroid.x += centroid.x * area;
+                clusterCentroid.y += centroid.y * area;
+                clusterCentroid.z += centroid.z * area;
+
+                Vec3& clusterNormal = clusterNormals[c];
+                clusterNormal.x += normal.x;
+                clusterNormal.y += normal.y;
+                clusterNormal.z += normal.z;
+
+                clusterAreas[c] += area;
+            }
+
+            meshCentroid.x += clusterCentroids[c].x;
+            meshCentroid.y += clusterCentroids[c].y;
+            meshCentroid.z += clusterCentroids[c].z;
+            meshArea += clusterAreas[c];
+        }
+
+        // Fully degenerate meshes have nothing to sort
+        if (meshArea <= 0.0f) return;
+
+        meshCentroid = {meshCentroid.x / meshArea, meshCentroid.y / meshArea, meshCentroid.z / meshArea};
+
+        // Clusters pointing away from the centroid are the most likely to occlude the rest
+        std::vector<float> sortKeys(clusterCount, 0.0f);
+        for (size_t c = 0; c < clusterCount; c++)
+        {
+            if (clusterAreas[c] <= 0.0f) continue;
+
+            const Vec3 centroid{clusterCentroids[c].x / clusterAreas[c], clusterCentroids[c].y / clusterAreas[c],
+                clusterCentroids[c].z / clusterAreas[c]};
+            const Vec3& normal = clusterNormals[c];
+            const float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+            if (length <= 0.0f) continue;
+
+            sortKeys[c] = ((centroid.x - meshCentroid.x) * normal.x + (centroid.y - meshCentroid.y) * normal.y +
+                (centroid.z - meshCentroid.z) * normal.z) / length;
+        }
+
+        std::vector<uint32_t> order(clusterCount);
+        for (size_t c = 0; c < clusterCount; c++) order[c] = static_cast<uint32_t>(c);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<uint32_t> result;
+        result.reserve(indexCount);
+        for (const uint32_t c : order)
+        {
+            result.insert(result.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+        }
+        std::copy(result.begin(), result.end(), indices);
+    }
+
+    size_t MeshOptimizer::OptimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexSize, uint32_t* indices,
+        size_t indexCount)
+    {
+        constexpr uint32_t UNUSED = 0xFFFFFFFF;
+
+        std::vector<uint32_t> remap(vertexCount, UNUSED);
+        uint32_t nextVertex = 0;
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            uint32_t& target = remap[indices[i]];
+            if (target == UNUSED) target = nextVertex++;
+            indices[i] = target;
+        }
+
+        auto* bytes = static_cast<char*>(vertices);
+        const std::vector<char> original(bytes, bytes + vertexCount * vertexSize);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            if (remap[v] != UNUSED)
+            {
+                std::memcpy(bytes + remap[v] * vertexSize, original.data() + v * vertexSize, vertexSize);
+            }
+        }
+
+        return nextVertex;
+    }
+}
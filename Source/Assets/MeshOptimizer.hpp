@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace VoidEngine
+{
+    // Post-transform vertex cache efficiency of an index buffer, measured on a FIFO cache.
+    //   acmr: average cache miss ratio, vertex shader invocations per triangle (0.5 is ideal on large grids, 3 is worst)
+    //   atvr: average transformed vertex ratio, vertex shader invocations per vertex (1 is ideal)
+    struct VertexCacheStats
+    {
+        float acmr = 0.0f;
+        float atvr = 0.0f;
+    };
+
+    // Index and vertex buffer reordering run on imported meshes before upload. All passes work on
+    // triangle lists with 32-bit indices and keep the rendered result identical.
+    class MeshOptimizer
+    {
+    public:
+        // Close to the post-transform cache of current desktop GPUs
+        static constexpr uint32_t CACHE_SIZE = 16;
+
+        VOIDENGINE_API static VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount,
+            size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+
+        // Reorders triangles for vertex cache locality (Tipsify, Sander et al. 2007)
+        VOIDENGINE_API static void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount,
+            uint32_t cacheSize = CACHE_SIZE);
+
+        // Reorders clusters of an already cache optimized index buffer so triangles facing away from the mesh
+        // centroid draw first. Clusters are split as long as their ACMR stays within `threshold` of the
+        // original, so the cache gain is mostly kept.
+        VOIDENGINE_API static void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions,
+            size_t vertexCount, size_t positionStride, float threshold = 1.05f, uint32_t cacheSize = CACHE_SIZE);
+
+        // Reorders vertices into the order the index buffer first references them and drops unreferenced ones.
+        // Returns the new vertex count.
+        VOIDENGINE_API static size_t OptimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexSize,
+            uint32_t* indices, size_t indexCount);
+    };
+}
@@ -0,0 +1,431 @@
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+namespace VoidEngine
+{
+    namespace
+    {
+        constexpr uint32_t NONE = 0xFFFFFFFF;
+        constexpr uint32_t MULTIPLE = 0xFFFFFFFE;
+
+        // Keeps borders and seams from sliding along the surface
+        constexpr float BORDER_WEIGHT = 10.0f;
+
+        enum class Kind : uint8_t
+        {
+            MANIFOLD,   // Interior vertex with a single attribute set
+            BORDER,     // On exactly one open border
+            SEAM,       // Two attribute sets meeting along a single seam
+            LOCKED,     // Anything else, never moved
+        };
+
+        // [from][to], whether a vertex of kind `from` may be collapsed onto a neighbour of kind `to`
+        constexpr bool CAN_COLLAPSE[4][4] = {
+            {true, true, true, true},
+            {false, true, false, false},
+            {false, false, true, false},
+            {false, false, false, false},
+        };
+
+        // Whether an edge between the two kinds shows up in both directions in the position topology,
+        // so each edge is ranked once
+        constexpr bool HAS_OPPOSITE[4][4] = {
+            {true, true, true, false},
+            {true, false, true, false},
+            {true, true, true, false},
+            {false, false, false, false},
+        };
+
+        struct Vec3
+        {
+            float x, y, z;
+
+            Vec3 operator-(const Vec3& other) const { return {x - other.x, y - other.y, z - other.z}; }
+            Vec3 operator*(float s) const { return {x * s, y * s, z * s}; }
+        };
+
+        float dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+        Vec3 cross(const Vec3& a, const Vec3& b)
+        {
+            return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+        }
+
+        float normalize(Vec3& v)
+        {
+            const float length = std::sqrt(dot(v, v));
+            if (length > 0.0f) v = v * (1.0f / length);
+            return length;
+        }
+
+        // Sum of squared distances to a set of weighted planes, as the symmetric matrix A, vector b and scalar c
+        // of v'Av + 2b'v + c
+        struct Quadric
+        {
+            float a00 = 0, a11 = 0, a22 = 0;
+            float a10 = 0, a20 = 0, a21 = 0;
+            float b0 = 0, b1 = 0, b2 = 0;
+            float c = 0;
+            float weight = 0;
+
+            static Quadric FromPlane(const Vec3& n, float d, float w)
+            {
+                Quadric q;
+                q.a00 = n.x * n.x * w; q.a11 = n.y * n.y * w; q.a22 = n.z * n.z * w;
+                q.a10 = n.y * n.x * w; q.a20 = n.z * n.x * w; q.a21 = n.z * n.y * w;
+                q.b0 = n.x * d * w; q.b1 = n.y * d * w; q.b2 = n.z * d * w;
+                q.c = d * d * w;
+                q.weight = w;
+                return q;
+            }
+
+            Quadric& operator+=(const Quadric& o)
+            {
+                a00 += o.a00; a11 += o.a11; a22 += o.a22;
+                a10 += o.a10; a20 += o.a20; a21 += o.a21;
+                b0 += o.b0; b1 += o.b1; b2 += o.b2;
+                c += o.c;
+                weight += o.weight;
+                return *this;
+            }
+
+            // Weighted mean squared distance of `v` to the planes
+            float Error(const Vec3& v) const
+            {
+                const float rx = a00 * v.x + a10 * v.y + a20 * v.z;
+                const float ry = a10 * v.x + a11 * v.y + a21 * v.z;
+                const float rz = a20 * v.x + a21 * v.y + a22 * v.z;
+                const float r = rx * v.x + ry * v.y + rz * v.z + 2.0f * (b0 * v.x + b1 * v.y + b2 * v.z) + c;
+                return weight > 0.0f ? std::fabs(r) / weight : 0.0f;
+            }
+        };
+
+        struct Collapse
+        {
+            uint32_t from;
+            uint32_t to;
+            float error;
+        };
+
+        // Compressed vertex -> item lists
+        struct Adjacency
+        {
+            std::vector<uint32_t> offsets;
+            std::vector<uint32_t> items;
+
+            const uint32_t* begin(uint32_t v) const { return items.data() + offsets[v]; }
+            const uint32_t* end(uint32_t v) const { return items.data() + offsets[v + 1]; }
+        };
+    }
+
+    size_t MeshSimplifier::Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+        const float* positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount,
+        float targetError, float* resultError)
+    {
+        assert(indexCount % 3 == 0);
+
+        std::vector<uint32_t> result(indices, indices + indexCount);
+        float maxError = 0.0f;
+
+        // Positions scaled into the unit cube, so errors are relative to the mesh extent
+        std::vector<Vec3> position(vertexCount);
+        {
+            Vec3 minimum{FLT_MAX, FLT_MAX, FLT_MAX};
+            Vec3 maximum{-FLT_MAX, -FLT_MAX, -FLT_MAX};
+            for (size_t v = 0; v < vertexCount; v++)
+            {
+                const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * positionStride);
+                position[v] = {p[0], p[1], p[2]};
+                minimum = {std::min(minimum.x, p[0]), std::min(minimum.y, p[1]), std::min(minimum.z, p[2])};
+                maximum = {std::max(maximum.x, p[0]), std::max(maximum.y, p[1]), std::max(maximum.z, p[2])};
+            }
+
+            const float extent = std::max({maximum.x - minimum.x, maximum.y - minimum.y, maximum.z - minimum.z});
+            const float scale = extent > 0.0f ? 1.0f / extent : 0.0f;
+            for (auto& p : position) p = (p - minimum) * scale;
+        }
+
+        // Corners sharing a position get the same id, their quadric is shared and they move together
+        std::vector<uint32_t> positionId(vertexCount);
+        uint32_t positionCount = 0;
+        {
+            std::vector<uint32_t> order(vertexCount);
+            std::iota(order.begin(), order.end(), 0u);
+            auto less = [&](uint32_t a, uint32_t b)
+            {
+                const Vec3& pa = position[a];
+                const Vec3& pb = position[b];
+                if (pa.x != pb.x) return pa.x < pb.x;
+                if (pa.y != pb.y) return pa.y < pb.y;
+                return pa.z < pb.z;
+            };
+            std::sort(order.begin(), order.end(), less);
+
+            for (size_t i = 0; i < order.size(); i++)
+            {
+                if (i > 0 && less(order[i - 1], order[i])) positionCount++;
+                positionId[order[i]] = positionCount;
+            }
+            if (vertexCount > 0) positionCount++;
+        }
+
+        std::vector<Quadric> quadrics(positionCount);
+        std::vector<bool> referenced(vertexCount);
+        std::vector<uint32_t> firstWedge(positionCount);
+        std::vector<uint32_t> wedge(vertexCount);
+        std::vector<uint32_t> loop(vertexCount);        // Target of the open edge leaving a vertex
+        std::vector<uint32_t> loopBack(vertexCount);    // Source of the open edge entering a vertex
+        std::vector<Kind> kind(vertexCount);
+        std::vector<uint32_t> collapseRemap(vertexCount);
+        std::vector<bool> locked(positionCount);
+        Adjacency edges;                                // Vertex -> targets of its half edges
+        Adjacency triangles;                            // Position -> triangles using it
+        std::vector<Collapse> collapses;
+
+        auto buildAdjacency = [&](Adjacency& adjacency, size_t count, auto&& key, auto&& item)
+        {
+            adjacency.offsets.assign(count + 1, 0);
+            for (size_t i = 0; i < result.size(); i++) adjacency.offsets[key(i) + 1]++;
+            for (size_t v = 0; v < count; v++) adjacency.offsets[v + 1] += adjacency.offsets[v];
+
+            adjacency.items.resize(result.size());
+            std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+            for (size_t i = 0; i < result.size(); i++) adjacency.items[fill[key(i)]++] = item(i);
+        };
+
+        auto next = [](size_t corner) { return corner - corner % 3 + (corner + 1) % 3; };
+
+        bool first = true;
+        while (result.size() > targetIndexCount)
+        {
+            // Attribute sets of each position, among the corners still referenced
+            std::fill(referenced.begin(), referenced.end(), false);
+            for (const uint32_t v : result) referenced[v] = true;
+
+            std::fill(firstWedge.begin(), firstWedge.end(), NONE);
+            std::iota(wedge.begin(), wedge.end(), 0u);
+            for (uint32_t v = 0; v < vertexCount; v++)
+            {
+                if (!referenced[v]) continue;
+
+                uint32_t& head = firstWedge[positionId[v]];
+                if (head == NONE)
+                {
+                    head = v;
+                } else
+                {
+                    wedge[v] = wedge[head];
+                    wedge[head] = v;
+                }
+            }
+
+            // An edge is open when no triangle uses it in the opposite direction
+            buildAdjacency(edges, vertexCount, [&](size_t i) { return result[i]; }, [&](size_t i) { return result[next(i)]; });
+
+            std::fill(loop.begin(), loop.end(), NONE);
+            std::fill(loopBack.begin(), loopBack.end(), NONE);
+            for (size_t i = 0; i < result.size(); i++)
+            {
+                const uint32_t a = result[i];
+                const uint32_t b = result[next(i)];
+                if (std::find(edges.begin(b), edges.end(b), a) != edges.end(b)) continue;
+
+                loop[a] = loop[a] == NONE ? b : MULTIPLE;
+                loopBack[b] = loopBack[b] == NONE ? a : MULTIPLE;
+            }
+
+            auto single = [](uint32_t v) { return v != NONE && v != MULTIPLE; };
+            for (uint32_t head : firstWedge)
+            {
+                if (head == NONE) continue;
+
+                Kind k = Kind::LOCKED;
+                if (wedge[head] == head)
+                {
+                    if (loop[head] == NONE && loopBack[head] == NONE) k = Kind::MANIFOLD;
+                    else if (single(loop[head]) && single(loopBack[head])) k = Kind::BORDER;
+                } else if (wedge[wedge[head]] == head)
+                {
+                    // Both sides of the seam are open, and each side's edges continue on the other one reversed
+                    const uint32_t other = wedge[head];
+                    if (single(loop[head]) && single(loopBack[head]) && single(loop[other]) && single(loopBack[other]) &&
+                        positionId[loop[head]] == positionId[loopBack[other]] &&
+                        positionId[loopBack[head]] == positionId[loop[other]] &&
+                        positionId[loop[head]] != positionId[loopBack[head]])
+                    {
+                        k = Kind::SEAM;
+                    }
+                }
+
+                uint32_t w = head;
+                do
+                {
+                    kind[w] = k;
+                    w = wedge[w];
+                } while (w != head);
+            }
+
+            if (first)
+            {
+                first = false;
+                for (size_t i = 0; i < result.size(); i += 3)
+                {
+                    const Vec3& p0 = position[result[i + 0]];
+                    const Vec3& p1 = position[result[i + 1]];
+                    const Vec3& p2 = position[result[i + 2]];
+
+                    Vec3 normal = cross(p1 - p0, p2 - p0);
+                    const float area = normalize(normal) * 0.5f;
+                    const Quadric q = Quadric::FromPlane(normal, -dot(normal, p0), area);
+                    for (int c = 0; c < 3; c++) quadrics[positionId[result[i + c]]] += q;
+                }
+
+                // Planes through open edges, perpendicular to their triangle
+                for (size_t i = 0; i < result.size(); i++)
+                {
+                    const uint32_t a = result[i];
+                    const uint32_t b = result[next(i)];
+                    if ((kind[a] != Kind::BORDER && kind[a] != Kind::SEAM) || loop[a] != b) continue;
+
+                    const Vec3& p0 = position[a];
+                    Vec3 edge = position[b] - p0;
+                    const float length = normalize(edge);
+
+                    const Vec3 toThird = position[result[next(next(i))]] - p0;
+                    Vec3 normal = toThird - edge * dot(toThird, edge);
+                    normalize(normal);
+
+                    const Quadric q = Quadric::FromPlane(normal, -dot(normal, p0), length * length * BORDER_WEIGHT);
+                    quadrics[positionId[a]] += q;
+                    quadrics[positionId[b]] += q;
+                }
+            }
+
+            // Rank every allowed collapse, in both directions when both are allowed
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i++)
+            {
+                const uint32_t v0 = result[i];
+                const uint32_t v1 = result[next(i)];
+                const auto k0 = static_cast<size_t>(kind[v0]);
+                const auto k1 = static_cast<size_t>(kind[v1]);
+
+                if (!CAN_COLLAPSE[k0][k1] && !CAN_COLLAPSE[k1][k0]) continue;
+                if (HAS_OPPOSITE[k0][k1] && positionId[v1] > positionId[v0]) continue;
+                // Two border or seam vertices connected by an interior edge belong to different loops
+                if (k0 == k1 && (kind[v0] == Kind::BORDER || kind[v0] == Kind::SEAM) && loop[v0] != v1) continue;
+
+                Quadric q = quadrics[positionId[v0]];
+                q += quadrics[positionId[v1]];
+
+                if (CAN_COLLAPSE[k0][k1]) collapses.push_back({v0, v1, q.Error(position[v1])});
+                if (CAN_COLLAPSE[k1][k0]) collapses.push_back({v1, v0, q.Error(position[v0])});
+            }
+            if (collapses.empty()) break;
+
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+            buildAdjacency(triangles, positionCount, [&](size_t i) { return positionId[result[i]]; },
+                [](size_t i) { return static_cast<uint32_t>(i / 3); });
+
+            // Moving v0 onto v1 must not turn any of the remaining triangles around v0 over
+            auto flips = [&](uint32_t v0, uint32_t v1)
+            {
+                const uint32_t p0 = positionId[v0];
+                const uint32_t p1 = positionId[v1];
+                for (const uint32_t* t = triangles.begin(p0); t != triangles.end(p0); t++)
+                {
+                    const uint32_t* corners = &result[*t * 3];
+                    int moved = -1;
+                    bool collapsing = false;
+                    for (int c = 0; c < 3; c++)
+                    {
+                        if (positionId[corners[c]] == p0) moved = c;
+                        collapsing |= positionId[corners[c]] == p1;
+                    }
+                    if (collapsing) continue;
+
+                    Vec3 p[3] = {position[corners[0]], position[corners[1]], position[corners[2]]};
+                    const Vec3 before = cross(p[1] - p[0], p[2] - p[0]);
+                    p[moved] = position[v1];
+                    const Vec3 after = cross(p[1] - p[0], p[2] - p[0]);
+                    if (dot(before, after) <= 0.0f) return true;
+                }
+                return false;
+            };
+
+            const float errorLimit = targetError * targetError;
+            const size_t triangleGoal = (result.size() - targetIndexCount) / 3;
+            size_t collapsedTriangles = 0;
+            size_t applied = 0;
+
+            std::iota(collapseRemap.begin(), collapseRemap.end(), 0u);
+            std::fill(locked.begin(), locked.end(), false);
+
+            for (const auto& collapse : collapses)
+            {
+                if (collapse.error > errorLimit || collapsedTriangles >= triangleGoal) break;
+
+                const uint32_t v0 = collapse.from;
+                const uint32_t v1 = collapse.to;
+                const uint32_t p0 = positionId[v0];
+                const uint32_t p1 = positionId[v1];
+                if (locked[p0] || locked[p1]) continue;
+
+                // The other side of a seam collapses along the same edge
+                uint32_t s0 = NONE;
+                uint32_t s1 = NONE;
+                if (kind[v0] == Kind::SEAM)
+                {
+                    s0 = wedge[v0];
+                    s1 = loop[v0] == v1 ? loopBack[s0] : loop[s0];
+                    if (!single(s1) || positionId[s1] != p1) continue;
+                }
+
+                if (flips(v0, v1)) continue;
+
+                collapseRemap[v0] = v1;
+                if (s0 != NONE) collapseRemap[s0] = s1;
+                quadrics[p1] += quadrics[p0];
+
+                // Nothing around v0 changes again this pass, so the flip test above stays valid
+                for (const uint32_t* t = triangles.begin(p0); t != triangles.end(p0); t++)
+                {
+                    for (int c = 0; c < 3; c++) locked[positionId[result[*t * 3 + c]]] = true;
+                }
+                locked[p1] = true;
+
+                maxError = std::max(maxError, collapse.error);
+                collapsedTriangles += kind[v0] == Kind::BORDER ? 1 : 2;
+                applied++;
+            }
+            if (applied == 0) break;
+
+            // Drop the triangles that lost an edge
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                const uint32_t a = collapseRemap[result[i + 0]];
+                const uint32_t b = collapseRemap[result[i + 1]];
+                const uint32_t c = collapseRemap[result[i + 2]];
+                if (positionId[a] == positionId[b] || positionId[b] == positionId[c] || positionId[a] == positionId[c]) continue;
+
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        std::memcpy(destination, result.data(), result.size() * sizeof(uint32_t));
+        if (resultError != nullptr) *resultError = std::sqrt(maxError);
+        return result.size();
+    }
+}
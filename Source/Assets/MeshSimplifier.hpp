@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace VoidEngine
+{
+    // Quadric error metric edge collapse (Garland and Heckbert 1997) for generating LODs.
+    //
+    // Only the index buffer is rewritten. Collapses always move a vertex onto one of its neighbours, so every
+    // level keeps referencing the original vertex buffer and a LOD chain needs no extra vertex data.
+    //
+    // Corners that share a position but differ in normal or UV form an attribute seam. Seam and border vertices
+    // only collapse along their own seam or border, both sides of a seam together, so UV islands stay closed
+    // and hard edges stay hard. Vertices where more than two attribute sets meet are never moved.
+    class MeshSimplifier
+    {
+    public:
+        // Simplifies the triangle list until it has at most `targetIndexCount` indices or the next collapse would
+        // exceed `targetError`, a distance relative to the mesh extent (0.01 is 1% of its largest dimension).
+        // Writes the result to `destination`, which must hold `indexCount` indices and may alias `indices`.
+        // Returns the new index count and stores the largest error introduced in `resultError`.
+        VOIDENGINE_API static size_t Simplify(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+            const float* positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount,
+            float targetError, float* resultError = nullptr);
+    };
+}
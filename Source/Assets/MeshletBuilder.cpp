@@ -0,0 +1,224 @@
+#include "MeshletBuilder.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace VoidEngine
+{
+    namespace
+    {
+        // Normal cones wider than this are not worth testing, a camera would almost never be behind all triangles
+        constexpr float MIN_CONE_DOT = 0.1f;
+
+        glm::vec3 position(const float* positions, size_t positionStride, uint32_t vertex)
+        {
+            const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + vertex * positionStride);
+            return {p[0], p[1], p[2]};
+        }
+    }
+
+    std::vector<Meshlet> MeshletBuilder::Build(uint32_t* indices, size_t indexCount, const float* positions,
+        size_t vertexCount, size_t positionStride, uint32_t maxVertices, uint32_t maxTriangles)
+    {
+        assert(indexCount % 3 == 0);
+        assert(maxVertices >= 3 && maxTriangles >= 1);
+
+        const size_t triangleCount = indexCount / 3;
+        std::vector<Meshlet> meshlets;
+        if (triangleCount == 0) return meshlets;
+
+        // Vertex to triangle adjacency
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t i = 0; i < indexCount; i++) offsets[indices[i] + 1]++;
+        for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+
+        std::vector<uint32_t> adjacency(indexCount);
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indexCount; i++) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        std::vector<glm::vec3> normals(triangleCount);
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            const glm::vec3 p0 = position(positions, positionStride, indices[t * 3 + 0]);
+            const glm::vec3 n = glm::cross(position(positions, positionStride, indices[t * 3 + 1]) - p0,
+                position(positions, positionStride, indices[t * 3 + 2]) - p0);
+            const float length = glm::length(n);
+            normals[t] = length > 0.0f ? n / length : glm::vec3{0.0f};
+        }
+
+        std::vector<bool> emitted(triangleCount, false);
+        // Marks the vertices of the current meshlet with its number + 1, so nothing has to be cleared between meshlets
+        std::vector<uint32_t> owner(vertexCount, 0);
+        std::vector<uint32_t> meshletVertices;
+        meshletVertices.reserve(maxVertices);
+
+        std::vector<uint32_t> result;
+        result.reserve(indexCount);
+
+        Meshlet current{};
+        glm::vec3 normalSum{0.0f};
+        size_t seedCursor = 0;
+
+        auto finish = [&]()
+        {
+            meshlets.push_back(current);
+            current = {};
+            current.firstIndex = static_cast<uint32_t>(result.size());
+            normalSum = glm::vec3{0.0f};
+            meshletVertices.clear();
+        };
+
+        auto newVertices = [&](size_t t)
+        {
+            const auto stamp = static_cast<uint32_t>(meshlets.size() + 1);
+            const uint32_t a = indices[t * 3], b = indices[t * 3 + 1], c = indices[t * 3 + 2];
+            return static_cast<uint32_t>((owner[a] != stamp) + (owner[b] != stamp && b != a) +
+                (owner[c] != stamp && c != a && c != b));
+        };
+
+        for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+        {
+            // Grow the meshlet across its own edges: fewest new vertices first, then the triangle closest to the
+            // meshlet's average facing so the normal cone stays narrow
+            size_t best = triangleCount;
+            uint32_t bestExtra = 3;
+            float bestSpread = FLT_MAX;
+            const float normalLength = glm::length(normalSum);
+            const glm::vec3 axis = normalLength > 0.0f ? normalSum / normalLength : glm::vec3{0.0f};
+
+            for (const uint32_t v : meshletVertices)
+            {
+                for (uint32_t i = offsets[v]; i < offsets[v + 1]; i++)
+                {
+                    const uint32_t t = adjacency[i];
+                    if (emitted[t]) continue;
+
+                    const uint32_t extra = newVertices(t);
+                    const float spread = 1.0f - glm::dot(normals[t], axis);
+                    if (extra < bestExtra || (extra == bestExtra && spread < bestSpread))
+                    {
+                        best = t;
+                        bestExtra = extra;
+                        bestSpread = spread;
+                    }
+                }
+            }
+
+            // Dead end: continue with the next triangle in index buffer order. Small pieces and meshes without
+            // shared vertices are packed together, a reasonably sized meshlet is finished instead so its bounds
+            // stay tight.
+            bool deadEnd = false;
+            if (best == triangleCount)
+            {
+                while (emitted[seedCursor]) seedCursor++;
+                best = seedCursor;
+                bestExtra = newVertices(best);
+                deadEnd = current.indexCount / 3 >= maxTriangles / 8;
+            }
+
+            // Full, the candidate starts the next meshlet
+            if (deadEnd || current.vertexCount + bestExtra > maxVertices || current.indexCount / 3 >= maxTriangles)
+            {
+                finish();
+            }
+
+            const auto stamp = static_cast<uint32_t>(meshlets.size() + 1);
+            for (int c = 0; c < 3; c++)
+            {
+                const uint32_t vertex = indices[best * 3 + c];
+                if (owner[vertex] != stamp)
+                {
+                    owner[vertex] = stamp;
+                    meshletVertices.push_back(vertex);
+                    current.vertexCount++;
+                }
+                result.push_back(vertex);
+            }
+            current.indexCount += 3;
+            normalSum += normals[best];
+            emitted[best] = true;
+        }
+        meshlets.push_back(current);
+
+        std::copy(result.begin(), result.end(), indices);
+        for (auto& meshlet : meshlets) ComputeBounds(meshlet, indices, positions, positionStride);
+
+        return meshlets;
+    }
+
+    void MeshletBuilder::ComputeBounds(Meshlet& meshlet, const uint32_t* indices, const float* positions,
+        size_t positionStride)
+    {
+        const uint32_t* triangles = indices + meshlet.firstIndex;
+        const size_t triangleCount = meshlet.indexCount / 3;
+
+        // Sphere around the box center, a little looser than the minimal one but cheap and stable
+        glm::vec3 minimum{FLT_MAX};
+        glm::vec3 maximum{-FLT_MAX};
+        for (size_t i = 0; i < meshlet.indexCount; i++)
+        {
+            const glm::vec3 p = position(positions, positionStride, triangles[i]);
+            minimum = glm::min(minimum, p);
+            maximum = glm::max(maximum, p);
+        }
+        meshlet.center = (minimum + maximum) * 0.5f;
+
+        float radiusSquared = 0.0f;
+        for (size_t i = 0; i < meshlet.indexCount; i++)
+        {
+            const glm::vec3 d = position(positions, positionStride, triangles[i]) - meshlet.center;
+            radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+        }
+        meshlet.radius = std::sqrt(radiusSquared);
+
+        // Cone around the average triangle normal
+        std::vector<glm::vec3> normals;
+        normals.reserve(triangleCount);
+        glm::vec3 axis{0.0f};
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            const glm::vec3 p0 = position(positions, positionStride, triangles[t * 3 + 0]);
+            const glm::vec3 p1 = position(positions, positionStride, triangles[t * 3 + 1]);
+            const glm::vec3 p2 = position(positions, positionStride, triangles[t * 3 + 2]);
+
+            const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            const float area = glm::length(normal);
+            // Degenerate triangles are never rasterized, they don't widen the cone
+            normals.push_back(area > 0.0f ? normal / area : glm::vec3{0.0f});
+            axis += normals.back();
+        }
+
+        meshlet.coneCutoff = 1.0f;
+        const float axisLength = glm::length(axis);
+        if (axisLength == 0.0f) return;
+        axis /= axisLength;
+
+        float minDot = 1.0f;
+        for (const auto& normal : normals)
+        {
+            if (normal != glm::vec3{0.0f}) minDot = std::min(minDot, glm::dot(normal, axis));
+        }
+        if (minDot <= MIN_CONE_DOT) return;
+
+        // Move the apex back along the axis until it is behind the plane of every triangle, then any camera inside
+        // the cone around it sees only back faces
+        float maxT = 0.0f;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            if (normals[t] == glm::vec3{0.0f}) continue;
+
+            const glm::vec3 corner = position(positions, positionStride, triangles[t * 3]);
+            const float t0 = glm::dot(meshlet.center - corner, normals[t]) / glm::dot(axis, normals[t]);
+            maxT = std::max(maxT, t0);
+        }
+
+        meshlet.coneApex = meshlet.center - axis * maxT;
+        meshlet.coneAxis = axis;
+        // Cosine of the cone's half angle, which is 90 degrees minus the angle the normals spread over
+        meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
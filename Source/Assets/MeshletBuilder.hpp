@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Common.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <External/glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VoidEngine
+{
+    // A small cluster of triangles culled as a unit. The triangles of a meshlet are a contiguous range of the
+    // index buffer, so visible meshlets are drawn straight from the regular index buffer.
+    struct Meshlet
+    {
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        uint32_t vertexCount = 0;   // Distinct vertices referenced
+
+        // Bounding sphere, in object space
+        glm::vec3 center{0.0f};
+        float radius = 0.0f;
+
+        // Normal cone. Every triangle faces away from a camera at `p` when
+        // dot(normalize(coneApex - p), coneAxis) >= coneCutoff. A cutoff of 1 disables the test.
+        glm::vec3 coneApex{0.0f};
+        glm::vec3 coneAxis{0.0f};
+        float coneCutoff = 1.0f;
+    };
+
+    // Splits triangle lists into meshlets. A meshlet grows across its own edges, preferring triangles that add
+    // no new vertices and face the same way as the rest of it, which keeps it compact and its normal cone narrow.
+    // When it can't grow any further, the next meshlet starts at the first unused triangle in index order.
+    class MeshletBuilder
+    {
+    public:
+        // Same limits as common mesh shader setups, small enough for the normal cones to stay useful
+        static constexpr uint32_t MAX_VERTICES = 64;
+        static constexpr uint32_t MAX_TRIANGLES = 124;
+
+        // Meshlets covering indices [0, indexCount). Triangles are reordered in place so that each meshlet is a
+        // contiguous range, Meshlet::firstIndex is relative to `indices`.
+        VOIDENGINE_API static std::vector<Meshlet> Build(uint32_t* indices, size_t indexCount,
+            const float* positions, size_t vertexCount, size_t positionStride,
+            uint32_t maxVertices = MAX_VERTICES, uint32_t maxTriangles = MAX_TRIANGLES);
+
+        // Fills the bounding sphere and normal cone from the meshlet's triangles
+        VOIDENGINE_API static void ComputeBounds(Meshlet& meshlet, const uint32_t* indices, const float* positions,
+            size_t positionStride);
+    };
+}
@@ -0,0 +1,58 @@
+#include "MeshletCuller.hpp"
+
+namespace VoidEngine
+{
+    void MeshletCuller::Cull(const Meshlet* meshlets, size_t meshletCount, const glm::mat4& modelViewProjection,
+        const glm::vec3& cameraPosition, bool cullBackfaces, std::vector<Range>& ranges, Stats& stats)
+    {
+        // Frustum planes in object space (Gribb and Hartmann), normalized so the sphere test works in object units.
+        // Vulkan clips depth to [0, w], so the near plane is the third row alone.
+        const glm::mat4 m = glm::transpose(modelViewProjection);
+        glm::vec4 planes[6] = {
+            m[3] + m[0], m[3] - m[0],
+            m[3] + m[1], m[3] - m[1],
+            m[2], m[3] - m[2],
+        };
+        for (auto& plane : planes)
+        {
+            const float length = glm::length(glm::vec3(plane));
+            if (length > 0.0f) plane /= length;
+        }
+
+        for (size_t i = 0; i < meshletCount; i++)
+        {
+            const Meshlet& meshlet = meshlets[i];
+
+            bool outside = false;
+            for (const auto& plane : planes)
+            {
+                outside |= glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius;
+            }
+            if (outside)
+            {
+                stats.frustumCulled++;
+                continue;
+            }
+
+            if (cullBackfaces && meshlet.coneCutoff < 1.0f)
+            {
+                const glm::vec3 toApex = meshlet.coneApex - cameraPosition;
+                const float distance = glm::length(toApex);
+                if (glm::dot(toApex, meshlet.coneAxis) >= meshlet.coneCutoff * distance)
+                {
+                    stats.backfaceCulled++;
+                    continue;
+                }
+            }
+
+            stats.visible++;
+            if (!ranges.empty() && ranges.back().firstIndex + ranges.back().indexCount == meshlet.firstIndex)
+            {
+                ranges.back().indexCount += meshlet.indexCount;
+            } else
+            {
+                ranges.push_back({meshlet.firstIndex, meshlet.indexCount});
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Common.hpp"
+#include "MeshletBuilder.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VoidEngine
+{
+    // CPU side meshlet culling. Rejects meshlets outside the view frustum and, when the pipeline culls back
+    // faces, meshlets whose normal cone faces away from the camera. Survivors are merged into as few index
+    // ranges as possible.
+    class MeshletCuller
+    {
+    public:
+        struct Range
+        {
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+        };
+
+        struct Stats
+        {
+            uint32_t visible = 0;
+            uint32_t frustumCulled = 0;
+            uint32_t backfaceCulled = 0;
+        };
+
+        // `modelViewProjection` maps object space to Vulkan clip space (depth 0 to 1). `cameraPosition` is in
+        // object space and only used with `cullBackfaces`, which must match the pipeline's cull mode or visible
+        // back faces disappear. Ranges are appended to `ranges`, counts added to `stats`.
+        VOIDENGINE_API static void Cull(const Meshlet* meshlets, size_t meshletCount, const glm::mat4& modelViewProjection,
+            const glm::vec3& cameraPosition, bool cullBackfaces, std::vector<Range>& ranges, Stats& stats);
+    };
+}
@@ -0,0 +1,310 @@
+#include "MipGenerator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+#ifdef VOIDENGINE_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace VoidEngine
+{
+    namespace
+    {
+        // One RGBA texel in linear float, a single SSE register
+#ifdef VOIDENGINE_SSE2
+        using Pixel = __m128;
+
+        Pixel load(const float* p) { return _mm_loadu_ps(p); }
+        void store(float* p, Pixel v) { _mm_storeu_ps(p, v); }
+        Pixel zero() { return _mm_setzero_ps(); }
+        Pixel add(Pixel a, Pixel b) { return _mm_add_ps(a, b); }
+        Pixel scale(Pixel a, float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+        Pixel multiplyAdd(Pixel sum, Pixel a, float w) { return _mm_add_ps(sum, _mm_mul_ps(a, _mm_set1_ps(w))); }
+        Pixel saturate(Pixel a) { return _mm_min_ps(_mm_max_ps(a, _mm_setzero_ps()), _mm_set1_ps(1.0f)); }
+
+        // Rounds each channel of a saturated pixel to `levels` steps
+        void quantize(Pixel a, float levels, int32_t result[4])
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(result), _mm_cvtps_epi32(_mm_mul_ps(a, _mm_set1_ps(levels))));
+        }
+#else
+        struct Pixel
+        {
+            float v[4];
+        };
+
+        Pixel load(const float* p) { return {p[0], p[1], p[2], p[3]}; }
+        void store(float* p, Pixel a) { for (int c = 0; c < 4; c++) p[c] = a.v[c]; }
+        Pixel zero() { return {}; }
+        Pixel add(Pixel a, Pixel b) { for (int c = 0; c < 4; c++) a.v[c] += b.v[c]; return a; }
+        Pixel scale(Pixel a, float s) { for (int c = 0; c < 4; c++) a.v[c] *= s; return a; }
+        Pixel multiplyAdd(Pixel sum, Pixel a, float w) { for (int c = 0; c < 4; c++) sum.v[c] += a.v[c] * w; return sum; }
+        Pixel saturate(Pixel a) { for (int c = 0; c < 4; c++) a.v[c] = std::clamp(a.v[c], 0.0f, 1.0f); return a; }
+
+        void quantize(Pixel a, float levels, int32_t result[4])
+        {
+            for (int c = 0; c < 4; c++) result[c] = static_cast<int32_t>(std::lround(a.v[c] * levels));
+        }
+#endif
+
+        // Linear values are looked up at 16-bit precision when encoding, fine enough near black where the
+        // sRGB curve is steepest
+        constexpr uint32_t ENCODE_STEPS = 65535;
+
+        constexpr int KAISER_TAPS = 8;
+
+        struct Tables
+        {
+            std::array<float, 256> srgbToLinear;
+            std::array<float, 256> unormToFloat;
+            std::array<uint8_t, ENCODE_STEPS + 1> linearToSrgb;
+            std::array<float, KAISER_TAPS> kaiser;
+
+            Tables()
+            {
+                for (int i = 0; i < 256; i++)
+                {
+                    const double c = i / 255.0;
+                    srgbToLinear[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+                    unormToFloat[i] = static_cast<float>(c);
+                }
+                for (uint32_t i = 0; i <= ENCODE_STEPS; i++)
+                {
+                    const double l = static_cast<double>(i) / ENCODE_STEPS;
+                    const double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+                    linearToSrgb[i] = static_cast<uint8_t>(std::lround(c * 255.0));
+                }
+
+                // Windowed sinc over two destination texels on each side, alpha 4 like common texture tools.
+                // Tap k covers the source texel at 2x - 3 + k, centered (k - 3.5) / 2 destination texels away.
+                constexpr double PI = 3.14159265358979323846;
+                constexpr double WIDTH = 2.0;
+                constexpr double ALPHA = 4.0;
+                auto bessel0 = [](double x)
+                {
+                    double sum = 1.0, term = 1.0;
+                    for (int k = 1; k < 32; k++)
+                    {
+                        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                        sum += term;
+                    }
+                    return sum;
+                };
+
+                double total = 0.0;
+                std::array<double, KAISER_TAPS> weights{};
+                for (int k = 0; k < KAISER_TAPS; k++)
+                {
+                    const double t = (k - 3.5) / 2.0;
+                    const double sinc = std::sin(PI * t) / (PI * t);
+                    const double r = t / WIDTH;
+                    const double window = bessel0(ALPHA * std::sqrt(std::max(0.0, 1.0 - r * r))) / bessel0(ALPHA);
+                    weights[k] = sinc * window;
+                    total += weights[k];
+                }
+                for (int k = 0; k < KAISER_TAPS; k++) kaiser[k] = static_cast<float>(weights[k] / total);
+            }
+        };
+
+        const Tables& tables()
+        {
+            static const Tables instance;
+            return instance;
+        }
+
+        // Linear float texel from RGBA8
+        Pixel decodeTexel(const uint8_t* p, const float* colorTable, const float* alphaTable)
+        {
+            const float texel[4] = {colorTable[p[0]], colorTable[p[1]], colorTable[p[2]], alphaTable[p[3]]};
+            return load(texel);
+        }
+
+        void decodeLevel(const Image& image, bool srgb, std::vector<float>& result)
+        {
+            const Tables& t = tables();
+            const float* colorTable = srgb ? t.srgbToLinear.data() : t.unormToFloat.data();
+
+            result.resize(image.pixels.size());
+            for (size_t i = 0; i < image.pixels.size(); i += 4)
+            {
+                store(result.data() + i, decodeTexel(image.pixels.data() + i, colorTable, t.unormToFloat.data()));
+            }
+        }
+
+        void encodeLevel(const float* source, size_t pixelCount, bool srgb, uint8_t* destination)
+        {
+            const Tables& t = tables();
+            int32_t srgbIndex[4];
+            int32_t linear[4];
+            for (size_t i = 0; i < pixelCount; i++)
+            {
+                const Pixel p = saturate(load(source + i * 4));
+                quantize(p, 255.0f, linear);
+                if (srgb)
+                {
+                    quantize(p, static_cast<float>(ENCODE_STEPS), srgbIndex);
+                    for (int c = 0; c < 3; c++) destination[i * 4 + c] = t.linearToSrgb[srgbIndex[c]];
+                } else
+                {
+                    for (int c = 0; c < 3; c++) destination[i * 4 + c] = static_cast<uint8_t>(linear[c]);
+                }
+                destination[i * 4 + 3] = static_cast<uint8_t>(linear[3]);
+            }
+        }
+
+        // Odd sizes clamp the last row or column, which weighs it a little more than an exact filter would.
+        // `fetch(row, x)` returns the texel of the level above.
+        template<typename Fetch>
+        void downsampleBox(uint32_t sourceWidth, uint32_t sourceHeight, float* destination, uint32_t width,
+            uint32_t height, Fetch&& fetch)
+        {
+            for (uint32_t y = 0; y < height; y++)
+            {
+                const size_t row0 = std::min(2 * y, sourceHeight - 1);
+                const size_t row1 = std::min(2 * y + 1, sourceHeight - 1);
+                float* out = destination + size_t(y) * width * 4;
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    const size_t x0 = std::min(2 * x, sourceWidth - 1);
+                    const size_t x1 = std::min(2 * x + 1, sourceWidth - 1);
+                    const Pixel sum = add(add(fetch(row0, x0), fetch(row0, x1)), add(fetch(row1, x0), fetch(row1, x1)));
+                    store(out + size_t(x) * 4, scale(sum, 0.25f));
+                }
+            }
+        }
+
+        // Separable: rows into `scratch` first, then columns. Taps past the edge repeat the border texel.
+        void downsampleKaiser(const float* source, uint32_t sourceWidth, uint32_t sourceHeight, float* destination,
+            uint32_t width, uint32_t height, std::vector<float>& scratch)
+        {
+            const auto& weights = tables().kaiser;
+            scratch.resize(size_t(width) * sourceHeight * 4);
+
+            auto clampTap = [](int64_t i, uint32_t size)
+            {
+                return static_cast<size_t>(std::clamp<int64_t>(i, 0, int64_t(size) - 1));
+            };
+
+            for (uint32_t y = 0; y < sourceHeight; y++)
+            {
+                const float* row = source + size_t(y) * sourceWidth * 4;
+                float* out = scratch.data() + size_t(y) * width * 4;
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    Pixel sum = zero();
+                    const int64_t first = int64_t(2) * x - 3;
+                    if (first >= 0 && first + KAISER_TAPS <= int64_t(sourceWidth))
+                    {
+                        // Away from the edges, no clamping
+                        const float* taps = row + first * 4;
+                        for (int k = 0; k < KAISER_TAPS; k++) sum = multiplyAdd(sum, load(taps + k * 4), weights[k]);
+                    } else
+                    {
+                        for (int k = 0; k < KAISER_TAPS; k++)
+                        {
+                            sum = multiplyAdd(sum, load(row + clampTap(first + k, sourceWidth) * 4), weights[k]);
+                        }
+                    }
+                    store(out + size_t(x) * 4, sum);
+                }
+            }
+
+            for (uint32_t y = 0; y < height; y++)
+            {
+                const float* rows[KAISER_TAPS];
+                for (int k = 0; k < KAISER_TAPS; k++)
+                {
+                    rows[k] = scratch.data() + clampTap(int64_t(2) * y - 3 + k, sourceHeight) * width * 4;
+                }
+
+                float* out = destination + size_t(y) * width * 4;
+                for (size_t x = 0; x < size_t(width) * 4; x += 4)
+                {
+                    Pixel sum = zero();
+                    for (int k = 0; k < KAISER_TAPS; k++) sum = multiplyAdd(sum, load(rows[k] + x), weights[k]);
+                    // The negative lobes overshoot at hard edges, keep that from building up over the levels
+                    store(out + x, saturate(sum));
+                }
+            }
+        }
+    }
+
+    MipChain MipGenerator::Generate(const Image& image, bool srgb, MipFilter filter)
+    {
+        assert(image.pixels.size() == size_t(image.width) * image.height * 4);
+
+        MipChain chain;
+        const uint32_t levelCount = LevelCount(image.width, image.height);
+
+        size_t total = 0;
+        uint32_t width = image.width;
+        uint32_t height = image.height;
+        for (uint32_t level = 0; level < levelCount; level++)
+        {
+            chain.levels.push_back({total, width, height});
+            total += size_t(width) * height * 4;
+            width = std::max(1u, width / 2);
+            height = std::max(1u, height / 2);
+        }
+
+        chain.data.resize(total);
+        std::copy(image.pixels.begin(), image.pixels.end(), chain.data.begin());
+        if (levelCount == 1) return chain;
+
+        const Tables& t = tables();
+        const float* colorTable = srgb ? t.srgbToLinear.data() : t.unormToFloat.data();
+
+        std::vector<float> current;
+        std::vector<float> next;
+        std::vector<float> scratch;
+        // The box filter reads the 8-bit base level directly, a float copy of it would be the largest buffer by far
+        if (filter == MipFilter::KAISER) decodeLevel(image, srgb, current);
+
+        for (uint32_t level = 1; level < levelCount; level++)
+        {
+            const MipChain::Level& above = chain.levels[level - 1];
+            const MipChain::Level& target = chain.levels[level];
+            next.resize(size_t(target.width) * target.height * 4);
+
+            if (filter == MipFilter::KAISER)
+            {
+                downsampleKaiser(current.data(), above.width, above.height, next.data(), target.width, target.height, scratch);
+            } else if (level == 1)
+            {
+                downsampleBox(above.width, above.height, next.data(), target.width, target.height, [&](size_t y, size_t x)
+                {
+                    return decodeTexel(image.pixels.data() + (y * above.width + x) * 4, colorTable, t.unormToFloat.data());
+                });
+            } else
+            {
+                downsampleBox(above.width, above.height, next.data(), target.width, target.height, [&](size_t y, size_t x)
+                {
+                    return load(current.data() + (y * above.width + x) * 4);
+                });
+            }
+
+            encodeLevel(next.data(), size_t(target.width) * target.height, srgb, chain.data.data() + target.offset);
+            std::swap(current, next);
+        }
+        return chain;
+    }
+
+    uint32_t MipGenerator::LevelCount(uint32_t width, uint32_t height)
+    {
+        uint32_t levels = 1;
+        for (uint32_t size = std::max(width, height); size > 1; size /= 2) levels++;
+        return levels;
+    }
+
+    bool MipGenerator::IsSimd()
+    {
+#ifdef VOIDENGINE_SSE2
+        return true;
+#else
+        return false;
+#endif
+    }
+}
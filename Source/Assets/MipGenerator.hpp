@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Common.hpp"
+#include "ImageDecoder.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VoidEngine
+{
+    enum class MipFilter : uint32_t
+    {
+        BOX,    // 2x2 average, cheapest
+        KAISER, // 8x8 Kaiser windowed sinc, keeps the smaller levels sharper
+    };
+
+    // How the texels of a MipChain are stored. BC formats are 4x4 blocks, see BlockCompressor.
+    enum class TextureFormat : uint32_t
+    {
+        RGBA8,
+        BC1, // RGB, 8 bytes per block
+        BC3, // RGBA, BC1 color plus a BC4 alpha block
+        BC4, // One channel, 8 bytes per block
+        BC5, // Two channels, two BC4 blocks
+        BC7, // RGBA, 16 bytes per block
+    };
+
+    // Every level of an image, largest first, packed back to back the way they are uploaded
+    struct MipChain
+    {
+        struct Level
+        {
+            size_t offset = 0;
+            uint32_t width = 0;
+            uint32_t height = 0;
+        };
+
+        std::vector<Level> levels;
+        std::vector<uint8_t> data;
+        TextureFormat format = TextureFormat::RGBA8;
+
+        // Error of the block compression on the first level in dB, 0 when stored uncompressed
+        float psnr = 0.0f;
+    };
+
+    // CPU mipmap generation. Levels are filtered in linear float space, four channels at a time with SSE2
+    // where the compiler targets it. With `srgb` the color channels are decoded from sRGB before filtering and
+    // encoded again afterwards, so dark and bright texels average to the right brightness. Alpha is always
+    // linear. Each level is filtered from the float copy of the one above, not from its 8-bit result.
+    class MipGenerator
+    {
+    public:
+        VOIDENGINE_API static MipChain Generate(const Image& image, bool srgb, MipFilter filter = MipFilter::BOX);
+
+        // Levels down to 1x1, halving each side and rounding down
+        VOIDENGINE_API static uint32_t LevelCount(uint32_t width, uint32_t height);
+
+        // Whether Generate() uses the SSE2 path in this build
+        VOIDENGINE_API static bool IsSimd();
+    };
+}
@@ -0,0 +1,768 @@
+#include "ObjParser.hpp"
+
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+
+namespace VoidEngine
+{
+    namespace
+    {
+        // Chunks smaller than this are not worth a task
+        constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+        // Per chunk bit flags marking indices that are still relative to the chunk (negative OBJ indices)
+        constexpr uint8_t RELATIVE_POSITION = 1 << 0;
+        constexpr uint8_t RELATIVE_NORMAL = 1 << 1;
+        constexpr uint8_t RELATIVE_TEXCOORD = 1 << 2;
+
+        struct Corner
+        {
+            ObjData::Index index;
+            uint8_t relative = 0;
+        };
+
+        struct Chunk
+        {
+            const char* begin = nullptr;
+            const char* end = nullptr;
+
+            std::vector<float> positions;
+            std::vector<float> colors;
+            std::vector<float> normals;
+            std::vector<float> texcoords;
+
+            std::vector<Corner> corners;
+            std::vector<uint32_t> faceSizes;
+
+            // usemtl names seen in this chunk, and the one each face uses as an index into them. Faces before
+            // the chunk's first usemtl get -1 and keep whatever the previous chunk ended with.
+            std::vector<std::string> materialNames;
+            std::vector<int32_t> faceMaterials;
+            int32_t currentMaterial = -1;
+            std::vector<std::string> materialLibraries;
+
+            // Offsets of this chunk's attributes in the merged streams, in elements
+            size_t positionBase = 0;
+            size_t normalBase = 0;
+            size_t texcoordBase = 0;
+
+            std::vector<ObjData::Index> triangles;
+            std::vector<int32_t> triangleMaterials;
+        };
+
+        bool isSpace(char c) { return c == ' ' || c == '\t'; }
+        bool isDigit(char c) { return c >= '0' && c <= '9'; }
+        bool isTokenEnd(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+        bool isIndexEnd(char c) { return c == '/' || isTokenEnd(c); }
+
+        const char* skipSpaces(const char* p, const char* end)
+        {
+            while (p < end && isSpace(*p)) p++;
+            return p;
+        }
+
+        // Whether the line starts with `keyword` followed by whitespace
+        bool startsWith(const char* p, const char* end, std::string_view keyword)
+        {
+            return static_cast<size_t>(end - p) > keyword.size() && std::memcmp(p, keyword.data(), keyword.size()) == 0 &&
+                isSpace(p[keyword.size()]);
+        }
+
+        // Next whitespace separated token on the line, empty at its end
+        std::string_view nextToken(const char*& p, const char* end)
+        {
+            p = skipSpaces(p, end);
+            const char* tokenEnd = p;
+            while (tokenEnd < end && !isTokenEnd(*tokenEnd)) tokenEnd++;
+
+            const std::string_view token(p, tokenEnd - p);
+            p = tokenEnd;
+            return token;
+        }
+
+        // Reads the next whitespace separated number on the line. The cursor always moves past the token,
+        // even when it is not a number, like tinyobj does.
+        bool tryParseReal(const char*& p, const char* end, float& result)
+        {
+            p = skipSpaces(p, end);
+            const char* tokenEnd = p;
+            while (tokenEnd < end && !isTokenEnd(*tokenEnd)) tokenEnd++;
+
+            const bool parsed = ObjParser::ParseFloat(p, tokenEnd, result);
+            p = tokenEnd;
+            return parsed;
+        }
+
+        float parseReal(const char*& p, const char* end, float defaultValue)
+        {
+            float result;
+            return tryParseReal(p, end, result) ? result : defaultValue;
+        }
+
+        // atoi() semantics: optional sign followed by digits, 0 when there are none
+        int parseInt(const char* p, const char* end)
+        {
+            bool negative = false;
+            if (p < end && (*p == '+' || *p == '-'))
+            {
+                negative = *p == '-';
+                p++;
+            }
+
+            int value = 0;
+            while (p < end && isDigit(*p))
+            {
+                value = value * 10 + (*p - '0');
+                p++;
+            }
+            return negative ? -value : value;
+        }
+
+        const char* skipIndex(const char* p, const char* end)
+        {
+            while (p < end && !isIndexEnd(*p)) p++;
+            return p;
+        }
+
+        // OBJ indices are 1-based, negative ones count back from the last attribute read so far
+        void fixIndex(int value, int32_t localCount, int32_t& index, uint8_t& relative, uint8_t relativeFlag)
+        {
+            if (value > 0)
+            {
+                index = value - 1;
+            } else if (value < 0)
+            {
+                index = localCount + value;
+                relative |= relativeFlag;
+            } else
+            {
+                index = -1;
+            }
+        }
+
+        // v, v/vt, v//vn or v/vt/vn
+        Corner parseCorner(const char*& p, const char* end, const Chunk& chunk)
+        {
+            Corner corner{};
+
+            const int position = parseInt(p, end);
+            if (position == 0)
+            {
+                throw std::runtime_error("Failed to parse OBJ face: zero vertex index");
+            }
+            fixIndex(position, static_cast<int32_t>(chunk.positions.size() / 3), corner.index.position,
+                corner.relative, RELATIVE_POSITION);
+
+            p = skipIndex(p, end);
+            if (p >= end || *p != '/') return corner;
+            p++;
+
+            if (p < end && *p == '/')
+            {
+                p++;
+                fixIndex(parseInt(p, end), static_cast<int32_t>(chunk.normals.size() / 3), corner.index.normal,
+                    corner.relative, RELATIVE_NORMAL);
+                p = skipIndex(p, end);
+                return corner;
+            }
+
+            fixIndex(parseInt(p, end), static_cast<int32_t>(chunk.texcoords.size() / 2), corner.index.texcoord,
+                corner.relative, RELATIVE_TEXCOORD);
+            p = skipIndex(p, end);
+            if (p >= end || *p != '/') return corner;
+            p++;
+
+            fixIndex(parseInt(p, end), static_cast<int32_t>(chunk.normals.size() / 3), corner.index.normal,
+                corner.relative, RELATIVE_NORMAL);
+            p = skipIndex(p, end);
+            return corner;
+        }
+
+        void parseChunk(Chunk& chunk)
+        {
+            const char* p = chunk.begin;
+
+            while (p < chunk.end)
+            {
+                const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+                if (lineEnd == nullptr) lineEnd = chunk.end;
+
+                p = skipSpaces(p, lineEnd);
+
+                if (lineEnd - p >= 2 && p[0] == 'v' && isSpace(p[1]))
+                {
+                    p += 2;
+                    const float x = parseReal(p, lineEnd, 0.0f);
+                    const float y = parseReal(p, lineEnd, 0.0f);
+                    const float z = parseReal(p, lineEnd, 0.0f);
+
+                    // Optional vertex colors. A lone fourth value is `w`, which tinyobj reports as red.
+                    float r, g, b;
+                    if (!tryParseReal(p, lineEnd, r))
+                    {
+                        r = g = b = 1.0f;
+                    } else if (!tryParseReal(p, lineEnd, g))
+                    {
+                        g = b = 1.0f;
+                    } else if (!tryParseReal(p, lineEnd, b))
+                    {
+                        r = g = b = 1.0f;
+                    }
+
+                    chunk.positions.insert(chunk.positions.end(), {x, y, z});
+                    chunk.colors.insert(chunk.colors.end(), {r, g, b});
+                } else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && isSpace(p[2]))
+                {
+                    p += 3;
+                    const float x = parseReal(p, lineEnd, 0.0f);
+                    const float y = parseReal(p, lineEnd, 0.0f);
+                    const float z = parseReal(p, lineEnd, 0.0f);
+                    chunk.normals.insert(chunk.normals.end(), {x, y, z});
+                } else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && isSpace(p[2]))
+                {
+                    p += 3;
+                    const float u = parseReal(p, lineEnd, 0.0f);
+                    const float v = parseReal(p, lineEnd, 0.0f);
+                    chunk.texcoords.insert(chunk.texcoords.end(), {u, v});
+                } else if (lineEnd - p >= 2 && p[0] == 'f' && isSpace(p[1]))
+                {
+                    p = skipSpaces(p + 2, lineEnd);
+
+                    uint32_t faceSize = 0;
+                    while (p < lineEnd && *p != '\r')
+                    {
+                        chunk.corners.push_back(parseCorner(p, lineEnd, chunk));
+                        faceSize++;
+
+                        while (p < lineEnd && isTokenEnd(*p)) p++;
+                    }
+                    chunk.faceSizes.push_back(faceSize);
+                    chunk.faceMaterials.push_back(chunk.currentMaterial);
+                } else if (startsWith(p, lineEnd, "usemtl"))
+                {
+                    // Like tinyobj, only the first token is the name
+                    p += 6;
+                    const std::string_view name = nextToken(p, lineEnd);
+                    if (!name.empty())
+                    {
+                        const auto it = std::find(chunk.materialNames.begin(), chunk.materialNames.end(), name);
+                        chunk.currentMaterial = static_cast<int32_t>(it - chunk.materialNames.begin());
+                        if (it == chunk.materialNames.end()) chunk.materialNames.emplace_back(name);
+                    }
+                } else if (startsWith(p, lineEnd, "mtllib"))
+                {
+                    p += 6;
+                    for (std::string_view name = nextToken(p, lineEnd); !name.empty(); name = nextToken(p, lineEnd))
+                    {
+                        chunk.materialLibraries.emplace_back(name);
+                    }
+                }
+
+                p = lineEnd + 1;
+            }
+        }
+
+        void resolveIndex(int32_t& index, bool relative, size_t base, size_t count)
+        {
+            if (index < 0 && !relative) return;
+
+            const int64_t resolved = relative ? static_cast<int64_t>(base) + index : index;
+            if (resolved < 0 || resolved >= static_cast<int64_t>(count))
+            {
+                throw std::runtime_error("OBJ face index out of range");
+            }
+            index = static_cast<int32_t>(resolved);
+        }
+
+        template<typename T>
+        int pnpoly(int nvert, const T* vertx, const T* verty, T testx, T testy)
+        {
+            int i, j, c = 0;
+            for (i = 0, j = nvert - 1; i < nvert; j = i++)
+            {
+                if (((verty[i] > testy) != (verty[j] > testy)) &&
+                    (testx < (vertx[j] - vertx[i]) * (testy - verty[i]) / (verty[j] - verty[i]) + vertx[i]))
+                    c = !c;
+            }
+            return c;
+        }
+
+        // tinyobj's built-in ear clipping, kept operation for operation so both loaders agree
+        void triangulatePolygon(const ObjData::Index* face, size_t count, const std::vector<float>& v,
+            std::vector<ObjData::Index>& out)
+        {
+            size_t axes[2] = {1, 2};
+            for (size_t k = 0; k < count; ++k)
+            {
+                const float* v0 = &v[3 * face[(k + 0) % count].position];
+                const float* v1 = &v[3 * face[(k + 1) % count].position];
+                const float* v2 = &v[3 * face[(k + 2) % count].position];
+
+                const float e0x = v1[0] - v0[0], e0y = v1[1] - v0[1], e0z = v1[2] - v0[2];
+                const float e1x = v2[0] - v1[0], e1y = v2[1] - v1[1], e1z = v2[2] - v1[2];
+                const float cx = std::fabs(e0y * e1z - e0z * e1y);
+                const float cy = std::fabs(e0z * e1x - e0x * e1z);
+                const float cz = std::fabs(e0x * e1y - e0y * e1x);
+                const float epsilon = std::numeric_limits<float>::epsilon();
+
+                if (cx > epsilon || cy > epsilon || cz > epsilon)
+                {
+                    if (!(cx > cy && cx > cz))
+                    {
+                        axes[0] = 0;
+                        if (cz > cx && cz > cy) axes[1] = 1;
+                    }
+                    break;
+                }
+            }
+
+            std::vector<ObjData::Index> remaining(face, face + count);
+            size_t guessVert = 0;
+            size_t remainingIterations = count;
+            size_t previousRemaining = count;
+
+            while (remaining.size() > 3 && remainingIterations > 0)
+            {
+                const size_t npolys = remaining.size();
+                if (guessVert >= npolys) guessVert -= npolys;
+
+                if (previousRemaining != npolys)
+                {
+                    previousRemaining = npolys;
+                    remainingIterations = npolys;
+                } else
+                {
+                    remainingIterations--;
+                }
+
+                ObjData::Index ind[3];
+                float vx[3], vy[3];
+                for (size_t k = 0; k < 3; k++)
+                {
+                    ind[k] = remaining[(guessVert + k) % npolys];
+                    vx[k] = v[3 * ind[k].position + axes[0]];
+                    vy[k] = v[3 * ind[k].position + axes[1]];
+                }
+
+                const float e0x = vx[1] - vx[0];
+                const float e0y = vy[1] - vy[0];
+                const float e1x = vx[2] - vx[1];
+                const float e1y = vy[2] - vy[1];
+                const float cross = e0x * e1y - e0y * e1x;
+                const float area = (vx[0] * vy[1] - vy[0] * vx[1]) * 0.5f;
+
+                // Reflex corner, try the next one
+                if (cross * area < 0.0f)
+                {
+                    guessVert += 1;
+                    continue;
+                }
+
+                bool overlap = false;
+                for (size_t otherVert = 3; otherVert < npolys; ++otherVert)
+                {
+                    const int32_t position = remaining[(guessVert + otherVert) % npolys].position;
+                    if (pnpoly(3, vx, vy, v[3 * position + axes[0]], v[3 * position + axes[1]]))
+                    {
+                        overlap = true;
+                        break;
+                    }
+                }
+
+                if (overlap)
+                {
+                    guessVert += 1;
+                    continue;
+                }
+
+                out.insert(out.end(), {ind[0], ind[1], ind[2]});
+                remaining.erase(remaining.begin() + static_cast<ptrdiff_t>((guessVert + 1) % npolys));
+            }
+
+            if (remaining.size() == 3)
+            {
+                out.insert(out.end(), {remaining[0], remaining[1], remaining[2]});
+            }
+        }
+
+        void triangulateChunk(Chunk& chunk, const std::vector<float>& positions)
+        {
+            chunk.triangles.reserve(chunk.corners.size());
+
+            std::vector<ObjData::Index> face;
+            size_t corner = 0;
+
+            for (size_t f = 0; f < chunk.faceSizes.size(); f++)
+            {
+                const uint32_t faceSize = chunk.faceSizes[f];
+
+                face.clear();
+                for (uint32_t i = 0; i < faceSize; i++)
+                {
+                    face.push_back(chunk.corners[corner + i].index);
+                }
+                corner += faceSize;
+
+                if (faceSize < 3)
+                {
+                    // Points and lines are not part of the mesh
+                } else if (faceSize == 3)
+                {
+                    chunk.triangles.insert(chunk.triangles.end(), face.begin(), face.end());
+                } else if (faceSize == 4)
+                {
+                    // Split the quad along its shorter diagonal
+                    const float* v0 = &positions[3 * face[0].position];
+                    const float* v1 = &positions[3 * face[1].position];
+                    const float* v2 = &positions[3 * face[2].position];
+                    const float* v3 = &positions[3 * face[3].position];
+
+                    const float e02x = v2[0] - v0[0], e02y = v2[1] - v0[1], e02z = v2[2] - v0[2];
+                    const float e13x = v3[0] - v1[0], e13y = v3[1] - v1[1], e13z = v3[2] - v1[2];
+                    const float sqr02 = e02x * e02x + e02y * e02y + e02z * e02z;
+                    const float sqr13 = e13x * e13x + e13y * e13y + e13z * e13z;
+
+                    if (sqr02 < sqr13)
+                    {
+                        chunk.triangles.insert(chunk.triangles.end(), {face[0], face[1], face[2], face[0], face[2], face[3]});
+                    } else
+                    {
+                        chunk.triangles.insert(chunk.triangles.end(), {face[0], face[1], face[3], face[1], face[2], face[3]});
+                    }
+                } else
+                {
+                    triangulatePolygon(face.data(), face.size(), positions, chunk.triangles);
+                }
+
+                // Every triangle the face turned into uses its material
+                chunk.triangleMaterials.resize(chunk.triangles.size() / 3, chunk.faceMaterials[f]);
+            }
+        }
+
+        template<typename T>
+        void copyStream(const std::vector<T>& source, std::vector<T>& destination, size_t offset)
+        {
+            if (!source.empty())
+            {
+                std::memcpy(destination.data() + offset, source.data(), source.size() * sizeof(T));
+            }
+        }
+    }
+
+    bool ObjParser::ParseFloat(const char* begin, const char* end, float& result)
+    {
+        static constexpr double powersOfTen[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        constexpr uint64_t MAX_MANTISSA = 1000000000000000000ULL;
+
+        const char* p = begin;
+        if (p >= end) return false;
+
+        bool negative = false;
+        if (*p == '+' || *p == '-')
+        {
+            negative = *p == '-';
+            p++;
+        }
+        const char* numberBegin = p;
+
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        bool truncated = false;
+
+        const char* integerBegin = p;
+        while (p < end && isDigit(*p))
+        {
+            if (mantissa < MAX_MANTISSA)
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            } else
+            {
+                exponent++;
+                truncated = true;
+            }
+            p++;
+        }
+
+        // Like tinyobj, ".5" and "-.5" are numbers, a bare sign is not
+        const bool hasDot = p < end && *p == '.';
+        if (p == integerBegin && !hasDot) return false;
+
+        if (hasDot)
+        {
+            p++;
+            while (p < end && isDigit(*p))
+            {
+                if (mantissa < MAX_MANTISSA)
+                {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                    exponent--;
+                } else
+                {
+                    truncated = true;
+                }
+                p++;
+            }
+        }
+
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            p++;
+            bool negativeExponent = false;
+            if (p < end && (*p == '+' || *p == '-'))
+            {
+                negativeExponent = *p == '-';
+                p++;
+            }
+            if (p >= end || !isDigit(*p)) return false;
+
+            int explicitExponent = 0;
+            while (p < end && isDigit(*p))
+            {
+                if (explicitExponent < 100000) explicitExponent = explicitExponent * 10 + (*p - '0');
+                p++;
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        }
+
+        double value;
+        if (!truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+        {
+            // Both operands are exact, so a single multiply or divide is correctly rounded
+            value = static_cast<double>(mantissa);
+            value = exponent < 0 ? value / powersOfTen[-exponent] : value * powersOfTen[exponent];
+        } else
+        {
+            const auto [ptr, ec] = std::from_chars(numberBegin, p, value);
+            if (ec == std::errc::result_out_of_range)
+            {
+                value = exponent > 0 ? std::numeric_limits<double>::infinity() : 0.0;
+            } else if (ec != std::errc{})
+            {
+                value = 0.0;
+            }
+        }
+
+        result = static_cast<float>(negative ? -value : value);
+        return true;
+    }
+
+    ObjData ObjParser::Parse(const std::string& filepath)
+    {
+        const MappedFile file(filepath);
+
+        try
+        {
+            return Parse(reinterpret_cast<const char*>(file.data()), file.size());
+        } catch (const std::runtime_error& e)
+        {
+            throw std::runtime_error(filepath + ": " + e.what());
+        }
+    }
+
+    ObjData ObjParser::Parse(const char* data, size_t size)
+    {
+        ThreadPool& pool = ThreadPool::getInstance();
+
+        // Split into line aligned chunks, a few per thread to even out uneven line mixes
+        const size_t maxChunks = std::max<size_t>(1, size / MIN_CHUNK_SIZE);
+        const size_t chunkCount = std::min(maxChunks, pool.getConcurrency() * 4);
+
+        std::vector<Chunk> chunks;
+        chunks.reserve(chunkCount);
+
+        const char* const end = data + size;
+        const char* begin = data;
+        for (size_t i = 1; i <= chunkCount && begin < end; i++)
+        {
+            const char* split = i == chunkCount ? end : data + size * i / chunkCount;
+            if (split < begin) split = begin;
+            if (split < end)
+            {
+                const char* newline = static_cast<const char*>(std::memchr(split, '\n', end - split));
+                split = newline != nullptr ? newline + 1 : end;
+            }
+
+            Chunk& chunk = chunks.emplace_back();
+            chunk.begin = begin;
+            chunk.end = split;
+            begin = split;
+        }
+
+        pool.parallelFor(chunks.size(), [&](size_t i) { parseChunk(chunks[i]); });
+
+        ObjData result{};
+
+        size_t positionCount = 0;
+        size_t normalCount = 0;
+        size_t texcoordCount = 0;
+        for (auto& chunk : chunks)
+        {
+            chunk.positionBase = positionCount;
+            chunk.normalBase = normalCount;
+            chunk.texcoordBase = texcoordCount;
+            positionCount += chunk.positions.size() / 3;
+            normalCount += chunk.normals.size() / 3;
+            texcoordCount += chunk.texcoords.size() / 2;
+        }
+
+        result.positions.resize(positionCount * 3);
+        result.colors.resize(positionCount * 3);
+        result.normals.resize(normalCount * 3);
+        result.texcoords.resize(texcoordCount * 2);
+
+        // Merge the attribute streams and turn chunk relative face indices into absolute ones
+        pool.parallelFor(chunks.size(), [&](size_t i)
+        {
+            Chunk& chunk = chunks[i];
+            copyStream(chunk.positions, result.positions, chunk.positionBase * 3);
+            copyStream(chunk.colors, result.colors, chunk.positionBase * 3);
+            copyStream(chunk.normals, result.normals, chunk.normalBase * 3);
+            copyStream(chunk.texcoords, result.texcoords, chunk.texcoordBase * 2);
+
+            for (auto& corner : chunk.corners)
+            {
+                resolveIndex(corner.index.position, corner.relative & RELATIVE_POSITION, chunk.positionBase, positionCount);
+                resolveIndex(corner.index.normal, corner.relative & RELATIVE_NORMAL, chunk.normalBase, normalCount);
+                resolveIndex(corner.index.texcoord, corner.relative & RELATIVE_TEXCOORD, chunk.texcoordBase, texcoordCount);
+            }
+        });
+
+        // Quads and polygons look at positions from any chunk, so this waits for the merge
+        pool.parallelFor(chunks.size(), [&](size_t i) { triangulateChunk(chunks[i], result.positions); });
+
+        size_t indexCount = 0;
+        for (const auto& chunk : chunks) indexCount += chunk.triangles.size();
+
+        result.indices.resize(indexCount);
+        result.triangleMaterials.reserve(indexCount / 3);
+        size_t indexOffset = 0;
+
+        // The usemtl in effect carries over chunk boundaries, so material ids are resolved in file order
+        int32_t currentMaterial = -1;
+        for (const auto& chunk : chunks)
+        {
+            copyStream(chunk.triangles, result.indices, indexOffset);
+            indexOffset += chunk.triangles.size();
+
+            std::vector<int32_t> materialIds(chunk.materialNames.size());
+            for (size_t i = 0; i < chunk.materialNames.size(); i++)
+            {
+                const auto it = std::find(result.materialNames.begin(), result.materialNames.end(), chunk.materialNames[i]);
+                materialIds[i] = static_cast<int32_t>(it - result.materialNames.begin());
+                if (it == result.materialNames.end()) result.materialNames.push_back(chunk.materialNames[i]);
+            }
+
+            for (const int32_t material : chunk.triangleMaterials)
+            {
+                result.triangleMaterials.push_back(material >= 0 ? materialIds[material] : currentMaterial);
+            }
+            if (chunk.currentMaterial >= 0) currentMaterial = materialIds[chunk.currentMaterial];
+
+            for (const auto& library : chunk.materialLibraries)
+            {
+                if (std::find(result.materialLibraries.begin(), result.materialLibraries.end(), library) == result.materialLibraries.end())
+                {
+                    result.materialLibraries.push_back(library);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    std::vector<Model::MaterialDesc> ObjParser::ParseMaterials(const std::string& filepath)
+    {
+        const MappedFile file(filepath);
+        const std::string directory = std::filesystem::path(filepath).parent_path().generic_string();
+
+        try
+        {
+            return ParseMaterials(reinterpret_cast<const char*>(file.data()), file.size(), directory);
+        } catch (const std::runtime_error& e)
+        {
+            throw std::runtime_error(filepath + ": " + e.what());
+        }
+    }
+
+    std::vector<Model::MaterialDesc> ObjParser::ParseMaterials(const char* data, size_t size,
+        const std::string& directory)
+    {
+        std::vector<Model::MaterialDesc> materials;
+        // d wins over Tr when a material has both, exporters disagree on what Tr means
+        bool hasDissolve = false;
+
+        const char* p = data;
+        const char* const end = data + size;
+        while (p < end)
+        {
+            const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (lineEnd == nullptr) lineEnd = end;
+
+            p = skipSpaces(p, lineEnd);
+
+            if (startsWith(p, lineEnd, "newmtl"))
+            {
+                p += 6;
+                auto& material = materials.emplace_back();
+                material.name = nextToken(p, lineEnd);
+                // Blinn-Phong without a specular map is a dielectric
+                material.metallicFactor = 0.0f;
+                hasDissolve = false;
+            } else if (materials.empty())
+            {
+                // Nothing before the first newmtl belongs to a material
+            } else if (startsWith(p, lineEnd, "Kd"))
+            {
+                p += 2;
+                auto& color = materials.back().baseColorFactor;
+                color.r = parseReal(p, lineEnd, 0.0f);
+                color.g = parseReal(p, lineEnd, color.r);
+                color.b = parseReal(p, lineEnd, color.r);
+            } else if (startsWith(p, lineEnd, "d"))
+            {
+                p += 1;
+                materials.back().baseColorFactor.a = parseReal(p, lineEnd, 1.0f);
+                hasDissolve = true;
+            } else if (startsWith(p, lineEnd, "Tr"))
+            {
+                p += 2;
+                if (!hasDissolve) materials.back().baseColorFactor.a = 1.0f - parseReal(p, lineEnd, 0.0f);
+            } else if (startsWith(p, lineEnd, "Ns"))
+            {
+                // Blinn-Phong exponent to the roughness that has the same highlight width, 2 / a^2 - 2 = Ns
+                p += 2;
+                const float shininess = std::max(parseReal(p, lineEnd, 0.0f), 0.0f);
+                materials.back().roughnessFactor = std::sqrt(2.0f / (shininess + 2.0f));
+            } else if (startsWith(p, lineEnd, "map_Kd"))
+            {
+                // Options like -bm come first, the file name is the last token
+                p += 6;
+                std::string_view path;
+                for (std::string_view token = nextToken(p, lineEnd); !token.empty(); token = nextToken(p, lineEnd))
+                {
+                    path = token;
+                }
+
+                std::string texture(path);
+                std::replace(texture.begin(), texture.end(), '\\', '/');
+                materials.back().baseColorTexture = texture.empty() || directory.empty() ? texture : directory + "/" + texture;
+            }
+
+            p = lineEnd + 1;
+        }
+
+        return materials;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Model.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Wavefront OBJ geometry as flat attribute streams plus triangulated corners.
+    // Only what Model consumes is kept: v (with optional vertex colors), vn, vt, f, mtllib and usemtl.
+    struct ObjData
+    {
+        // One corner of a triangle. Indices are 0-based into the streams below, -1 when absent.
+        struct Index
+        {
+            int32_t position = -1;
+            int32_t normal = -1;
+            int32_t texcoord = -1;
+        };
+
+        std::vector<float> positions; // xyz
+        std::vector<float> colors;    // rgb, one entry per position, white when the file has none
+        std::vector<float> normals;   // xyz
+        std::vector<float> texcoords; // uv
+
+        std::vector<Index> indices;   // three per triangle, in file order
+
+        std::vector<std::string> materialLibraries; // mtllib file names, relative to the OBJ file
+        std::vector<std::string> materialNames;     // usemtl names, in order of first use
+        std::vector<int32_t> triangleMaterials;     // Index into materialNames per triangle, -1 before the first usemtl
+    };
+
+    // Memory maps an OBJ file and parses line aligned chunks of it on the ThreadPool.
+    // Results match tinyobj::LoadObj with its default triangulation and color fallback.
+    class ObjParser
+    {
+    public:
+        VOIDENGINE_API static ObjData Parse(const std::string& filepath);
+        VOIDENGINE_API static ObjData Parse(const char* data, size_t size);
+
+        // Reads the materials of an .mtl library: Kd, d (or Tr), Ns and map_Kd. OBJ materials are Blinn-Phong,
+        // they are converted to metallic-roughness with no metal and the roughness whose Blinn-Phong exponent is
+        // Ns. Ks has no equivalent and is ignored. Texture paths are made relative to the working directory.
+        VOIDENGINE_API static std::vector<Model::MaterialDesc> ParseMaterials(const std::string& filepath);
+        VOIDENGINE_API static std::vector<Model::MaterialDesc> ParseMaterials(const char* data, size_t size,
+            const std::string& directory);
+
+        // Parses a single number the way the OBJ reader does. Returns false when `begin` does not start with
+        // one, trailing characters after a valid prefix are ignored.
+        VOIDENGINE_API static bool ParseFloat(const char* begin, const char* end, float& result);
+    };
+}
@@ -0,0 +1,147 @@
+#include "TangentGenerator.hpp"
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace VoidEngine
+{
+    namespace
+    {
+        // Triangles per parallelFor task
+        constexpr size_t BATCH_SIZE = 4096;
+
+        // Handedness of a triangle's texture space. Triangles without texture space area join either.
+        enum Orientation : uint8_t
+        {
+            ANY = 0,
+            POSITIVE = 1,
+            NEGATIVE = 2,
+        };
+
+        // `v` projected onto the plane perpendicular to `normal`, normalized unless it vanishes
+        glm::vec3 projectUnit(glm::vec3 v, const glm::vec3& normal)
+        {
+            v -= normal * glm::dot(normal, v);
+            const float length = glm::length(v);
+            return length > FLT_MIN ? v / length : v;
+        }
+
+        glm::vec3 finishTangent(const glm::vec3& sum, const glm::vec3& normal)
+        {
+            const float length = glm::length(sum);
+            if (length > FLT_MIN) return sum / length;
+
+            // No triangle of the vertex has texture space area, any tangent will do
+            const glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3{1.0f, 0.0f, 0.0f} : glm::vec3{0.0f, 1.0f, 0.0f};
+            const glm::vec3 tangent = projectUnit(axis, normal);
+            return glm::dot(tangent, tangent) > 0.0f ? tangent : glm::vec3{1.0f, 0.0f, 0.0f};
+        }
+    }
+
+    std::vector<glm::vec4> TangentGenerator::Generate(std::vector<Model::Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        const size_t vertexCount = vertices.size();
+
+        // Angle weighted tangent of every corner, each triangle only writes its own three
+        std::vector<glm::vec3> cornerTangents(triangleCount * 3);
+        std::vector<uint8_t> cornerOrientations(triangleCount * 3);
+
+        const size_t batchCount = (triangleCount + BATCH_SIZE - 1) / BATCH_SIZE;
+        ThreadPool::getInstance().parallelFor(batchCount, [&](size_t batch)
+        {
+            const size_t end = std::min(triangleCount, (batch + 1) * BATCH_SIZE);
+            for (size_t t = batch * BATCH_SIZE; t < end; t++)
+            {
+                const Model::Vertex* corners[3] = {
+                    &vertices[indices[t * 3 + 0]], &vertices[indices[t * 3 + 1]], &vertices[indices[t * 3 + 2]]
+                };
+
+                const glm::vec3 d1 = corners[1]->position - corners[0]->position;
+                const glm::vec3 d2 = corners[2]->position - corners[0]->position;
+                const glm::vec2 st1 = corners[1]->uv - corners[0]->uv;
+                const glm::vec2 st2 = corners[2]->uv - corners[0]->uv;
+
+                const float signedArea = st1.x * st2.y - st1.y * st2.x;
+                if (!(std::abs(signedArea) > FLT_MIN))
+                {
+                    for (size_t c = 0; c < 3; c++)
+                    {
+                        cornerTangents[t * 3 + c] = glm::vec3{0.0f};
+                        cornerOrientations[t * 3 + c] = ANY;
+                    }
+                    continue;
+                }
+
+                // Direction of increasing u, flipped on mirrored triangles so the sign ends up in w alone
+                const float sign = signedArea > 0.0f ? 1.0f : -1.0f;
+                const glm::vec3 triangleTangent = (st2.y * d1 - st1.y * d2) * sign;
+
+                for (size_t c = 0; c < 3; c++)
+                {
+                    const glm::vec3& position = corners[c]->position;
+                    const glm::vec3& normal = corners[c]->normal;
+                    const glm::vec3 toPrevious = projectUnit(corners[(c + 2) % 3]->position - position, normal);
+                    const glm::vec3 toNext = projectUnit(corners[(c + 1) % 3]->position - position, normal);
+                    const float angle = std::acos(std::clamp(glm::dot(toPrevious, toNext), -1.0f, 1.0f));
+
+                    cornerTangents[t * 3 + c] = projectUnit(triangleTangent, normal) * angle;
+                    cornerOrientations[t * 3 + c] = signedArea > 0.0f ? POSITIVE : NEGATIVE;
+                }
+            }
+        });
+
+        // Sum the corners of every vertex per handedness
+        std::vector<glm::vec3> positiveSums(vertexCount, glm::vec3{0.0f});
+        std::vector<glm::vec3> negativeSums(vertexCount, glm::vec3{0.0f});
+        std::vector<uint8_t> vertexOrientations(vertexCount, ANY);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            const uint32_t vertex = indices[i];
+            const uint8_t orientation = cornerOrientations[i];
+            if (orientation == ANY) continue;
+
+            vertexOrientations[vertex] |= orientation;
+            (orientation == POSITIVE ? positiveSums : negativeSums)[vertex] += cornerTangents[i];
+        }
+
+        // One copy per handedness where both meet. The original keeps the positive side.
+        std::vector<uint32_t> mirrored(vertexCount, UINT32_MAX);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            if (vertexOrientations[v] != (POSITIVE | NEGATIVE)) continue;
+
+            mirrored[v] = static_cast<uint32_t>(vertices.size());
+            const Model::Vertex copy = vertices[v];
+            vertices.push_back(copy);
+        }
+
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            const uint32_t vertex = indices[i];
+            if (cornerOrientations[i] == NEGATIVE && mirrored[vertex] != UINT32_MAX) indices[i] = mirrored[vertex];
+        }
+
+        std::vector<glm::vec4> tangents(vertices.size());
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            const glm::vec3& normal = vertices[v].normal;
+            if (vertexOrientations[v] == NEGATIVE)
+            {
+                tangents[v] = glm::vec4{finishTangent(negativeSums[v], normal), -1.0f};
+                continue;
+            }
+
+            tangents[v] = glm::vec4{finishTangent(positiveSums[v], normal), 1.0f};
+            if (mirrored[v] != UINT32_MAX)
+            {
+                tangents[mirrored[v]] = glm::vec4{finishTangent(negativeSums[v], normal), -1.0f};
+            }
+        }
+
+        return tangents;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Model.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Per vertex tangent frames for normal mapping, matching MikkTSpace (Mikkelsen 2008), which is what Blender,
+    // Substance and most bakers use. Normal maps only look right when they are sampled in the tangent space they
+    // were baked in.
+    //
+    // Like MikkTSpace, every corner gets the triangle's texture space tangent projected onto the corner's normal,
+    // weighted by the corner angle, and the corners of a vertex are summed per handedness. Triangles are processed
+    // in parallel. Vertices shared by mirrored and unmirrored triangles are split into one copy per handedness
+    // afterwards, the others keep their index.
+    class TangentGenerator
+    {
+    public:
+        // Returns a tangent per vertex: xyz is the unit tangent, w the bitangent sign, so
+        // bitangent = w * cross(normal, tangent). Appends the split vertices to `vertices` and points the corners
+        // of mirrored triangles at them. Corners whose triangles have no texture space area take the tangent of
+        // their vertex, or an arbitrary one perpendicular to the normal when it has none either.
+        VOIDENGINE_API static std::vector<glm::vec4> Generate(std::vector<Model::Vertex>& vertices,
+            std::vector<uint32_t>& indices);
+    };
+}
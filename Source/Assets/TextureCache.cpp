@@ -0,0 +1,153 @@
+#include "TextureCache.hpp"
+#include "BlockCompressor.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace VoidEngine
+{
+    static_assert(sizeof(TextureCache::Header) == 48, "TextureCache::Header layout changed, bump TextureCache::VERSION");
+    static_assert(sizeof(TextureCache::Level) == 16, "TextureCache::Level layout changed, bump TextureCache::VERSION");
+
+    std::string TextureCache::GetCachePath(const std::string& sourcePath)
+    {
+        return sourcePath + ".vtex";
+    }
+
+    uint64_t TextureCache::HashSource(const MappedFile& source, const Texture::ImportOptions& options)
+    {
+        // Options are hashed field by field, the struct may contain padding. useCache doesn't change the result.
+        uint64_t hash = hashBytes(source.data(), source.size(), VERSION);
+        hash = hashBytes(&options.colorSpace, sizeof(options.colorSpace), hash);
+        hash = hashBytes(&options.generateMips, sizeof(options.generateMips), hash);
+        hash = hashBytes(&options.mipFilter, sizeof(options.mipFilter), hash);
+        hash = hashBytes(&options.compression, sizeof(options.compression), hash);
+        hash = hashBytes(&options.compressionQuality, sizeof(options.compressionQuality), hash);
+        return hash;
+    }
+
+    TextureCache::TextureCache(MappedFile mappedFile) : file(std::move(mappedFile))
+    {
+    }
+
+    std::unique_ptr<TextureCache> TextureCache::Open(const std::string& cachePath, uint64_t sourceHash)
+    {
+        // Caches can be packed into an archive along with their sources
+        if (!MappedFile::Exists(cachePath)) return nullptr;
+
+        std::unique_ptr<TextureCache> cache;
+        try
+        {
+            cache.reset(new TextureCache(MappedFile(cachePath)));
+        } catch (const std::exception& e)
+        {
+            std::cerr << "TextureCache: " << e.what() << "\n";
+            return nullptr;
+        }
+
+        const MappedFile& f = cache->file;
+        if (f.size() < sizeof(Header)) return nullptr;
+
+        Header header{};
+        std::memcpy(&header, f.data(), sizeof(Header));
+
+        if (header.magic != MAGIC || header.version != VERSION) return nullptr;
+        if (header.sourceHash != sourceHash) return nullptr;
+        if (header.levelCount == 0 || header.format > TextureFormat::BC7) return nullptr;
+
+        const uint64_t tableEnd = sizeof(Header) + static_cast<uint64_t>(header.levelCount) * sizeof(Level);
+        if (tableEnd > f.size() || header.dataOffset < tableEnd || header.dataOffset + header.dataSize > f.size())
+        {
+            return nullptr;
+        }
+
+        // Reject truncated files up front so GetMipChain() never reads past the mapping
+        for (uint32_t i = 0; i < header.levelCount; i++)
+        {
+            Level level{};
+            std::memcpy(&level, f.data() + sizeof(Header) + i * sizeof(Level), sizeof(Level));
+            const uint64_t size = BlockCompressor::LevelSize(header.format, level.width, level.height);
+            if (level.width == 0 || level.height == 0 || level.offset + size > header.dataSize) return nullptr;
+        }
+
+        return cache;
+    }
+
+    bool TextureCache::Write(const std::string& cachePath, uint64_t sourceHash, const MipChain& chain)
+    {
+        Header header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.sourceHash = sourceHash;
+        header.format = chain.format;
+        header.levelCount = static_cast<uint32_t>(chain.levels.size());
+        header.psnr = chain.psnr;
+        header.dataSize = chain.data.size();
+
+        std::vector<Level> levels;
+        for (const auto& level : chain.levels)
+        {
+            levels.push_back({level.offset, level.width, level.height});
+        }
+
+        const uint64_t tableEnd = sizeof(Header) + levels.size() * sizeof(Level);
+        header.dataOffset = (tableEnd + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+
+        // Write to a temporary file first so a crash or a concurrent reader never sees a partial cache
+        const std::string tmpPath = cachePath + ".tmp";
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open())
+            {
+                std::cerr << "TextureCache: Failed to open " << tmpPath << " for writing.\n";
+                return false;
+            }
+
+            static constexpr char padding[DATA_ALIGNMENT]{};
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(levels.data()), static_cast<std::streamsize>(levels.size() * sizeof(Level)));
+            out.write(padding, static_cast<std::streamsize>(header.dataOffset - tableEnd));
+            out.write(reinterpret_cast<const char*>(chain.data.data()), static_cast<std::streamsize>(chain.data.size()));
+
+            if (!out.good())
+            {
+                std::cerr << "TextureCache: Failed to write " << tmpPath << ".\n";
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, cachePath, ec);
+        if (ec)
+        {
+            std::cerr << "TextureCache: Failed to replace " << cachePath << ": " << ec.message() << "\n";
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+
+        return true;
+    }
+
+    MipChain TextureCache::GetMipChain() const
+    {
+        Header header{};
+        std::memcpy(&header, file.data(), sizeof(Header));
+
+        MipChain chain;
+        chain.format = header.format;
+        chain.psnr = header.psnr;
+        for (uint32_t i = 0; i < header.levelCount; i++)
+        {
+            Level level{};
+            std::memcpy(&level, file.data() + sizeof(Header) + i * sizeof(Level), sizeof(Level));
+            chain.levels.push_back({static_cast<size_t>(level.offset), level.width, level.height});
+        }
+
+        const uint8_t* data = file.data() + header.dataOffset;
+        chain.data.assign(data, data + header.dataSize);
+        return chain;
+    }
+}
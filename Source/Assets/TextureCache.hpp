@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Common.hpp"
+#include "MappedFile.hpp"
+#include "Texture.hpp"
+
+#include <memory>
+#include <string>
+
+namespace VoidEngine
+{
+    // Versioned binary cache of an imported and block compressed texture, written next to the source file
+    // the first time it is imported so later loads skip decoding, mip generation and encoding. The level data
+    // is stored exactly as it is uploaded.
+    //
+    // File layout:
+    //   Header | Level[levelCount] | level data (aligned to DATA_ALIGNMENT)
+    class TextureCache
+    {
+    public:
+        static constexpr uint32_t MAGIC = 0x58455456; // "VTEX"
+        static constexpr uint32_t VERSION = 1;
+        static constexpr uint64_t DATA_ALIGNMENT = 64;
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t sourceHash;    // hashBytes() of the source file contents and import options
+            TextureFormat format;
+            uint32_t levelCount;
+            float psnr;             // MipChain::psnr
+            uint32_t reserved;
+            uint64_t dataOffset;    // From the start of the file
+            uint64_t dataSize;
+        };
+
+        struct Level
+        {
+            uint64_t offset;        // From dataOffset
+            uint32_t width;
+            uint32_t height;
+        };
+
+        VOIDENGINE_API static std::string GetCachePath(const std::string& sourcePath);
+        VOIDENGINE_API static uint64_t HashSource(const MappedFile& source, const Texture::ImportOptions& options);
+
+        // Returns nullptr if the cache is missing, was written by another version or no
+        // longer matches the source file.
+        VOIDENGINE_API static std::unique_ptr<TextureCache> Open(const std::string& cachePath, uint64_t sourceHash);
+        VOIDENGINE_API static bool Write(const std::string& cachePath, uint64_t sourceHash, const MipChain& chain);
+
+        MipChain GetMipChain() const;
+
+    private:
+        explicit TextureCache(MappedFile mappedFile);
+
+        MappedFile file;
+    };
+}
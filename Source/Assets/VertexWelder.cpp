@@ -0,0 +1,172 @@
+#include "VertexWelder.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+namespace VoidEngine
+{
+    static_assert(sizeof(Model::Vertex) == 11 * sizeof(float), "VertexWelder hashes Vertex as 11 packed floats");
+
+    namespace
+    {
+        constexpr uint64_t C1 = 0x87C37B91114253D5ULL;
+        constexpr uint64_t C2 = 0x4CF5AD432745937FULL;
+
+        // Murmur3 style mixing of one 64-bit lane
+        inline uint64_t mixLane(uint64_t h, uint64_t k)
+        {
+            k *= C1;
+            k = std::rotl(k, 31);
+            k *= C2;
+            h ^= k;
+            return std::rotl(h, 27) * 5 + 0x52DCE729;
+        }
+
+        inline uint32_t finalize(uint64_t h)
+        {
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDULL;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53ULL;
+            h ^= h >> 33;
+            return static_cast<uint32_t>(h);
+        }
+
+        // Grid cell of a component. Clamped so huge values cannot overflow the integer conversion.
+        inline int64_t quantize(float value, double inverseEpsilon)
+        {
+            const double cell = std::floor(static_cast<double>(value) * inverseEpsilon + 0.5);
+            return static_cast<int64_t>(std::clamp(cell, -4.0e18, 4.0e18));
+        }
+    }
+
+    VertexWelder::VertexWelder(std::vector<Model::Vertex>& vertices, size_t expectedCorners, float epsilon)
+        : vertices(vertices), epsilon(epsilon), inverseEpsilon(epsilon > 0.0f ? 1.0 / epsilon : 0.0)
+    {
+        if (epsilon < 0.0f)
+        {
+            throw std::invalid_argument("VertexWelder epsilon must not be negative");
+        }
+
+        // Sized for up to half of the corners being unique, which covers smooth meshes. Flat shaded
+        // meshes grow the table once.
+        const size_t capacity = std::bit_ceil(std::max<size_t>(expectedCorners, 64));
+        slots.assign(capacity, Slot{0, EMPTY});
+        mask = capacity - 1;
+
+        vertices.reserve(vertices.size() + expectedCorners / 2);
+    }
+
+    void VertexWelder::Add(const Model::Vertex* corners, size_t count, std::vector<uint32_t>& indices)
+    {
+        uint32_t hashes[BLOCK_SIZE];
+
+        for (size_t base = 0; base < count; base += BLOCK_SIZE)
+        {
+            const size_t blockCount = std::min(BLOCK_SIZE, count - base);
+            hashBlock(corners + base, blockCount, hashes);
+
+            for (size_t i = 0; i < blockCount; i++)
+            {
+                indices.push_back(insert(corners[base + i], hashes[i]));
+            }
+        }
+    }
+
+    void VertexWelder::hashBlock(const Model::Vertex* corners, size_t count, uint32_t* hashes) const
+    {
+        if (epsilon == 0.0f)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                uint32_t words[COMPONENTS + 1];
+                std::memcpy(words, &corners[i], sizeof(Model::Vertex));
+                words[COMPONENTS] = 0;
+
+                uint64_t h = 0;
+                for (size_t w = 0; w < COMPONENTS + 1; w += 2)
+                {
+                    // -0.0f has to hash like 0.0f since they compare equal
+                    const uint64_t lo = words[w] == 0x80000000u ? 0u : words[w];
+                    const uint64_t hi = words[w + 1] == 0x80000000u ? 0u : words[w + 1];
+                    h = mixLane(h, lo | (hi << 32));
+                }
+                hashes[i] = finalize(h);
+            }
+        } else
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                const float* components = &corners[i].position.x;
+
+                uint64_t h = 0;
+                for (size_t c = 0; c < COMPONENTS; c++)
+                {
+                    h = mixLane(h, static_cast<uint64_t>(quantize(components[c], inverseEpsilon)));
+                }
+                hashes[i] = finalize(h);
+            }
+        }
+    }
+
+    uint32_t VertexWelder::insert(const Model::Vertex& corner, uint32_t hash)
+    {
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            Slot& slot = slots[i];
+
+            if (slot.index == EMPTY)
+            {
+                if (vertices.size() >= EMPTY)
+                {
+                    throw std::runtime_error("VertexWelder: too many unique vertices for 32-bit indices");
+                }
+
+                const auto index = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(corner);
+                slot = {hash, index};
+
+                // Keep the load factor at or below 1/2 so probe sequences stay short
+                if (++used * 2 > slots.size()) grow();
+                return index;
+            }
+
+            if (slot.hash == hash && equal(vertices[slot.index], corner))
+            {
+                return slot.index;
+            }
+        }
+    }
+
+    bool VertexWelder::equal(const Model::Vertex& a, const Model::Vertex& b) const
+    {
+        if (epsilon == 0.0f) return a == b;
+
+        const float* componentsA = &a.position.x;
+        const float* componentsB = &b.position.x;
+        for (size_t c = 0; c < COMPONENTS; c++)
+        {
+            if (quantize(componentsA[c], inverseEpsilon) != quantize(componentsB[c], inverseEpsilon)) return false;
+        }
+        return true;
+    }
+
+    void VertexWelder::grow()
+    {
+        std::vector<Slot> old(slots.size() * 2, Slot{0, EMPTY});
+        old.swap(slots);
+        mask = slots.size() - 1;
+
+        // Stored hashes make rehashing a pure move, no vertex is touched
+        for (const Slot& slot : old)
+        {
+            if (slot.index == EMPTY) continue;
+
+            size_t i = slot.hash & mask;
+            while (slots[i].index != EMPTY) i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+    }
+}
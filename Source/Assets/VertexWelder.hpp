@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Model.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Flat open addressing table that merges identical triangle corners into unique vertices.
+    //
+    // Slots only hold a 32-bit hash and an index into the output vertex array, so the table costs
+    // 8 bytes per slot and never allocates per vertex. Corners are hashed in blocks straight from
+    // their raw bits before being probed, which keeps the hashing loop free of branches.
+    //
+    // With an epsilon of 0 corners must match exactly (-0 and +0 compare equal, like Vertex::operator==).
+    // A positive epsilon snaps every component to a grid of that size before comparing, so nearly
+    // identical corners merge into the first one seen. Values straddling a grid line still stay apart.
+    class VertexWelder
+    {
+    public:
+        // `vertices` receives the unique vertices, in order of first appearance
+        VOIDENGINE_API VertexWelder(std::vector<Model::Vertex>& vertices, size_t expectedCorners, float epsilon = 0.0f);
+
+        // Welds `count` corners and appends one index per corner to `indices`
+        VOIDENGINE_API void Add(const Model::Vertex* corners, size_t count, std::vector<uint32_t>& indices);
+
+        // Number of corners that can be handed to Add() at once without the hashes spilling out of the stack
+        static constexpr size_t BLOCK_SIZE = 1024;
+
+    private:
+        struct Slot
+        {
+            uint32_t hash;
+            uint32_t index; // EMPTY when unused
+        };
+
+        static constexpr uint32_t EMPTY = 0xFFFFFFFF;
+        static constexpr size_t COMPONENTS = sizeof(Model::Vertex) / sizeof(float);
+
+        void hashBlock(const Model::Vertex* corners, size_t count, uint32_t* hashes) const;
+        uint32_t insert(const Model::Vertex& corner, uint32_t hash);
+        bool equal(const Model::Vertex& a, const Model::Vertex& b) const;
+        void grow();
+
+        std::vector<Model::Vertex>& vertices;
+        std::vector<Slot> slots;
+        size_t mask = 0;
+        size_t used = 0;
+        float epsilon;
+        double inverseEpsilon;
+    };
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <functional>
 
 #ifdef _WIN32
@@ -12,6 +14,11 @@
     #define VOIDENGINE_API
 #endif
 
+// SSE2 is part of every x86-64 target, MSVC just doesn't define __SSE2__ for it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define VOIDENGINE_SSE2
+#endif
+
 #ifndef ENGINE_DIR
     #define ENGINE_DIR "../"
 #endif
@@ -24,4 +31,46 @@ namespace VoidEngine
         seed ^= std::hash<T>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
         (hashCombine(seed, rest), ...);
     };
+
+    // 64-bit hash over a raw byte range, consumed 8 bytes at a time. Used to fingerprint
+    // source assets, not for security.
+    inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0)
+    {
+        constexpr uint64_t m = 0xc6a4a7935bd1e995ULL;
+        constexpr int r = 47;
+
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        uint64_t h = seed ^ (size * m);
+
+        const size_t blocks = size / 8;
+        for (size_t i = 0; i < blocks; i++)
+        {
+            uint64_t k;
+            std::memcpy(&k, bytes + i * 8, sizeof(k));
+
+            k *= m;
+            k ^= k >> r;
+            k *= m;
+
+            h ^= k;
+            h *= m;
+        }
+
+        const unsigned char* tail = bytes + blocks * 8;
+        uint64_t t = 0;
+        for (size_t i = 0; i < (size & 7); i++)
+        {
+            t |= static_cast<uint64_t>(tail[i]) << (8 * i);
+        }
+        if (size & 7)
+        {
+            h ^= t;
+            h *= m;
+        }
+
+        h ^= h >> r;
+        h *= m;
+        h ^= h >> r;
+        return h;
+    }
 }
\ No newline at end of file
@@ -6,25 +6,29 @@
 
 namespace VoidEngine
 {
-    std::atomic<unsigned int> GameObject::nextId{0};
-
-
-    GameObject::GameObject(unsigned int objId, Game* game) : game_(*game), id(objId), device_(*game->GetDevice())
-    //, model(device_)
+    GameObject::GameObject(Game* game)
+        : game_(*game), device_(*game->GetDevice()), world_(game->GetSceneManager()->GetWorld()),
+          hierarchy_(game->GetSceneManager()->GetTransformHierarchy()),
+          spatialIndex_(game->GetSceneManager()->GetSpatialIndex())
     {
-        init();
+        entity = world_.Create(Transform{}, WorldMatrix{}, GameObjectRef{this});
     }
 
-    GameObject::GameObject(Game* game) : game_(*game),  id(nextId++), device_(*game->GetDevice())//, model(device_)
+    GameObject::~GameObject()
     {
-        init();
+        if (world_.Has<TransformNode>(entity)) hierarchy_.Remove(entity);
+        spatialIndex_.Remove(entity);
+        world_.Destroy(entity);
     }
 
     GameObject::GameObject(GameObject&& other) noexcept
-        : device_(other.device_), id(other.id), transform(other.transform), game_(other.game_)
+        : game_(other.game_), device_(other.device_), world_(other.world_), hierarchy_(other.hierarchy_),
+          spatialIndex_(other.spatialIndex_), entity(other.entity), handle(other.handle)
     {
-        // Ensure the moved object is in a valid state
-        other.id = 0;
+        // The entity now belongs to this object, the moved from one is left without one
+        if (world_.IsAlive(entity)) world_.Get<GameObjectRef>(entity)->object = this;
+        other.entity = {};
+        other.handle = {};
     }
 
     GameObject& GameObject::operator=(GameObject&& other) noexcept {
@@ -32,25 +36,86 @@ namespace VoidEngine
             return *this; // Handle self-assignment
 
         //device_ = other.device_; // Reassign device reference
-        id = other.id;
-        model = std::move(other.model); // Transfer ownership of model
-        transform = other.transform; // Move transform
+        if (world_.Has<TransformNode>(entity)) hierarchy_.Remove(entity);
+        spatialIndex_.Remove(entity);
+        world_.Destroy(entity);
+        entity = other.entity;
+        handle = other.handle;
+        if (world_.IsAlive(entity)) world_.Get<GameObjectRef>(entity)->object = this;
 
         // Invalidate the moved object
-        other.id = 0;
+        other.entity = {};
+        other.handle = {};
 
         return *this;
     }
 
+    GameObject::GameObject(const GameObject& other)
+        : game_(other.game_), device_(other.device_), world_(other.world_), hierarchy_(other.hierarchy_),
+          spatialIndex_(other.spatialIndex_)
+    {
+        entity = world_.Create(Transform{}, WorldMatrix{}, GameObjectRef{this});
+        other.copyComponentsTo(entity);
+    }
+
+    GameObject& GameObject::operator=(const GameObject& other)
+    {
+        if (this == &other) return *this; // Handle self-assignment
+        // Keeps its own handle, only the components are copied
+        other.copyComponentsTo(entity);
+        //device_ = other.device_;
+        return *this;
+    }
+
+    std::shared_ptr<Model> GameObject::GetModel() const
+    {
+        const auto* renderer = world_.Get<const MeshRenderer>(entity);
+        return renderer != nullptr ? renderer->model : nullptr;
+    }
+
+    void GameObject::SetModel(std::shared_ptr<Model> model)
+    {
+        if (model == nullptr)
+        {
+            world_.Remove<MeshRenderer>(entity);
+            return;
+        }
+        world_.Add(entity, MeshRenderer{std::move(model)});
+    }
+
+    void GameObject::SetOccluder(std::shared_ptr<const OccluderMesh> mesh)
+    {
+        if (mesh == nullptr)
+        {
+            world_.Remove<Occluder>(entity);
+            return;
+        }
+        world_.Add(entity, Occluder{std::move(mesh)});
+    }
+
+    void GameObject::SetParent(const GameObject* parent)
+    {
+        hierarchy_.SetParent(entity, parent != nullptr ? parent->entity : Entity{});
+    }
+
     void GameObject::Update()
     {
         // Derived classes should call:
         // GameObject::Update();
     }
 
-    void GameObject::init()
+    void GameObject::ParallelUpdate(CommandBuffer& /*commands*/)
+    {
+    }
+
+    void GameObject::copyComponentsTo(Entity target) const
     {
-        model = new Model(device_);
-        //model = std::make_unique<Model>(device_);
+        // Render queue membership is not copied, the copy is added to a queue like any new object
+        *world_.Get<Transform>(target) = GetTransform();
+        if (target == entity) return;
+
+        const auto model = GetModel();
+        if (model != nullptr) world_.Add(target, MeshRenderer{model});
+        else world_.Remove<MeshRenderer>(target);
     }
-}
\ No newline at end of file
+}
@@ -2,7 +2,12 @@
 
 #include "common.hpp"
 #include "Model.hpp"
+#include "OcclusionCuller.hpp"
+#include "SlotMap.hpp"
+#include "SpatialIndex.hpp"
 #include "Transform.hpp"
+#include "TransformSystem.hpp"
+#include "World.hpp"
 
 #include <gtc/matrix_transform.hpp>
 
@@ -11,47 +16,78 @@
 namespace VoidEngine
 {
     class Game;
+    class GameObject;
 
+    // Mesh drawn at the entity's Transform. The model is shared with every other entity using the same mesh, see
+    // ModelManager.
+    struct MeshRenderer
+    {
+        std::shared_ptr<Model> model;
+    };
+
+    // Back reference from an entity to the GameObject wrapping it, for the systems that still call into objects
+    struct GameObjectRef
+    {
+        GameObject* object = nullptr;
+    };
+
+    // Object oriented view of an entity in the SceneManager's World. Its components live in the World's chunks
+    // with those of every other entity, the object only holds the handle, so systems can iterate them without
+    // touching GameObjects at all. Subclasses still get Update() and ParallelUpdate() called every frame through
+    // GameObjectRef.
     class GameObject
     {
     public:
-        VOIDENGINE_API explicit GameObject(unsigned int objId, Game* game);
         VOIDENGINE_API explicit GameObject(Game* game);
-        virtual ~GameObject() = default;
-
-        GameObject(GameObject&&) noexcept;                          // Move constructor func(std::move());
-        GameObject& operator=(GameObject &&) noexcept;              // Move assignment  var = std::move();
-        GameObject(const GameObject& other)                         // Copy constructor var1 = var2;
-            : transform(other.transform), model(other.model), game_(other.game_), device_(other.device_), id(nextId++) {}
-
-        GameObject& operator=(const GameObject& other)              // Copy assignment
-        {
-            if (this == &other) return *this; // Handle self-assignment
-            id = nextId++;
-            transform = other.transform;
-            model = other.model;
-            //device_ = other.device_;
-            return *this;
-        }
-
-        [[nodiscard("id should not be discarded")]] unsigned int getId() const { return id; }
+        VOIDENGINE_API virtual ~GameObject();
+
+        VOIDENGINE_API GameObject(GameObject&&) noexcept;                  // Move constructor func(std::move());
+        VOIDENGINE_API GameObject& operator=(GameObject &&) noexcept;      // Move assignment  var = std::move();
+        VOIDENGINE_API GameObject(const GameObject& other);                // Copy constructor var1 = var2;
+        VOIDENGINE_API GameObject& operator=(const GameObject& other);     // Copy assignment
+
+        // Null until the object is added to the SceneManager
+        SlotHandle GetHandle() const { return handle; }
         template <typename T> T* GetAs() { return dynamic_cast<T*>(this); }
 
-        Transform transform;
+        Entity GetEntity() const { return entity; }
+
+        // References into the World, valid until the next structural change (a component added or removed on any
+        // entity)
+        Transform& GetTransform() { return *world_.Get<Transform>(entity); }
+        const Transform& GetTransform() const { return *world_.Get<const Transform>(entity); }
 
-        //std::string model;
-        Model* model;
+        // Null for objects without geometry
+        VOIDENGINE_API std::shared_ptr<Model> GetModel() const;
+        // Adds a MeshRenderer on first use, a null model removes it
+        VOIDENGINE_API void SetModel(std::shared_ptr<Model> model);
+        // Hides what is behind the object from the OcclusionCuller, a null mesh removes the Occluder
+        VOIDENGINE_API void SetOccluder(std::shared_ptr<const OccluderMesh> mesh);
 
+        // The transform becomes relative to the parent's, null detaches it. See TransformHierarchy.
+        VOIDENGINE_API void SetParent(const GameObject* parent);
+
+        // Called every frame on the main thread, may change anything
         VOIDENGINE_API virtual void Update();
+        // Called every frame after Update(), on any ThreadPool thread while other objects run theirs. May write
+        // this object's own components. Structural changes and writes to shared state go into `commands`, which
+        // is applied on the main thread once every object is done.
+        VOIDENGINE_API virtual void ParallelUpdate(CommandBuffer& commands);
 
     protected:
         Game& game_;
         Device& device_;
+        World& world_;
+        TransformHierarchy& hierarchy_;
+        SpatialIndex& spatialIndex_;
 
     private:
-        unsigned int id;
-        static std::atomic<unsigned int> nextId;
+        friend class SceneManager;
+
+        // Copies this object's components onto `target`, which must have a Transform
+        void copyComponentsTo(Entity target) const;
 
-        void init();
+        Entity entity;
+        SlotHandle handle;
     };
 }
\ No newline at end of file
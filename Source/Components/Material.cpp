@@ -0,0 +1,43 @@
+#include "Material.hpp"
+
+namespace VoidEngine
+{
+    static_assert(sizeof(MaterialParameters) == 32, "MaterialParameters must match MaterialUbo in Simple_shader.frag");
+
+    std::unique_ptr<DescriptorSetLayout> Material::CreateSetLayout(Device& device)
+    {
+        return DescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+            .build();
+    }
+
+    Material::Material(Device& device, uint32_t id, const MaterialParameters& parameters, VkDescriptorSet descriptorSet)
+        : id(id), parameters(parameters), descriptorSet(descriptorSet)
+    {
+        // Written once and read by the GPU from then on, not worth a device local copy
+        uniformBuffer = std::make_unique<Buffer>(
+            device,
+            sizeof(MaterialParameters),
+            1,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        uniformBuffer->map();
+        uniformBuffer->writeToBuffer(&parameters);
+        uniformBuffer->unmap();
+
+        VkDescriptorBufferInfo bufferInfo = uniformBuffer->descriptorInfo();
+
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = descriptorSet;
+        descriptorWrite.dstBinding = 0;
+        descriptorWrite.dstArrayElement = 0;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pBufferInfo = &bufferInfo;
+
+        vkUpdateDescriptorSets(device.device(), 1, &descriptorWrite, 0, nullptr);
+    }
+
+    Material::~Material() = default;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "Descriptors.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <External/glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+
+namespace VoidEngine
+{
+    // Shading parameters of a material, laid out like the std140 MaterialUbo of Simple_shader.frag. The defaults
+    // are the look models had before materials existed.
+    struct MaterialParameters
+    {
+        glm::vec4 baseColorFactor{1.0f};                    // Multiplies the vertex color
+        glm::vec4 specularFactor{1.0f, 1.0f, 1.0f, 512.0f}; // Highlight color in rgb, Blinn-Phong exponent in w
+
+        bool operator==(const MaterialParameters& other) const = default;
+    };
+
+    // GPU side of a material: its parameter block in a uniform buffer and the descriptor set binding it at
+    // DESCRIPTOR_SET. Created and shared by the MaterialManager, so every distinct parameter block exists once
+    // no matter how many models use it.
+    class Material
+    {
+    public:
+        // Set index in the pipeline layout, after the per frame set 0
+        static constexpr uint32_t DESCRIPTOR_SET = 1;
+
+        // Layout of the material set. Every pipeline layout that draws materials includes one at DESCRIPTOR_SET.
+        VOIDENGINE_API static std::unique_ptr<DescriptorSetLayout> CreateSetLayout(Device& device);
+
+        // Fills the uniform buffer and points `descriptorSet`, allocated with CreateSetLayout()'s layout, at it
+        VOIDENGINE_API Material(Device& device, uint32_t id, const MaterialParameters& parameters, VkDescriptorSet descriptorSet);
+        VOIDENGINE_API ~Material();
+
+        Material(const Material&) = delete;
+        Material& operator=(const Material&) = delete;
+
+        // Unique among live materials, draws are sorted by it
+        uint32_t GetId() const { return id; }
+        const MaterialParameters& GetParameters() const { return parameters; }
+        VkDescriptorSet GetDescriptorSet() const { return descriptorSet; }
+
+    private:
+        uint32_t id;
+        MaterialParameters parameters;
+        std::unique_ptr<Buffer> uniformBuffer;
+        // Owned by the MaterialManager's pool
+        VkDescriptorSet descriptorSet;
+    };
+
+    // Shared handle to a Material owned by the MaterialManager
+    using MaterialHandle = std::shared_ptr<Material>;
+}
@@ -1,25 +1,25 @@
 #include "Model.hpp"
 
 #include "Common.hpp"
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <External/tinyobjloader/tinyobjloader.hpp>
+#include "GltfParser.hpp"
+#include "MappedFile.hpp"
+#include "MeshCache.hpp"
+#include "MeshSimplifier.hpp"
+#include "ObjParser.hpp"
+#include "TangentGenerator.hpp"
+#include "ThreadPool.hpp"
+#include "VertexWelder.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
-#include "External/glm/gtx/hash.hpp"
-
 #include "External/glm/gtx/string_cast.hpp"
+#include "External/glm/gtc/matrix_transform.hpp"
+#include "External/glm/gtc/packing.hpp"
 
-template<>
-struct std::hash<VoidEngine::Model::Vertex>
-{
-    size_t operator()(VoidEngine::Model::Vertex const& vertex) const noexcept
-    {
-        size_t seed = 0;
-        VoidEngine::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-        return seed;
-    }
-};
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <utility>
 
 namespace VoidEngine
 {
@@ -45,6 +45,93 @@ namespace VoidEngine
         return attributeDescriptions;
     }
 
+    std::vector<VkVertexInputBindingDescription> Model::PackedVertex::getBindingDescriptions()
+    {
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof(PackedVertex);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        return bindingDescriptions;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> Model::PackedVertex::getAttributeDescriptions()
+    {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+        attributeDescriptions.push_back({0, 0, VK_FORMAT_R16G16B16A16_SNORM, offsetof(PackedVertex, position)});
+        attributeDescriptions.push_back({1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(PackedVertex, color)});
+        attributeDescriptions.push_back({2, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedVertex, normal)});
+        attributeDescriptions.push_back({3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertex, uv)});
+
+        return attributeDescriptions;
+    }
+
+    Model::PackedVertex Model::PackedVertex::Pack(const Vertex& vertex, const glm::vec3& center, const glm::vec3& inverseHalfExtent)
+    {
+        PackedVertex packed{};
+
+        const glm::vec3 position = glm::clamp((vertex.position - center) * inverseHalfExtent, -1.0f, 1.0f);
+        for (int i = 0; i < 3; i++)
+        {
+            packed.position[i] = static_cast<int16_t>(glm::packSnorm1x16(position[i]));
+        }
+        packed.position[3] = 0;
+
+        // Octahedral mapping: project onto |x| + |y| + |z| = 1 and fold the lower half over the diagonals
+        glm::vec3 normal = vertex.normal;
+        const float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+        glm::vec2 octahedral = l1 > 0.0f ? glm::vec2(normal) / l1 : glm::vec2(0.0f);
+        if (l1 > 0.0f && normal.z < 0.0f)
+        {
+            const glm::vec2 signs{octahedral.x >= 0.0f ? 1.0f : -1.0f, octahedral.y >= 0.0f ? 1.0f : -1.0f};
+            octahedral = (1.0f - glm::abs(glm::vec2(octahedral.y, octahedral.x))) * signs;
+        }
+        packed.normal[0] = static_cast<int16_t>(glm::packSnorm1x16(octahedral.x));
+        packed.normal[1] = static_cast<int16_t>(glm::packSnorm1x16(octahedral.y));
+
+        const uint32_t color = glm::packUnorm4x8(glm::vec4(vertex.color, 1.0f));
+        std::memcpy(packed.color, &color, sizeof(color));
+
+        packed.uv[0] = glm::packHalf1x16(vertex.uv.x);
+        packed.uv[1] = glm::packHalf1x16(vertex.uv.y);
+
+        return packed;
+    }
+
+    std::vector<VkVertexInputBindingDescription> Model::PackedTangent::getBindingDescriptions()
+    {
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+        bindingDescriptions[0].binding = BINDING;
+        bindingDescriptions[0].stride = sizeof(PackedTangent);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        return bindingDescriptions;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> Model::PackedTangent::getAttributeDescriptions()
+    {
+        return {{LOCATION, BINDING, VK_FORMAT_R8G8B8A8_SNORM, offsetof(PackedTangent, tangent)}};
+    }
+
+    Model::PackedTangent Model::PackedTangent::Pack(const glm::vec4& tangent)
+    {
+        PackedTangent packed{};
+        const uint32_t bits = glm::packSnorm4x8(tangent);
+        std::memcpy(packed.tangent, &bits, sizeof(bits));
+        return packed;
+    }
+
+    std::vector<VkVertexInputBindingDescription> Model::GetBindingDescriptions(VertexFormat format)
+    {
+        return format == VertexFormat::PACKED ? PackedVertex::getBindingDescriptions() : Vertex::getBindingDescriptions();
+    }
+
+    std::vector<VkVertexInputAttributeDescription> Model::GetAttributeDescriptions(VertexFormat format)
+    {
+        return format == VertexFormat::PACKED ? PackedVertex::getAttributeDescriptions() : Vertex::getAttributeDescriptions();
+    }
+
     Model::Model(Device& _device) : vertexCount(0), indexCount(0), device(_device)
     {
         //createVertexBuffers(vertices);
@@ -53,6 +140,37 @@ namespace VoidEngine
 
     Model::~Model() = default;
 
+    void Model::Swap(Model& other)
+    {
+        std::swap(vertexBuffer, other.vertexBuffer);
+        std::swap(tangentBuffer, other.tangentBuffer);
+        std::swap(indexBuffer, other.indexBuffer);
+        std::swap(hasIndexBuffer, other.hasIndexBuffer);
+        std::swap(vertexCount, other.vertexCount);
+        std::swap(indexCount, other.indexCount);
+        std::swap(indexType, other.indexType);
+        std::swap(vertexFormat, other.vertexFormat);
+        std::swap(boundsMin, other.boundsMin);
+        std::swap(boundsMax, other.boundsMax);
+        std::swap(boundingSphere, other.boundingSphere);
+        std::swap(lods, other.lods);
+        std::swap(meshlets, other.meshlets);
+        std::swap(submeshes, other.submeshes);
+        std::swap(nodes, other.nodes);
+        std::swap(materials, other.materials);
+        std::swap(materialHandles, other.materialHandles);
+        std::swap(vertices, other.vertices);
+        std::swap(tangents, other.tangents);
+        std::swap(indices, other.indices);
+        std::swap(vertexCacheBefore, other.vertexCacheBefore);
+        std::swap(vertexCacheAfter, other.vertexCacheAfter);
+        std::swap(stagedCopies, other.stagedCopies);
+
+        const bool wasResident = IsResident();
+        resident.store(other.IsResident(), std::memory_order_release);
+        other.resident.store(wasResident, std::memory_order_release);
+    }
+
     /*
     void Model::bind(VkCommandBuffer commandBuffer) const
     {
@@ -69,7 +187,16 @@ namespace VoidEngine
 
     void Model::draw(VkCommandBuffer commandBuffer) const
     {
-        if (hasIndexBuffer)
+        if (!lods.empty())
+        {
+            vkCmdDrawIndexed(commandBuffer, lods[0].indexCount, 1, lods[0].firstIndex, 0, 0);
+        } else if (!submeshes.empty())
+        {
+            for (const auto& submesh : submeshes)
+            {
+                vkCmdDrawIndexed(commandBuffer, submesh.indexCount, 1, submesh.firstIndex, submesh.vertexOffset, 0);
+            }
+        } else if (hasIndexBuffer)
         {
             vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
         } else
@@ -78,34 +205,136 @@ namespace VoidEngine
         }
     }
 
-    void Model::createVertexBuffers(const std::vector<Vertex>& vertices)
+    namespace
+    {
+        // Half extents of zero would divide by zero when packing, every position is at the center then anyway
+        glm::vec3 packingHalfExtent(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+        {
+            const glm::vec3 halfExtent = (boundsMax - boundsMin) * 0.5f;
+            return {
+                halfExtent.x > 0.0f ? halfExtent.x : 1.0f,
+                halfExtent.y > 0.0f ? halfExtent.y : 1.0f,
+                halfExtent.z > 0.0f ? halfExtent.z : 1.0f
+            };
+        }
+    }
+
+    glm::mat4 Model::GetDequantizeMatrix() const
+    {
+        if (vertexFormat != VertexFormat::PACKED) return glm::mat4{1.0f};
+
+        const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+        return glm::scale(glm::translate(glm::mat4{1.0f}, center), packingHalfExtent(boundsMin, boundsMax));
+    }
+
+    void Model::uploadVertices(const Vertex* vertexData, uint32_t count)
+    {
+        boundsMin = glm::vec3{0.0f};
+        boundsMax = glm::vec3{0.0f};
+        if (count > 0)
+        {
+            boundsMin = boundsMax = vertexData[0].position;
+            for (uint32_t i = 1; i < count; i++)
+            {
+                boundsMin = glm::min(boundsMin, vertexData[i].position);
+                boundsMax = glm::max(boundsMax, vertexData[i].position);
+            }
+        }
+
+        // Around the box center, but only as large as the farthest vertex, usually well inside the box corners
+        const glm::vec3 boundsCenter = (boundsMin + boundsMax) * 0.5f;
+        float radiusSquared = 0.0f;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const glm::vec3 offset = vertexData[i].position - boundsCenter;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+        boundingSphere = glm::vec4(boundsCenter, std::sqrt(radiusSquared));
+
+        if (vertexFormat == VertexFormat::FULL)
+        {
+            createVertexBuffers(vertexData, count, sizeof(Vertex));
+            return;
+        }
+
+        const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+        const glm::vec3 inverseHalfExtent = 1.0f / packingHalfExtent(boundsMin, boundsMax);
+
+        vertexCount = count;
+        assert(vertexCount >= 3 && "Vertex count must be at least 3.");
+        createDeviceBuffer(vertexBuffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(PackedVertex), count, [&](void* staging)
+        {
+            auto* packed = static_cast<PackedVertex*>(staging);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                packed[i] = PackedVertex::Pack(vertexData[i], center, inverseHalfExtent);
+            }
+        });
+    }
+
+    void Model::createVertexBuffers(const void* vertexData, uint32_t count, uint32_t vertexSize)
     {
-        vertexCount = static_cast<uint32_t>(vertices.size());
+        vertexCount = count;
         assert(vertexCount >= 3 && "Vertex count must be at least 3.");
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-        uint32_t vertexSize = sizeof(vertices[0]);
+        createDeviceBuffer(vertexBuffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexSize, count, [&](void* staging)
+        {
+            std::memcpy(staging, vertexData, static_cast<size_t>(vertexSize) * count);
+        });
+    }
+
+    void Model::uploadTangents(const PackedTangent* tangentData, uint32_t count)
+    {
+        tangentBuffer.reset();
+        if (tangentData == nullptr || count == 0) return;
 
-        Buffer stagingBuffer{
+        createDeviceBuffer(tangentBuffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sizeof(PackedTangent), count, [&](void* staging)
+        {
+            std::memcpy(staging, tangentData, sizeof(PackedTangent) * count);
+        });
+    }
+
+    void Model::createDeviceBuffer(std::unique_ptr<Buffer>& buffer, VkBufferUsageFlags usage, uint32_t elementSize,
+        uint32_t count, const std::function<void(void* staging)>& fill)
+    {
+        VkDeviceSize bufferSize = static_cast<VkDeviceSize>(elementSize) * count;
+
+        auto stagingBuffer = std::make_unique<Buffer>(
             device,
-            vertexSize,
-            vertexCount,
+            elementSize,
+            count,
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        };
+            );
 
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)vertices.data());
-        stagingBuffer.unmap();
+        stagingBuffer->map();
+        fill(stagingBuffer->getMappedMemory());
+        stagingBuffer->unmap();
 
-        vertexBuffer = std::make_unique<Buffer>(
+        buffer = std::make_unique<Buffer>(
             device,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            elementSize,
+            count,
+            usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
             );
 
-        device.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+        stagedCopies.push_back({std::move(stagingBuffer), buffer->getBuffer(), bufferSize});
+    }
+
+    void Model::uploadStagedCopies()
+    {
+        // All buffers of the model in a single submission
+        VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+        for (const auto& copy : stagedCopies)
+        {
+            VkBufferCopy region{};
+            region.size = copy.size;
+            vkCmdCopyBuffer(commandBuffer, copy.staging->getBuffer(), copy.destination, 1, &region);
+        }
+        device.endSingleTimeCommands(commandBuffer);
+
+        stagedCopies.clear();
+        MarkResident();
     }
 
     //glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.33333f, 0.1f, 100.0f);
@@ -113,68 +342,500 @@ namespace VoidEngine
 
     void Model::LoadModelFromFile(const std::string& filepath)
     {
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn, err;
+        LoadModelFromFile(filepath, ImportOptions{});
+    }
+
+    void Model::LoadModelFromFile(const std::string& filepath, const ImportOptions& options)
+    {
+        importFile(filepath, options);
+        uploadStagedCopies();
+    }
+
+    std::vector<Model::StagedCopy> Model::StageModelFromFile(const std::string& filepath, const ImportOptions& options)
+    {
+        importFile(filepath, options);
+        return std::exchange(stagedCopies, {});
+    }
+
+    void Model::importFile(const std::string& filepath, const ImportOptions& options)
+    {
+        if (GltfParser::IsGltfPath(filepath))
+        {
+            loadGltf(filepath, options);
+            return;
+        }
+
+        // Hashing the source is far cheaper than parsing it, and keeps stale caches from being used
+        const uint64_t sourceHash = MeshCache::HashSource(MappedFile(filepath), options);
+        const std::string cachePath = MeshCache::GetCachePath(filepath, options);
+
+        vertexFormat = options.vertexFormat;
 
-        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str()))
+        if (const auto cache = MeshCache::Open(cachePath, sourceHash))
         {
-            throw std::runtime_error(warn + err);
+            std::vector<std::string> materialLibraries;
+            std::vector<std::string> materialNames;
+            cache->GetVertexCacheStats(vertexCacheBefore, vertexCacheAfter);
+            cache->GetLods(lods);
+            cache->GetMeshlets(meshlets);
+            cache->GetSubmeshes(submeshes);
+            cache->GetMaterialLibraries(materialLibraries);
+            cache->GetMaterialNames(materialNames);
+            resolveObjMaterials(filepath, materialLibraries, materialNames);
+            uploadVertices(cache->GetVertices(), cache->GetVertexCount());
+            uploadTangents(cache->GetTangents(), cache->GetVertexCount());
+            createIndexBuffers(cache->GetIndices(), cache->GetIndexCount());
+            return;
         }
 
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+        const ObjData obj = ObjParser::Parse(filepath);
 
-        for (const auto &shape : shapes)
+        // Triangles are grouped by material in order of first use, keeping their file order within each group,
+        // so every material is a single index range. Group 0 holds the triangles before the first usemtl.
+        const size_t triangleCount = obj.indices.size() / 3;
+        std::vector<size_t> groupStart(obj.materialNames.size() + 2, 0);
+        for (const int32_t material : obj.triangleMaterials)
         {
-            for (const auto &index : shape.mesh.indices)
+            groupStart[material + 2]++;
+        }
+        for (size_t i = 1; i < groupStart.size(); i++)
+        {
+            groupStart[i] += groupStart[i - 1];
+        }
+
+        std::vector<uint32_t> triangleOrder(triangleCount);
+        {
+            std::vector<size_t> next(groupStart.begin(), groupStart.end() - 1);
+            for (size_t t = 0; t < triangleCount; t++)
+            {
+                triangleOrder[next[obj.triangleMaterials[t] + 1]++] = static_cast<uint32_t>(t);
+            }
+        }
+
+        submeshes.clear();
+        for (size_t group = 0; group + 1 < groupStart.size(); group++)
+        {
+            if (groupStart[group + 1] == groupStart[group]) continue;
+
+            Submesh submesh{};
+            submesh.firstIndex = static_cast<uint32_t>(groupStart[group] * 3);
+            submesh.indexCount = static_cast<uint32_t>((groupStart[group + 1] - groupStart[group]) * 3);
+            // An index into obj.materialNames until resolveObjMaterials()
+            submesh.material = group == 0 ? Submesh::NO_MATERIAL : static_cast<uint32_t>(group - 1);
+            submeshes.push_back(submesh);
+        }
+
+        VertexWelder welder{vertices, obj.indices.size(), options.weldEpsilon};
+        indices.reserve(obj.indices.size());
+
+        // Corners are assembled a block at a time so the welder can hash them in bulk
+        std::vector<Vertex> corners;
+        corners.reserve(VertexWelder::BLOCK_SIZE);
+
+        for (const uint32_t triangle : triangleOrder)
+        {
+            for (size_t corner = 0; corner < 3; corner++)
             {
-                Vertex vertex{};
+                const auto& index = obj.indices[triangle * 3 + corner];
+                Vertex& vertex = corners.emplace_back();
 
-                if (index.vertex_index >= 0)
+                if (index.position >= 0)
                 {
                     vertex.position = {
-                        attrib.vertices[3 * index.vertex_index + 0],
-                        attrib.vertices[3 * index.vertex_index + 1],
-                        attrib.vertices[3 * index.vertex_index + 2]
+                        obj.positions[3 * index.position + 0],
+                        obj.positions[3 * index.position + 1],
+                        obj.positions[3 * index.position + 2]
                     };
 
                     vertex.color = {
-                        attrib.colors[3 * index.vertex_index + 0],
-                        attrib.colors[3 * index.vertex_index + 1],
-                        attrib.colors[3 * index.vertex_index + 2]
+                        obj.colors[3 * index.position + 0],
+                        obj.colors[3 * index.position + 1],
+                        obj.colors[3 * index.position + 2]
                     };
                 }
 
-                if (index.normal_index >= 0)
+                if (index.normal >= 0)
                 {
                     vertex.normal = {
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2]
+                        obj.normals[3 * index.normal + 0],
+                        obj.normals[3 * index.normal + 1],
+                        obj.normals[3 * index.normal + 2]
                     };
                 }
 
-                if (index.texcoord_index >= 0)
+                if (index.texcoord >= 0)
                 {
                     vertex.uv = {
-                        attrib.texcoords[2 * index.texcoord_index + 0],
-                        attrib.texcoords[2 * index.texcoord_index + 1]
+                        obj.texcoords[2 * index.texcoord + 0],
+                        obj.texcoords[2 * index.texcoord + 1]
                     };
                 }
+            }
 
-                static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex must be trivially copyable!");
+            // Whole triangles only, flushed before the next one would overflow the block
+            if (corners.size() + 3 > VertexWelder::BLOCK_SIZE)
+            {
+                welder.Add(corners.data(), corners.size(), indices);
+                corners.clear();
+            }
+        }
+        welder.Add(corners.data(), corners.size(), indices);
+
+        // Before optimizing, which moves the split vertices next to their uses
+        tangents.clear();
+        if (options.generateTangents && !obj.normals.empty() && !obj.texcoords.empty()) generateTangents();
+
+        if (options.optimize) optimizeMesh();
+
+        generateLods(options);
+        buildMeshlets(options.optimize);
+
+        stageBuffers();
+
+        MeshCache::Write(cachePath, sourceHash, *this, obj.materialLibraries, obj.materialNames);
+        resolveObjMaterials(filepath, obj.materialLibraries, obj.materialNames);
+    }
+
+    void Model::resolveObjMaterials(const std::string& filepath, const std::vector<std::string>& libraries,
+        const std::vector<std::string>& names)
+    {
+        // A missing library or material is not fatal, its triangles get the default material
+        std::vector<MaterialDesc> definitions;
+        const std::filesystem::path directory = std::filesystem::path(filepath).parent_path();
+        for (const auto& library : libraries)
+        {
+            try
+            {
+                auto parsed = ObjParser::ParseMaterials((directory / library).generic_string());
+                definitions.insert(definitions.end(), std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()));
+            } catch (const std::exception& e)
+            {
+                std::cerr << filepath << ": " << e.what() << "\n";
+            }
+        }
+
+        materials.clear();
+        std::vector<uint32_t> materialIndex(names.size(), Submesh::NO_MATERIAL);
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            const auto it = std::find_if(definitions.begin(), definitions.end(), [&](const MaterialDesc& material)
+            {
+                return material.name == names[i];
+            });
+            if (it == definitions.end())
+            {
+                std::cerr << filepath << ": material " << names[i] << " not found, using the default\n";
+                continue;
+            }
+
+            materialIndex[i] = static_cast<uint32_t>(materials.size());
+            materials.push_back(*it);
+        }
+
+        for (auto& submesh : submeshes)
+        {
+            submesh.material = submesh.material < materialIndex.size() ? materialIndex[submesh.material] : Submesh::NO_MATERIAL;
+        }
+    }
+
+    void Model::loadGltf(const std::string& filepath, const ImportOptions& options)
+    {
+        // Welding and optimization are skipped: glTF meshes are already indexed, and the point of this path is to
+        // go from the mapped file to the staging buffer in a single copy
+        const GltfData gltf = GltfParser::Parse(filepath);
+
+        vertexFormat = options.vertexFormat;
+        vertices.clear();
+        indices.clear();
+        submeshes.clear();
+        nodes.clear();
+        materials = gltf.materials;
+
+        // Primitives without a material use the spec's default material, appended on demand
+        const auto defaultMaterial = static_cast<uint32_t>(materials.size());
+
+        std::vector<const GltfData::Primitive*> primitives;
+        std::vector<uint32_t> meshFirstSubmesh(gltf.meshes.size());
+        size_t totalVertices = 0;
+        size_t totalIndices = 0;
+        size_t maxPrimitiveVertices = 0;
+        bool hasBounds = false;
+
+        for (size_t m = 0; m < gltf.meshes.size(); m++)
+        {
+            meshFirstSubmesh[m] = static_cast<uint32_t>(submeshes.size());
+
+            for (const auto& primitive : gltf.meshes[m].primitives)
+            {
+                const size_t primitiveVertices = GltfParser::GetVertexCount(gltf, primitive);
+                const size_t primitiveIndices = GltfParser::GetIndexCount(gltf, primitive);
+                if (primitiveIndices == 0) continue;
+
+                Submesh submesh{};
+                submesh.firstIndex = static_cast<uint32_t>(totalIndices);
+                submesh.indexCount = static_cast<uint32_t>(primitiveIndices);
+                submesh.vertexOffset = static_cast<int32_t>(totalVertices);
+                submesh.material = primitive.material >= 0 ? static_cast<uint32_t>(primitive.material) : defaultMaterial;
+                submeshes.push_back(submesh);
+                primitives.push_back(&primitive);
+
+                totalVertices += primitiveVertices;
+                totalIndices += primitiveIndices;
+                maxPrimitiveVertices = std::max(maxPrimitiveVertices, primitiveVertices);
+                if (totalVertices > static_cast<size_t>(std::numeric_limits<int32_t>::max()) ||
+                    totalIndices > std::numeric_limits<uint32_t>::max())
+                {
+                    throw std::runtime_error(filepath + ": too much geometry for a single model");
+                }
 
-                if (!uniqueVertices.contains(vertex))
+                // POSITION bounds are required by the spec, only scan the data when a file leaves them out
+                const auto& positions = gltf.accessors[primitive.position];
+                glm::vec3 primitiveMin{positions.min[0], positions.min[1], positions.min[2]};
+                glm::vec3 primitiveMax{positions.max[0], positions.max[1], positions.max[2]};
+                if (!positions.hasBounds)
                 {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
+                    positions.ReadFloats(0, &primitiveMin.x, 3);
+                    primitiveMax = primitiveMin;
+                    for (size_t i = 1; i < positions.count; i++)
+                    {
+                        glm::vec3 position;
+                        positions.ReadFloats(i, &position.x, 3);
+                        primitiveMin = glm::min(primitiveMin, position);
+                        primitiveMax = glm::max(primitiveMax, position);
+                    }
                 }
-                indices.push_back(uniqueVertices[vertex]);
+                boundsMin = hasBounds ? glm::min(boundsMin, primitiveMin) : primitiveMin;
+                boundsMax = hasBounds ? glm::max(boundsMax, primitiveMax) : primitiveMax;
+                hasBounds = true;
             }
         }
 
-        CreateBuffers();
+        if (submeshes.empty())
+        {
+            throw std::runtime_error(filepath + ": no triangle meshes");
+        }
+        if (std::any_of(submeshes.begin(), submeshes.end(), [&](const Submesh& submesh) { return submesh.material == defaultMaterial; }))
+        {
+            materials.emplace_back().name = "default";
+        }
+
+        // Indices stay relative to each primitive's vertexOffset, so 16 bits suffice as long as every primitive is small
+        indexType = maxPrimitiveVertices <= std::numeric_limits<uint16_t>::max() ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        const uint32_t indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+        const uint32_t vertexSize = vertexFormat == VertexFormat::PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+        const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+        const glm::vec3 inverseHalfExtent = 1.0f / packingHalfExtent(boundsMin, boundsMax);
+
+        vertexCount = static_cast<uint32_t>(totalVertices);
+        indexCount = static_cast<uint32_t>(totalIndices);
+        hasIndexBuffer = true;
+
+        createDeviceBuffer(vertexBuffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexSize, vertexCount, [&](void* staging)
+        {
+            for (size_t i = 0; i < primitives.size(); i++)
+            {
+                GltfParser::CopyVertices(gltf, *primitives[i], vertexFormat, center,
+                    inverseHalfExtent, static_cast<uint8_t*>(staging) + static_cast<size_t>(submeshes[i].vertexOffset) * vertexSize);
+            }
+        });
+
+        createDeviceBuffer(indexBuffer, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexSize, indexCount, [&](void* staging)
+        {
+            for (size_t i = 0; i < primitives.size(); i++)
+            {
+                GltfParser::CopyIndices(gltf, *primitives[i], indexType,
+                    static_cast<uint8_t*>(staging) + static_cast<size_t>(submeshes[i].firstIndex) * indexSize);
+            }
+        });
+
+        // Flatten the default scene depth first so parents precede their children
+        std::vector<std::pair<uint32_t, int32_t>> stack; // glTF node, parent in `nodes`
+        for (auto it = gltf.sceneNodes.rbegin(); it != gltf.sceneNodes.rend(); ++it)
+        {
+            stack.emplace_back(*it, -1);
+        }
+
+        while (!stack.empty())
+        {
+            const auto [index, parent] = stack.back();
+            stack.pop_back();
+
+            const auto& source = gltf.nodes[index];
+            Node node{};
+            node.name = source.name;
+            node.parent = parent;
+            node.localMatrix = source.matrix;
+            node.worldMatrix = parent >= 0 ? nodes[parent].worldMatrix * source.matrix : source.matrix;
+            node.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(node.worldMatrix))));
+            if (source.mesh >= 0)
+            {
+                node.firstSubmesh = meshFirstSubmesh[source.mesh];
+                const size_t end = static_cast<size_t>(source.mesh) + 1 < meshFirstSubmesh.size() ? meshFirstSubmesh[source.mesh + 1] : submeshes.size();
+                node.submeshCount = static_cast<uint32_t>(end - node.firstSubmesh);
+            }
+
+            const auto nodeIndex = static_cast<int32_t>(nodes.size());
+            nodes.push_back(std::move(node));
+
+            for (auto it = source.children.rbegin(); it != source.children.rend(); ++it)
+            {
+                stack.emplace_back(*it, nodeIndex);
+            }
+        }
+
+        // The bounds above are of the primitives as stored, the sphere covers their corners as placed by each node
+        glm::vec3 sceneMin{std::numeric_limits<float>::max()};
+        glm::vec3 sceneMax{-std::numeric_limits<float>::max()};
+        for (const auto& node : nodes)
+        {
+            if (node.submeshCount == 0) continue;
+            for (int corner = 0; corner < 8; corner++)
+            {
+                const glm::vec3 local{corner & 1 ? boundsMax.x : boundsMin.x, corner & 2 ? boundsMax.y : boundsMin.y,
+                    corner & 4 ? boundsMax.z : boundsMin.z};
+                const glm::vec3 placed = node.worldMatrix * glm::vec4(local, 1.0f);
+                sceneMin = glm::min(sceneMin, placed);
+                sceneMax = glm::max(sceneMax, placed);
+            }
+        }
+        if (sceneMin.x > sceneMax.x) sceneMin = sceneMax = glm::vec3{0.0f};
+        boundingSphere = glm::vec4((sceneMin + sceneMax) * 0.5f, glm::length(sceneMax - sceneMin) * 0.5f);
+    }
+
+    void Model::generateTangents()
+    {
+        const std::vector<glm::vec4> generated = TangentGenerator::Generate(vertices, indices);
+
+        tangents.resize(generated.size());
+        for (size_t i = 0; i < generated.size(); i++)
+        {
+            tangents[i] = PackedTangent::Pack(generated[i]);
+        }
+    }
+
+    void Model::optimizeMesh()
+    {
+        if (indices.empty()) return;
+
+        vertexCacheBefore = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+        // Triangles are only reordered within their submesh, so the material ranges stay intact
+        for (const auto& submesh : submeshes)
+        {
+            uint32_t* range = indices.data() + submesh.firstIndex;
+            MeshOptimizer::OptimizeVertexCache(range, submesh.indexCount, vertices.size());
+            MeshOptimizer::OptimizeOverdraw(range, submesh.indexCount, &vertices[0].position.x, vertices.size(), sizeof(Vertex));
+        }
+        // The fetch order only depends on the indices, so the tangents are reordered with a copy of them first
+        if (!tangents.empty())
+        {
+            std::vector<uint32_t> tangentIndices = indices;
+            tangents.resize(MeshOptimizer::OptimizeVertexFetch(tangents.data(), tangents.size(), sizeof(PackedTangent),
+                tangentIndices.data(), tangentIndices.size()));
+        }
+        vertices.resize(MeshOptimizer::OptimizeVertexFetch(vertices.data(), vertices.size(), sizeof(Vertex), indices.data(), indices.size()));
+
+        vertexCacheAfter = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+    }
+
+    void Model::generateLods(const ImportOptions& options)
+    {
+        lods.clear();
+        if (indices.empty()) return;
+
+        const auto submeshCount = static_cast<uint32_t>(submeshes.size());
+        lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.0f, 0, submeshCount});
+
+        // Every submesh is simplified on its own so materials never bleed into each other. Their shared edges are
+        // open borders to the simplifier, which only slides them along themselves, so coarse levels may show thin
+        // cracks between materials.
+        //
+        // Each level is simplified from the one before, which is much cheaper than starting over from the full
+        // mesh every time. Levels are appended to the index buffer behind the full detail one.
+        std::vector<std::vector<uint32_t>> lodIndices(submeshCount);
+        for (uint32_t i = 0; i < submeshCount; i++)
+        {
+            const auto begin = indices.begin() + submeshes[i].firstIndex;
+            lodIndices[i].assign(begin, begin + submeshes[i].indexCount);
+        }
+
+        std::vector<float> errors(submeshCount);
+        for (uint32_t level = 1; level < options.lodCount; level++)
+        {
+            const Lod& previous = lods.back();
+
+            ThreadPool::getInstance().parallelFor(submeshCount, [&](size_t i)
+            {
+                std::vector<uint32_t>& submeshIndices = lodIndices[i];
+                const auto targetCount = static_cast<size_t>(static_cast<float>(submeshIndices.size() / 3) * options.lodReduction) * 3;
+
+                float error = 0.0f;
+                const size_t count = MeshSimplifier::Simplify(submeshIndices.data(), submeshIndices.data(), submeshIndices.size(),
+                    &vertices[0].position.x, vertices.size(), sizeof(Vertex), targetCount, options.lodMaxError, &error);
+
+                // A submesh that hardly shrinks is drawn as it was in the previous level
+                errors[i] = 0.0f;
+                if (count > submeshIndices.size() * 9 / 10) return;
+
+                errors[i] = error;
+                submeshIndices.resize(count);
+                if (options.optimize)
+                {
+                    MeshOptimizer::OptimizeVertexCache(submeshIndices.data(), submeshIndices.size(), vertices.size());
+                }
+            });
+
+            size_t count = 0;
+            for (const auto& submeshIndices : lodIndices) count += submeshIndices.size();
+
+            // Hardly smaller than the previous level, not worth drawing instead of it
+            if (count == 0 || count > previous.indexCount * 9 / 10) break;
+
+            // Errors of consecutive levels add up at most
+            Lod lod{static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(count),
+                previous.error + *std::max_element(errors.begin(), errors.end()), static_cast<uint32_t>(submeshes.size()), submeshCount};
+            for (uint32_t i = 0; i < submeshCount; i++)
+            {
+                Submesh submesh = submeshes[previous.firstSubmesh + i];
+                submesh.firstIndex = static_cast<uint32_t>(indices.size());
+                submesh.indexCount = static_cast<uint32_t>(lodIndices[i].size());
+                submeshes.push_back(submesh);
+                indices.insert(indices.end(), lodIndices[i].begin(), lodIndices[i].end());
+            }
+            lods.push_back(lod);
+        }
+    }
+
+    void Model::buildMeshlets(bool optimize)
+    {
+        meshlets.clear();
+        if (lods.empty()) return;
+
+        // Reorders the full detail triangles of each submesh into meshlets, their order within each one is
+        // optimized again
+        for (uint32_t i = lods[0].firstSubmesh; i < lods[0].firstSubmesh + lods[0].submeshCount; i++)
+        {
+            Submesh& submesh = submeshes[i];
+            submesh.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+
+            const std::vector<Meshlet> built = MeshletBuilder::Build(indices.data() + submesh.firstIndex, submesh.indexCount,
+                &vertices[0].position.x, vertices.size(), sizeof(Vertex));
+            for (Meshlet meshlet : built)
+            {
+                meshlet.firstIndex += submesh.firstIndex;
+                meshlets.push_back(meshlet);
+            }
+            submesh.meshletCount = static_cast<uint32_t>(built.size());
+        }
+
+        if (optimize)
+        {
+            for (const auto& meshlet : meshlets)
+            {
+                MeshOptimizer::OptimizeVertexCache(indices.data() + meshlet.firstIndex, meshlet.indexCount, vertices.size());
+            }
+            vertexCacheAfter = MeshOptimizer::AnalyzeVertexCache(indices.data(), lods[0].indexCount, vertices.size());
+        }
     }
 
     void Model::AddVertex(const Vertex &v)
@@ -185,40 +846,43 @@ namespace VoidEngine
 
     void Model::CreateBuffers()
     {
-        createVertexBuffers(vertices);
-        createIndexBuffers(indices);
+        stageBuffers();
+        uploadStagedCopies();
     }
 
-    void Model::createIndexBuffers(const std::vector<uint32_t>& indices)
+    void Model::stageBuffers()
     {
-        indexCount = static_cast<uint32_t>(indices.size());
+        uploadVertices(vertices.data(), static_cast<uint32_t>(vertices.size()));
+        uploadTangents(tangents.data(), static_cast<uint32_t>(tangents.size()));
+        createIndexBuffers(indices.data(), static_cast<uint32_t>(indices.size()));
+    }
+
+    void Model::createIndexBuffers(const uint32_t* indexData, uint32_t count)
+    {
+        indexCount = count;
         hasIndexBuffer = indexCount > 0;
 
         if (!hasIndexBuffer) return;
 
-        VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-        uint32_t indexSize = sizeof(indices[0]);
-
-        Buffer stagingBuffer{
-            device,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        indexBuffer = std::make_unique<Buffer>(
-            device,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)indices.data());
-        stagingBuffer.unmap();
+        // Every index fits in 16 bits, halve the buffer
+        if (vertexCount <= std::numeric_limits<uint16_t>::max())
+        {
+            indexType = VK_INDEX_TYPE_UINT16;
+            createDeviceBuffer(indexBuffer, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, sizeof(uint16_t), indexCount, [&](void* staging)
+            {
+                auto* shortIndices = static_cast<uint16_t*>(staging);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    shortIndices[i] = static_cast<uint16_t>(indexData[i]);
+                }
+            });
+            return;
+        }
 
-        device.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+        indexType = VK_INDEX_TYPE_UINT32;
+        createDeviceBuffer(indexBuffer, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, sizeof(uint32_t), indexCount, [&](void* staging)
+        {
+            std::memcpy(staging, indexData, sizeof(uint32_t) * count);
+        });
     }
-} // VoidEngine
\ No newline at end of file
+} // VoidEngine
@@ -3,14 +3,20 @@
 #include "Common.hpp"
 #include "Device.hpp"
 #include "Buffer.hpp"
+#include "Material.hpp"
+#include "MeshletBuilder.hpp"
+#include "MeshOptimizer.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <iostream>
 #include <External/glm/glm.hpp>
 
-#include <vector>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace VoidEngine
 {
@@ -33,6 +39,126 @@ namespace VoidEngine
             }
         };
 
+        // Vertex buffer layouts. Vertex is what the importer and mesh cache work with, it is converted when
+        // the GPU buffer is created.
+        enum class VertexFormat : uint32_t
+        {
+            FULL,   // Vertex, 44 bytes
+            PACKED, // PackedVertex, 20 bytes
+        };
+
+        struct PackedVertex
+        {
+            int16_t position[4];    // snorm16 within the mesh bounds, see GetDequantizeMatrix(). w is unused.
+            int16_t normal[2];      // snorm16 octahedral encoding
+            uint8_t color[4];       // unorm8, alpha is always 1
+            uint16_t uv[2];         // half float
+
+            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+
+            static PackedVertex Pack(const Vertex& vertex, const glm::vec3& center, const glm::vec3& inverseHalfExtent);
+        };
+
+        // Optional second vertex stream for normal mapping, see TangentGenerator. xyz is the tangent, w the sign of
+        // the bitangent: bitangent = w * cross(normal, tangent).
+        struct PackedTangent
+        {
+            static constexpr uint32_t BINDING = 1;
+            static constexpr uint32_t LOCATION = 4;
+
+            int8_t tangent[4];      // snorm8
+
+            // Pipelines that sample normal maps append these to the vertex format's descriptions
+            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+
+            static PackedTangent Pack(const glm::vec4& tangent);
+        };
+
+        static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions(VertexFormat format);
+        static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions(VertexFormat format);
+
+        // Settings that change the imported geometry. Part of the mesh cache key.
+        struct ImportOptions
+        {
+            // Corners whose components all land in the same grid cell of this size are welded into one
+            // vertex. 0 only welds exact duplicates.
+            float weldEpsilon = 0.0f;
+
+            // Reorder triangles and vertices for the vertex cache, overdraw and vertex fetch
+            bool optimize = true;
+
+            // Only affects the GPU buffer, the mesh cache always stores Vertex
+            VertexFormat vertexFormat = VertexFormat::PACKED;
+
+            // Generate the tangent stream. Skipped for files without normals or texture coordinates.
+            bool generateTangents = true;
+
+            // Levels of detail generated for OBJ imports, counting the full detail mesh. 1 disables them.
+            uint32_t lodCount = 4;
+            // Fraction of the previous level's triangles each level aims for
+            float lodReduction = 0.5f;
+            // Largest simplification error per level, relative to the mesh extent. The chain ends early
+            // once a level can't shrink enough within it.
+            float lodMaxError = 0.02f;
+        };
+
+        // Range of the index buffer drawn for one level of detail. All levels share the vertex buffer. Every level
+        // is split into the same materials, its submeshes are a range of `submeshes`.
+        struct Lod
+        {
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            float error = 0.0f; // Distance to the full detail surface, relative to the mesh extent
+            uint32_t firstSubmesh = 0;
+            uint32_t submeshCount = 0;
+        };
+
+        // Metallic-roughness material of an imported scene. OBJ materials are converted, see ObjParser::ParseMaterials().
+        struct MaterialDesc
+        {
+            std::string name;
+            glm::vec4 baseColorFactor{1.0f};
+            float metallicFactor = 1.0f;
+            float roughnessFactor = 1.0f;
+            std::string baseColorTexture; // Path of the image file, empty when there is none or it is embedded
+        };
+
+        // Index range drawn with one material. Indices are relative to vertexOffset.
+        struct Submesh
+        {
+            // Drawn with the MaterialManager's default material
+            static constexpr uint32_t NO_MATERIAL = ~0u;
+
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            int32_t vertexOffset = 0;
+            uint32_t material = 0;      // Index into `materials` or NO_MATERIAL
+            uint32_t firstMeshlet = 0;  // Meshlets of the range, full detail OBJ submeshes only
+            uint32_t meshletCount = 0;
+        };
+
+        // Node of an imported scene hierarchy. Parents always come before their children.
+        struct Node
+        {
+            std::string name;
+            int32_t parent = -1;
+            glm::mat4 localMatrix{1.0f};
+            glm::mat4 worldMatrix{1.0f};  // Relative to the model, not the GameObject
+            glm::mat4 normalMatrix{1.0f}; // Inverse transpose of worldMatrix
+            uint32_t firstSubmesh = 0;
+            uint32_t submeshCount = 0;
+        };
+
+        // A filled staging buffer waiting to be copied into one of the model's device buffers
+        struct StagedCopy
+        {
+            std::unique_ptr<Buffer> staging;
+            VkBuffer destination = VK_NULL_HANDLE;
+            VkDeviceSize size = 0;
+        };
+
         VOIDENGINE_API explicit Model(Device& _device);
         VOIDENGINE_API ~Model();
 
@@ -40,21 +166,100 @@ namespace VoidEngine
         void draw(VkCommandBuffer commandBuffer) const;
 
         std::unique_ptr<Buffer> vertexBuffer;
+        // PackedTangent per vertex, nullptr when the model has no tangents
+        std::unique_ptr<Buffer> tangentBuffer;
         std::unique_ptr<Buffer> indexBuffer;
         bool hasIndexBuffer = false;
         uint32_t vertexCount;
         uint32_t indexCount;
 
+        // Meshes with fewer than 65536 vertices get 16-bit indices
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+        VertexFormat vertexFormat = VertexFormat::FULL;
+
+        // Object space bounds of the vertices, valid once the buffers are created
+        glm::vec3 boundsMin{0.0f};
+        glm::vec3 boundsMax{0.0f};
+        // Object space center and radius enclosing everything the model draws, node transforms included. Used for
+        // frustum culling.
+        glm::vec4 boundingSphere{0.0f};
+
+        // Maps PACKED positions back to object space. Identity for FULL.
+        glm::mat4 GetDequantizeMatrix() const;
+
+        // lods[0] is the full detail mesh. Empty for glTF imports and procedural models, which draw the whole
+        // index buffer.
+        std::vector<Lod> lods{};
+
+        // Clusters of lods[0] for culling parts of dense meshes, see MeshletCuller. Empty when lods is. Each
+        // full detail submesh owns a contiguous range of them.
+        std::vector<Meshlet> meshlets{};
+
+        // glTF imports have a submesh per primitive, drawn through `nodes`. OBJ imports have one per material and
+        // level of detail, drawn through `lods`, with the triangles of each material grouped together. Procedural
+        // models have none and draw the whole index buffer.
+        std::vector<Submesh> submeshes{};
+        std::vector<Node> nodes{};
+        std::vector<MaterialDesc> materials{};
+
+        // GPU side of `materials`, same order. Filled by MaterialManager::Resolve() before the model is drawn.
+        std::vector<MaterialHandle> materialHandles{};
+
+        // Loads .obj, .gltf and .glb files and uploads them, blocking until the model is resident
         VOIDENGINE_API void LoadModelFromFile(const std::string &filepath);
+        VOIDENGINE_API void LoadModelFromFile(const std::string &filepath, const ImportOptions &options);
+
+        // Imports the file and fills staging buffers without submitting anything to the GPU, so it can run
+        // on a worker thread. The returned copies have to execute (see UploadQueue) before MarkResident().
+        VOIDENGINE_API std::vector<StagedCopy> StageModelFromFile(const std::string &filepath, const ImportOptions &options);
+
+        // Non resident models are skipped when rendering
+        bool IsResident() const { return resident.load(std::memory_order_acquire); }
+        void MarkResident() { resident.store(true, std::memory_order_release); }
+
+        // Exchanges everything but the device with `other`, which must not be in use by another thread. Hot reload
+        // swaps a model with its reimport this way, so every handle to it sees the new mesh and `other` keeps the
+        // old buffers until they can be destroyed.
+        VOIDENGINE_API void Swap(Model& other);
+
         void AddVertex(const Vertex &v);
 
         std::vector<Vertex> vertices{};
+        // Empty or one per vertex
+        std::vector<PackedTangent> tangents{};
         std::vector<uint32_t> indices{};
         void CreateBuffers();
 
+        // Vertex cache efficiency of the imported index buffer before and after optimization
+        VertexCacheStats vertexCacheBefore{};
+        VertexCacheStats vertexCacheAfter{};
+
     private:
-        void createVertexBuffers(const std::vector<Vertex> &vertices);
-        void createIndexBuffers(const std::vector<uint32_t> &indices);
+        void importFile(const std::string& filepath, const ImportOptions& options);
+        void loadGltf(const std::string& filepath, const ImportOptions& options);
+        void stageBuffers();
+        void generateTangents();
+        void optimizeMesh();
+        void generateLods(const ImportOptions& options);
+        void buildMeshlets(bool optimize);
+        // Loads the mtllib files and turns submesh indices into `names` into indices into `materials`
+        void resolveObjMaterials(const std::string& filepath, const std::vector<std::string>& libraries,
+            const std::vector<std::string>& names);
+        void uploadVertices(const Vertex* vertexData, uint32_t count);
+        void uploadTangents(const PackedTangent* tangentData, uint32_t count);
+        void createVertexBuffers(const void* vertexData, uint32_t count, uint32_t vertexSize);
+        void createIndexBuffers(const uint32_t* indexData, uint32_t count);
+
+        // Creates a device local buffer and a staging buffer that `fill` writes into. The copy between them
+        // is only recorded in stagedCopies.
+        void createDeviceBuffer(std::unique_ptr<Buffer>& buffer, VkBufferUsageFlags usage, uint32_t elementSize,
+            uint32_t count, const std::function<void(void* staging)>& fill);
+        // Runs the staged copies in one blocking submission and marks the model resident
+        void uploadStagedCopies();
+
+        // Filled by createDeviceBuffer()
+        std::vector<StagedCopy> stagedCopies;
+        std::atomic<bool> resident{false};
 
         Device& device;
     };
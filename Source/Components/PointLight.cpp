@@ -17,7 +17,7 @@ namespace VoidEngine
     void PointLight::SetPointLight(float i, float r, glm::vec3 c)
     {
         color = c;
-        transform.scale.x = r;
+        GetTransform().scale.x = r;
         radius = r;
         intensity = i;
     }
@@ -96,6 +96,7 @@ namespace VoidEngine
 
             assert(lightIndex < MAX_LIGHTS && "Point lights exceed maximum specified");
 
+            Transform& transform = GetTransform();
             transform.translation = glm::vec3(rotateLight * glm::vec4(transform.translation, 1.f));
 
             ubo.pointLights[lightIndex].position = glm::vec4(transform.translation, 1.f);
@@ -0,0 +1,324 @@
+#include "Texture.hpp"
+#include "TextureCache.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+namespace VoidEngine
+{
+    Texture::Texture(Device& _device) : device(_device)
+    {
+    }
+
+    Texture::~Texture()
+    {
+        destroy();
+    }
+
+    void Texture::Swap(Texture& other)
+    {
+        std::swap(width, other.width);
+        std::swap(height, other.height);
+        std::swap(mipLevels, other.mipLevels);
+        std::swap(format, other.format);
+        std::swap(sizeInBytes, other.sizeInBytes);
+        std::swap(psnr, other.psnr);
+        std::swap(image, other.image);
+        std::swap(imageMemory, other.imageMemory);
+        std::swap(imageView, other.imageView);
+        std::swap(sampler, other.sampler);
+
+        const bool wasResident = IsResident();
+        resident.store(other.IsResident(), std::memory_order_release);
+        other.resident.store(wasResident, std::memory_order_release);
+    }
+
+    namespace
+    {
+        bool endsWith(const std::string& text, const char* suffix)
+        {
+            const size_t length = std::strlen(suffix);
+            return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+        }
+
+        bool isGrayscale(const Image& image)
+        {
+            for (size_t i = 0; i < image.pixels.size(); i += 4)
+            {
+                if (image.pixels[i] != image.pixels[i + 1] || image.pixels[i] != image.pixels[i + 2]) return false;
+            }
+            return true;
+        }
+
+        bool hasAlpha(const Image& image)
+        {
+            for (size_t i = 3; i < image.pixels.size(); i += 4)
+            {
+                if (image.pixels[i] != 255) return true;
+            }
+            return false;
+        }
+
+        VkFormat vulkanFormat(TextureFormat format, bool srgb)
+        {
+            switch (format)
+            {
+                case TextureFormat::RGBA8: return srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+                case TextureFormat::BC1: return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+                case TextureFormat::BC3: return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+                case TextureFormat::BC4: return VK_FORMAT_BC4_UNORM_BLOCK;
+                case TextureFormat::BC5: return VK_FORMAT_BC5_UNORM_BLOCK;
+                case TextureFormat::BC7: return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+            }
+            return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    MipChain Texture::Import(const std::string& filepath, const ImportOptions& options)
+    {
+        const MappedFile source(filepath);
+
+        const bool cached = options.compression != Compression::NONE && options.useCache;
+        const uint64_t sourceHash = cached ? TextureCache::HashSource(source, options) : 0;
+        const std::string cachePath = TextureCache::GetCachePath(filepath);
+        if (cached)
+        {
+            if (const auto cache = TextureCache::Open(cachePath, sourceHash))
+            {
+                return cache->GetMipChain();
+            }
+        }
+
+        Image image = ImageDecoder::Decode(source.data(), source.size());
+        const TextureFormat format = ChooseFormat(filepath, image, options);
+
+        MipChain chain;
+        if (options.generateMips)
+        {
+            const bool srgb = options.colorSpace == ColorSpace::SRGB && format != TextureFormat::BC4 &&
+                format != TextureFormat::BC5;
+            chain = MipGenerator::Generate(image, srgb, options.mipFilter);
+        } else
+        {
+            chain.levels.push_back({0, image.width, image.height});
+            chain.data = std::move(image.pixels);
+        }
+        if (format == TextureFormat::RGBA8) return chain;
+
+        MipChain compressed = BlockCompressor::Compress(chain, format, options.compressionQuality);
+        compressed.psnr = BlockCompressor::ComputePsnr(chain, compressed);
+        if (cached)
+        {
+            TextureCache::Write(cachePath, sourceHash, compressed);
+        }
+        return compressed;
+    }
+
+    TextureFormat Texture::ChooseFormat(const std::string& filepath, const Image& image, const ImportOptions& options)
+    {
+        switch (options.compression)
+        {
+            case Compression::NONE: return TextureFormat::RGBA8;
+            case Compression::BC1: return TextureFormat::BC1;
+            case Compression::BC3: return TextureFormat::BC3;
+            case Compression::BC4: return TextureFormat::BC4;
+            case Compression::BC5: return TextureFormat::BC5;
+            case Compression::BC7: return TextureFormat::BC7;
+            case Compression::AUTO: break;
+        }
+
+        std::string name = std::filesystem::path(filepath).stem().string();
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+
+        // Height maps saved as _bump are grayscale, BC5 would store the same channel twice
+        const bool normalMap = endsWith(name, "_ddn") || endsWith(name, "_nrm") || endsWith(name, "_normal") ||
+            endsWith(name, "_bump");
+        if (normalMap) return isGrayscale(image) ? TextureFormat::BC4 : TextureFormat::BC5;
+
+        // Colored specular maps keep their color
+        const bool dataMap = endsWith(name, "_spec") || endsWith(name, "_mask") || endsWith(name, "_gloss") ||
+            endsWith(name, "_rough") || endsWith(name, "_ao");
+        const bool alpha = hasAlpha(image);
+        if (dataMap && !alpha && isGrayscale(image)) return TextureFormat::BC4;
+
+        if (options.compressionQuality != CompressionQuality::FAST) return TextureFormat::BC7;
+        return alpha ? TextureFormat::BC3 : TextureFormat::BC1;
+    }
+
+    Texture::ImportOptions Texture::SupportedOptions(const Device& device, ImportOptions options)
+    {
+        // Enabled on the device when available, see Device::createLogicalDevice
+        if (!device.enabledFeatures.textureCompressionBC) options.compression = Compression::NONE;
+        return options;
+    }
+
+    void Texture::LoadTextureFromFile(const std::string& filepath)
+    {
+        LoadTextureFromFile(filepath, ImportOptions{});
+    }
+
+    void Texture::LoadTextureFromFile(const std::string& filepath, const ImportOptions& options)
+    {
+        Upload(StageTextureFromFile(filepath, options));
+    }
+
+    void Texture::Upload(const StagedUpload& upload)
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = upload.image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, upload.mipLevels, 0, 1};
+
+        // Every level in one copy
+        VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        vkCmdCopyBufferToImage(commandBuffer, upload.staging->getBuffer(), upload.image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(upload.regions.size()), upload.regions.data());
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        device.endSingleTimeCommands(commandBuffer);
+
+        MarkResident();
+    }
+
+    Texture::StagedUpload Texture::StageTextureFromFile(const std::string& filepath, const ImportOptions& options)
+    {
+        const ImportOptions supported = SupportedOptions(device, options);
+        return StageMipChain(Import(filepath, supported), supported);
+    }
+
+    Texture::StagedUpload Texture::StageMipChain(const MipChain& chain, const ImportOptions& options)
+    {
+        createImage(chain, options);
+
+        StagedUpload upload{};
+        upload.image = image;
+        upload.mipLevels = mipLevels;
+
+        // Levels are tightly packed texels or blocks, so every offset is a multiple of the texel or block size
+        // as Vulkan requires
+        upload.staging = std::make_unique<Buffer>(
+            device,
+            1,
+            static_cast<uint32_t>(chain.data.size()),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+        upload.staging->map();
+        std::memcpy(upload.staging->getMappedMemory(), chain.data.data(), chain.data.size());
+        upload.staging->unmap();
+
+        for (uint32_t level = 0; level < mipLevels; level++)
+        {
+            const MipChain::Level& source = chain.levels[level];
+
+            VkBufferImageCopy region{};
+            region.bufferOffset = source.offset;
+            region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+            region.imageExtent = {source.width, source.height, 1};
+            upload.regions.push_back(region);
+        }
+        return upload;
+    }
+
+    VkDescriptorImageInfo Texture::descriptorInfo() const
+    {
+        VkDescriptorImageInfo info{};
+        info.sampler = sampler;
+        info.imageView = imageView;
+        info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        return info;
+    }
+
+    void Texture::createImage(const MipChain& chain, const ImportOptions& options)
+    {
+        destroy();
+
+        width = chain.levels[0].width;
+        height = chain.levels[0].height;
+        mipLevels = static_cast<uint32_t>(chain.levels.size());
+        format = vulkanFormat(chain.format, options.colorSpace == ColorSpace::SRGB);
+        sizeInBytes = chain.data.size();
+        psnr = chain.psnr;
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = format;
+        imageInfo.extent = {width, height, 1};
+        imageInfo.mipLevels = mipLevels;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = format;
+        // BC4 reads as gray like the single channel map it came from. BC5 keeps blue 0, normal maps rebuild Z.
+        if (chain.format == TextureFormat::BC4)
+        {
+            viewInfo.components = {VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_ONE};
+        }
+        viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1};
+        if (vkCreateImageView(device.device(), &viewInfo, nullptr, &imageView) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create texture image view!");
+        }
+
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        // Enabled on the device, see Device::createLogicalDevice
+        samplerInfo.anisotropyEnable = VK_TRUE;
+        samplerInfo.maxAnisotropy = device.properties.limits.maxSamplerAnisotropy;
+        samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+        samplerInfo.minLod = 0.0f;
+        samplerInfo.maxLod = static_cast<float>(mipLevels);
+        samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+        if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create texture sampler!");
+        }
+    }
+
+    void Texture::destroy()
+    {
+        if (sampler != VK_NULL_HANDLE) vkDestroySampler(device.device(), sampler, nullptr);
+        if (imageView != VK_NULL_HANDLE) vkDestroyImageView(device.device(), imageView, nullptr);
+        if (image != VK_NULL_HANDLE) vkDestroyImage(device.device(), image, nullptr);
+        if (imageMemory != VK_NULL_HANDLE) vkFreeMemory(device.device(), imageMemory, nullptr);
+
+        sampler = VK_NULL_HANDLE;
+        imageView = VK_NULL_HANDLE;
+        image = VK_NULL_HANDLE;
+        imageMemory = VK_NULL_HANDLE;
+    }
+}
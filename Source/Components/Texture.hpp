@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Device.hpp"
+#include "Buffer.hpp"
+#include "BlockCompressor.hpp"
+#include "ImageDecoder.hpp"
+#include "MipGenerator.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Sampled 2D image with a full mip chain, RGBA8 or block compressed
+    class Texture
+    {
+    public:
+        enum class ColorSpace : uint32_t
+        {
+            SRGB,   // Color maps, decoded to linear by the sampler
+            LINEAR, // Normal, bump, roughness and other data maps
+        };
+
+        enum class Compression : uint32_t
+        {
+            NONE,
+            AUTO, // See ChooseFormat()
+            BC1,
+            BC3,
+            BC4,
+            BC5,
+            BC7,
+        };
+
+        struct ImportOptions
+        {
+            ColorSpace colorSpace = ColorSpace::SRGB;
+            // Only the base level is uploaded without them
+            bool generateMips = true;
+            MipFilter mipFilter = MipFilter::BOX;
+            Compression compression = Compression::AUTO;
+            CompressionQuality compressionQuality = CompressionQuality::NORMAL;
+            // Keep compressed results next to the source file, see TextureCache
+            bool useCache = true;
+        };
+
+        // A filled staging buffer holding every mip level, waiting to be copied into the image
+        struct StagedUpload
+        {
+            std::unique_ptr<Buffer> staging;
+            VkImage image = VK_NULL_HANDLE;
+            uint32_t mipLevels = 0;
+            std::vector<VkBufferImageCopy> regions;
+        };
+
+        VOIDENGINE_API explicit Texture(Device& _device);
+        VOIDENGINE_API ~Texture();
+
+        Texture(const Texture&) = delete;
+        Texture& operator=(const Texture&) = delete;
+
+        // Decodes the file, builds its mip chain and block compresses it, or reads all of that back from the
+        // TextureCache. CPU only and thread safe, this is the expensive part.
+        VOIDENGINE_API static MipChain Import(const std::string& filepath, const ImportOptions& options);
+
+        // Format the texture is stored in. AUTO goes by the file name and the contents: normal maps (_ddn, _nrm,
+        // _normal, _bump) become BC5, or BC4 when they are grayscale height maps, grayscale masks and specular
+        // maps (_spec, _mask, _gloss, _rough, _ao) BC4 and everything else BC7, or BC1/BC3 at FAST quality.
+        // BC4 and BC5 have no sRGB variant, textures stored in them are always sampled as LINEAR data.
+        VOIDENGINE_API static TextureFormat ChooseFormat(const std::string& filepath, const Image& image,
+            const ImportOptions& options);
+
+        // The options with compression turned off if the device can't sample BC formats
+        VOIDENGINE_API static ImportOptions SupportedOptions(const Device& device, ImportOptions options);
+
+        // Imports the file and uploads it, blocking until the texture is resident
+        VOIDENGINE_API void LoadTextureFromFile(const std::string& filepath);
+        VOIDENGINE_API void LoadTextureFromFile(const std::string& filepath, const ImportOptions& options);
+
+        // Imports the file, creates the image and fills a staging buffer without submitting anything to the GPU,
+        // so it can run on a worker thread. The upload has to execute (see UploadQueue) before MarkResident().
+        VOIDENGINE_API StagedUpload StageTextureFromFile(const std::string& filepath, const ImportOptions& options);
+
+        // Creates the image from an already imported chain, see StageTextureFromFile()
+        VOIDENGINE_API StagedUpload StageMipChain(const MipChain& chain, const ImportOptions& options);
+
+        // Executes a staged upload right away, blocking until the texture is resident
+        VOIDENGINE_API void Upload(const StagedUpload& upload);
+
+        // Exchanges everything but the device with `other`, see Model::Swap(). Descriptor sets written with the
+        // old view keep pointing at it, their owner has to update them.
+        VOIDENGINE_API void Swap(Texture& other);
+
+        // Non resident textures must not be sampled
+        bool IsResident() const { return resident.load(std::memory_order_acquire); }
+        void MarkResident() { resident.store(true, std::memory_order_release); }
+
+        VkDescriptorImageInfo descriptorInfo() const;
+
+        VkImage getImage() const { return image; }
+        VkImageView getImageView() const { return imageView; }
+        VkSampler getSampler() const { return sampler; }
+
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipLevels = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+
+        // Size of all levels on the GPU
+        VkDeviceSize sizeInBytes = 0;
+
+        // MipChain::psnr of the imported chain, 0 when uncompressed
+        float psnr = 0.0f;
+
+    private:
+        void createImage(const MipChain& chain, const ImportOptions& options);
+        void destroy();
+
+        Device& device;
+
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+        VkImageView imageView = VK_NULL_HANDLE;
+        VkSampler sampler = VK_NULL_HANDLE;
+
+        std::atomic<bool> resident{false};
+    };
+}
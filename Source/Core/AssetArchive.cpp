@@ -0,0 +1,332 @@
+#include "AssetArchive.hpp"
+
+#include "FileWatcher.hpp"
+#include "Lz4.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+
+namespace VoidEngine
+{
+    namespace
+    {
+        // Below this many blocks an entry decompresses faster than the pool wakes up
+        constexpr uint32_t PARALLEL_BLOCKS = 8;
+
+        std::mutex& mountMutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        std::vector<std::shared_ptr<const AssetArchive>>& mountedArchives()
+        {
+            static std::vector<std::shared_ptr<const AssetArchive>> archives;
+            return archives;
+        }
+
+        uint64_t align(uint64_t offset)
+        {
+            return (offset + AssetArchive::ALIGNMENT - 1) & ~(AssetArchive::ALIGNMENT - 1);
+        }
+
+        uint32_t readU32(const uint8_t* p)
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+    }
+
+    static_assert(sizeof(AssetArchive::Header) == 16 && sizeof(AssetArchive::Entry) == 48,
+        "The archive layout must not depend on the compiler");
+
+    AssetArchive::AssetArchive(MappedFile mappedFile) : file(std::move(mappedFile))
+    {
+    }
+
+    uint64_t AssetArchive::HashPath(std::string_view path)
+    {
+        return hashBytes(path.data(), path.size(), MAGIC);
+    }
+
+    std::unique_ptr<AssetArchive> AssetArchive::Open(const std::string& filepath)
+    {
+        // Never looked up in the archives themselves
+        std::unique_ptr<AssetArchive> archive(new AssetArchive(MappedFile(filepath, false)));
+        const MappedFile& f = archive->file;
+
+        Header header{};
+        if (f.size() < sizeof(Header)) throw std::runtime_error("Not an asset archive: " + filepath);
+        std::memcpy(&header, f.data(), sizeof(Header));
+        if (header.magic != MAGIC) throw std::runtime_error("Not an asset archive: " + filepath);
+        if (header.version != VERSION) throw std::runtime_error("Unsupported asset archive version: " + filepath);
+
+        const uint64_t tableEnd = sizeof(Header) + static_cast<uint64_t>(header.entryCount) * sizeof(Entry);
+        if (tableEnd + header.pathBytes > f.size()) throw std::runtime_error("Truncated asset archive: " + filepath);
+
+        // The table directly follows the 16 byte header of a page aligned mapping, so it is aligned for Entry
+        archive->entries = reinterpret_cast<const Entry*>(f.data() + sizeof(Header));
+        archive->entryCount = header.entryCount;
+        archive->paths = reinterpret_cast<const char*>(f.data() + tableEnd);
+
+        for (uint32_t i = 0; i < header.entryCount; i++)
+        {
+            const Entry& entry = archive->entries[i];
+            const bool valid = static_cast<uint64_t>(entry.pathOffset) + entry.pathLength <= header.pathBytes &&
+                entry.offset <= f.size() && entry.storedSize <= f.size() - entry.offset &&
+                (entry.compression == Compression::NONE ? entry.storedSize == entry.size :
+                    entry.compression == Compression::LZ4 &&
+                    entry.blockCount == (entry.size + BLOCK_SIZE - 1) / BLOCK_SIZE &&
+                    static_cast<uint64_t>(entry.blockCount) * sizeof(uint32_t) <= entry.storedSize);
+            if (!valid) throw std::runtime_error("Corrupt asset archive: " + filepath);
+        }
+
+        return archive;
+    }
+
+    const AssetArchive::Entry* AssetArchive::Find(const std::string& path) const
+    {
+        const std::string normalized = FileWatcher::Normalize(path);
+        const uint64_t hash = HashPath(normalized);
+
+        const Entry* end = entries + entryCount;
+        for (const Entry* it = std::lower_bound(entries, end, hash, [](const Entry& entry, uint64_t value)
+            {
+                return entry.pathHash < value;
+            }); it != end && it->pathHash == hash; ++it)
+        {
+            if (GetPath(*it) == normalized) return it;
+        }
+        return nullptr;
+    }
+
+    void AssetArchive::Read(const Entry& entry, uint8_t* destination) const
+    {
+        const uint8_t* stored = GetData(entry);
+        if (entry.compression == Compression::NONE)
+        {
+            std::memcpy(destination, stored, entry.size);
+            return;
+        }
+
+        // Block offsets from the table, checked against the entry before anything is decompressed
+        std::vector<uint64_t> offsets(entry.blockCount);
+        uint64_t offset = static_cast<uint64_t>(entry.blockCount) * sizeof(uint32_t);
+        for (uint32_t i = 0; i < entry.blockCount; i++)
+        {
+            offsets[i] = offset;
+            offset += readU32(stored + i * sizeof(uint32_t)) & ~STORED_BLOCK;
+        }
+        if (offset > entry.storedSize) throw std::runtime_error("Corrupt asset archive entry: " + std::string(GetPath(entry)));
+
+        auto decompress = [&](size_t i)
+        {
+            const uint32_t block = readU32(stored + i * sizeof(uint32_t));
+            const uint32_t blockSize = block & ~STORED_BLOCK;
+            const size_t size = std::min<uint64_t>(BLOCK_SIZE, entry.size - i * BLOCK_SIZE);
+            uint8_t* output = destination + i * BLOCK_SIZE;
+
+            if (block & STORED_BLOCK)
+            {
+                if (blockSize != size) throw std::runtime_error("Corrupt asset archive entry: " + std::string(GetPath(entry)));
+                std::memcpy(output, stored + offsets[i], size);
+            } else if (Lz4::Decompress(stored + offsets[i], blockSize, output, size) != size)
+            {
+                throw std::runtime_error("Corrupt asset archive entry: " + std::string(GetPath(entry)));
+            }
+        };
+
+        if (entry.blockCount >= PARALLEL_BLOCKS)
+        {
+            ThreadPool::getInstance().parallelFor(entry.blockCount, decompress);
+        } else
+        {
+            for (uint32_t i = 0; i < entry.blockCount; i++) decompress(i);
+        }
+    }
+
+    AssetArchive::WriteStats AssetArchive::Write(const std::string& filepath, const std::vector<SourceFile>& files,
+        bool compress)
+    {
+        struct Packed
+        {
+            std::string path;
+            uint64_t hash;
+            MappedFile source;
+            std::vector<uint8_t> compressed;    // Block table and blocks, empty when stored as is
+        };
+
+        std::vector<Packed> packed;
+        packed.reserve(files.size());
+        for (const auto& file : files)
+        {
+            const std::string path = FileWatcher::Normalize(file.path);
+            packed.push_back({path, HashPath(path), MappedFile(file.filepath, false), {}});
+        }
+
+        std::sort(packed.begin(), packed.end(), [](const Packed& a, const Packed& b)
+        {
+            return std::tie(a.hash, a.path) < std::tie(b.hash, b.path);
+        });
+        for (size_t i = 1; i < packed.size(); i++)
+        {
+            if (packed[i].path == packed[i - 1].path) throw std::runtime_error("Packed twice: " + packed[i].path);
+        }
+
+        if (compress)
+        {
+            for (auto& file : packed)
+            {
+                const size_t size = file.source.size();
+                const size_t blockCount = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+                if (blockCount == 0) continue;
+
+                std::vector<std::vector<uint8_t>> blocks(blockCount);
+                ThreadPool::getInstance().parallelFor(blockCount, [&](size_t i)
+                {
+                    const size_t blockSize = std::min<size_t>(BLOCK_SIZE, size - i * BLOCK_SIZE);
+                    Lz4::Compress(file.source.data() + i * BLOCK_SIZE, blockSize, blocks[i]);
+                });
+
+                std::vector<uint8_t> compressed(blockCount * sizeof(uint32_t));
+                for (size_t i = 0; i < blockCount; i++)
+                {
+                    const uint8_t* raw = file.source.data() + i * BLOCK_SIZE;
+                    const size_t rawSize = std::min<size_t>(BLOCK_SIZE, size - i * BLOCK_SIZE);
+                    const bool stored = blocks[i].size() >= rawSize;
+
+                    const uint32_t block = stored ? static_cast<uint32_t>(rawSize) | STORED_BLOCK : static_cast<uint32_t>(blocks[i].size());
+                    std::memcpy(compressed.data() + i * sizeof(uint32_t), &block, sizeof(block));
+                    if (stored) compressed.insert(compressed.end(), raw, raw + rawSize);
+                    else compressed.insert(compressed.end(), blocks[i].begin(), blocks[i].end());
+                }
+
+                // Already compressed formats (PNG, BC textures) would only grow by the block table
+                if (compressed.size() < size) file.compressed = std::move(compressed);
+            }
+        }
+
+        Header header{MAGIC, VERSION, static_cast<uint32_t>(packed.size()), 0};
+        std::string pathStrings;
+        std::vector<Entry> entries(packed.size());
+        for (size_t i = 0; i < packed.size(); i++)
+        {
+            entries[i].pathHash = packed[i].hash;
+            entries[i].pathOffset = static_cast<uint32_t>(pathStrings.size());
+            entries[i].pathLength = static_cast<uint32_t>(packed[i].path.size());
+            pathStrings += packed[i].path;
+        }
+        header.pathBytes = static_cast<uint32_t>(pathStrings.size());
+
+        WriteStats stats{};
+        uint64_t offset = align(sizeof(Header) + entries.size() * sizeof(Entry) + pathStrings.size());
+        for (size_t i = 0; i < packed.size(); i++)
+        {
+            const bool compressed = !packed[i].compressed.empty();
+            entries[i].offset = offset;
+            entries[i].size = packed[i].source.size();
+            entries[i].storedSize = compressed ? packed[i].compressed.size() : entries[i].size;
+            entries[i].compression = compressed ? Compression::LZ4 : Compression::NONE;
+            entries[i].blockCount = compressed ? static_cast<uint32_t>((entries[i].size + BLOCK_SIZE - 1) / BLOCK_SIZE) : 0;
+            offset = align(offset + entries[i].storedSize);
+
+            stats.sourceBytes += entries[i].size;
+            stats.storedBytes += entries[i].storedSize;
+        }
+        stats.files = packed.size();
+
+        // Written to a temporary file first, a game may have the old archive mapped
+        const std::string tmpPath = filepath + ".tmp";
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) throw std::runtime_error("Failed to open " + tmpPath + " for writing.");
+
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+            out.write(pathStrings.data(), static_cast<std::streamsize>(pathStrings.size()));
+
+            static constexpr char padding[ALIGNMENT]{};
+            for (size_t i = 0; i < packed.size(); i++)
+            {
+                out.write(padding, static_cast<std::streamsize>(entries[i].offset - static_cast<uint64_t>(out.tellp())));
+                const uint8_t* data = packed[i].compressed.empty() ? packed[i].source.data() : packed[i].compressed.data();
+                out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(entries[i].storedSize));
+            }
+            // Pads the last entry too, so every entry ends on a page
+            out.write(padding, static_cast<std::streamsize>(offset - static_cast<uint64_t>(out.tellp())));
+
+            if (!out.good()) throw std::runtime_error("Failed to write " + tmpPath);
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, filepath, ec);
+        if (ec) throw std::runtime_error("Failed to write " + filepath + ": " + ec.message());
+
+        stats.archiveBytes = offset;
+        return stats;
+    }
+
+    void AssetArchive::Mount(const std::string& filepath)
+    {
+        std::shared_ptr<const AssetArchive> archive = Open(filepath);
+
+        std::lock_guard lock(mountMutex());
+        mountedArchives().push_back(std::move(archive));
+    }
+
+    void AssetArchive::UnmountAll()
+    {
+        // Views handed out keep their archive mapped
+        std::lock_guard lock(mountMutex());
+        mountedArchives().clear();
+    }
+
+    bool AssetArchive::FindMounted(const std::string& filepath, View& view)
+    {
+        std::shared_ptr<const AssetArchive> archive;
+        const Entry* entry = nullptr;
+        {
+            std::lock_guard lock(mountMutex());
+            auto& archives = mountedArchives();
+            for (auto it = archives.rbegin(); it != archives.rend() && entry == nullptr; ++it)
+            {
+                entry = (*it)->Find(filepath);
+                archive = *it;
+            }
+        }
+        if (entry == nullptr) return false;
+
+        if (entry->compression == Compression::NONE)
+        {
+            view.data = archive->GetData(*entry);
+            view.size = entry->size;
+            archive->file.prefetch(view.data, view.size);
+            view.owner = std::move(archive);
+            return true;
+        }
+
+        auto buffer = std::make_shared<std::vector<uint8_t>>(entry->size);
+        archive->Read(*entry, buffer->data());
+        view.data = buffer->data();
+        view.size = buffer->size();
+        view.owner = std::move(buffer);
+        return true;
+    }
+
+    bool AssetArchive::IsPacked(const std::string& filepath)
+    {
+        std::lock_guard lock(mountMutex());
+        for (const auto& archive : mountedArchives())
+        {
+            if (archive->Find(filepath) != nullptr) return true;
+        }
+        return false;
+    }
+}
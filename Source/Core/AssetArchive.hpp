@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Common.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Read-only pack of asset files, memory mapped as a whole so loading a level costs one open instead of one per
+    // file. Mounted archives are searched by every MappedFile before the file system, which makes them transparent
+    // to the parsers, the caches and RenderPipeline; files not in any of them still load from disk. Written by
+    // the AssetPacker tool.
+    //
+    // File layout:
+    //   Header | Entry[entryCount] | paths | entry data, each aligned to ALIGNMENT
+    //
+    // Entries are sorted by path hash, so a lookup is a binary search over the mapped table. LZ4 entries start
+    // with a uint32_t per BLOCK_SIZE block holding its compressed size, STORED_BLOCK set for blocks kept as is
+    // because they didn't shrink, followed by the blocks.
+    class AssetArchive
+    {
+    public:
+        static constexpr uint32_t MAGIC = 0x4B415056; // "VPAK"
+        static constexpr uint32_t VERSION = 1;
+        // Entries start on a page, so a stored one is mapped without touching its neighbours
+        static constexpr uint64_t ALIGNMENT = 4096;
+        static constexpr uint32_t BLOCK_SIZE = 64 * 1024;
+        static constexpr uint32_t STORED_BLOCK = 0x80000000u;
+
+        enum class Compression : uint32_t
+        {
+            NONE = 0,
+            LZ4 = 1,
+        };
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t entryCount;
+            uint32_t pathBytes;     // Size of the path strings following the entries
+        };
+
+        struct Entry
+        {
+            uint64_t pathHash;      // HashPath() of the path
+            uint32_t pathOffset;    // Into the path strings
+            uint32_t pathLength;
+            uint64_t offset;        // From the start of the file
+            uint64_t storedSize;    // Bytes in the archive, including the block table
+            uint64_t size;          // Bytes once decompressed
+            Compression compression;
+            uint32_t blockCount;    // LZ4 only
+        };
+
+        // A file to pack: its path in the archive, as the engine asks for it, and where to read it from
+        struct SourceFile
+        {
+            std::string path;
+            std::string filepath;
+        };
+
+        struct WriteStats
+        {
+            size_t files = 0;
+            uint64_t sourceBytes = 0;
+            uint64_t storedBytes = 0;   // Entry data without the alignment padding
+            uint64_t archiveBytes = 0;
+        };
+
+        // Contents of a mounted entry. Stored entries point into the archive mapping, compressed ones into a
+        // decompressed copy; `owner` keeps either alive.
+        struct View
+        {
+            std::shared_ptr<const void> owner;
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+        };
+
+        // Throws std::runtime_error if the file can't be mapped or isn't a valid archive
+        VOIDENGINE_API static std::unique_ptr<AssetArchive> Open(const std::string& filepath);
+
+        // Packs `files` into a new archive at `filepath`, compressing entries that shrink with LZ4 when `compress`
+        // is set. Throws std::runtime_error if a file can't be read, or two have the same path.
+        VOIDENGINE_API static WriteStats Write(const std::string& filepath, const std::vector<SourceFile>& files,
+            bool compress);
+
+        // Hash of the normalized path, see FileWatcher::Normalize()
+        VOIDENGINE_API static uint64_t HashPath(std::string_view path);
+
+        // Adds an archive to the ones searched by MappedFile. Later mounts are searched first. Thread safe.
+        VOIDENGINE_API static void Mount(const std::string& filepath);
+        VOIDENGINE_API static void UnmountAll();
+
+        // Looks `filepath` up in the mounted archives. Thread safe.
+        VOIDENGINE_API static bool FindMounted(const std::string& filepath, View& view);
+        // Whether `filepath` is in one of the mounted archives
+        VOIDENGINE_API static bool IsPacked(const std::string& filepath);
+
+        // Entry for `path`, nullptr if the archive doesn't contain it
+        VOIDENGINE_API const Entry* Find(const std::string& path) const;
+
+        // Decompresses the entry into `destination`, which must hold entry.size bytes. Large entries are spread
+        // over the ThreadPool. Throws std::runtime_error on corrupt data.
+        VOIDENGINE_API void Read(const Entry& entry, uint8_t* destination) const;
+
+        // Stored bytes of an uncompressed entry
+        const uint8_t* GetData(const Entry& entry) const { return file.data() + entry.offset; }
+        std::string_view GetPath(const Entry& entry) const { return {paths + entry.pathOffset, entry.pathLength}; }
+
+        uint32_t GetEntryCount() const { return entryCount; }
+        const Entry* GetEntries() const { return entries; }
+
+    private:
+        explicit AssetArchive(MappedFile mappedFile);
+
+        MappedFile file;
+        const Entry* entries = nullptr;
+        uint32_t entryCount = 0;
+        const char* paths = nullptr;
+    };
+}
@@ -93,7 +93,7 @@ namespace VoidEngine
      * @param offset (Optional) Byte offset from beginning of mapped region
      *
      */
-    void Buffer::writeToBuffer(void *data, VkDeviceSize size, VkDeviceSize offset)
+    void Buffer::writeToBuffer(const void *data, VkDeviceSize size, VkDeviceSize offset)
     {
         assert(mapped && "Cannot copy to unmapped buffer");
 
@@ -174,7 +174,7 @@ namespace VoidEngine
      * @param index Used in offset calculation
      *
      */
-    void Buffer::writeToIndex(void *data, int index)
+    void Buffer::writeToIndex(const void *data, int index)
     {
         writeToBuffer(data, instanceSize, index * alignmentSize);
     }
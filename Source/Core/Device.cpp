@@ -160,8 +160,13 @@ namespace VoidEngine
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        // Block compressed textures, Texture falls back to RGBA8 without it
+        deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -170,6 +175,7 @@ namespace VoidEngine
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
         createInfo.pEnabledFeatures = &deviceFeatures;
+        enabledFeatures = deviceFeatures;
         createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
         createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
@@ -191,6 +197,12 @@ namespace VoidEngine
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+        graphicsTimestampValidBits = queueFamilies[indices.graphicsFamily].timestampValidBits;
     }
 
     void Device::createCommandPool()
@@ -203,7 +215,8 @@ namespace VoidEngine
         poolInfo.flags =
             VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
-        if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS ||
+            vkCreateCommandPool(device_, &poolInfo, nullptr, &singleTimePool) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create command pool!");
         }
@@ -212,6 +225,7 @@ namespace VoidEngine
     void Device::cleanup() {
         if (device_ != VK_NULL_HANDLE) {
             vkDestroyCommandPool(device_, commandPool, nullptr);
+            vkDestroyCommandPool(device_, singleTimePool, nullptr);
             vkDestroyDevice(device_, nullptr);
         }
 
@@ -514,10 +528,13 @@ namespace VoidEngine
 
     VkCommandBuffer Device::beginSingleTimeCommands()
     {
+        // Recording touches the pool too, so it stays locked until endSingleTimeCommands()
+        singleTimeMutex.lock();
+
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = commandPool;
+        allocInfo.commandPool = singleTimePool;
         allocInfo.commandBufferCount = 1;
 
         VkCommandBuffer commandBuffer;
@@ -540,10 +557,20 @@ namespace VoidEngine
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
 
-        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue_);
+        // Waits on a fence rather than the queue, so frames can still be submitted in the meantime
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkFence fence;
+        vkCreateFence(device_, &fenceInfo, nullptr, &fence);
+        {
+            auto lock = lockQueues();
+            vkQueueSubmit(graphicsQueue_, 1, &submitInfo, fence);
+        }
+        vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_MAX);
+        vkDestroyFence(device_, fence, nullptr);
 
-        vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+        vkFreeCommandBuffers(device_, singleTimePool, 1, &commandBuffer);
+        singleTimeMutex.unlock();
     }
 
     void Device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
@@ -3,6 +3,7 @@
 #include "Window.hpp"
 
 // std lib headers
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -43,16 +44,20 @@ namespace VoidEngine
             physicalDevice(other.physicalDevice),
             window(other.window),
             commandPool(other.getCommandPool()),
+            singleTimePool(other.singleTimePool),
             device_(other.device_),
             surface_(other.surface_),
             graphicsQueue_(other.graphicsQueue_),
             presentQueue_(other.presentQueue_),
-            properties(other.properties)
+            properties(other.properties),
+            enabledFeatures(other.enabledFeatures),
+            graphicsTimestampValidBits(other.graphicsTimestampValidBits)
         {
             other.instance = VK_NULL_HANDLE;
             other.debugMessenger = VK_NULL_HANDLE;
             other.physicalDevice = VK_NULL_HANDLE;
             other.commandPool = VK_NULL_HANDLE;
+            other.singleTimePool = VK_NULL_HANDLE;
             other.device_ = VK_NULL_HANDLE;
             other.surface_ = VK_NULL_HANDLE;
             other.graphicsQueue_ = VK_NULL_HANDLE;
@@ -73,17 +78,21 @@ namespace VoidEngine
             physicalDevice = other.physicalDevice;
             window = other.window;
             commandPool = other.commandPool;
+            singleTimePool = other.singleTimePool;
             device_ = other.device_;
             surface_ = other.surface_;
             graphicsQueue_ = other.graphicsQueue_;
             presentQueue_ = other.presentQueue_;
             properties = other.properties;
+            enabledFeatures = other.enabledFeatures;
+            graphicsTimestampValidBits = other.graphicsTimestampValidBits;
 
             // Nullify moved-from object
             other.instance = VK_NULL_HANDLE;
             other.debugMessenger = VK_NULL_HANDLE;
             other.physicalDevice = VK_NULL_HANDLE;
             other.commandPool = VK_NULL_HANDLE;
+            other.singleTimePool = VK_NULL_HANDLE;
             other.device_ = VK_NULL_HANDLE;
             other.surface_ = VK_NULL_HANDLE;
             other.graphicsQueue_ = VK_NULL_HANDLE;
@@ -103,6 +112,10 @@ namespace VoidEngine
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
 
+        // Hold while submitting to, presenting on or waiting for a queue. Loader threads submit uploads while
+        // the render thread submits frames, and Vulkan requires queue access to be externally synchronized.
+        std::unique_lock<std::mutex> lockQueues() { return std::unique_lock(queueMutex); }
+
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
         QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
@@ -117,6 +130,8 @@ namespace VoidEngine
             VkBuffer &buffer,
             VkDeviceMemory &bufferMemory);
 
+        // Safe to call from several threads. The commands are recorded from a pool of their own, which stays
+        // locked until endSingleTimeCommands(), so concurrent callers take turns.
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -130,6 +145,10 @@ namespace VoidEngine
             VkDeviceMemory &imageMemory);
 
         VkPhysicalDeviceProperties properties;
+        // Optional features are only set when the physical device supports them
+        VkPhysicalDeviceFeatures enabledFeatures{};
+        // Meaningful low bits of timestamps written on the graphics queue, 0 when it can't write any
+        uint32_t graphicsTimestampValidBits = 0;
 
     private:
         void createInstance();
@@ -156,6 +175,10 @@ namespace VoidEngine
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
         Window &window;
         VkCommandPool commandPool;
+        // Single-time commands only, the render thread records from commandPool without locking
+        VkCommandPool singleTimePool = VK_NULL_HANDLE;
+        std::mutex singleTimeMutex;
+        std::mutex queueMutex;
 
         VkDevice device_;
         VkSurfaceKHR surface_;
@@ -0,0 +1,206 @@
+#include "DynamicAabbTree.hpp"
+
+namespace VoidEngine
+{
+    DynamicAabbTree::DynamicAabbTree(float margin) : margin(margin)
+    {
+    }
+
+    uint32_t DynamicAabbTree::Insert(const Aabb& bounds, uint32_t userData)
+    {
+        const uint32_t proxy = allocateNode();
+        nodes[proxy].bounds = {bounds.min - margin, bounds.max + margin};
+        nodes[proxy].userData = userData;
+        insertLeaf(proxy);
+        proxyCount++;
+        return proxy;
+    }
+
+    void DynamicAabbTree::Remove(uint32_t proxy)
+    {
+        removeLeaf(proxy);
+        freeNode(proxy);
+        proxyCount--;
+    }
+
+    bool DynamicAabbTree::Move(uint32_t proxy, const Aabb& bounds)
+    {
+        const Aabb fat{bounds.min - margin, bounds.max + margin};
+
+        // Still inside, and the old box isn't much larger than a fresh one would be, after shrinking for example
+        const Aabb& current = nodes[proxy].bounds;
+        const Aabb loose{fat.min - 4.0f * margin, fat.max + 4.0f * margin};
+        if (current.Contains(bounds) && loose.Contains(current)) return false;
+
+        removeLeaf(proxy);
+        nodes[proxy].bounds = fat;
+        insertLeaf(proxy);
+        return true;
+    }
+
+    uint32_t DynamicAabbTree::allocateNode()
+    {
+        uint32_t node = freeList;
+        if (node != NULL_NODE)
+        {
+            freeList = nodes[node].parent;
+            nodes[node] = Node{};
+        } else
+        {
+            node = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+        }
+        nodes[node].height = 0;
+        return node;
+    }
+
+    void DynamicAabbTree::freeNode(uint32_t node)
+    {
+        nodes[node] = Node{};
+        nodes[node].parent = freeList;
+        freeList = node;
+    }
+
+    void DynamicAabbTree::insertLeaf(uint32_t leaf)
+    {
+        if (root == NULL_NODE)
+        {
+            root = leaf;
+            nodes[leaf].parent = NULL_NODE;
+            return;
+        }
+
+        // Walk down towards the sibling whose pairing with the leaf adds the least surface area. Every node passed on
+        // the way grows to include the leaf, which is the cost of going deeper.
+        const Aabb leafBounds = nodes[leaf].bounds;
+        uint32_t sibling = root;
+        while (!nodes[sibling].IsLeaf())
+        {
+            const Node& node = nodes[sibling];
+            const float combinedCost = Aabb::Union(node.bounds, leafBounds).GetCost();
+            const float pairCost = 2.0f * combinedCost;
+            const float inheritedCost = 2.0f * (combinedCost - node.bounds.GetCost());
+
+            auto descendCost = [&](uint32_t child)
+            {
+                const Aabb& childBounds = nodes[child].bounds;
+                const float grown = Aabb::Union(childBounds, leafBounds).GetCost();
+                return (nodes[child].IsLeaf() ? grown : grown - childBounds.GetCost()) + inheritedCost;
+            };
+            const float cost1 = descendCost(node.child1);
+            const float cost2 = descendCost(node.child2);
+
+            if (pairCost < cost1 && pairCost < cost2) break;
+            sibling = cost1 < cost2 ? node.child1 : node.child2;
+        }
+
+        const uint32_t oldParent = nodes[sibling].parent;
+        const uint32_t newParent = allocateNode();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].bounds = Aabb::Union(leafBounds, nodes[sibling].bounds);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+
+        if (oldParent == NULL_NODE)
+        {
+            root = newParent;
+        } else if (nodes[oldParent].child1 == sibling)
+        {
+            nodes[oldParent].child1 = newParent;
+        } else
+        {
+            nodes[oldParent].child2 = newParent;
+        }
+
+        refit(oldParent);
+    }
+
+    void DynamicAabbTree::removeLeaf(uint32_t leaf)
+    {
+        if (leaf == root)
+        {
+            root = NULL_NODE;
+            return;
+        }
+
+        // The parent goes away, the sibling takes its place
+        const uint32_t parent = nodes[leaf].parent;
+        const uint32_t grandParent = nodes[parent].parent;
+        const uint32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+        if (grandParent == NULL_NODE)
+        {
+            root = sibling;
+            return;
+        }
+
+        if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+        else nodes[grandParent].child2 = sibling;
+        refit(grandParent);
+    }
+
+    void DynamicAabbTree::refit(uint32_t node)
+    {
+        while (node != NULL_NODE)
+        {
+            node = balance(node);
+
+            Node& current = nodes[node];
+            current.height = 1 + std::max(nodes[current.child1].height, nodes[current.child2].height);
+            current.bounds = Aabb::Union(nodes[current.child1].bounds, nodes[current.child2].bounds);
+            node = current.parent;
+        }
+    }
+
+    uint32_t DynamicAabbTree::balance(uint32_t a)
+    {
+        Node& nodeA = nodes[a];
+        if (nodeA.IsLeaf() || nodeA.height < 2) return a;
+
+        const uint32_t b = nodeA.child1;
+        const uint32_t c = nodeA.child2;
+        const int32_t difference = nodes[c].height - nodes[b].height;
+        if (difference >= -1 && difference <= 1) return a;
+
+        // The taller child moves up into a's place, a takes the taller grandchild's sibling
+        const bool rotateC = difference > 1;
+        const uint32_t up = rotateC ? c : b;
+        const uint32_t stays = rotateC ? b : c;
+        Node& nodeUp = nodes[up];
+        const uint32_t f = nodeUp.child1;
+        const uint32_t g = nodeUp.child2;
+
+        nodeUp.child1 = a;
+        nodeUp.parent = nodeA.parent;
+        nodeA.parent = up;
+        if (nodeUp.parent == NULL_NODE)
+        {
+            root = up;
+        } else if (nodes[nodeUp.parent].child1 == a)
+        {
+            nodes[nodeUp.parent].child1 = up;
+        } else
+        {
+            nodes[nodeUp.parent].child2 = up;
+        }
+
+        // The taller grandchild stays with `up`, the shorter one goes to a
+        const uint32_t keep = nodes[f].height > nodes[g].height ? f : g;
+        const uint32_t give = keep == f ? g : f;
+        nodeUp.child2 = keep;
+        if (rotateC) nodeA.child2 = give;
+        else nodeA.child1 = give;
+        nodes[give].parent = a;
+
+        nodeA.bounds = Aabb::Union(nodes[stays].bounds, nodes[give].bounds);
+        nodeA.height = 1 + std::max(nodes[stays].height, nodes[give].height);
+        nodeUp.bounds = Aabb::Union(nodeA.bounds, nodes[keep].bounds);
+        nodeUp.height = 1 + std::max(nodeA.height, nodes[keep].height);
+        return up;
+    }
+}
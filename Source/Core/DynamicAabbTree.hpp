@@ -0,0 +1,205 @@
+#pragma once
+
+#include "Common.hpp"
+#include "FrustumCuller.hpp"
+
+#include <External/glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VoidEngine
+{
+    struct Aabb
+    {
+        glm::vec3 min{0.0f};
+        glm::vec3 max{0.0f};
+
+        static Aabb FromSphere(const glm::vec3& center, float radius) { return {center - radius, center + radius}; }
+
+        bool Contains(const Aabb& other) const
+        {
+            return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+        }
+        bool Overlaps(const Aabb& other) const
+        {
+            return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+        }
+        // Half the surface area, enough for comparing costs
+        float GetCost() const
+        {
+            const glm::vec3 size = max - min;
+            return size.x * size.y + size.y * size.z + size.z * size.x;
+        }
+
+        static Aabb Union(const Aabb& a, const Aabb& b) { return {glm::min(a.min, b.min), glm::max(a.max, b.max)}; }
+    };
+
+    // Bounding volume hierarchy over boxes that move. Leaves store their box enlarged by a margin, so small moves
+    // don't touch the tree at all, and larger ones remove and reinsert a single leaf. Inserting picks the sibling
+    // that grows the tree's surface area the least and rotations keep it balanced, queries visit O(log n) nodes
+    // plus the ones they return.
+    //
+    // Proxies are leaf ids, stable until removed, each carrying a 32 bit value for the caller.
+    class DynamicAabbTree
+    {
+    public:
+        static constexpr uint32_t NULL_NODE = 0xFFFFFFFF;
+
+        VOIDENGINE_API explicit DynamicAabbTree(float margin = 0.1f);
+
+        VOIDENGINE_API uint32_t Insert(const Aabb& bounds, uint32_t userData);
+        VOIDENGINE_API void Remove(uint32_t proxy);
+        // Returns true if the bounds left the enlarged box and the proxy was reinserted
+        VOIDENGINE_API bool Move(uint32_t proxy, const Aabb& bounds);
+
+        uint32_t GetUserData(uint32_t proxy) const { return nodes[proxy].userData; }
+        // The enlarged box queries test against
+        const Aabb& GetFatBounds(uint32_t proxy) const { return nodes[proxy].bounds; }
+
+        size_t GetProxyCount() const { return proxyCount; }
+        // Longest path from the root to a leaf, 0 for an empty tree
+        uint32_t GetHeight() const { return root == NULL_NODE ? 0 : static_cast<uint32_t>(nodes[root].height); }
+
+        // Calls callback(uint32_t userData) for every proxy whose enlarged box overlaps `bounds`
+        template<typename F>
+        void QueryAabb(const Aabb& bounds, F&& callback) const
+        {
+            traverse([&](const Aabb& box) { return box.Overlaps(bounds); }, callback);
+        }
+
+        template<typename F>
+        void QuerySphere(const glm::vec3& center, float radius, F&& callback) const
+        {
+            traverse([&](const Aabb& box)
+            {
+                const glm::vec3 offset = center - glm::clamp(center, box.min, box.max);
+                return glm::dot(offset, offset) <= radius * radius;
+            }, callback);
+        }
+
+        // Proxies inside or crossing the frustum
+        template<typename F>
+        void QueryFrustum(const Frustum& frustum, F&& callback) const
+        {
+            traverse([&](const Aabb& box)
+            {
+                for (const auto& plane : frustum.planes)
+                {
+                    // The corner farthest along the plane normal
+                    const glm::vec3 corner{plane.x >= 0.0f ? box.max.x : box.min.x, plane.y >= 0.0f ? box.max.y : box.min.y,
+                        plane.z >= 0.0f ? box.max.z : box.min.z};
+                    if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) return false;
+                }
+                return true;
+            }, callback);
+        }
+
+        // Calls callback(uint32_t userData, float entryDistance) for proxies whose enlarged box the ray enters
+        // within `maxDistance`, roughly nearest first. The callback returns the distance to keep searching up to:
+        // `maxDistance` to find every box, the distance of an exact hit to find the closest one, 0 to stop.
+        template<typename F>
+        void QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, F&& callback) const
+        {
+            if (root == NULL_NODE) return;
+            const glm::vec3 inverseDirection = 1.0f / direction;
+
+            std::vector<uint32_t> stack;
+            stack.push_back(root);
+            while (!stack.empty())
+            {
+                const Node& node = nodes[stack.back()];
+                stack.pop_back();
+
+                float entry;
+                if (!rayEnters(node.bounds, origin, inverseDirection, maxDistance, entry)) continue;
+                if (node.IsLeaf())
+                {
+                    maxDistance = callback(node.userData, entry);
+                    if (maxDistance <= 0.0f) return;
+                    continue;
+                }
+
+                // The nearer child goes on top of the stack
+                float entry1 = 0.0f;
+                float entry2 = 0.0f;
+                const bool hit1 = rayEnters(nodes[node.child1].bounds, origin, inverseDirection, maxDistance, entry1);
+                const bool hit2 = rayEnters(nodes[node.child2].bounds, origin, inverseDirection, maxDistance, entry2);
+                if (hit1 && hit2)
+                {
+                    stack.push_back(entry1 <= entry2 ? node.child2 : node.child1);
+                    stack.push_back(entry1 <= entry2 ? node.child1 : node.child2);
+                } else if (hit1) stack.push_back(node.child1);
+                else if (hit2) stack.push_back(node.child2);
+            }
+        }
+
+    private:
+        struct Node
+        {
+            Aabb bounds;
+            uint32_t parent = NULL_NODE;    // Next free node while on the free list
+            uint32_t child1 = NULL_NODE;
+            uint32_t child2 = NULL_NODE;
+            int32_t height = -1;            // 0 for leaves, -1 while free
+            uint32_t userData = 0;
+
+            bool IsLeaf() const { return child1 == NULL_NODE; }
+        };
+
+        // Visits every node `overlaps` accepts and hands the leaves' user data to `callback`
+        template<typename Test, typename F>
+        void traverse(Test&& overlaps, F& callback) const
+        {
+            if (root == NULL_NODE) return;
+
+            std::vector<uint32_t> stack;
+            stack.push_back(root);
+            while (!stack.empty())
+            {
+                const Node& node = nodes[stack.back()];
+                stack.pop_back();
+                if (!overlaps(node.bounds)) continue;
+
+                if (node.IsLeaf())
+                {
+                    callback(node.userData);
+                } else
+                {
+                    stack.push_back(node.child1);
+                    stack.push_back(node.child2);
+                }
+            }
+        }
+
+        // Slab test, `entry` is where the ray enters the box, 0 if it starts inside
+        static bool rayEnters(const Aabb& box, const glm::vec3& origin, const glm::vec3& inverseDirection,
+            float maxDistance, float& entry)
+        {
+            const glm::vec3 t1 = (box.min - origin) * inverseDirection;
+            const glm::vec3 t2 = (box.max - origin) * inverseDirection;
+            const glm::vec3 entries = glm::min(t1, t2);
+            const glm::vec3 exits = glm::max(t1, t2);
+            entry = std::max({entries.x, entries.y, entries.z, 0.0f});
+            const float exit = std::min({exits.x, exits.y, exits.z, maxDistance});
+            return entry <= exit;
+        }
+
+        uint32_t allocateNode();
+        void freeNode(uint32_t node);
+        void insertLeaf(uint32_t leaf);
+        void removeLeaf(uint32_t leaf);
+        // Rotates the subtree at `node` if its children's heights differ by more than one, returns its new root
+        uint32_t balance(uint32_t node);
+        // Recomputes bounds and heights from `node` up to the root, balancing on the way
+        void refit(uint32_t node);
+
+        float margin;
+        std::vector<Node> nodes;
+        uint32_t root = NULL_NODE;
+        uint32_t freeList = NULL_NODE;
+        size_t proxyCount = 0;
+    };
+}
@@ -0,0 +1,122 @@
+#include "FileWatcher.hpp"
+
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+    #include <cerrno>
+    #include <cstring>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+namespace VoidEngine
+{
+    FileWatcher::FileWatcher()
+    {
+#ifdef __linux__
+        // Non-blocking, so Poll() only drains what is already there
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0)
+        {
+            std::cerr << "Failed to create the file watcher: " << std::strerror(errno) << "\n";
+        }
+#endif
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+#ifdef __linux__
+        // Closing the descriptor removes every watch
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    bool FileWatcher::IsSupported()
+    {
+#ifdef __linux__
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    std::string FileWatcher::Normalize(const std::string& filepath)
+    {
+        return std::filesystem::path(filepath).lexically_normal().generic_string();
+    }
+
+    void FileWatcher::Watch(const std::string& filepath)
+    {
+#ifdef __linux__
+        const std::string path = Normalize(filepath);
+
+        std::lock_guard lock(mutex);
+        if (fd < 0 || !files.insert(path).second) return;
+
+        std::string directory = std::filesystem::path(path).parent_path().generic_string();
+        if (directory.empty()) directory = ".";
+        if (watchedDirectories.contains(directory)) return;
+
+        // Written in place, or renamed over by editors that save atomically. Creation alone is not reported,
+        // the file may still be empty then.
+        const int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0)
+        {
+            std::cerr << "Failed to watch " << directory << ": " << std::strerror(errno) << "\n";
+            return;
+        }
+        directories[wd] = directory;
+        watchedDirectories.insert(directory);
+#else
+        (void)filepath;
+#endif
+    }
+
+    std::vector<std::string> FileWatcher::Poll()
+    {
+        std::vector<std::string> changed;
+#ifdef __linux__
+        std::lock_guard lock(mutex);
+        if (fd < 0) return changed;
+
+        std::unordered_set<std::string> seen;
+        bool overflowed = false;
+
+        alignas(inotify_event) char buffer[4096];
+        while (true)
+        {
+            const ssize_t length = read(fd, buffer, sizeof(buffer));
+            if (length <= 0) break;
+
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                if (event->mask & IN_Q_OVERFLOW)
+                {
+                    overflowed = true;
+                    continue;
+                }
+
+                const auto it = directories.find(event->wd);
+                if (it == directories.end() || event->len == 0) continue;
+
+                const std::string path = Normalize(it->second + "/" + event->name);
+                if (files.contains(path) && seen.insert(path).second)
+                {
+                    changed.push_back(path);
+                }
+            }
+        }
+
+        // Events were dropped, anything may have changed
+        if (overflowed)
+        {
+            changed.assign(files.begin(), files.end());
+        }
+#endif
+        return changed;
+    }
+}
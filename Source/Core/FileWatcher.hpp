@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Reports files that were written since the last Poll(), for hot reloading assets edited while the game runs.
+    //
+    // Backed by inotify on Linux. The watch is put on the directory of every file, so editors that save to a
+    // temporary file and rename it over the original are caught as well. Other platforms have no backend yet,
+    // IsSupported() is false there and Poll() never reports anything.
+    class FileWatcher
+    {
+    public:
+        VOIDENGINE_API FileWatcher();
+        VOIDENGINE_API ~FileWatcher();
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        // Starts watching `filepath`, which does not have to exist yet. Thread safe, watching a file twice is a no-op.
+        VOIDENGINE_API void Watch(const std::string& filepath);
+
+        // Watched files that were written or replaced since the last call, each reported once, normalized like
+        // the managers' cache keys ("models/./vase.obj" is "models/vase.obj"). Never blocks.
+        VOIDENGINE_API std::vector<std::string> Poll();
+
+        VOIDENGINE_API static bool IsSupported();
+
+        // The form Poll() reports `filepath` in
+        VOIDENGINE_API static std::string Normalize(const std::string& filepath);
+
+    private:
+        std::mutex mutex;
+        int fd = -1;
+        // Watch descriptor to the directory it watches
+        std::unordered_map<int, std::string> directories;
+        std::unordered_set<std::string> watchedDirectories;
+        std::unordered_set<std::string> files;
+    };
+}
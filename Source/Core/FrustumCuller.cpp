@@ -0,0 +1,95 @@
+#include "FrustumCuller.hpp"
+
+#ifdef VOIDENGINE_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace VoidEngine
+{
+    namespace
+    {
+        // Spheres [begin, count) one at a time. Same operation order as the SIMD path, so both agree exactly.
+        size_t cullRange(const Frustum& frustum, const SphereSoA& spheres, size_t begin, uint8_t* visible)
+        {
+            size_t visibleCount = 0;
+            for (size_t i = begin; i < spheres.Size(); i++)
+            {
+                bool outside = false;
+                for (const auto& plane : frustum.planes)
+                {
+                    const float distance = plane.x * spheres.x[i] + plane.y * spheres.y[i] + plane.z * spheres.z[i] + plane.w;
+                    outside |= distance < -spheres.radius[i];
+                }
+                visible[i] = outside ? 0 : 1;
+                visibleCount += visible[i];
+            }
+            return visibleCount;
+        }
+    }
+
+    Frustum Frustum::FromViewProjection(const glm::mat4& viewProjection)
+    {
+        // Gribb and Hartmann. Vulkan clips depth to [0, w], so the near plane is the third row alone.
+        const glm::mat4 m = glm::transpose(viewProjection);
+        Frustum frustum{{
+            m[3] + m[0], m[3] - m[0],
+            m[3] + m[1], m[3] - m[1],
+            m[2], m[3] - m[2],
+        }};
+        for (auto& plane : frustum.planes)
+        {
+            const float length = glm::length(glm::vec3(plane));
+            if (length > 0.0f) plane /= length;
+        }
+        return frustum;
+    }
+
+    size_t FrustumCuller::Cull(const Frustum& frustum, const SphereSoA& spheres, uint8_t* visible)
+    {
+#ifdef VOIDENGINE_SSE2
+        const size_t simdCount = spheres.Size() & ~size_t{3};
+        size_t visibleCount = 0;
+        for (size_t i = 0; i < simdCount; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(&spheres.x[i]);
+            const __m128 y = _mm_loadu_ps(&spheres.y[i]);
+            const __m128 z = _mm_loadu_ps(&spheres.z[i]);
+            const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+
+            __m128 outside = _mm_setzero_ps();
+            for (const auto& plane : frustum.planes)
+            {
+                __m128 distance = _mm_mul_ps(_mm_set1_ps(plane.x), x);
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.y), y));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.z), z));
+                distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+            }
+
+            const int outsideMask = _mm_movemask_ps(outside);
+            for (int lane = 0; lane < 4; lane++)
+            {
+                visible[i + lane] = (outsideMask >> lane & 1) ? 0 : 1;
+                visibleCount += visible[i + lane];
+            }
+        }
+        return visibleCount + cullRange(frustum, spheres, simdCount, visible);
+#else
+        return cullRange(frustum, spheres, 0, visible);
+#endif
+    }
+
+    size_t FrustumCuller::CullScalar(const Frustum& frustum, const SphereSoA& spheres, uint8_t* visible)
+    {
+        return cullRange(frustum, spheres, 0, visible);
+    }
+
+    bool FrustumCuller::IsSimd()
+    {
+#ifdef VOIDENGINE_SSE2
+        return true;
+#else
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <External/glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Six planes facing into the view volume, normalized so distances are in world units
+    struct Frustum
+    {
+        glm::vec4 planes[6];
+
+        // `viewProjection` maps world space to Vulkan clip space (depth 0 to 1)
+        VOIDENGINE_API static Frustum FromViewProjection(const glm::mat4& viewProjection);
+    };
+
+    // World space bounding spheres one float per array, so four spheres fill an SSE register
+    struct SphereSoA
+    {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<float> radius;
+
+        size_t Size() const { return radius.size(); }
+        void Clear()
+        {
+            x.clear();
+            y.clear();
+            z.clear();
+            radius.clear();
+        }
+        void Push(const glm::vec3& center, float sphereRadius)
+        {
+            x.push_back(center.x);
+            y.push_back(center.y);
+            z.push_back(center.z);
+            radius.push_back(sphereRadius);
+        }
+    };
+
+    // Tests bounding spheres against the view frustum four at a time, before any draw is recorded for them
+    class FrustumCuller
+    {
+    public:
+        // Sets visible[i] to 1 for spheres that reach into the frustum and to 0 for those entirely behind one of
+        // its planes. Returns the number of visible spheres.
+        VOIDENGINE_API static size_t Cull(const Frustum& frustum, const SphereSoA& spheres, uint8_t* visible);
+        // Same results one sphere at a time, the reference for the SIMD path
+        VOIDENGINE_API static size_t CullScalar(const Frustum& frustum, const SphereSoA& spheres, uint8_t* visible);
+
+        // Whether Cull() uses the SSE2 path in this build
+        VOIDENGINE_API static bool IsSimd();
+    };
+}
@@ -0,0 +1,178 @@
+#include "MappedFile.hpp"
+#include "AssetArchive.hpp"
+
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace VoidEngine
+{
+    MappedFile::MappedFile(const std::string& filepath, bool searchArchives) : path_(filepath)
+    {
+        if (AssetArchive::View view; searchArchives && AssetArchive::FindMounted(filepath, view))
+        {
+            owner_ = std::move(view.owner);
+            data_ = view.data;
+            size_ = view.size;
+            return;
+        }
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Failed to open file: " + filepath);
+        }
+        fileHandle = file;
+
+        LARGE_INTEGER fileSize{};
+        GetFileSizeEx(file, &fileSize);
+        size_ = static_cast<size_t>(fileSize.QuadPart);
+
+        // Mapping an empty file is an error on Windows, an empty view is valid for us
+        if (size_ == 0) return;
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr)
+        {
+            close();
+            throw std::runtime_error("Failed to map file: " + filepath);
+        }
+        mappingHandle = mapping;
+
+        data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (data_ == nullptr)
+        {
+            close();
+            throw std::runtime_error("Failed to map file: " + filepath);
+        }
+#else
+        int fd = ::open(filepath.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Failed to open file: " + filepath);
+        }
+
+        struct stat st{};
+        if (fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Failed to stat file: " + filepath);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+
+        if (size_ > 0)
+        {
+            void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("Failed to map file: " + filepath);
+            }
+            madvise(mapped, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const uint8_t*>(mapped);
+        }
+
+        // The mapping keeps its own reference to the file
+        ::close(fd);
+#endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    bool MappedFile::Exists(const std::string& filepath)
+    {
+        std::error_code ec;
+        return AssetArchive::IsPacked(filepath) || std::filesystem::is_regular_file(filepath, ec);
+    }
+
+    void MappedFile::prefetch(const uint8_t* data, size_t size) const
+    {
+#ifndef _WIN32
+        if (size == 0) return;
+
+        // madvise wants whole pages
+        const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(data) & ~(pageSize - 1);
+        const uintptr_t end = reinterpret_cast<uintptr_t>(data) + size;
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+#else
+        (void)data;
+        (void)size;
+#endif
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : path_(std::move(other.path_)), data_(other.data_), size_(other.size_), owner_(std::move(other.owner_))
+#ifdef _WIN32
+        , fileHandle(other.fileHandle), mappingHandle(other.mappingHandle)
+#endif
+    {
+        other.data_ = nullptr;
+        other.size_ = 0;
+#ifdef _WIN32
+        other.fileHandle = nullptr;
+        other.mappingHandle = nullptr;
+#endif
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this == &other) return *this;
+
+        close();
+
+        path_ = std::move(other.path_);
+        data_ = other.data_;
+        size_ = other.size_;
+        owner_ = std::move(other.owner_);
+        other.data_ = nullptr;
+        other.size_ = 0;
+#ifdef _WIN32
+        fileHandle = other.fileHandle;
+        mappingHandle = other.mappingHandle;
+        other.fileHandle = nullptr;
+        other.mappingHandle = nullptr;
+#endif
+        return *this;
+    }
+
+    void MappedFile::close()
+    {
+        if (owner_ != nullptr)
+        {
+            owner_.reset();
+            data_ = nullptr;
+            size_ = 0;
+            return;
+        }
+
+#ifdef _WIN32
+        if (data_ != nullptr) UnmapViewOfFile(data_);
+        if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+        if (fileHandle != nullptr) CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+#else
+        if (data_ != nullptr) munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
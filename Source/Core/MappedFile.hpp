@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace VoidEngine
+{
+    // Read-only memory mapping of a whole file. The mapping lives as long as the object.
+    //
+    // Files in a mounted AssetArchive are served from it, only the others are opened on disk. Unless
+    // `searchArchives` is false, which the archives themselves and the packer use.
+    class MappedFile
+    {
+    public:
+        VOIDENGINE_API explicit MappedFile(const std::string& filepath, bool searchArchives = true);
+        VOIDENGINE_API ~MappedFile();
+
+        // Whether a MappedFile of `filepath` would open, from an archive or the disk
+        VOIDENGINE_API static bool Exists(const std::string& filepath);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        VOIDENGINE_API MappedFile(MappedFile&& other) noexcept;
+        VOIDENGINE_API MappedFile& operator=(MappedFile&& other) noexcept;
+
+        const uint8_t* data() const { return data_; }
+        size_t size() const { return size_; }
+        const std::string& path() const { return path_; }
+
+        // Asks the OS to start reading a range of the mapping in ahead of use
+        VOIDENGINE_API void prefetch(const uint8_t* data, size_t size) const;
+
+    private:
+        void close();
+
+        std::string path_;
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+        // Set when the contents come from an archive, which keeps them alive. Nothing is mapped by this object then.
+        std::shared_ptr<const void> owner_;
+
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+    };
+}
@@ -0,0 +1,323 @@
+#include "OcclusionCuller.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef VOIDENGINE_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace VoidEngine
+{
+    namespace
+    {
+        constexpr uint32_t FULL_MASK = 0xFFFFFFFF;
+
+        // Pixels of a tile whose whole square is inside all three edges, bit y * TILE_WIDTH + x. The SIMD and the
+        // scalar version do the same float operations in the same order, so they agree exactly.
+        template<typename T>
+        uint32_t coverageScalar(const T& triangle, uint32_t tileX, uint32_t tileY)
+        {
+            uint32_t mask = 0;
+            for (uint32_t row = 0; row < OcclusionCuller::TILE_HEIGHT; row++)
+            {
+                const float y = static_cast<float>(tileY) + (static_cast<float>(row) + 0.5f);
+                const glm::vec3 rowValue = triangle.edgeB * y + triangle.edgeC;
+                for (uint32_t column = 0; column < OcclusionCuller::TILE_WIDTH; column++)
+                {
+                    const float x = static_cast<float>(tileX) + (static_cast<float>(column) + 0.5f);
+                    const bool inside = triangle.edgeA.x * x + rowValue.x >= 0.0f && triangle.edgeA.y * x + rowValue.y >= 0.0f &&
+                        triangle.edgeA.z * x + rowValue.z >= 0.0f;
+                    if (inside) mask |= 1u << (row * OcclusionCuller::TILE_WIDTH + column);
+                }
+            }
+            return mask;
+        }
+
+#ifdef VOIDENGINE_SSE2
+        template<typename T>
+        uint32_t coverageSimd(const T& triangle, uint32_t tileX, uint32_t tileY)
+        {
+            // The tile's eight pixel centers in x, as two registers
+            const __m128 left = _mm_add_ps(_mm_set1_ps(static_cast<float>(tileX)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+            const __m128 right = _mm_add_ps(_mm_set1_ps(static_cast<float>(tileX)), _mm_setr_ps(4.5f, 5.5f, 6.5f, 7.5f));
+
+            uint32_t mask = 0;
+            for (uint32_t row = 0; row < OcclusionCuller::TILE_HEIGHT; row++)
+            {
+                const float y = static_cast<float>(tileY) + (static_cast<float>(row) + 0.5f);
+                const glm::vec3 rowValue = triangle.edgeB * y + triangle.edgeC;
+
+                __m128 insideLeft = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                __m128 insideRight = insideLeft;
+                for (int edge = 0; edge < 3; edge++)
+                {
+                    const __m128 a = _mm_set1_ps(triangle.edgeA[edge]);
+                    const __m128 value = _mm_set1_ps(rowValue[edge]);
+                    insideLeft = _mm_and_ps(insideLeft, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a, left), value), _mm_setzero_ps()));
+                    insideRight = _mm_and_ps(insideRight, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a, right), value), _mm_setzero_ps()));
+                }
+
+                const auto bits = static_cast<uint32_t>(_mm_movemask_ps(insideLeft) | _mm_movemask_ps(insideRight) << 4);
+                mask |= bits << (row * OcclusionCuller::TILE_WIDTH);
+            }
+            return mask;
+        }
+#endif
+    }
+
+    OccluderMesh OccluderMesh::Box(const glm::vec3& min, const glm::vec3& max)
+    {
+        OccluderMesh mesh;
+        for (int corner = 0; corner < 8; corner++)
+        {
+            mesh.positions.emplace_back(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z);
+        }
+        // Two triangles per face, winding doesn't matter for occluders
+        mesh.indices = {
+            0, 1, 3, 0, 3, 2,   4, 6, 7, 4, 7, 5,
+            0, 4, 5, 0, 5, 1,   2, 3, 7, 2, 7, 6,
+            0, 2, 6, 0, 6, 4,   1, 5, 7, 1, 7, 3,
+        };
+        return mesh;
+    }
+
+    OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height)
+        : tilesX((std::max(width, 1u) + TILE_WIDTH - 1) / TILE_WIDTH), tilesY((std::max(height, 1u) + TILE_HEIGHT - 1) / TILE_HEIGHT)
+    {
+        this->width = tilesX * TILE_WIDTH;
+        this->height = tilesY * TILE_HEIGHT;
+        tiles.resize(static_cast<size_t>(tilesX) * tilesY);
+    }
+
+    void OcclusionCuller::BeginFrame(const glm::mat4& viewProjection)
+    {
+        this->viewProjection = viewProjection;
+        std::fill(tiles.begin(), tiles.end(), Tile{});
+        triangles.clear();
+    }
+
+    void OcclusionCuller::AddOccluder(const OccluderMesh& mesh, const glm::mat4& modelMatrix)
+    {
+        const glm::mat4 modelViewProjection = viewProjection * modelMatrix;
+        clipPositions.resize(mesh.positions.size());
+        for (size_t i = 0; i < mesh.positions.size(); i++)
+        {
+            clipPositions[i] = modelViewProjection * glm::vec4(mesh.positions[i], 1.0f);
+        }
+
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            glm::vec3 screen[3];
+            bool clipped = false;
+            for (int vertex = 0; vertex < 3; vertex++)
+            {
+                const glm::vec4& clip = clipPositions[mesh.indices[i + vertex]];
+                // Leaving out a triangle only loses occlusion, clipping it isn't worth it
+                if (clip.w <= 0.0f || clip.z < 0.0f)
+                {
+                    clipped = true;
+                    break;
+                }
+                screen[vertex] = {(clip.x / clip.w * 0.5f + 0.5f) * static_cast<float>(width),
+                    (clip.y / clip.w * 0.5f + 0.5f) * static_cast<float>(height), clip.z / clip.w};
+            }
+            if (clipped) continue;
+
+            float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) -
+                (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+            if (std::abs(area) < 1e-6f) continue;
+            // Both sides occlude, counter clockwise makes the edge functions positive inside
+            if (area < 0.0f)
+            {
+                std::swap(screen[1], screen[2]);
+                area = -area;
+            }
+
+            const glm::vec2 low = glm::min(glm::min(glm::vec2(screen[0]), glm::vec2(screen[1])), glm::vec2(screen[2]));
+            const glm::vec2 high = glm::max(glm::max(glm::vec2(screen[0]), glm::vec2(screen[1])), glm::vec2(screen[2]));
+            const int minX = std::max(static_cast<int>(std::floor(low.x)), 0);
+            const int minY = std::max(static_cast<int>(std::floor(low.y)), 0);
+            const int maxX = std::min(static_cast<int>(std::ceil(high.x)) - 1, static_cast<int>(width) - 1);
+            const int maxY = std::min(static_cast<int>(std::ceil(high.y)) - 1, static_cast<int>(height) - 1);
+            if (minX > maxX || minY > maxY) continue;
+
+            Triangle triangle{};
+            for (int edge = 0; edge < 3; edge++)
+            {
+                const glm::vec3& from = screen[edge];
+                const glm::vec3& to = screen[(edge + 1) % 3];
+                const float a = from.y - to.y;
+                const float b = to.x - from.x;
+                triangle.edgeA[edge] = a;
+                triangle.edgeB[edge] = b;
+                // Shifted in by the half pixel the farthest corner of a pixel square is from its center
+                triangle.edgeC[edge] = from.x * to.y - from.y * to.x - 0.5f * (std::abs(a) + std::abs(b));
+            }
+
+            const glm::vec3 edge1 = screen[1] - screen[0];
+            const glm::vec3 edge2 = screen[2] - screen[0];
+            triangle.depthPlane.x = (edge1.z * edge2.y - edge2.z * edge1.y) / area;
+            triangle.depthPlane.y = (edge2.z * edge1.x - edge1.z * edge2.x) / area;
+            triangle.depthPlane.z = screen[0].z - triangle.depthPlane.x * screen[0].x - triangle.depthPlane.y * screen[0].y;
+            triangle.maxDepth = std::max({screen[0].z, screen[1].z, screen[2].z});
+
+            triangle.minTileX = static_cast<uint32_t>(minX) / TILE_WIDTH;
+            triangle.minTileY = static_cast<uint32_t>(minY) / TILE_HEIGHT;
+            triangle.maxTileX = static_cast<uint32_t>(maxX) / TILE_WIDTH;
+            triangle.maxTileY = static_cast<uint32_t>(maxY) / TILE_HEIGHT;
+            triangles.push_back(triangle);
+        }
+    }
+
+    void OcclusionCuller::Rasterize()
+    {
+        rasterize(IsSimd());
+    }
+
+    void OcclusionCuller::RasterizeScalar()
+    {
+        rasterize(false);
+    }
+
+    void OcclusionCuller::rasterize(bool simd)
+    {
+        // Every tile row only writes its own tiles
+        ThreadPool::getInstance().parallelFor(tilesY, [&](size_t tileY)
+        {
+            rasterizeTileRow(static_cast<uint32_t>(tileY), simd);
+        });
+    }
+
+    void OcclusionCuller::rasterizeTileRow(uint32_t tileY, bool simd)
+    {
+        const uint32_t y = tileY * TILE_HEIGHT;
+        for (const Triangle& triangle : triangles)
+        {
+            if (tileY < triangle.minTileY || tileY > triangle.maxTileY) continue;
+
+            for (uint32_t tileX = triangle.minTileX; tileX <= triangle.maxTileX; tileX++)
+            {
+                const uint32_t x = tileX * TILE_WIDTH;
+#ifdef VOIDENGINE_SSE2
+                const uint32_t coverage = simd ? coverageSimd(triangle, x, y) : coverageScalar(triangle, x, y);
+#else
+                const uint32_t coverage = coverageScalar(triangle, x, y);
+#endif
+                if (coverage == 0) continue;
+
+                // The plane is farthest at a corner of the tile, and the triangle never farther than its vertices
+                const glm::vec3& plane = triangle.depthPlane;
+                const float left = static_cast<float>(x);
+                const float right = static_cast<float>(x + TILE_WIDTH);
+                const float top = static_cast<float>(y);
+                const float bottom = static_cast<float>(y + TILE_HEIGHT);
+                const float planeMax = std::max({plane.x * left + plane.y * top, plane.x * right + plane.y * top,
+                    plane.x * left + plane.y * bottom, plane.x * right + plane.y * bottom}) + plane.z;
+
+                updateTile(tiles[static_cast<size_t>(tileY) * tilesX + tileX], coverage, std::min(planeMax, triangle.maxDepth));
+            }
+        }
+    }
+
+    void OcclusionCuller::updateTile(Tile& tile, uint32_t coverage, float depth) const
+    {
+        if (depth >= tile.zMax0) return;
+
+        // A triangle much farther than the working layer would push all of it back, start the layer over instead
+        if (tile.mask != 0 && depth - tile.zMax1 > tile.zMax0 - depth)
+        {
+            tile.mask = coverage;
+            tile.zMax1 = depth;
+        } else
+        {
+            tile.zMax1 = tile.mask != 0 ? std::max(tile.zMax1, depth) : depth;
+            tile.mask |= coverage;
+        }
+
+        // The layer covers the tile, it becomes the tile's depth
+        if (tile.mask == FULL_MASK)
+        {
+            tile.zMax0 = tile.zMax1;
+            tile.zMax1 = 0.0f;
+            tile.mask = 0;
+        }
+    }
+
+    bool OcclusionCuller::IsVisible(const Aabb& worldBounds) const
+    {
+        glm::vec2 low{std::numeric_limits<float>::max()};
+        glm::vec2 high{-std::numeric_limits<float>::max()};
+        float nearest = std::numeric_limits<float>::max();
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const glm::vec3 position{corner & 1 ? worldBounds.max.x : worldBounds.min.x,
+                corner & 2 ? worldBounds.max.y : worldBounds.min.y, corner & 4 ? worldBounds.max.z : worldBounds.min.z};
+            const glm::vec4 clip = viewProjection * glm::vec4(position, 1.0f);
+            // Reaches in front of the near plane, it covers too much of the screen to bother
+            if (clip.w <= 0.0f || clip.z < 0.0f) return true;
+
+            const glm::vec2 screen{(clip.x / clip.w * 0.5f + 0.5f) * static_cast<float>(width),
+                (clip.y / clip.w * 0.5f + 0.5f) * static_cast<float>(height)};
+            low = glm::min(low, screen);
+            high = glm::max(high, screen);
+            nearest = std::min(nearest, clip.z / clip.w);
+        }
+
+        // Every pixel the box touches
+        const int minX = std::max(static_cast<int>(std::floor(low.x)), 0);
+        const int minY = std::max(static_cast<int>(std::floor(low.y)), 0);
+        const int maxX = std::min(static_cast<int>(std::floor(high.x)), static_cast<int>(width) - 1);
+        const int maxY = std::min(static_cast<int>(std::floor(high.y)), static_cast<int>(height) - 1);
+        if (minX > maxX || minY > maxY) return true;
+
+        for (uint32_t tileY = minY / TILE_HEIGHT; tileY <= maxY / TILE_HEIGHT; tileY++)
+        {
+            for (uint32_t tileX = minX / TILE_WIDTH; tileX <= maxX / TILE_WIDTH; tileX++)
+            {
+                const Tile& tile = tiles[static_cast<size_t>(tileY) * tilesX + tileX];
+                if (nearest > tile.zMax0) continue;
+
+                // The box's pixels within this tile, one run of columns repeated over its rows
+                const int tileLeft = static_cast<int>(tileX * TILE_WIDTH);
+                const int tileTop = static_cast<int>(tileY * TILE_HEIGHT);
+                const int firstColumn = std::max(minX - tileLeft, 0);
+                const int lastColumn = std::min(maxX - tileLeft, static_cast<int>(TILE_WIDTH) - 1);
+                const int firstRow = std::max(minY - tileTop, 0);
+                const int lastRow = std::min(maxY - tileTop, static_cast<int>(TILE_HEIGHT) - 1);
+                const uint32_t columns = ((1u << (lastColumn + 1)) - 1) & ~((1u << firstColumn) - 1);
+                uint32_t boxMask = 0;
+                for (int row = firstRow; row <= lastRow; row++) boxMask |= columns << (row * TILE_WIDTH);
+                if ((boxMask & ~tile.mask) == 0 && nearest > tile.zMax1) continue;
+
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void OcclusionCuller::ResolveDepth(std::vector<float>& depth) const
+    {
+        depth.resize(static_cast<size_t>(width) * height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const Tile& tile = tiles[static_cast<size_t>(y / TILE_HEIGHT) * tilesX + x / TILE_WIDTH];
+                const uint32_t bit = 1u << ((y % TILE_HEIGHT) * TILE_WIDTH + x % TILE_WIDTH);
+                depth[static_cast<size_t>(y) * width + x] = tile.mask & bit ? std::min(tile.zMax0, tile.zMax1) : tile.zMax0;
+            }
+        }
+    }
+
+    bool OcclusionCuller::IsSimd()
+    {
+#ifdef VOIDENGINE_SSE2
+        return true;
+#else
+        return false;
+#endif
+    }
+}
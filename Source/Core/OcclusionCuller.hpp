@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Common.hpp"
+#include "DynamicAabbTree.hpp"
+
+#include <External/glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Simplified geometry that hides what is behind it: walls, floors, large columns. A few dozen triangles each,
+    // separate from the render mesh.
+    struct OccluderMesh
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+
+        // The twelve triangles of a box
+        VOIDENGINE_API static OccluderMesh Box(const glm::vec3& min, const glm::vec3& max);
+    };
+
+    // Marks an entity as an occluder, drawn into the OcclusionCuller's depth buffer with its WorldMatrix
+    struct Occluder
+    {
+        std::shared_ptr<const OccluderMesh> mesh;
+    };
+
+    // CPU masked software occlusion culling. Occluder triangles are rasterized into a small depth buffer of 8x4
+    // pixel tiles, each keeping the farthest occluder depth of the whole tile plus a second, nearer layer for the
+    // pixels in a coverage mask. Coverage only counts pixels a triangle covers entirely and depths are the
+    // farthest a triangle reaches within a tile, so the buffer never claims more occlusion than the occluders
+    // give: objects are only reported hidden when they really are. Tile rows are rasterized in parallel on the
+    // ThreadPool.
+    //
+    // Depth is Vulkan NDC depth, 0 at the near plane and 1 at the far one.
+    class OcclusionCuller
+    {
+    public:
+        static constexpr uint32_t TILE_WIDTH = 8;
+        static constexpr uint32_t TILE_HEIGHT = 4;
+
+        // Rounded up to whole tiles
+        VOIDENGINE_API explicit OcclusionCuller(uint32_t width = 320, uint32_t height = 192);
+
+        // Clears the buffer and drops the occluders of the previous frame
+        VOIDENGINE_API void BeginFrame(const glm::mat4& viewProjection);
+        // Queues the triangles of an occluder. Triangles crossing the near plane are left out.
+        VOIDENGINE_API void AddOccluder(const OccluderMesh& mesh, const glm::mat4& modelMatrix);
+        // Draws the queued occluders into the buffer
+        VOIDENGINE_API void Rasterize();
+        // Same buffer without SIMD, the reference for the SSE2 path
+        VOIDENGINE_API void RasterizeScalar();
+
+        // False if the occluders hide the whole box, conservative otherwise
+        VOIDENGINE_API bool IsVisible(const Aabb& worldBounds) const;
+
+        // Depth the buffer guarantees for every pixel, row by row, 1 where nothing was drawn. For validating the
+        // buffer against a reference image.
+        VOIDENGINE_API void ResolveDepth(std::vector<float>& depth) const;
+
+        size_t GetOccluderTriangleCount() const { return triangles.size(); }
+        uint32_t GetWidth() const { return width; }
+        uint32_t GetHeight() const { return height; }
+
+        // Whether Rasterize() uses the SSE2 path in this build
+        VOIDENGINE_API static bool IsSimd();
+
+    private:
+        struct Tile
+        {
+            float zMax0 = 1.0f;     // Every pixel of the tile has an occluder at least this near
+            float zMax1 = 0.0f;     // The pixels in `mask` have one at least this near
+            uint32_t mask = 0;      // Bit y * TILE_WIDTH + x
+        };
+
+        // Screen space triangle set up for rasterizing. Edge functions are positive inside and already reduced by
+        // half a pixel's extent, so evaluating them at a pixel center tests the whole pixel.
+        struct Triangle
+        {
+            glm::vec3 edgeA;    // Edge function factors for x
+            glm::vec3 edgeB;    // for y
+            glm::vec3 edgeC;    // constant
+            glm::vec3 depthPlane;   // z = x * depthPlane.x + y * depthPlane.y + depthPlane.z
+            float maxDepth;
+            uint32_t minTileX, minTileY, maxTileX, maxTileY;
+        };
+
+        void rasterize(bool simd);
+        void rasterizeTileRow(uint32_t tileY, bool simd);
+        void updateTile(Tile& tile, uint32_t coverage, float depth) const;
+
+        uint32_t width;
+        uint32_t height;
+        uint32_t tilesX;
+        uint32_t tilesY;
+        glm::mat4 viewProjection{1.0f};
+        std::vector<Tile> tiles;
+        std::vector<Triangle> triangles;
+        // Reused by AddOccluder()
+        std::vector<glm::vec4> clipPositions;
+    };
+}
@@ -1,13 +1,15 @@
 #include "../Core/RenderPipeline.hpp"
 #include "../Components/Model.hpp"
 #include "../Common.hpp"
+#include "FileWatcher.hpp"
+#include "MappedFile.hpp"
 #include "ModelManager.hpp"
 
-#include <fstream>
-#include <ios>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 #include <cassert>
+#include <utility>
 
 #include "Descriptors.hpp"
 #include "RenderManager.hpp"
@@ -20,16 +22,14 @@ namespace VoidEngine
         glm::mat4 normalMatrix{1.f};
     };
 
-    RenderPipeline::RenderPipeline(Device& device_): configInfo(), device(device_)
+    RenderPipeline::RenderPipeline(Device& device_, Model::VertexFormat vertexFormat): configInfo(), device(device_)
     {
-        SetDefaultPipelineConfigInfo();
+        SetDefaultPipelineConfigInfo(vertexFormat);
         //createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
     }
 
     RenderPipeline::~RenderPipeline()
     {
-        vkDestroyShaderModule(device.device(), vertShaderModule, nullptr);
-        vkDestroyShaderModule(device.device(), fragShaderModule, nullptr);
         vkDestroyPipeline(device.device(), graphicsPipeline, nullptr);
     }
 
@@ -38,7 +38,7 @@ namespace VoidEngine
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
     }
 
-    void RenderPipeline::SetDefaultPipelineConfigInfo()
+    void RenderPipeline::SetDefaultPipelineConfigInfo(Model::VertexFormat vertexFormat)
     {
         configInfo.inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
         configInfo.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -117,7 +117,12 @@ namespace VoidEngine
         std::unique_ptr<DescriptorSetLayout> globalSetLayout = DescriptorSetLayout::Builder(device)
                 .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS, 1)
                 .build();
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout->getDescriptorSetLayout()};
+        // Same layout the MaterialManager allocates from, so the pipelines of a queue stay compatible and a bound
+        // material survives pipeline switches
+        std::unique_ptr<DescriptorSetLayout> materialSetLayout = Material::CreateSetLayout(device);
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout->getDescriptorSetLayout(),
+            materialSetLayout->getDescriptorSetLayout()};
+        static_assert(Material::DESCRIPTOR_SET == 1, "Material set has to follow the global set");
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -131,8 +136,8 @@ namespace VoidEngine
             throw std::runtime_error("Failed to create pipeline layout.");
         }
 
-        configInfo.bindingDescriptions = Model::Vertex::getBindingDescriptions();
-        configInfo.attributeDescriptions = Model::Vertex::getAttributeDescriptions();
+        configInfo.bindingDescriptions = Model::GetBindingDescriptions(vertexFormat);
+        configInfo.attributeDescriptions = Model::GetAttributeDescriptions(vertexFormat);
 
         assert(!configInfo.bindingDescriptions.empty() && "bindingDescriptions is empty!");
         assert(!configInfo.attributeDescriptions.empty() && "attributeDescriptions is empty!");
@@ -143,22 +148,11 @@ namespace VoidEngine
         //std::string enginePath = ENGINE_DIR + filepath;
         // My cmake copies the spirv files to the correct location
         if (filepath.empty()) return {};
-        const std::string& enginePath = filepath;
-        std::ifstream file(enginePath, std::ios::ate | std::ios::binary);
-
-        if (!file.is_open())
-        {
-            throw std::runtime_error("Failed to open file: " + enginePath);
-        }
-
-        size_t fileSize = static_cast<size_t>(file.tellg());
 
-        std::vector<char> buffer(fileSize);
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-        file.close();
-
-        return buffer;
+        // Through MappedFile so shaders load from a mounted AssetArchive too
+        const MappedFile file(filepath);
+        const auto* data = reinterpret_cast<const char*>(file.data());
+        return {data, data + file.size()};
     }
 
     void RenderPipeline::CreateGraphicsPipeline(
@@ -167,11 +161,41 @@ namespace VoidEngine
     {
         assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline:: No pipelineLayout provided in configInfo.");
         assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline:: No renderPass provided in configInfo.");
-        auto vertCode = readFile(vertFilepath);
-        auto fragCode = readFile(fragFilepath);
+        vertShaderPath = FileWatcher::Normalize(vertFilepath);
+        fragShaderPath = FileWatcher::Normalize(fragFilepath);
+
+        graphicsPipeline = createPipeline(readFile(vertShaderPath), readFile(fragShaderPath));
+    }
+
+    bool RenderPipeline::UsesShader(const std::string& filepath) const
+    {
+        const std::string path = FileWatcher::Normalize(filepath);
+        return path == vertShaderPath || path == fragShaderPath;
+    }
+
+    VkPipeline RenderPipeline::Rebuild() const
+    {
+        return createPipeline(readFile(vertShaderPath), readFile(fragShaderPath));
+    }
 
-        createShaderModule(vertCode, &vertShaderModule);
-        createShaderModule(fragCode, &fragShaderModule);
+    VkPipeline RenderPipeline::ReplacePipeline(VkPipeline pipeline)
+    {
+        return std::exchange(graphicsPipeline, pipeline);
+    }
+
+    VkPipeline RenderPipeline::createPipeline(const std::vector<char>& vertCode, const std::vector<char>& fragCode) const
+    {
+        // Only needed while the pipeline is created
+        const VkShaderModule vertShaderModule = createShaderModule(vertCode);
+        VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+        try
+        {
+            fragShaderModule = createShaderModule(fragCode);
+        } catch (...)
+        {
+            vkDestroyShaderModule(device.device(), vertShaderModule, nullptr);
+            throw;
+        }
 
         VkPipelineShaderStageCreateInfo shaderStages[2];
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -232,24 +256,43 @@ namespace VoidEngine
         pipelineInfo.basePipelineIndex = -1;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        if (vkCreateGraphicsPipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        const VkResult result = vkCreateGraphicsPipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+
+        vkDestroyShaderModule(device.device(), vertShaderModule, nullptr);
+        vkDestroyShaderModule(device.device(), fragShaderModule, nullptr);
+
+        if (result != VK_SUCCESS)
         {
             throw std::runtime_error("Failed to create graphics pipeline.");
         }
+        return pipeline;
     }
 
-    void RenderPipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule)
+    VkShaderModule RenderPipeline::createShaderModule(const std::vector<char>& code) const
     {
+        // SPIR-V is a stream of 32-bit words, anything else is a truncated or half written file
+        if (code.empty() || code.size() % sizeof(uint32_t) != 0)
+        {
+            throw std::runtime_error("Invalid SPIR-V code.");
+        }
+
+        // The file was read into chars, copied so the words are aligned
+        std::vector<uint32_t> words(code.size() / sizeof(uint32_t));
+        std::memcpy(words.data(), code.data(), code.size());
+
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
         createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+        createInfo.pCode = words.data();
         createInfo.pNext = nullptr;
         createInfo.flags = 0;
 
-        if (vkCreateShaderModule(device.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
+        VkShaderModule shaderModule = VK_NULL_HANDLE;
+        if (vkCreateShaderModule(device.device(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
         {
             throw std::runtime_error("Failed to create shader module.");
         }
+        return shaderModule;
     }
 }
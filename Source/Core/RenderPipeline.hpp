@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include "Device.hpp"
+#include "../Components/Model.hpp"
 
 namespace VoidEngine
 {
@@ -37,7 +38,8 @@ namespace VoidEngine
     public:
         PipelineConfigInfo configInfo;
 
-        RenderPipeline(Device& device_);
+        // `vertexFormat` selects the vertex input layout, the vertex shader has to match it
+        RenderPipeline(Device& device_, Model::VertexFormat vertexFormat = Model::VertexFormat::FULL);
         ~RenderPipeline();
 
         RenderPipeline(const RenderPipeline&) = delete;
@@ -48,17 +50,32 @@ namespace VoidEngine
             const std::string& vertFilepath,
             const std::string& fragFilepath);
 
+        // Whether the pipeline was created from the SPIR-V file `filepath`
+        bool UsesShader(const std::string& filepath) const;
+        const std::string& GetVertShaderPath() const { return vertShaderPath; }
+        const std::string& GetFragShaderPath() const { return fragShaderPath; }
+
+        // Creates a new pipeline from the current contents of the shader files without touching the bound one, so
+        // it can run on a worker thread while this one is still recorded. Throws if the files can't be loaded.
+        VkPipeline Rebuild() const;
+
+        // Makes `pipeline` the bound one and returns the previous pipeline, which the caller destroys once no
+        // frame in flight uses it anymore
+        VkPipeline ReplacePipeline(VkPipeline pipeline);
+
     private:
         static std::vector<char> readFile(const std::string& filepath);
 
-        void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
-        void SetDefaultPipelineConfigInfo();
+        VkPipeline createPipeline(const std::vector<char>& vertCode, const std::vector<char>& fragCode) const;
+        VkShaderModule createShaderModule(const std::vector<char>& code) const;
+        void SetDefaultPipelineConfigInfo(Model::VertexFormat vertexFormat);
 
         Device& device;
         VkFramebuffer framebuffer{};
         VkPipeline graphicsPipeline{};
-        VkShaderModule vertShaderModule{};
-        VkShaderModule fragShaderModule{};
+        // Normalized like FileWatcher reports them
+        std::string vertShaderPath;
+        std::string fragShaderPath;
 
         // TODO: Command buffer
         // TODO: Descriptor set, for queue specific ubo, textures, etc.
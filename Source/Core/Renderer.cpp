@@ -14,9 +14,14 @@ namespace VoidEngine
     {
         //recreateSwapChain(depthFormat, renderPass);
         createCommandBuffers();
+        createTimestampPool();
     }
 
-    Renderer::~Renderer() { freeCommandBuffers(); }
+    Renderer::~Renderer()
+    {
+        if (timestampPool != VK_NULL_HANDLE) vkDestroyQueryPool(device.device(), timestampPool, nullptr);
+        freeCommandBuffers();
+    }
 
     void Renderer::createCommandBuffers()
     {
@@ -34,6 +39,24 @@ namespace VoidEngine
         }
     }
 
+    void Renderer::createTimestampPool()
+    {
+        const uint32_t validBits = device.graphicsTimestampValidBits;
+        if (!device.properties.limits.timestampComputeAndGraphics || validBits == 0) return;
+        timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = 2 * SwapChain::MAX_FRAMES_IN_FLIGHT;
+
+        if (vkCreateQueryPool(device.device(), &poolInfo, nullptr, &timestampPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+        timestampsWritten.assign(SwapChain::MAX_FRAMES_IN_FLIGHT, false);
+    }
+
     void Renderer::freeCommandBuffers()
     {
         vkFreeCommandBuffers(
@@ -48,10 +71,16 @@ namespace VoidEngine
     {
         assert(!isFrameStarted && "Can't call beginFrame while already in progress");
 
-        //vkWaitForFences(device.device(), 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
-        //vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
+        const auto frameStart = std::chrono::steady_clock::now();
+        if (lastFrameStart != std::chrono::steady_clock::time_point{})
+        {
+            timings.frameMs = std::chrono::duration<double, std::milli>(frameStart - lastFrameStart).count();
+        }
+        lastFrameStart = frameStart;
 
+        // Waits for the frame that last used this slot, the ones in the other slots keep running on the GPU
         auto result = swapChain.acquireNextImage(&currentImageIndex);
+        timings.cpuWaitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
         {
             //recreateSwapChain(RenderManager::FindDepthFormat(device));
@@ -62,13 +91,9 @@ namespace VoidEngine
         }
 
         isFrameStarted = true;
+        currentFrameIndex = static_cast<int>(swapChain.GetCurrentFrame());
 
-        //auto commandBuffer = getCurrentCommandBuffer();
-
-        // Todo: Do a more elegant wait here
-        vkDeviceWaitIdle(device.device());
-
-        VkCommandBuffer commandBuffer = commandBuffers[swapChain.GetCurrentFrame()];
+        VkCommandBuffer commandBuffer = commandBuffers[currentFrameIndex];
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
@@ -80,13 +105,36 @@ namespace VoidEngine
             throw std::runtime_error("failed to begin recording command buffer!");
         }
 
+        if (timestampPool != VK_NULL_HANDLE)
+        {
+            // The slot's fence has signaled, so the timestamps of the frame recorded into it before are available
+            const uint32_t firstQuery = 2 * static_cast<uint32_t>(currentFrameIndex);
+            uint64_t timestamps[2];
+            if (timestampsWritten[currentFrameIndex] &&
+                vkGetQueryPoolResults(device.device(), timestampPool, firstQuery, 2, sizeof(timestamps), timestamps,
+                    sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+            {
+                // Masked, so a counter narrower than 64 bits that wrapped during the frame still gives the right span
+                timings.gpuBusyMs = static_cast<double>((timestamps[1] - timestamps[0]) & timestampMask) *
+                    device.properties.limits.timestampPeriod / 1e6;
+            }
+
+            vkCmdResetQueryPool(commandBuffer, timestampPool, firstQuery, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, firstQuery);
+        }
+
         return commandBuffer;
     }
 
     void Renderer::endFrame(SwapChain& swapChain, VkCommandBuffer& commandBuffer)
     {
         assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
-        //auto commandBuffer = getCurrentCommandBuffer();
+        if (timestampPool != VK_NULL_HANDLE)
+        {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, 2 * static_cast<uint32_t>(currentFrameIndex) + 1);
+            timestampsWritten[currentFrameIndex] = true;
+        }
+
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to record command buffer!");
@@ -104,7 +152,6 @@ namespace VoidEngine
         }
 
         isFrameStarted = false;
-        currentFrameIndex = (currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
     }
 
     void Renderer::beginSwapChainRenderPass(VkCommandBuffer& commandBuffer, VkRenderPass renderPass, SwapChain& swapChain, std::vector<VkFramebuffer> framebuffers)
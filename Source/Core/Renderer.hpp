@@ -6,6 +6,7 @@
 
 // std
 #include <cassert>
+#include <chrono>
 #include <memory>
 #include <vector>
 
@@ -13,6 +14,17 @@
 
 namespace VoidEngine
 {
+    // Where the time of a frame went, to check that recording and the GPU overlap
+    struct FrameTimings
+    {
+        double frameMs = 0.0;       // From one beginFrame() to the next
+        double cpuWaitMs = 0.0;     // Blocked in beginFrame() on the frame slot's fence and the next image
+        // Between the first and the last command of the frame, from timestamps. Read once the slot comes around
+        // again, so it lags SwapChain::GetFramesInFlight() frames behind. 0 when the graphics queue can't write
+        // timestamps.
+        double gpuBusyMs = 0.0;
+    };
+
     class Renderer
     {
     public:
@@ -43,14 +55,27 @@ namespace VoidEngine
 
         uint32_t GetCurrentImageIndex() const { return currentImageIndex; }
 
+        // Of the last frame begun
+        const FrameTimings& GetFrameTimings() const { return timings; }
+
     private:
         void createCommandBuffers();
         void freeCommandBuffers();
+        void createTimestampPool();
 
         Window &window;
         Device &device;
+        // One per frame slot, only reset once the slot's fence signaled
         std::vector<VkCommandBuffer> commandBuffers;
 
+        // Two timestamps per frame slot, null when the device can't time graphics work
+        VkQueryPool timestampPool = VK_NULL_HANDLE;
+        // Device::graphicsTimestampValidBits as a mask, the bits above it are undefined
+        uint64_t timestampMask = ~0ull;
+        std::vector<bool> timestampsWritten;
+        FrameTimings timings{};
+        std::chrono::steady_clock::time_point lastFrameStart{};
+
         uint32_t currentImageIndex;
         int currentFrameIndex{0};
         bool isFrameStarted{false};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "SwapChain.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace VoidEngine
+{
+    // GPU resources dropped by their owner that frames still in flight may use. A resource retired in frame n is
+    // handed back for destruction once SwapChain::MAX_FRAMES_IN_FLIGHT more frames have been submitted, by then
+    // no command buffer recorded while it was in use can be pending anymore. Not thread safe, owners lock around
+    // it along with the rest of their state.
+    template<typename T>
+    class RetireQueue
+    {
+    public:
+        // `frame` is the owner's count of frames, advanced once per EndFrame()
+        void Retire(T resource, uint64_t frame)
+        {
+            retired.push_back({std::move(resource), frame});
+        }
+
+        // Calls destroy(T&) on every resource that no frame can use anymore at `frame` and forgets them
+        template<typename F>
+        void Collect(uint64_t frame, F&& destroy)
+        {
+            const auto end = std::partition(retired.begin(), retired.end(), [frame](const Entry& entry)
+            {
+                return frame - entry.frame <= SwapChain::MAX_FRAMES_IN_FLIGHT;
+            });
+            for (auto it = end; it != retired.end(); ++it) destroy(it->resource);
+            retired.erase(end, retired.end());
+        }
+
+        // Calls destroy(T&) on every resource regardless of its frame, once the device is idle
+        template<typename F>
+        void Clear(F&& destroy)
+        {
+            for (auto& entry : retired) destroy(entry.resource);
+            retired.clear();
+        }
+
+        size_t Size() const { return retired.size(); }
+
+    private:
+        struct Entry
+        {
+            T resource;
+            uint64_t frame;
+        };
+
+        std::vector<Entry> retired;
+    };
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Handle to an element of a SlotMap. The generation tells the handle of a removed element apart from a newer
+    // element reusing its slot.
+    struct SlotHandle
+    {
+        static constexpr uint32_t NULL_INDEX = 0xFFFFFFFF;
+
+        uint32_t index = NULL_INDEX;
+        uint32_t generation = 0;
+
+        bool IsNull() const { return index == NULL_INDEX; }
+        bool operator==(const SlotHandle& other) const = default;
+    };
+
+    // Elements addressed by SlotHandle. Lookups are two array reads, removed slots are reused with a new generation
+    // so stale handles find nothing. The elements themselves are kept dense for iteration, removing one moves the
+    // last element into its place.
+    template<typename T>
+    class SlotMap
+    {
+    public:
+        SlotHandle Insert(T value)
+        {
+            uint32_t index;
+            if (!freeSlots.empty())
+            {
+                index = freeSlots.back();
+                freeSlots.pop_back();
+            } else
+            {
+                index = static_cast<uint32_t>(slots.size());
+                slots.push_back({});
+            }
+
+            slots[index].dense = static_cast<uint32_t>(values.size());
+            values.push_back(std::move(value));
+            denseToSlot.push_back(index);
+            return {index, slots[index].generation};
+        }
+
+        // Returns false for stale handles
+        bool Remove(SlotHandle handle)
+        {
+            if (!Contains(handle)) return false;
+
+            Slot& slot = slots[handle.index];
+            // Destroyed once the map is consistent again, in case its destructor looks into the map
+            T removed = std::move(values[slot.dense]);
+            const uint32_t last = static_cast<uint32_t>(values.size() - 1);
+            if (slot.dense != last)
+            {
+                values[slot.dense] = std::move(values[last]);
+                denseToSlot[slot.dense] = denseToSlot[last];
+                slots[denseToSlot[last]].dense = slot.dense;
+            }
+            values.pop_back();
+            denseToSlot.pop_back();
+
+            slot.dense = NO_ELEMENT;
+            slot.generation++;
+            freeSlots.push_back(handle.index);
+            return true;
+        }
+
+        bool Contains(SlotHandle handle) const
+        {
+            return handle.index < slots.size() && slots[handle.index].generation == handle.generation &&
+                slots[handle.index].dense != NO_ELEMENT;
+        }
+
+        // nullptr for stale handles. Valid until the next Insert() or Remove().
+        T* Get(SlotHandle handle) { return Contains(handle) ? &values[slots[handle.index].dense] : nullptr; }
+        const T* Get(SlotHandle handle) const { return Contains(handle) ? &values[slots[handle.index].dense] : nullptr; }
+
+        size_t Size() const { return values.size(); }
+        bool IsEmpty() const { return values.empty(); }
+
+        // Handle of the element at `denseIndex` of the iteration order
+        SlotHandle GetHandle(size_t denseIndex) const
+        {
+            const uint32_t index = denseToSlot[denseIndex];
+            return {index, slots[index].generation};
+        }
+
+        void Clear()
+        {
+            for (size_t i = values.size(); i-- > 0;) Remove(GetHandle(i));
+        }
+
+        // The elements in no particular order
+        auto begin() { return values.begin(); }
+        auto end() { return values.end(); }
+        auto begin() const { return values.begin(); }
+        auto end() const { return values.end(); }
+
+    private:
+        static constexpr uint32_t NO_ELEMENT = 0xFFFFFFFF;
+
+        struct Slot
+        {
+            uint32_t dense = NO_ELEMENT;    // Into values, NO_ELEMENT while free
+            uint32_t generation = 0;        // Bumped when the element is removed
+        };
+
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+        std::vector<T> values;
+        std::vector<uint32_t> denseToSlot;
+    };
+}
@@ -0,0 +1,75 @@
+#include "SpatialIndex.hpp"
+#include "GameObject.hpp"
+
+#include <algorithm>
+
+namespace VoidEngine
+{
+    namespace
+    {
+        // Box around the model's bounding sphere in world space, scaled by the largest axis of the transform
+        Aabb worldBounds(const WorldMatrix& worldMatrix, const Model& model)
+        {
+            const glm::mat4& matrix = worldMatrix.model;
+            const float scale = std::max({glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])),
+                glm::length(glm::vec3(matrix[2]))});
+            const glm::vec3 center = matrix * glm::vec4(glm::vec3(model.boundingSphere), 1.0f);
+            return Aabb::FromSphere(center, model.boundingSphere.w * scale);
+        }
+    }
+
+    SpatialIndex::SpatialIndex(World& world, float margin)
+        : world(world), tree(margin), addQuery(world), moveQuery(world), removeQuery(world)
+    {
+        addQuery.Without<SpatialProxy>();
+        removeQuery.Without<MeshRenderer>();
+    }
+
+    size_t SpatialIndex::Update()
+    {
+        const uint32_t since = lastVersion;
+        lastVersion = world.NextChangeVersion();
+        size_t changed = 0;
+
+        // Collected first, the World doesn't allow structural changes while a query iterates
+        pending.clear();
+        removeQuery.ForEach([this](Entity entity, const SpatialProxy&) { pending.push_back(entity); });
+        for (const Entity entity : pending) Remove(entity);
+
+        // Moved, or drawn with a different model
+        auto move = [&](const WorldMatrix& worldMatrix, const MeshRenderer& meshRenderer, const SpatialProxy& proxy)
+        {
+            if (meshRenderer.model == nullptr) return;
+            changed += tree.Move(proxy.proxy, worldBounds(worldMatrix, *meshRenderer.model));
+        };
+        moveQuery.ChangedSince<WorldMatrix>(since).ForEach(move);
+        moveQuery.ChangedSince<MeshRenderer>(since).ForEach(move);
+
+        // Bounds are only known once the model has loaded
+        pending.clear();
+        addQuery.ForEach([this](Entity entity, const WorldMatrix&, const MeshRenderer& meshRenderer)
+        {
+            if (meshRenderer.model != nullptr && meshRenderer.model->IsResident()) pending.push_back(entity);
+        });
+        for (const Entity entity : pending)
+        {
+            const Aabb bounds = worldBounds(*world.Get<const WorldMatrix>(entity), *world.Get<const MeshRenderer>(entity)->model);
+            if (entities.size() <= entity.index) entities.resize(entity.index + 1);
+            entities[entity.index] = entity;
+            world.Add(entity, SpatialProxy{tree.Insert(bounds, entity.index)});
+            changed++;
+        }
+
+        return changed;
+    }
+
+    void SpatialIndex::Remove(Entity entity)
+    {
+        const auto* proxy = world.Get<const SpatialProxy>(entity);
+        if (proxy == nullptr) return;
+
+        tree.Remove(proxy->proxy);
+        entities[entity.index] = {};
+        world.Remove<SpatialProxy>(entity);
+    }
+}
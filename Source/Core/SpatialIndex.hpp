@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Common.hpp"
+#include "DynamicAabbTree.hpp"
+#include "TransformSystem.hpp"
+#include "World.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VoidEngine
+{
+    struct MeshRenderer;
+
+    // Leaf of an entity in the SpatialIndex, added by SpatialIndex::Update()
+    struct SpatialProxy
+    {
+        uint32_t proxy;
+    };
+
+    // DynamicAabbTree over the world space bounds of every entity drawn with a resident model, so culling, picking
+    // and proximity queries don't have to visit every entity. Update() keeps it in step with the WorldMatrix
+    // components, only chunks where one changed are looked at.
+    //
+    // Queries hand out candidates by their enlarged bounds, callers that need exact results test them further.
+    class SpatialIndex
+    {
+    public:
+        // `margin` enlarges the stored bounds, entities moving less than it between updates leave the tree alone
+        VOIDENGINE_API explicit SpatialIndex(World& world, float margin = 0.1f);
+
+        // Adds entities whose model became resident, moves the ones whose WorldMatrix or model changed and drops
+        // the ones without a MeshRenderer anymore. Call after the TransformSystem. A structural change.
+        // Returns the number of leaves added or reinserted.
+        VOIDENGINE_API size_t Update();
+
+        // Entities must be removed before they are destroyed, GameObject does so
+        VOIDENGINE_API void Remove(Entity entity);
+
+        // Calls callback(Entity) for every entity whose bounds may intersect the frustum
+        template<typename F>
+        void QueryFrustum(const Frustum& frustum, F&& callback) const
+        {
+            tree.QueryFrustum(frustum, [&](uint32_t index) { callback(entities[index]); });
+        }
+
+        template<typename F>
+        void QuerySphere(const glm::vec3& center, float radius, F&& callback) const
+        {
+            tree.QuerySphere(center, radius, [&](uint32_t index) { callback(entities[index]); });
+        }
+
+        template<typename F>
+        void QueryAabb(const Aabb& bounds, F&& callback) const
+        {
+            tree.QueryAabb(bounds, [&](uint32_t index) { callback(entities[index]); });
+        }
+
+        // callback(Entity, float entryDistance) returns the distance to keep searching up to, see
+        // DynamicAabbTree::QueryRay()
+        template<typename F>
+        void QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, F&& callback) const
+        {
+            tree.QueryRay(origin, direction, maxDistance, [&](uint32_t index, float entry) { return callback(entities[index], entry); });
+        }
+
+        const DynamicAabbTree& GetTree() const { return tree; }
+
+    private:
+        World& world;
+        DynamicAabbTree tree;
+        // By entity index, the tree's user data
+        std::vector<Entity> entities;
+
+        Query<const WorldMatrix, const MeshRenderer> addQuery;
+        Query<const WorldMatrix, const MeshRenderer, const SpatialProxy> moveQuery;
+        Query<const SpatialProxy> removeQuery;
+        uint32_t lastVersion = 0;
+
+        // Reused every update
+        std::vector<Entity> pending;
+    };
+}
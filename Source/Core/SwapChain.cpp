@@ -1,6 +1,7 @@
 #include "SwapChain.hpp"
 
 // std
+#include <algorithm>
 #include <iostream>
 #include <limits>
 #include <stdexcept>
@@ -19,6 +20,7 @@ namespace VoidEngine {
     {
         init(depthFormat);//, renderPass);
 
+        framesInFlight = previous->framesInFlight;
         oldSwapChain = nullptr;
     }
 
@@ -66,8 +68,16 @@ namespace VoidEngine {
         return swapChainImageFormat;
     }
 
+    void SwapChain::SetFramesInFlight(uint32_t count)
+    {
+        // The slots left out keep their fences, nothing waits on them again until they are cycled through anew
+        framesInFlight = std::clamp(count, 1u, MAX_FRAMES_IN_FLIGHT);
+        if (currentFrame >= framesInFlight) currentFrame = 0;
+    }
+
     VkResult SwapChain::acquireNextImage(uint32_t *imageIndex)
     {
+        // Only the frame that last used this slot has to be done, the others keep running
         vkWaitForFences(
             device.device(),
             1,
@@ -112,6 +122,7 @@ namespace VoidEngine {
         submitInfo.pSignalSemaphores = signalSemaphores;
 
         vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
+        auto queueLock = device.lockQueues();
         if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to submit draw command buffer!");
@@ -131,7 +142,7 @@ namespace VoidEngine {
 
         auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        currentFrame = (currentFrame + 1) % framesInFlight;
 
         return result;
     }
@@ -3,6 +3,7 @@
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
+#include "Common.hpp"
 #include "Device.hpp"
 
 namespace VoidEngine
@@ -10,7 +11,11 @@ namespace VoidEngine
     class SwapChain
     {
     public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+        // Per frame resources (command buffers, uniform buffers, descriptor sets, sync objects) exist once per
+        // slot up to this, SetFramesInFlight() picks how many are cycled through
+        static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+        static constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+
         SwapChain(Device &deviceRef, VkExtent2D extent, VkFormat depthFormat);//, VkRenderPass renderPass);
         SwapChain(Device& deviceRef, VkExtent2D extent, std::shared_ptr<SwapChain> previous, VkFormat depthFormat);//, VkRenderPass renderPass);
         ~SwapChain();
@@ -45,8 +50,14 @@ namespace VoidEngine
         std::vector<VkFence> inFlightFences;
         std::vector<VkFence> imagesInFlight;
 
+        // Slot of the frame being recorded, its resources are free once acquireNextImage() returned
         size_t GetCurrentFrame() const { return currentFrame; }
 
+        // Frames the CPU may record ahead of the GPU, clamped to [1, MAX_FRAMES_IN_FLIGHT]. Takes effect with the
+        // next frame, call it outside of Renderer::beginFrame() and endFrame().
+        VOIDENGINE_API void SetFramesInFlight(uint32_t count);
+        uint32_t GetFramesInFlight() const { return framesInFlight; }
+
     private:
         void init(VkFormat depthFormat);//, VkRenderPass renderPass);
         void createImageViews();
@@ -81,5 +92,6 @@ namespace VoidEngine
         std::vector<VkSemaphore> imageAvailableSemaphores;
         std::vector<VkSemaphore> renderFinishedSemaphores;
         size_t currentFrame = 0;
+        uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
     };
 } // VoidEngine
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <utility>
+
+namespace VoidEngine
+{
+    namespace
+    {
+        // Pool and deque of the current thread, if it is a worker
+        thread_local const ThreadPool* currentPool = nullptr;
+        thread_local size_t currentQueue = 0;
+
+        // Batches per thread in parallelFor, so threads that finish early can steal from slower ones
+        constexpr size_t BATCHES_PER_THREAD = 4;
+    }
+
+    ThreadPool::ThreadPool(size_t threadCount)
+    {
+        // The thread calling parallelFor is the extra worker
+        const size_t workerCount = threadCount > 1 ? threadCount - 1 : 0;
+
+        for (size_t i = 0; i < workerCount + 1; i++)
+        {
+            queues.push_back(std::make_unique<WorkQueue>());
+        }
+
+        workers.reserve(workerCount);
+        for (size_t i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard lock(sleepMutex);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    size_t ThreadPool::getThreadIndex() const
+    {
+        return currentPool == this ? currentQueue + 1 : 0;
+    }
+
+    void ThreadPool::submit(std::function<void()> task)
+    {
+        std::vector<Job> jobs;
+        jobs.push_back({std::move(task), nullptr});
+
+        // Nobody would ever pick it up
+        if (workers.empty())
+        {
+            run(jobs.front());
+            return;
+        }
+
+        push(std::move(jobs));
+    }
+
+    void ThreadPool::submit(std::function<void()> task, JobCounter& counter, JobCounter* dependency)
+    {
+        counter.pending.fetch_add(1, std::memory_order_relaxed);
+        Job job{std::move(task), &counter};
+
+        if (dependency != nullptr)
+        {
+            // Checked under the dependency's lock, finish() takes the continuations under the same one
+            std::lock_guard lock(dependency->mutex);
+            if (dependency->pending.load(std::memory_order_acquire) > 0)
+            {
+                dependency->continuations.push_back(std::move(job));
+                return;
+            }
+        }
+
+        std::vector<Job> jobs;
+        jobs.push_back(std::move(job));
+        push(std::move(jobs));
+    }
+
+    void ThreadPool::wait(JobCounter& counter)
+    {
+        const size_t queue = ownQueue();
+        // Without workers nobody else would run the jobs the counter depends on
+        const JobCounter* only = currentPool == this || workers.empty() ? nullptr : &counter;
+        while (!counter.isDone())
+        {
+            // The remaining jobs are running elsewhere
+            if (!runOne(queue, true, only)) std::this_thread::yield();
+        }
+
+        // The last job decrements the counter under its lock, once we hold it the job is done with the counter
+        std::exception_ptr error;
+        {
+            std::lock_guard lock(counter.mutex);
+            error = std::exchange(counter.error, nullptr);
+        }
+        if (error) std::rethrow_exception(error);
+    }
+
+    void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task)
+    {
+        if (count == 0) return;
+
+        if (count == 1 || workers.empty())
+        {
+            for (size_t i = 0; i < count; i++) task(i);
+            return;
+        }
+
+        const size_t batches = std::min(count, getConcurrency() * BATCHES_PER_THREAD);
+        JobCounter counter;
+        counter.pending.store(batches, std::memory_order_relaxed);
+
+        std::vector<Job> jobs;
+        jobs.reserve(batches);
+        for (size_t batch = 0; batch < batches; batch++)
+        {
+            const size_t begin = count * batch / batches;
+            const size_t end = count * (batch + 1) / batches;
+            // `task` outlives the batches, wait() returns after the last one
+            jobs.push_back({[&task, begin, end]()
+            {
+                for (size_t i = begin; i < end; i++) task(i);
+            }, &counter});
+        }
+        push(std::move(jobs));
+
+        wait(counter);
+    }
+
+    void ThreadPool::workerLoop(size_t queue)
+    {
+        currentPool = this;
+        currentQueue = queue;
+
+        while (true)
+        {
+            if (runOne(queue, false)) continue;
+
+            std::unique_lock lock(sleepMutex);
+            wakeUp.wait(lock, [this]() { return stopping || queuedJobs.load() > 0; });
+
+            if (stopping && queuedJobs.load() == 0) return;
+        }
+    }
+
+    size_t ThreadPool::ownQueue() const
+    {
+        return currentPool == this ? currentQueue : queues.size() - 1;
+    }
+
+    void ThreadPool::push(std::vector<Job> jobs)
+    {
+        if (jobs.empty()) return;
+
+        WorkQueue& queue = *queues[ownQueue()];
+        {
+            std::lock_guard lock(queue.mutex);
+            for (auto& job : jobs) queue.jobs.push_back(std::move(job));
+        }
+        queuedJobs.fetch_add(jobs.size());
+
+        // Taking the lock orders this with a worker that checked queuedJobs and is about to sleep
+        {
+            std::lock_guard lock(sleepMutex);
+        }
+        if (jobs.size() == 1) wakeUp.notify_one();
+        else wakeUp.notify_all();
+    }
+
+    bool ThreadPool::runOne(size_t queue, bool countedOnly, const JobCounter* only)
+    {
+        Job job;
+        bool found = false;
+
+        auto take = [&](WorkQueue& from, bool newest)
+        {
+            std::lock_guard lock(from.mutex);
+            if (only != nullptr)
+            {
+                // Outside threads share a deque, the counter's jobs can be anywhere in it
+                auto matches = [only](const Job& queued) { return queued.counter == only; };
+                std::deque<Job>::iterator it;
+                if (newest)
+                {
+                    const auto reverse = std::find_if(from.jobs.rbegin(), from.jobs.rend(), matches);
+                    if (reverse == from.jobs.rend()) return;
+                    it = std::prev(reverse.base());
+                } else
+                {
+                    it = std::find_if(from.jobs.begin(), from.jobs.end(), matches);
+                    if (it == from.jobs.end()) return;
+                }
+                job = std::move(*it);
+                from.jobs.erase(it);
+                found = true;
+                return;
+            }
+
+            if (from.jobs.empty()) return;
+            Job& candidate = newest ? from.jobs.back() : from.jobs.front();
+            if (countedOnly && candidate.counter == nullptr) return;
+            job = std::move(candidate);
+            if (newest) from.jobs.pop_back();
+            else from.jobs.pop_front();
+            found = true;
+        };
+
+        // Newest first from our own deque, it is most likely still in cache
+        take(*queues[queue], true);
+
+        // Oldest first from the others, usually the largest pieces of work left
+        for (size_t i = 1; i < queues.size() && !found; i++)
+        {
+            take(*queues[(queue + i) % queues.size()], false);
+        }
+
+        if (!found) return false;
+
+        queuedJobs.fetch_sub(1);
+        run(job);
+        return true;
+    }
+
+    void ThreadPool::run(Job& job)
+    {
+        if (job.counter == nullptr)
+        {
+            // Nobody waits for a background task, an exception leaving the worker would terminate the program
+            try
+            {
+                job.task();
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "ThreadPool: Background task failed: " << e.what() << "\n";
+            }
+            catch (...)
+            {
+                std::cerr << "ThreadPool: Background task failed.\n";
+            }
+            return;
+        }
+
+        try
+        {
+            job.task();
+        }
+        catch (...)
+        {
+            std::lock_guard lock(job.counter->mutex);
+            if (!job.counter->error) job.counter->error = std::current_exception();
+        }
+        finish(*job.counter);
+    }
+
+    void ThreadPool::finish(JobCounter& counter)
+    {
+        std::vector<Job> ready;
+        {
+            std::lock_guard lock(counter.mutex);
+            if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) ready.swap(counter.continuations);
+        }
+        // The counter may be gone from here on, its continuations count towards their own
+        push(std::move(ready));
+    }
+}
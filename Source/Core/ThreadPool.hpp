@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VoidEngine
+{
+    class JobCounter;
+
+    // A task and the counter it counts towards, if any
+    struct Job
+    {
+        std::function<void()> task;
+        JobCounter* counter = nullptr;
+    };
+
+    // Number of jobs submitted with it that haven't finished yet. Jobs can wait for a counter to reach zero with
+    // ThreadPool::wait(), or be started once it does by passing it as their dependency to ThreadPool::submit().
+    // Must outlive the jobs counting towards it, waiting for it before it goes out of scope takes care of that.
+    class JobCounter
+    {
+    public:
+        JobCounter() = default;
+        JobCounter(const JobCounter&) = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+
+        bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class ThreadPool;
+
+        std::atomic<size_t> pending{0};
+        std::mutex mutex;
+        // Jobs waiting for this counter, submitted once it reaches zero
+        std::vector<Job> continuations;
+        // First exception thrown by a job, rethrown by ThreadPool::wait()
+        std::exception_ptr error;
+    };
+
+    // Engine wide job system. Every worker has its own deque: it pushes and pops at the back, idle workers steal
+    // from the front of the others, so nested work stays on the thread that made it and large batches spread out
+    // on their own. Threads outside the pool share one more deque.
+    class ThreadPool
+    {
+    public:
+        VOIDENGINE_API explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+        VOIDENGINE_API ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Number of threads that take part in parallelFor, including the caller
+        size_t getConcurrency() const { return workers.size() + 1; }
+
+        // In [0, getConcurrency()), for per thread state: 0 for threads outside the pool, workers count from 1.
+        // Only one outside thread should use per thread state of a pool at a time.
+        VOIDENGINE_API size_t getThreadIndex() const;
+
+        // Runs a background task on a worker, or right away on the caller when the pool has none. wait() never
+        // picks these up, so waiting for short jobs doesn't end up running a long task. Nothing waits for the
+        // task either, an exception it throws is logged and dropped.
+        VOIDENGINE_API void submit(std::function<void()> task);
+
+        // Runs the task as a job counting towards `counter`. With a dependency it starts once the dependency's
+        // jobs have all finished. In a pool without workers it runs on the thread that waits for the counter.
+        VOIDENGINE_API void submit(std::function<void()> task, JobCounter& counter, JobCounter* dependency = nullptr);
+
+        // Runs other jobs until every job of `counter` has finished, then rethrows the first exception one threw.
+        // Threads outside a pool with workers only run the jobs of `counter` meanwhile: they all share thread
+        // index 0, and one shouldn't end up in another's jobs, or stall on an unrelated long one.
+        VOIDENGINE_API void wait(JobCounter& counter);
+
+        // Runs task(i) for every i in [0, count) and returns once all of them have finished.
+        // The range is split into a few batches per thread, the calling thread works on them too, so this is safe
+        // to call from the pool itself.
+        VOIDENGINE_API void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+        // Singleton access
+        static ThreadPool& getInstance()
+        {
+            static ThreadPool instance;
+            return instance;
+        }
+
+    private:
+        struct WorkQueue
+        {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        void workerLoop(size_t queue);
+
+        // Deque of the calling thread
+        size_t ownQueue() const;
+        void push(std::vector<Job> jobs);
+        // Runs a job from the thread's own deque or stolen from another one, false if there was none.
+        // `countedOnly` leaves background tasks alone, `only` restricts it to the jobs of one counter.
+        bool runOne(size_t queue, bool countedOnly, const JobCounter* only = nullptr);
+        void run(Job& job);
+        void finish(JobCounter& counter);
+
+        std::vector<std::thread> workers;
+        // One per worker, then the one shared by outside threads
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        std::atomic<size_t> queuedJobs{0};
+
+        std::mutex sleepMutex;
+        std::condition_variable wakeUp;
+        bool stopping = false;
+    };
+}
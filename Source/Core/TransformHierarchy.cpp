@@ -0,0 +1,215 @@
+#include "TransformHierarchy.hpp"
+#include "TransformSystem.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace VoidEngine
+{
+    TransformHierarchy::TransformHierarchy(World& world) : world(world)
+    {
+    }
+
+    void TransformHierarchy::SetParent(Entity child, Entity parent)
+    {
+        const uint32_t parentNode = parent.IsNull() ? NO_PARENT : findOrAddNode(parent);
+        const bool added = findNode(child) == NO_PARENT;
+        const uint32_t childNode = findOrAddNode(child);
+        if (parentNode >= childNode && parentNode < childNode + subtreeSizes[childNode])
+        {
+            throw std::runtime_error("TransformHierarchy: Parent is in the subtree of the child.");
+        }
+
+        // A new node appended right after its parent's subtree is in depth first order already, which is what
+        // building a hierarchy parents first does
+        if (added && (parentNode == NO_PARENT || parentNode + subtreeSizes[parentNode] == childNode))
+        {
+            parents[childNode] = parentNode;
+            for (uint32_t node = parentNode; node != NO_PARENT; node = parents[node]) subtreeSizes[node]++;
+            return;
+        }
+
+        parents[childNode] = parentNode;
+        dirtyNodes.push_back(childNode);
+        reorder();
+    }
+
+    Entity TransformHierarchy::GetParent(Entity child) const
+    {
+        const uint32_t node = findNode(child);
+        if (node == NO_PARENT || parents[node] == NO_PARENT) return {};
+        return entities[parents[node]];
+    }
+
+    void TransformHierarchy::GetChildren(Entity parent, std::vector<Entity>& children) const
+    {
+        children.clear();
+        const uint32_t node = findNode(parent);
+        if (node == NO_PARENT) return;
+
+        for (uint32_t i = node + 1; i < node + subtreeSizes[node]; i++)
+        {
+            if (parents[i] == node) children.push_back(entities[i]);
+        }
+    }
+
+    void TransformHierarchy::Remove(Entity entity)
+    {
+        const uint32_t node = findNode(entity);
+        if (node == NO_PARENT) return;
+
+        for (uint32_t i = node + 1; i < node + subtreeSizes[node]; i++)
+        {
+            if (parents[i] != node) continue;
+            parents[i] = NO_PARENT;
+            dirtyNodes.push_back(i);
+        }
+        entities[node] = {};
+        world.Remove<TransformNode>(entity);
+        reorder();
+    }
+
+    size_t TransformHierarchy::Update()
+    {
+        if (dirtyNodes.empty()) return 0;
+        std::sort(dirtyNodes.begin(), dirtyNodes.end());
+
+        size_t swept = 0;
+        uint32_t end = 0;
+        for (const uint32_t dirty : dirtyNodes)
+        {
+            // Already swept with an ancestor
+            if (dirty < end) continue;
+
+            end = dirty + subtreeSizes[dirty];
+            for (uint32_t node = dirty; node < end; node++)
+            {
+                if (const uint32_t parent = parents[node]; parent == NO_PARENT)
+                {
+                    worldModels[node] = localModels[node];
+                    worldNormals[node] = localNormals[node];
+                } else
+                {
+                    worldModels[node] = worldModels[parent] * localModels[node];
+                    worldNormals[node] = worldNormals[parent] * localNormals[node];
+                }
+
+                if (auto* matrix = world.Get<WorldMatrix>(entities[node]))
+                {
+                    matrix->model = worldModels[node];
+                    matrix->normal = worldNormals[node];
+                }
+            }
+            swept += end - dirty;
+        }
+        dirtyNodes.clear();
+        return swept;
+    }
+
+    uint32_t TransformHierarchy::findOrAddNode(Entity entity)
+    {
+        if (!world.IsAlive(entity)) throw std::runtime_error("TransformHierarchy: Entity is not alive.");
+        if (const uint32_t node = findNode(entity); node != NO_PARENT) return node;
+
+        glm::mat4 model{1.0f};
+        glm::mat4 normal{1.0f};
+        if (const auto* transform = world.Get<const Transform>(entity))
+        {
+            model = transform->mat4();
+            normal = transform->normalMatrix();
+        }
+
+        const auto node = static_cast<uint32_t>(entities.size());
+        entities.push_back(entity);
+        parents.push_back(NO_PARENT);
+        subtreeSizes.push_back(1);
+        localModels.push_back(model);
+        localNormals.push_back(normal);
+        worldModels.push_back(model);
+        worldNormals.push_back(normal);
+        dirtyNodes.push_back(node);
+        world.Add(entity, TransformNode{node});
+        return node;
+    }
+
+    uint32_t TransformHierarchy::findNode(Entity entity) const
+    {
+        const auto* node = world.Get<const TransformNode>(entity);
+        return node != nullptr ? node->node : NO_PARENT;
+    }
+
+    void TransformHierarchy::reorder()
+    {
+        const auto count = static_cast<uint32_t>(entities.size());
+
+        // Children as first child / next sibling links, siblings keep their current order
+        std::vector<uint32_t> firstChild(count, NO_PARENT);
+        std::vector<uint32_t> nextSibling(count, NO_PARENT);
+        for (uint32_t i = count; i-- > 0;)
+        {
+            if (entities[i].IsNull() || parents[i] == NO_PARENT) continue;
+            nextSibling[i] = firstChild[parents[i]];
+            firstChild[parents[i]] = i;
+        }
+
+        std::vector<uint32_t> order;
+        order.reserve(count);
+        for (uint32_t root = 0; root < count; root++)
+        {
+            if (entities[root].IsNull() || parents[root] != NO_PARENT) continue;
+
+            uint32_t node = root;
+            while (true)
+            {
+                order.push_back(node);
+                if (firstChild[node] != NO_PARENT)
+                {
+                    node = firstChild[node];
+                    continue;
+                }
+                while (node != root && nextSibling[node] == NO_PARENT) node = parents[node];
+                if (node == root) break;
+                node = nextSibling[node];
+            }
+        }
+
+        std::vector<uint32_t> newIndex(count, NO_PARENT);
+        for (uint32_t i = 0; i < order.size(); i++) newIndex[order[i]] = i;
+
+        auto permute = [&](auto& values)
+        {
+            std::remove_reference_t<decltype(values)> sorted;
+            sorted.reserve(order.size());
+            for (const uint32_t old : order) sorted.push_back(values[old]);
+            values = std::move(sorted);
+        };
+        for (uint32_t& parent : parents)
+        {
+            if (parent != NO_PARENT) parent = newIndex[parent];
+        }
+        permute(parents);
+        permute(entities);
+        permute(localModels);
+        permute(localNormals);
+        permute(worldModels);
+        permute(worldNormals);
+
+        subtreeSizes.assign(order.size(), 1);
+        for (size_t i = order.size(); i-- > 0;)
+        {
+            if (parents[i] != NO_PARENT) subtreeSizes[parents[i]] += subtreeSizes[i];
+        }
+
+        std::erase_if(dirtyNodes, [&](uint32_t& node)
+        {
+            node = newIndex[node];
+            return node == NO_PARENT;
+        });
+
+        for (uint32_t i = 0; i < order.size(); i++)
+        {
+            if (order[i] == i) continue;
+            if (auto* node = world.Get<TransformNode>(entities[i])) node->node = i;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Common.hpp"
+#include "World.hpp"
+
+#include <External/glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Node of an entity in the TransformHierarchy, added by TransformHierarchy::SetParent()
+    struct TransformNode
+    {
+        uint32_t node;
+    };
+
+    // Parent/child relationships between entities with a Transform. A child's Transform is relative to its parent,
+    // its WorldMatrix is the parent's times its own.
+    //
+    // Nodes are kept in depth first order, so every subtree is one contiguous range that follows its root and
+    // parents always come before their children. Update() only sweeps the ranges under nodes whose local matrix
+    // changed, a hierarchy where nothing moved costs nothing. Adding new entities parents first is cheap, other
+    // reparenting reorders all nodes and is meant for setting up rather than for every frame.
+    class TransformHierarchy
+    {
+    public:
+        static constexpr uint32_t NO_PARENT = 0xFFFFFFFF;
+
+        VOIDENGINE_API explicit TransformHierarchy(World& world);
+
+        // Moves `child` and its subtree under `parent`, a null parent makes it a root. The child keeps its
+        // Transform, which is now relative to the new parent. Throws std::runtime_error if `parent` is in the
+        // child's subtree. A structural change.
+        VOIDENGINE_API void SetParent(Entity child, Entity parent);
+        // Null for roots and entities outside the hierarchy
+        VOIDENGINE_API Entity GetParent(Entity child) const;
+        VOIDENGINE_API void GetChildren(Entity parent, std::vector<Entity>& children) const;
+
+        // Takes the entity out, its children become roots. Entities must be removed before they are destroyed,
+        // GameObject does so.
+        VOIDENGINE_API void Remove(Entity entity);
+
+        // Local matrices of hierarchy nodes, set by the TransformSystem when their Transform changed
+        glm::mat4& GetLocalModel(uint32_t node) { return localModels[node]; }
+        glm::mat4& GetLocalNormal(uint32_t node) { return localNormals[node]; }
+        void MarkDirty(uint32_t node) { dirtyNodes.push_back(node); }
+
+        // Recomputes the world matrices under every dirty node and writes them to the entities' WorldMatrix.
+        // Returns the number of nodes swept.
+        VOIDENGINE_API size_t Update();
+
+        size_t GetNodeCount() const { return entities.size(); }
+
+    private:
+        // Node of the entity, added as a root if it has none yet
+        uint32_t findOrAddNode(Entity entity);
+        uint32_t findNode(Entity entity) const;
+        // Restores the depth first order after parents changed, dropping nodes whose entity is null
+        void reorder();
+
+        World& world;
+
+        // One entry per node, in depth first order
+        std::vector<Entity> entities;
+        std::vector<uint32_t> parents;          // NO_PARENT for roots, otherwise smaller than the node itself
+        std::vector<uint32_t> subtreeSizes;     // The node and its descendants, which directly follow it
+        std::vector<glm::mat4> localModels;
+        std::vector<glm::mat4> localNormals;
+        std::vector<glm::mat4> worldModels;
+        std::vector<glm::mat4> worldNormals;
+
+        // Nodes whose local matrix changed since the last Update(), duplicates allowed
+        std::vector<uint32_t> dirtyNodes;
+    };
+}
@@ -0,0 +1,249 @@
+#include "TransformSystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef VOIDENGINE_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace VoidEngine
+{
+    namespace
+    {
+        bool sameTransform(const Transform& a, const Transform& b)
+        {
+            return a.translation == b.translation && a.rotation == b.rotation && a.scale == b.scale;
+        }
+
+        // One transform of `transforms`, the formula of Transform::mat4() with std::sin/std::cos
+        void computeOne(const TransformSoA& transforms, size_t i, glm::mat4& model, glm::mat4& normal)
+        {
+            const float c3 = std::cos(transforms.rotation[2][i]);
+            const float s3 = std::sin(transforms.rotation[2][i]);
+            const float c2 = std::cos(transforms.rotation[0][i]);
+            const float s2 = std::sin(transforms.rotation[0][i]);
+            const float c1 = std::cos(transforms.rotation[1][i]);
+            const float s1 = std::sin(transforms.rotation[1][i]);
+
+            const glm::vec3 rotation[3] = {
+                {c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1},
+                {c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3},
+                {c2 * s1, -s2, c1 * c2},
+            };
+            for (int column = 0; column < 3; column++)
+            {
+                const float scale = transforms.scale[column][i];
+                model[column] = glm::vec4(rotation[column] * scale, 0.0f);
+                normal[column] = glm::vec4(rotation[column] / scale, 0.0f);
+            }
+            model[3] = {transforms.translation[0][i], transforms.translation[1][i], transforms.translation[2][i], 1.0f};
+            normal[3] = {0.0f, 0.0f, 0.0f, 1.0f};
+        }
+
+#ifdef VOIDENGINE_SSE2
+        // Four sines and cosines at once. The angle is reduced to [-pi/4, pi/4] around the nearest multiple of
+        // pi/2 and both are evaluated with the minimax polynomials of Cephes' sinf/cosf, which are within a few
+        // ulp of std::sin/std::cos for the angles transforms use.
+        void sinCos(__m128 x, __m128& sine, __m128& cosine)
+        {
+            const __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.63661977236f)));
+            const __m128 q = _mm_cvtepi32_ps(quadrant);
+            // pi/2 split in three so the reduction stays exact
+            x = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(1.5703125f)));
+            x = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(4.837512969970703125e-4f)));
+            x = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(7.549789954891882e-8f)));
+
+            const __m128 x2 = _mm_mul_ps(x, x);
+            __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), x2), _mm_set1_ps(8.3321608736e-3f));
+            s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-1.6666654611e-1f));
+            s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, x2), x), x);
+
+            __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), x2), _mm_set1_ps(-1.388731625493765e-3f));
+            c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(4.166664568298827e-2f));
+            c = _mm_mul_ps(_mm_mul_ps(c, x2), x2);
+            c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(x2, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+            // Odd quadrants swap sine and cosine, the sign follows the quadrant
+            const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+            const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+            const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+                _mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+            sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sinSign);
+            cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cosSign);
+        }
+
+        // Columns x, y, z, w of four matrices, one lane each, transposed into one column per matrix
+        void storeColumn(__m128 x, __m128 y, __m128 z, __m128 w, glm::mat4* const* matrices, int column)
+        {
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            _mm_storeu_ps(&(*matrices[0])[column][0], x);
+            _mm_storeu_ps(&(*matrices[1])[column][0], y);
+            _mm_storeu_ps(&(*matrices[2])[column][0], z);
+            _mm_storeu_ps(&(*matrices[3])[column][0], w);
+        }
+
+        void computeFour(const TransformSoA& transforms, size_t first, glm::mat4* const* models, glm::mat4* const* normals)
+        {
+            __m128 s1, c1, s2, c2, s3, c3;
+            sinCos(_mm_loadu_ps(&transforms.rotation[1][first]), s1, c1);
+            sinCos(_mm_loadu_ps(&transforms.rotation[0][first]), s2, c2);
+            sinCos(_mm_loadu_ps(&transforms.rotation[2][first]), s3, c3);
+
+            const __m128 s1s2 = _mm_mul_ps(s1, s2);
+            const __m128 c1s2 = _mm_mul_ps(c1, s2);
+            const __m128 rotation[3][3] = {
+                {
+                    _mm_add_ps(_mm_mul_ps(c1, c3), _mm_mul_ps(s1s2, s3)),
+                    _mm_mul_ps(c2, s3),
+                    _mm_sub_ps(_mm_mul_ps(c1s2, s3), _mm_mul_ps(c3, s1)),
+                },
+                {
+                    _mm_sub_ps(_mm_mul_ps(c3, s1s2), _mm_mul_ps(c1, s3)),
+                    _mm_mul_ps(c2, c3),
+                    _mm_add_ps(_mm_mul_ps(c1s2, c3), _mm_mul_ps(s1, s3)),
+                },
+                {
+                    _mm_mul_ps(c2, s1),
+                    _mm_xor_ps(s2, _mm_set1_ps(-0.0f)),
+                    _mm_mul_ps(c1, c2),
+                },
+            };
+
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            for (int column = 0; column < 3; column++)
+            {
+                const __m128 scale = _mm_loadu_ps(&transforms.scale[column][first]);
+                const __m128 inverseScale = _mm_div_ps(one, scale);
+                storeColumn(_mm_mul_ps(rotation[column][0], scale), _mm_mul_ps(rotation[column][1], scale),
+                    _mm_mul_ps(rotation[column][2], scale), zero, models, column);
+                storeColumn(_mm_mul_ps(rotation[column][0], inverseScale), _mm_mul_ps(rotation[column][1], inverseScale),
+                    _mm_mul_ps(rotation[column][2], inverseScale), zero, normals, column);
+            }
+            storeColumn(_mm_loadu_ps(&transforms.translation[0][first]), _mm_loadu_ps(&transforms.translation[1][first]),
+                _mm_loadu_ps(&transforms.translation[2][first]), one, models, 3);
+            storeColumn(zero, zero, zero, one, normals, 3);
+        }
+#endif
+
+        // Matrix i of `transforms` goes to model(i) and normal(i), so the results can be written straight to
+        // where they are kept
+        template<typename ModelOutput, typename NormalOutput>
+        void computeAll(const TransformSoA& transforms, ModelOutput&& model, NormalOutput&& normal)
+        {
+            size_t i = 0;
+#ifdef VOIDENGINE_SSE2
+            // The padding lanes of the last four are computed too, into a scratch matrix
+            glm::mat4 scratch;
+            for (; i < transforms.count; i += 4)
+            {
+                glm::mat4* models[4];
+                glm::mat4* normals[4];
+                for (size_t lane = 0; lane < 4; lane++)
+                {
+                    models[lane] = i + lane < transforms.count ? &model(i + lane) : &scratch;
+                    normals[lane] = i + lane < transforms.count ? &normal(i + lane) : &scratch;
+                }
+                computeFour(transforms, i, models, normals);
+            }
+#endif
+            for (; i < transforms.count; i++)
+            {
+                computeOne(transforms, i, model(i), normal(i));
+            }
+        }
+    }
+
+    void TransformSoA::Resize(size_t newCount)
+    {
+        const size_t padded = (newCount + 3) / 4 * 4;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            translation[axis].resize(padded);
+            rotation[axis].resize(padded);
+            scale[axis].resize(padded);
+            // Shrinking leaves old transforms in the padding
+            std::fill(translation[axis].begin() + std::min(count, newCount), translation[axis].end(), 0.0f);
+            std::fill(rotation[axis].begin() + std::min(count, newCount), rotation[axis].end(), 0.0f);
+            std::fill(scale[axis].begin() + std::min(count, newCount), scale[axis].end(), 1.0f);
+        }
+        count = newCount;
+    }
+
+    void TransformSoA::Set(size_t index, const Transform& transform)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            translation[axis][index] = transform.translation[axis];
+            rotation[axis][index] = transform.rotation[axis];
+            scale[axis][index] = transform.scale[axis];
+        }
+    }
+
+    TransformSystem::TransformSystem(World& world) : world(world), hierarchy(world), query(world), nodeQuery(world)
+    {
+        query.Without<TransformNode>();
+    }
+
+    size_t TransformSystem::Update()
+    {
+        const uint32_t since = lastVersion;
+        lastVersion = world.NextChangeVersion();
+
+        size_t updated = 0;
+        query.ChangedSince<Transform>(since).ForEachChunk([&](size_t count, const Entity*, const Transform* transforms,
+            WorldMatrix* matrices)
+        {
+            gatherDirty(count, transforms, matrices);
+            computeAll(dirty, [&](size_t i) -> glm::mat4& { return matrices[dirtyRows[i]].model; },
+                [&](size_t i) -> glm::mat4& { return matrices[dirtyRows[i]].normal; });
+            updated += dirty.count;
+        });
+
+        // Hierarchy nodes get their local matrix, the world matrices follow in one sweep
+        nodeQuery.ChangedSince<Transform>(since).ForEachChunk([&](size_t count, const Entity*,
+            const Transform* transforms, WorldMatrix* matrices, const TransformNode* nodes)
+        {
+            gatherDirty(count, transforms, matrices);
+            computeAll(dirty, [&](size_t i) -> glm::mat4& { return hierarchy.GetLocalModel(nodes[dirtyRows[i]].node); },
+                [&](size_t i) -> glm::mat4& { return hierarchy.GetLocalNormal(nodes[dirtyRows[i]].node); });
+            for (const uint32_t row : dirtyRows) hierarchy.MarkDirty(nodes[row].node);
+        });
+        updated += hierarchy.Update();
+
+        return updated;
+    }
+
+    void TransformSystem::gatherDirty(size_t count, const Transform* transforms, WorldMatrix* matrices)
+    {
+        dirty.Resize(count);
+        dirtyRows.clear();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (sameTransform(transforms[i], matrices[i].source)) continue;
+
+            dirty.Set(dirtyRows.size(), transforms[i]);
+            dirtyRows.push_back(i);
+            matrices[i].source = transforms[i];
+        }
+        dirty.Resize(dirtyRows.size());
+    }
+
+    void TransformSystem::ComputeMatrices(const TransformSoA& transforms, glm::mat4* modelMatrices,
+        glm::mat4* normalMatrices)
+    {
+        computeAll(transforms, [&](size_t i) -> glm::mat4& { return modelMatrices[i]; },
+            [&](size_t i) -> glm::mat4& { return normalMatrices[i]; });
+    }
+
+    bool TransformSystem::IsSimd()
+    {
+#ifdef VOIDENGINE_SSE2
+        return true;
+#else
+        return false;
+#endif
+    }
+}
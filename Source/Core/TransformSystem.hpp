@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Transform.hpp"
+#include "TransformHierarchy.hpp"
+#include "World.hpp"
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Matrices of the entity's Transform, kept up to date by TransformSystem. Entities without one are not drawn.
+    struct WorldMatrix
+    {
+        // Transform the matrices were computed from. The NaN scale never compares equal, so new entities are
+        // always computed once. First so the comparison touches one cache line.
+        Transform source{{}, glm::vec3{std::numeric_limits<float>::quiet_NaN()}, {}};
+        glm::mat4 model{1.0f};
+        // Inverse transpose of the model matrix' upper 3x3, padded to a mat4 like the push constants expect
+        glm::mat4 normal{1.0f};
+    };
+
+    // Translations, rotations and scales one float per array, so four transforms fill an SSE register. The arrays
+    // are padded to a multiple of four with identity transforms.
+    struct TransformSoA
+    {
+        std::vector<float> translation[3];
+        std::vector<float> rotation[3];
+        std::vector<float> scale[3];
+        size_t count = 0;
+
+        // New transforms are identities
+        VOIDENGINE_API void Resize(size_t newCount);
+        VOIDENGINE_API void Set(size_t index, const Transform& transform);
+    };
+
+    // Computes the WorldMatrix of every entity whose Transform changed, gathered chunk by chunk into a TransformSoA
+    // and computed four at a time. Chunks where no Transform was written since the last update are skipped without
+    // being touched, in the others unchanged transforms cost a comparison. For entities in the hierarchy the result
+    // is the local matrix, the hierarchy then sweeps the subtrees below them.
+    class TransformSystem
+    {
+    public:
+        VOIDENGINE_API explicit TransformSystem(World& world);
+
+        // Returns the number of matrices recomputed
+        VOIDENGINE_API size_t Update();
+
+        TransformHierarchy& GetHierarchy() { return hierarchy; }
+
+        // Same matrices as Transform::mat4() and Transform::normalMatrix(), written to `modelMatrices` and
+        // `normalMatrices`, `transforms.count` each
+        VOIDENGINE_API static void ComputeMatrices(const TransformSoA& transforms, glm::mat4* modelMatrices,
+            glm::mat4* normalMatrices);
+
+        // Whether ComputeMatrices() uses the SSE2 path in this build
+        VOIDENGINE_API static bool IsSimd();
+
+    private:
+        // Gathers the transforms of a chunk that changed into `dirty` and their rows into `dirtyRows`
+        void gatherDirty(size_t count, const Transform* transforms, WorldMatrix* matrices);
+
+        World& world;
+        TransformHierarchy hierarchy;
+        Query<const Transform, WorldMatrix> query;
+        Query<const Transform, WorldMatrix, const TransformNode> nodeQuery;
+        uint32_t lastVersion = 0;
+
+        // Reused every update, sized for one chunk
+        TransformSoA dirty;
+        std::vector<uint32_t> dirtyRows;
+    };
+}
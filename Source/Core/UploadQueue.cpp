@@ -0,0 +1,253 @@
+#include "UploadQueue.hpp"
+
+#include <stdexcept>
+
+namespace VoidEngine
+{
+    UploadQueue::UploadQueue(Device& device, VkDeviceSize frameBudget) : device(device), frameBudget(frameBudget)
+    {
+        // A pool of its own, the device pool is used by the render thread without synchronization
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = device.findPhysicalQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create upload command pool.");
+        }
+    }
+
+    UploadQueue::~UploadQueue()
+    {
+        WaitIdle();
+
+        for (auto& batch : freeBatches)
+        {
+            vkDestroyFence(device.device(), batch.fence, nullptr);
+        }
+        // Command buffers go with the pool
+        vkDestroyCommandPool(device.device(), commandPool, nullptr);
+    }
+
+    void UploadQueue::Enqueue(std::unique_ptr<Buffer> staging, VkBuffer destination, VkDeviceSize size,
+        std::function<void()> onComplete)
+    {
+        Copy copy{};
+        copy.staging = std::move(staging);
+        copy.destination = destination;
+        copy.size = size;
+        copy.onComplete = std::move(onComplete);
+
+        std::lock_guard lock(mutex);
+        queuedBytes += size;
+        queued.push_back(std::move(copy));
+    }
+
+    void UploadQueue::EnqueueImage(std::unique_ptr<Buffer> staging, VkImage image, uint32_t mipLevels,
+        std::vector<VkBufferImageCopy> regions, std::function<void()> onComplete)
+    {
+        Copy copy{};
+        copy.size = staging->getBufferSize();
+        copy.staging = std::move(staging);
+        copy.onComplete = std::move(onComplete);
+        copy.image = image;
+        copy.mipLevels = mipLevels;
+        copy.regions = std::move(regions);
+
+        std::lock_guard lock(mutex);
+        queuedBytes += copy.size;
+        queued.push_back(std::move(copy));
+    }
+
+    void UploadQueue::Flush()
+    {
+        retire(false);
+
+        std::vector<Copy> copies;
+        VkDeviceSize bytes = 0;
+        {
+            std::lock_guard lock(mutex);
+            while (!queued.empty() && (copies.empty() || bytes + queued.front().size <= frameBudget))
+            {
+                bytes += queued.front().size;
+                copies.push_back(std::move(queued.front()));
+                queued.pop_front();
+            }
+            queuedBytes -= bytes;
+            lastFlushBytes = bytes;
+        }
+
+        if (!copies.empty()) submit(std::move(copies));
+    }
+
+    void UploadQueue::WaitIdle()
+    {
+        while (true)
+        {
+            {
+                std::lock_guard lock(mutex);
+                if (queued.empty()) break;
+            }
+            Flush();
+        }
+        retire(true);
+    }
+
+    UploadQueue::Stats UploadQueue::GetStats() const
+    {
+        std::lock_guard lock(mutex);
+
+        Stats stats{};
+        stats.queuedCopies = queued.size();
+        stats.queuedBytes = queuedBytes;
+        stats.inFlightCopies = inFlightCopies;
+        stats.lastFlushBytes = lastFlushBytes;
+        stats.submissions = submissions;
+        return stats;
+    }
+
+    void UploadQueue::retire(bool wait)
+    {
+        // Batches complete in submission order, so stop at the first one still running
+        while (!inFlight.empty())
+        {
+            Batch& batch = inFlight.front();
+            if (wait)
+            {
+                vkWaitForFences(device.device(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+            } else if (vkGetFenceStatus(device.device(), batch.fence) != VK_SUCCESS)
+            {
+                break;
+            }
+
+            for (auto& copy : batch.copies)
+            {
+                if (copy.onComplete) copy.onComplete();
+            }
+
+            {
+                std::lock_guard lock(mutex);
+                inFlightCopies -= batch.copies.size();
+            }
+            // Frees the staging buffers
+            batch.copies.clear();
+
+            freeBatches.push_back(std::move(batch));
+            inFlight.pop_front();
+        }
+    }
+
+    void UploadQueue::submit(std::vector<Copy> copies)
+    {
+        Batch batch;
+        if (!freeBatches.empty())
+        {
+            batch = std::move(freeBatches.back());
+            freeBatches.pop_back();
+            vkResetFences(device.device(), 1, &batch.fence);
+            vkResetCommandBuffer(batch.commandBuffer, 0);
+        } else
+        {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = commandPool;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(device.device(), &allocInfo, &batch.commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to allocate upload command buffer.");
+            }
+
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            if (vkCreateFence(device.device(), &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create upload fence.");
+            }
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+
+        // Images start out undefined, their previous contents don't matter
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        for (const auto& copy : copies)
+        {
+            if (copy.image == VK_NULL_HANDLE) continue;
+
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = copy.image;
+            barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, copy.mipLevels, 0, 1};
+            imageBarriers.push_back(barrier);
+        }
+        if (!imageBarriers.empty())
+        {
+            vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+        }
+
+        for (const auto& copy : copies)
+        {
+            if (copy.image != VK_NULL_HANDLE)
+            {
+                vkCmdCopyBufferToImage(batch.commandBuffer, copy.staging->getBuffer(), copy.image,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(copy.regions.size()), copy.regions.data());
+                continue;
+            }
+
+            VkBufferCopy region{};
+            region.size = copy.size;
+            vkCmdCopyBuffer(batch.commandBuffer, copy.staging->getBuffer(), copy.destination, 1, &region);
+        }
+
+        // Frames recorded after the fence signaled may read the buffers, but make the writes available to
+        // vertex input and shaders anyway so an early consumer on the same queue is still correct
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+
+        for (auto& imageBarrier : imageBarriers)
+        {
+            imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
+        vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0, 1, &barrier, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+
+        vkEndCommandBuffer(batch.commandBuffer);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &batch.commandBuffer;
+        {
+            auto queueLock = device.lockQueues();
+            if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, batch.fence) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to submit uploads.");
+            }
+        }
+
+        {
+            std::lock_guard lock(mutex);
+            inFlightCopies += copies.size();
+            submissions++;
+        }
+        batch.copies = std::move(copies);
+        inFlight.push_back(std::move(batch));
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Buffer.hpp"
+#include "Device.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Batches staging buffer to device buffer and image copies into one submission per frame.
+    //
+    // Any thread can Enqueue() copies. The render thread calls Flush() once per frame, which records
+    // everything queued so far (up to a byte budget) into a single command buffer, submits it with a
+    // fence and returns without waiting. Completion callbacks run in a later Flush() once the fence has
+    // signaled, at which point the staging buffers are released.
+    class UploadQueue
+    {
+    public:
+        // Copies started per Flush(), so a level streaming in spreads over several frames. A single
+        // larger copy still goes through on its own.
+        static constexpr VkDeviceSize DEFAULT_FRAME_BUDGET = 64ull * 1024 * 1024;
+
+        struct Stats
+        {
+            size_t queuedCopies = 0;     // Waiting for a Flush()
+            size_t inFlightCopies = 0;   // Submitted, fence not signaled yet
+            VkDeviceSize queuedBytes = 0;
+            VkDeviceSize lastFlushBytes = 0;
+            uint64_t submissions = 0;
+        };
+
+        VOIDENGINE_API explicit UploadQueue(Device& device, VkDeviceSize frameBudget = DEFAULT_FRAME_BUDGET);
+        VOIDENGINE_API ~UploadQueue();
+
+        UploadQueue(const UploadQueue&) = delete;
+        UploadQueue& operator=(const UploadQueue&) = delete;
+
+        // Thread safe. `staging` is kept alive until the copy has executed. `onComplete` runs on the thread
+        // calling Flush(), after the copy is visible to later submissions on the graphics queue.
+        VOIDENGINE_API void Enqueue(std::unique_ptr<Buffer> staging, VkBuffer destination, VkDeviceSize size,
+            std::function<void()> onComplete = {});
+
+        // Same for an image: every region is copied from `staging` into `image`, which goes from undefined to
+        // shader read only layout. `mipLevels` must cover all regions, so a texture uploads in a single copy.
+        VOIDENGINE_API void EnqueueImage(std::unique_ptr<Buffer> staging, VkImage image, uint32_t mipLevels,
+            std::vector<VkBufferImageCopy> regions, std::function<void()> onComplete = {});
+
+        // Render thread only. Retires finished batches and submits the queued copies.
+        VOIDENGINE_API void Flush();
+
+        // Submits everything still queued and blocks until all of it has executed
+        VOIDENGINE_API void WaitIdle();
+
+        VOIDENGINE_API Stats GetStats() const;
+
+    private:
+        struct Copy
+        {
+            std::unique_ptr<Buffer> staging;
+            VkBuffer destination = VK_NULL_HANDLE;
+            VkDeviceSize size = 0;
+            std::function<void()> onComplete;
+
+            // Image copies only, `destination` is unused then
+            VkImage image = VK_NULL_HANDLE;
+            uint32_t mipLevels = 0;
+            std::vector<VkBufferImageCopy> regions;
+        };
+
+        struct Batch
+        {
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            VkFence fence = VK_NULL_HANDLE;
+            std::vector<Copy> copies;
+        };
+
+        void retire(bool wait);
+        void submit(std::vector<Copy> copies);
+
+        Device& device;
+        VkDeviceSize frameBudget;
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+
+        mutable std::mutex mutex;
+        std::deque<Copy> queued;
+        VkDeviceSize queuedBytes = 0;
+
+        VkDeviceSize lastFlushBytes = 0;
+        uint64_t submissions = 0;
+        size_t inFlightCopies = 0;
+
+        // Render thread only
+        std::deque<Batch> inFlight;
+        std::vector<Batch> freeBatches;
+    };
+}
@@ -0,0 +1,267 @@
+#include "World.hpp"
+
+#include <mutex>
+#include <string>
+
+namespace VoidEngine
+{
+    namespace
+    {
+        struct Registry
+        {
+            std::mutex mutex;
+            std::unordered_map<std::type_index, ComponentId> ids;
+            std::vector<ComponentRegistry::Info> infos;
+        };
+
+        Registry& registry()
+        {
+            static Registry instance;
+            return instance;
+        }
+
+        size_t alignUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    ComponentId ComponentRegistry::Register(const std::type_info& type, const Info& info)
+    {
+        Registry& r = registry();
+        std::lock_guard lock(r.mutex);
+
+        if (const auto it = r.ids.find(type); it != r.ids.end()) return it->second;
+        if (r.infos.size() == MAX_COMPONENTS)
+        {
+            throw std::runtime_error("ComponentRegistry: More than " + std::to_string(MAX_COMPONENTS) + " component types.");
+        }
+        if (info.alignment > Archetype::CHUNK_ALIGNMENT)
+        {
+            throw std::runtime_error(std::string("ComponentRegistry: ") + type.name() + " is aligned beyond a chunk.");
+        }
+
+        const auto id = static_cast<ComponentId>(r.infos.size());
+        // Never reallocates, so Get() can hand out references without holding the lock
+        r.infos.reserve(MAX_COMPONENTS);
+        r.infos.push_back(info);
+        r.ids.emplace(type, id);
+        return id;
+    }
+
+    const ComponentRegistry::Info& ComponentRegistry::Get(ComponentId id)
+    {
+        return registry().infos[id];
+    }
+
+    Archetype::Archetype(const ComponentMask& componentMask) : mask(componentMask)
+    {
+        columnOf.fill(NO_COLUMN);
+
+        size_t rowSize = sizeof(Entity);
+        for (ComponentId id = 0; id < ComponentRegistry::MAX_COMPONENTS; id++)
+        {
+            if (!mask.test(id)) continue;
+
+            columnOf[id] = static_cast<uint16_t>(columns.size());
+            columns.push_back({id, ComponentRegistry::Get(id), 0});
+            rowSize += columns.back().info.size;
+        }
+
+        // Columns are laid out one after the other, the alignment padding between them can cost a few rows
+        for (chunkCapacity = static_cast<uint32_t>(CHUNK_SIZE / rowSize); chunkCapacity > 0; chunkCapacity--)
+        {
+            size_t offset = sizeof(Entity) * chunkCapacity;
+            for (auto& column : columns)
+            {
+                offset = alignUp(offset, column.info.alignment);
+                column.offset = offset;
+                offset += column.info.size * chunkCapacity;
+            }
+            if (offset <= CHUNK_SIZE) break;
+        }
+        if (chunkCapacity == 0) throw std::runtime_error("Archetype: Components don't fit in a chunk.");
+    }
+
+    Archetype::~Archetype()
+    {
+        for (const auto& column : columns)
+        {
+            for (size_t chunk = 0; chunk < chunks.size(); chunk++)
+            {
+                auto* data = static_cast<std::byte*>(GetColumnData(chunk, columnOf[column.id]));
+                for (size_t row = 0; row < GetChunkEntityCount(chunk); row++)
+                {
+                    column.info.destroy(data + row * column.info.size);
+                }
+            }
+        }
+    }
+
+    uint32_t Archetype::allocateRow(Entity entity, uint32_t version)
+    {
+        if (entityCount == chunks.size() * chunkCapacity)
+        {
+            chunks.emplace_back(static_cast<std::byte*>(::operator new(CHUNK_SIZE, std::align_val_t{CHUNK_ALIGNMENT})));
+            changeVersions.resize(chunks.size() * columns.size());
+        }
+
+        const auto row = static_cast<uint32_t>(entityCount++);
+        GetEntities(row / chunkCapacity)[row % chunkCapacity] = entity;
+        markChunkChanged(row / chunkCapacity, version);
+        return row;
+    }
+
+    Entity Archetype::removeRow(uint32_t row, uint32_t version)
+    {
+        const auto last = static_cast<uint32_t>(entityCount - 1);
+        Entity moved{};
+        if (row != last)
+        {
+            for (uint16_t column = 0; column < columns.size(); column++)
+            {
+                columns[column].info.relocate(GetComponent(row, column), GetComponent(last, column));
+            }
+            moved = GetEntity(last);
+            GetEntities(row / chunkCapacity)[row % chunkCapacity] = moved;
+            markChunkChanged(row / chunkCapacity, version);
+        }
+
+        entityCount--;
+        // Keeps one spare chunk so an entity moving back and forth doesn't allocate every time
+        if (chunks.size() > 1 && entityCount <= (chunks.size() - 2) * chunkCapacity)
+        {
+            chunks.pop_back();
+            changeVersions.resize(chunks.size() * columns.size());
+        }
+        return moved;
+    }
+
+    void Archetype::markChunkChanged(size_t chunk, uint32_t version)
+    {
+        for (uint16_t column = 0; column < columns.size(); column++) MarkChanged(chunk, column, version);
+    }
+
+    World::World()
+    {
+        findArchetype(ComponentMask{});
+    }
+
+    World::~World() = default;
+
+    Entity World::Create()
+    {
+        const Entity entity = Reserve();
+        Place(entity);
+        return entity;
+    }
+
+    Entity World::Reserve()
+    {
+        if (!freeIndices.empty())
+        {
+            const uint32_t index = freeIndices.back();
+            freeIndices.pop_back();
+            records[index].alive = true;
+            return {index, records[index].generation};
+        }
+
+        records.push_back({nullptr, 0, 0, true});
+        return {static_cast<uint32_t>(records.size() - 1), 0};
+    }
+
+    void World::Destroy(Entity entity)
+    {
+        if (!IsAlive(entity)) return;
+        checkStructuralChange();
+
+        Record& record = records[entity.index];
+        if (Archetype* archetype = record.archetype)
+        {
+            for (uint16_t column = 0; column < archetype->columns.size(); column++)
+            {
+                archetype->columns[column].info.destroy(archetype->GetComponent(record.row, column));
+            }
+            if (const Entity moved = archetype->removeRow(record.row, changeVersion); !moved.IsNull())
+            {
+                records[moved.index].row = record.row;
+            }
+        }
+
+        record.archetype = nullptr;
+        record.generation++;
+        record.alive = false;
+        freeIndices.push_back(entity.index);
+    }
+
+    bool World::IsAlive(Entity entity) const
+    {
+        return entity.index < records.size() && records[entity.index].alive &&
+            records[entity.index].generation == entity.generation;
+    }
+
+    World::Record& World::getRecord(Entity entity)
+    {
+        if (!IsAlive(entity)) throw std::runtime_error("World: Entity is not alive.");
+        return records[entity.index];
+    }
+
+    World::Record& World::getPlacedRecord(Entity entity)
+    {
+        Record& record = getRecord(entity);
+        if (record.archetype == nullptr) throw std::runtime_error("World: Entity is reserved but not placed yet.");
+        return record;
+    }
+
+    Archetype* World::findArchetype(const ComponentMask& mask)
+    {
+        if (const auto it = archetypeLookup.find(mask); it != archetypeLookup.end()) return it->second;
+
+        archetypes.push_back(std::make_unique<Archetype>(mask));
+        archetypeLookup.emplace(mask, archetypes.back().get());
+        return archetypes.back().get();
+    }
+
+    void World::moveEntity(Entity entity, Archetype* target)
+    {
+        Record& record = records[entity.index];
+        Archetype* source = record.archetype;
+
+        const uint32_t targetRow = target->allocateRow(entity, changeVersion);
+        for (uint16_t column = 0; column < source->columns.size(); column++)
+        {
+            void* component = source->GetComponent(record.row, column);
+            const uint16_t targetColumn = target->GetColumn(source->columns[column].id);
+            if (targetColumn != Archetype::NO_COLUMN)
+            {
+                source->columns[column].info.relocate(target->GetComponent(targetRow, targetColumn), component);
+            } else
+            {
+                source->columns[column].info.destroy(component);
+            }
+        }
+
+        if (const Entity moved = source->removeRow(record.row, changeVersion); !moved.IsNull())
+        {
+            records[moved.index].row = record.row;
+        }
+        record.archetype = target;
+        record.row = targetRow;
+    }
+
+    void World::checkStructuralChange() const
+    {
+        if (iterating > 0) throw std::runtime_error("World: Structural change while a query iterates, use a CommandBuffer.");
+    }
+
+    void CommandBuffer::Apply()
+    {
+        // Commands may record more commands into this buffer, which run after the current ones
+        for (size_t i = 0; i < commands.size(); i++)
+        {
+            std::unique_ptr<Command> command = std::move(commands[i]);
+            command->Execute(world);
+        }
+        commands.clear();
+    }
+}
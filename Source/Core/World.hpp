@@ -0,0 +1,509 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace VoidEngine
+{
+    // Handle to an entity of a World. The generation tells the handle of a destroyed entity apart from a newer
+    // entity reusing its index.
+    struct Entity
+    {
+        static constexpr uint32_t NULL_INDEX = 0xFFFFFFFF;
+
+        uint32_t index = NULL_INDEX;
+        uint32_t generation = 0;
+
+        bool IsNull() const { return index == NULL_INDEX; }
+        bool operator==(const Entity& other) const = default;
+    };
+
+    using ComponentId = uint32_t;
+
+    class ComponentRegistry
+    {
+    public:
+        static constexpr size_t MAX_COMPONENTS = 64;
+
+        // How the World moves and destroys a component type without knowing it
+        struct Info
+        {
+            size_t size;
+            size_t alignment;
+            // Move constructs `destination` from `source` and destroys `source`
+            void (*relocate)(void* destination, void* source);
+            void (*destroy)(void* component);
+        };
+
+        // Ids are handed out in order of first use. The registry lives in the engine library, so the game and the
+        // engine agree on them. Throws std::runtime_error past MAX_COMPONENTS types.
+        VOIDENGINE_API static ComponentId Register(const std::type_info& type, const Info& info);
+        VOIDENGINE_API static const Info& Get(ComponentId id);
+
+        template<typename T>
+        static ComponentId Id()
+        {
+            static const ComponentId id = Register(typeid(T), {sizeof(T), alignof(T),
+                [](void* destination, void* source)
+                {
+                    new (destination) T(std::move(*static_cast<T*>(source)));
+                    static_cast<T*>(source)->~T();
+                },
+                [](void* component) { static_cast<T*>(component)->~T(); }});
+            return id;
+        }
+    };
+
+    using ComponentMask = std::bitset<ComponentRegistry::MAX_COMPONENTS>;
+
+    // All entities with exactly the same set of components. Their components are stored in fixed size chunks, one
+    // array per component type in each, so iterating a component touches only that component's memory. Rows are
+    // kept dense: removing one moves the last row into its place.
+    class Archetype
+    {
+    public:
+        static constexpr size_t CHUNK_SIZE = 16 * 1024;
+        static constexpr size_t CHUNK_ALIGNMENT = 64;
+        static constexpr uint16_t NO_COLUMN = 0xFFFF;
+
+        VOIDENGINE_API explicit Archetype(const ComponentMask& mask);
+        VOIDENGINE_API ~Archetype();
+
+        Archetype(const Archetype&) = delete;
+        Archetype& operator=(const Archetype&) = delete;
+
+        const ComponentMask& GetMask() const { return mask; }
+        size_t GetEntityCount() const { return entityCount; }
+        size_t GetChunkCount() const { return chunks.size(); }
+        uint32_t GetChunkCapacity() const { return chunkCapacity; }
+
+        // Column of a component in the chunks, NO_COLUMN if the archetype doesn't have it
+        uint16_t GetColumn(ComponentId id) const { return columnOf[id]; }
+
+        size_t GetChunkEntityCount(size_t chunk) const
+        {
+            return chunk + 1 < chunks.size() ? chunkCapacity : entityCount - chunk * chunkCapacity;
+        }
+        Entity* GetEntities(size_t chunk) const { return reinterpret_cast<Entity*>(chunks[chunk].get()); }
+        void* GetColumnData(size_t chunk, uint16_t column) const { return chunks[chunk].get() + columns[column].offset; }
+
+        Entity GetEntity(uint32_t row) const { return GetEntities(row / chunkCapacity)[row % chunkCapacity]; }
+        void* GetComponent(uint32_t row, uint16_t column) const
+        {
+            return static_cast<std::byte*>(GetColumnData(row / chunkCapacity, column)) +
+                static_cast<size_t>(row % chunkCapacity) * columns[column].info.size;
+        }
+
+        // World change version of the last write to a column of a chunk, see World::NextChangeVersion(). Stamped
+        // atomically, so threads writing components of different entities in a chunk can do so at the same time.
+        uint32_t GetChangeVersion(size_t chunk, uint16_t column) const { return changeVersions[chunk * columns.size() + column]; }
+        void MarkChanged(size_t chunk, uint16_t column, uint32_t version)
+        {
+            std::atomic_ref(changeVersions[chunk * columns.size() + column]).store(version, std::memory_order_relaxed);
+        }
+
+    private:
+        friend class World;
+
+        struct Column
+        {
+            ComponentId id;
+            ComponentRegistry::Info info;
+            size_t offset;          // From the start of a chunk
+        };
+
+        struct ChunkDeleter
+        {
+            void operator()(std::byte* chunk) const { ::operator delete(chunk, std::align_val_t{CHUNK_ALIGNMENT}); }
+        };
+
+        // Appends a row for `entity`, its components are left for the caller to construct
+        uint32_t allocateRow(Entity entity, uint32_t version);
+        // Fills the row, whose components must already be destroyed or moved out, with the last one. Returns the
+        // entity that moved into it, or a null one when the row was the last.
+        Entity removeRow(uint32_t row, uint32_t version);
+        void markChunkChanged(size_t chunk, uint32_t version);
+
+        ComponentMask mask;
+        std::vector<Column> columns;
+        std::array<uint16_t, ComponentRegistry::MAX_COMPONENTS> columnOf{};
+        uint32_t chunkCapacity = 0;
+        std::vector<std::unique_ptr<std::byte, ChunkDeleter>> chunks;
+        std::vector<uint32_t> changeVersions;   // Chunk by chunk, one per column
+        size_t entityCount = 0;
+
+        // Archetype an entity moves to when a component is added or removed, filled on first use
+        std::array<Archetype*, ComponentRegistry::MAX_COMPONENTS> addEdges{};
+        std::array<Archetype*, ComponentRegistry::MAX_COMPONENTS> removeEdges{};
+    };
+
+    // Entities and their components, stored by archetype. Not thread safe.
+    //
+    // Adding or removing components and entities is a structural change: it moves rows between archetypes, so it
+    // isn't allowed while a Query iterates. Record it in a CommandBuffer then, and apply that afterwards.
+    class World
+    {
+    public:
+        VOIDENGINE_API World();
+        VOIDENGINE_API ~World();
+
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+
+        // Entity without components
+        VOIDENGINE_API Entity Create();
+
+        template<typename... Cs>
+        Entity Create(Cs&&... components)
+        {
+            const Entity entity = Reserve();
+            Place(entity, std::forward<Cs>(components)...);
+            return entity;
+        }
+
+        // Destroying a destroyed entity does nothing
+        VOIDENGINE_API void Destroy(Entity entity);
+        VOIDENGINE_API bool IsAlive(Entity entity) const;
+
+        // Handle of an entity that doesn't exist in any archetype yet, until Place() gives it its components.
+        // Lets a CommandBuffer return handles to the entities it will create.
+        VOIDENGINE_API Entity Reserve();
+
+        template<typename... Cs>
+        void Place(Entity entity, Cs&&... components)
+        {
+            checkStructuralChange();
+            Record& record = getRecord(entity);
+            if (record.archetype != nullptr) throw std::runtime_error("World: Entity already placed.");
+
+            ComponentMask mask;
+            (mask.set(ComponentRegistry::Id<std::decay_t<Cs>>()), ...);
+            if (mask.count() != sizeof...(Cs)) throw std::runtime_error("World: Duplicate component type.");
+
+            Archetype* archetype = findArchetype(mask);
+            record.row = archetype->allocateRow(entity, changeVersion);
+            record.archetype = archetype;
+            (construct<std::decay_t<Cs>>(record, std::forward<Cs>(components)), ...);
+        }
+
+        // Adds the component, or assigns it when the entity already has one. Returns the stored component.
+        template<typename T>
+        T& Add(Entity entity, T component = {})
+        {
+            const ComponentId id = ComponentRegistry::Id<T>();
+            Record& record = getPlacedRecord(entity);
+            if (const uint16_t column = record.archetype->GetColumn(id); column != Archetype::NO_COLUMN)
+            {
+                T& stored = *static_cast<T*>(record.archetype->GetComponent(record.row, column));
+                stored = std::move(component);
+                record.archetype->MarkChanged(record.row / record.archetype->GetChunkCapacity(), column, changeVersion);
+                return stored;
+            }
+
+            checkStructuralChange();
+            Archetype*& edge = record.archetype->addEdges[id];
+            if (edge == nullptr) edge = findArchetype(ComponentMask{record.archetype->GetMask()}.set(id));
+            moveEntity(entity, edge);
+            return construct<T>(record, std::move(component));
+        }
+
+        // Removing a component the entity doesn't have does nothing
+        template<typename T>
+        void Remove(Entity entity)
+        {
+            const ComponentId id = ComponentRegistry::Id<T>();
+            Record& record = getPlacedRecord(entity);
+            if (record.archetype->GetColumn(id) == Archetype::NO_COLUMN) return;
+
+            checkStructuralChange();
+            Archetype*& edge = record.archetype->removeEdges[id];
+            if (edge == nullptr) edge = findArchetype(ComponentMask{record.archetype->GetMask()}.reset(id));
+            moveEntity(entity, edge);
+        }
+
+        // nullptr if the entity is dead or doesn't have the component. Valid until the next structural change.
+        // A non const T counts as a write, see NextChangeVersion().
+        template<typename T>
+        T* Get(Entity entity) const
+        {
+            if (!IsAlive(entity)) return nullptr;
+            const Record& record = records[entity.index];
+            if (record.archetype == nullptr) return nullptr;
+
+            const uint16_t column = record.archetype->GetColumn(ComponentRegistry::Id<std::remove_const_t<T>>());
+            if (column == Archetype::NO_COLUMN) return nullptr;
+            if constexpr (!std::is_const_v<T>)
+            {
+                record.archetype->MarkChanged(record.row / record.archetype->GetChunkCapacity(), column, changeVersion);
+            }
+            return static_cast<T*>(record.archetype->GetComponent(record.row, column));
+        }
+
+        template<typename T>
+        bool Has(Entity entity) const { return Get<const T>(entity) != nullptr; }
+
+        size_t GetEntityCount() const { return records.size() - freeIndices.size(); }
+
+        // Grows with every new combination of components, archetypes are never removed
+        const std::vector<std::unique_ptr<Archetype>>& GetArchetypes() const { return archetypes; }
+
+        // Counts the queries iterating, structural changes throw meanwhile
+        void BeginIteration() { iterating++; }
+        void EndIteration() { iterating--; }
+
+        // Every write to a component stamps its chunk with the current change version: non const Get<T>(), Add(),
+        // new rows and queries iterating a non const component. Returns the current version and starts a new
+        // one, so a system keeping the returned value sees which chunks were written after this call by
+        // comparing with Query::ChangedSince().
+        uint32_t GetChangeVersion() const { return changeVersion; }
+        uint32_t NextChangeVersion() { return changeVersion++; }
+
+    private:
+        struct Record
+        {
+            Archetype* archetype;   // nullptr while reserved or once destroyed
+            uint32_t row;
+            uint32_t generation;    // Bumped when destroyed
+            bool alive;
+        };
+
+        template<typename T, typename Arg>
+        T& construct(const Record& record, Arg&& value)
+        {
+            void* component = record.archetype->GetComponent(record.row, record.archetype->GetColumn(ComponentRegistry::Id<T>()));
+            return *new (component) T(std::forward<Arg>(value));
+        }
+
+        VOIDENGINE_API Record& getRecord(Entity entity);
+        VOIDENGINE_API Record& getPlacedRecord(Entity entity);
+        VOIDENGINE_API Archetype* findArchetype(const ComponentMask& mask);
+        // Moves the entity's row into `target`. Components both have are moved, the others of the old archetype
+        // destroyed and the others of `target` left unconstructed.
+        VOIDENGINE_API void moveEntity(Entity entity, Archetype* target);
+        VOIDENGINE_API void checkStructuralChange() const;
+
+        std::vector<Record> records;
+        std::vector<uint32_t> freeIndices;
+
+        std::vector<std::unique_ptr<Archetype>> archetypes;
+        std::unordered_map<ComponentMask, Archetype*> archetypeLookup;
+
+        int iterating = 0;
+        uint32_t changeVersion = 1;
+    };
+
+    // Entities with all of the components Cs, optionally without some others. The matching archetypes are cached
+    // and only archetypes created since the last iteration are checked again, so keep queries around rather than
+    // building one per frame. Cs can be const to document read only access.
+    template<typename... Cs>
+    class Query
+    {
+    public:
+        explicit Query(World& world) : world(world)
+        {
+            (required.set(ComponentRegistry::Id<std::remove_const_t<Cs>>()), ...);
+        }
+
+        // Skips entities with component T
+        template<typename T>
+        Query& Without()
+        {
+            excluded.set(ComponentRegistry::Id<T>());
+            matches.clear();
+            checkedArchetypes = 0;
+            return *this;
+        }
+
+        // Skips chunks where no T, one of Cs, was written after World::NextChangeVersion() returned `version`
+        template<typename T>
+        Query& ChangedSince(uint32_t version)
+        {
+            changedComponent = ComponentRegistry::Id<std::remove_const_t<T>>();
+            changedSince = version;
+            return *this;
+        }
+
+        // Calls function(Cs&...) or function(Entity, Cs&...) for every matching entity
+        template<typename F>
+        void ForEach(F&& function)
+        {
+            ForEachChunk([&](size_t count, const Entity* entities, Cs*... columns)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    if constexpr (std::is_invocable_v<F&, Entity, Cs&...>) function(entities[i], columns[i]...);
+                    else function(columns[i]...);
+                }
+            });
+        }
+
+        // Calls function(size_t count, const Entity* entities, Cs*... arrays) once per chunk, for loops that want
+        // the component arrays themselves
+        template<typename F>
+        void ForEachChunk(F&& function)
+        {
+            refresh();
+
+            struct IterationScope
+            {
+                World& world;
+                explicit IterationScope(World& world) : world(world) { world.BeginIteration(); }
+                ~IterationScope() { world.EndIteration(); }
+            } scope{world};
+
+            for (const Match& match : matches)
+            {
+                const uint16_t changedColumn = changedComponent < ComponentRegistry::MAX_COMPONENTS
+                    ? match.archetype->GetColumn(changedComponent) : Archetype::NO_COLUMN;
+                for (size_t chunk = 0; chunk < match.archetype->GetChunkCount(); chunk++)
+                {
+                    if (changedColumn != Archetype::NO_COLUMN &&
+                        match.archetype->GetChangeVersion(chunk, changedColumn) <= changedSince) continue;
+                    callChunk(function, match, chunk, std::index_sequence_for<Cs...>{});
+                }
+            }
+        }
+
+        size_t Count()
+        {
+            refresh();
+            size_t count = 0;
+            for (const Match& match : matches) count += match.archetype->GetEntityCount();
+            return count;
+        }
+
+    private:
+        struct Match
+        {
+            Archetype* archetype;
+            std::array<uint16_t, sizeof...(Cs)> columns;
+        };
+
+        void refresh()
+        {
+            const auto& archetypes = world.GetArchetypes();
+            for (; checkedArchetypes < archetypes.size(); checkedArchetypes++)
+            {
+                Archetype* archetype = archetypes[checkedArchetypes].get();
+                const ComponentMask& mask = archetype->GetMask();
+                if ((mask & required) != required || (mask & excluded).any()) continue;
+
+                matches.push_back({archetype, {archetype->GetColumn(ComponentRegistry::Id<std::remove_const_t<Cs>>())...}});
+            }
+        }
+
+        template<typename F, size_t... I>
+        void callChunk(F& function, const Match& match, size_t chunk, std::index_sequence<I...>)
+        {
+            const size_t count = match.archetype->GetChunkEntityCount(chunk);
+            if (count == 0) return;
+            // Non const components are handed out for writing
+            ((std::is_const_v<Cs> ? void() : match.archetype->MarkChanged(chunk, match.columns[I], world.GetChangeVersion())), ...);
+            function(count, static_cast<const Entity*>(match.archetype->GetEntities(chunk)),
+                static_cast<Cs*>(match.archetype->GetColumnData(chunk, match.columns[I]))...);
+        }
+
+        World& world;
+        ComponentMask required;
+        ComponentMask excluded;
+        std::vector<Match> matches;
+        size_t checkedArchetypes = 0;
+        ComponentId changedComponent = ComponentRegistry::MAX_COMPONENTS;
+        uint32_t changedSince = 0;
+    };
+
+    // Structural changes recorded while queries iterate and applied in order afterwards. Commands on entities
+    // destroyed by then are skipped.
+    class CommandBuffer
+    {
+    public:
+        explicit CommandBuffer(World& world) : world(world) {}
+
+        // The handle is valid right away, the entity gets its components on Apply(). Reserves the entity in the
+        // World right away, so unlike the other commands it must not be recorded from several threads at once.
+        template<typename... Cs>
+        Entity Create(Cs... components)
+        {
+            const Entity entity = world.Reserve();
+            record([entity, values = std::make_tuple(std::move(components)...)](World& target) mutable
+            {
+                std::apply([&](auto&&... unpacked) { target.Place(entity, std::move(unpacked)...); }, std::move(values));
+            });
+            return entity;
+        }
+
+        void Destroy(Entity entity)
+        {
+            record([entity](World& target) { target.Destroy(entity); });
+        }
+
+        template<typename T>
+        void Add(Entity entity, T component = {})
+        {
+            record([entity, value = std::move(component)](World& target) mutable
+            {
+                if (target.IsAlive(entity)) target.Add<T>(entity, std::move(value));
+            });
+        }
+
+        template<typename T>
+        void Remove(Entity entity)
+        {
+            record([entity](World& target)
+            {
+                if (target.IsAlive(entity)) target.Remove<T>(entity);
+            });
+        }
+
+        // Calls function(World&) on Apply(), for changes to state other than components
+        template<typename F>
+        void Run(F&& function)
+        {
+            record(std::forward<F>(function));
+        }
+
+        bool IsEmpty() const { return commands.empty(); }
+
+        VOIDENGINE_API void Apply();
+
+    private:
+        struct Command
+        {
+            virtual ~Command() = default;
+            virtual void Execute(World& world) = 0;
+        };
+
+        // Type erased without std::function, which would require copyable components
+        template<typename F>
+        struct TypedCommand final : Command
+        {
+            explicit TypedCommand(F&& function) : function(std::move(function)) {}
+            void Execute(World& world) override { function(world); }
+            F function;
+        };
+
+        template<typename F>
+        void record(F&& function)
+        {
+            commands.push_back(std::make_unique<TypedCommand<std::decay_t<F>>>(std::forward<F>(function)));
+        }
+
+        World& world;
+        std::vector<std::unique_ptr<Command>> commands;
+    };
+}
@@ -10,7 +10,7 @@ namespace VoidEngine {
     {
         auto* pl = new PointLight(&game);
         pl->SetPointLight(intensity, radius, color);
-        pl->transform = transform;
+        pl->GetTransform() = transform;
         pl->UpdateLight(*game.ubo, pointLights.size());
 
         const std::vector<Model::Vertex> v =
@@ -21,10 +21,12 @@ namespace VoidEngine {
                 {{1.0f, 1.0f, 0.0f}, color, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
             };
 
-        pl->model->AddVertex(v[0]);
-        pl->model->AddVertex(v[1]);
-        pl->model->AddVertex(v[2]);
-        pl->model->CreateBuffers();
+        auto model = game.modelManager->Create();
+        model->AddVertex(v[0]);
+        model->AddVertex(v[1]);
+        model->AddVertex(v[2]);
+        model->CreateBuffers();
+        pl->SetModel(std::move(model));
 
         game.AddGameObject(pl, RenderQueueType::LIGHT);
 
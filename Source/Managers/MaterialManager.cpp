@@ -0,0 +1,144 @@
+#include "VoidEngine.hpp"
+#include "MaterialManager.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace VoidEngine {
+    MaterialManager::MaterialManager(Game* game) : game(game)
+    {
+        setLayout = Material::CreateSetLayout(*game->GetDevice());
+
+        std::lock_guard lock(mutex);
+        const Entry entry = create(MaterialParameters{});
+        materials.emplace(MaterialParameters{}, entry);
+        defaultMaterial = entry.material;
+
+        std::cerr << "MaterialManager created.\n";
+    }
+
+    MaterialManager::~MaterialManager()
+    {
+        // Destroying the pools frees every set, including those of materials still referenced elsewhere
+        std::cerr << "MaterialManager destroyed.\n";
+    }
+
+    size_t MaterialManager::ParametersHash::operator()(const MaterialParameters& parameters) const
+    {
+        return static_cast<size_t>(hashBytes(&parameters, sizeof(parameters), 0));
+    }
+
+    MaterialParameters MaterialManager::GetParameters(const Model::MaterialDesc& material)
+    {
+        // Metals keep their base color as diffuse, without environment lighting they would be black otherwise
+        constexpr float DIELECTRIC_SPECULAR = 0.04f;
+        constexpr float MIN_EXPONENT = 1.0f;
+        constexpr float MAX_EXPONENT = 512.0f;
+
+        const glm::vec3 baseColor{material.baseColorFactor};
+        const float metallic = glm::clamp(material.metallicFactor, 0.0f, 1.0f);
+        const float roughness = std::max(material.roughnessFactor, 1e-3f);
+
+        MaterialParameters parameters{};
+        parameters.baseColorFactor = material.baseColorFactor;
+        parameters.specularFactor = glm::vec4(glm::mix(glm::vec3{DIELECTRIC_SPECULAR}, baseColor, metallic),
+            std::clamp(2.0f / (roughness * roughness) - 2.0f, MIN_EXPONENT, MAX_EXPONENT));
+        return parameters;
+    }
+
+    MaterialHandle MaterialManager::Get(const MaterialParameters& parameters)
+    {
+        std::lock_guard lock(mutex);
+        requests++;
+
+        if (const auto it = materials.find(parameters); it != materials.end())
+        {
+            return it->second.material;
+        }
+
+        const Entry entry = create(parameters);
+        materials.emplace(parameters, entry);
+        created++;
+        return entry.material;
+    }
+
+    void MaterialManager::Resolve(Model& model)
+    {
+        model.materialHandles.clear();
+        model.materialHandles.reserve(model.materials.size());
+        for (const auto& material : model.materials)
+        {
+            model.materialHandles.push_back(Get(GetParameters(material)));
+        }
+    }
+
+    MaterialManager::Entry MaterialManager::create(const MaterialParameters& parameters)
+    {
+        // Allocating and freeing sets from a pool has to be externally synchronized, the caller holds the mutex
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        DescriptorPool* pool = nullptr;
+        for (const auto& candidate : pools)
+        {
+            if (candidate->allocateDescriptor(setLayout->getDescriptorSetLayout(), descriptorSet))
+            {
+                pool = candidate.get();
+                break;
+            }
+        }
+
+        if (pool == nullptr)
+        {
+            pools.push_back(DescriptorPool::Builder(*game->GetDevice())
+                .setMaxSets(SETS_PER_POOL)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, SETS_PER_POOL)
+                .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
+                .build());
+            pool = pools.back().get();
+
+            if (!pool->allocateDescriptor(setLayout->getDescriptorSetLayout(), descriptorSet))
+            {
+                throw std::runtime_error("Failed to allocate a material descriptor set.");
+            }
+        }
+
+        return {std::make_shared<Material>(*game->GetDevice(), nextId++, parameters, descriptorSet), pool};
+    }
+
+    void MaterialManager::EndFrame()
+    {
+        std::lock_guard lock(mutex);
+        frameNumber++;
+
+        // The map and the default hold one reference each to the default material, so it is never evicted
+        for (auto it = materials.begin(); it != materials.end();)
+        {
+            if (it->second.material.use_count() == 1)
+            {
+                retiredMaterials.Retire(std::move(it->second), frameNumber);
+                it = materials.erase(it);
+            } else
+            {
+                ++it;
+            }
+        }
+
+        // Freed under the lock, loader threads allocate from the same pools
+        retiredMaterials.Collect(frameNumber, [](Entry& entry)
+        {
+            std::vector<VkDescriptorSet> sets{entry.material->GetDescriptorSet()};
+            entry.pool->freeDescriptors(sets);
+        });
+    }
+
+    MaterialManager::Stats MaterialManager::GetStats() const
+    {
+        std::lock_guard lock(mutex);
+
+        Stats stats{};
+        stats.materials = materials.size() + retiredMaterials.Size();
+        stats.requests = requests;
+        stats.created = created;
+        return stats;
+    }
+} // VoidEngine
@@ -0,0 +1,86 @@
+#pragma once
+#include "Common.hpp"
+#include "Descriptors.hpp"
+#include "Material.hpp"
+#include "Model.hpp"
+#include "RetireQueue.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace VoidEngine {
+    class Game;
+
+    // Owns every Material. Materials are keyed by their parameter block, so imported materials that only differ
+    // in name (Sponza's are mostly identical) share one uniform buffer and descriptor set, and draws sorted by
+    // material bind it once for all of them.
+    //
+    // Unreferenced materials are evicted in EndFrame() like meshes, their descriptor sets go back to the pool
+    // SwapChain::MAX_FRAMES_IN_FLIGHT frames later.
+    class MaterialManager {
+    public:
+        // Descriptor sets per pool, another pool is added when they run out
+        static constexpr uint32_t SETS_PER_POOL = 256;
+
+        struct Stats
+        {
+            size_t materials = 0;       // Live, including the default and ones waiting for eviction
+            uint64_t requests = 0;      // Get() calls
+            uint64_t created = 0;       // Requests that needed a new parameter block
+        };
+
+        VOIDENGINE_API explicit MaterialManager(Game* game);
+        VOIDENGINE_API ~MaterialManager();
+
+        // Parameters the shaders use for an imported metallic-roughness material. Highlights get the Fresnel
+        // color at normal incidence and the Blinn-Phong exponent matching the roughness.
+        VOIDENGINE_API static MaterialParameters GetParameters(const Model::MaterialDesc& material);
+
+        // Returns the material with these parameters, creating it on first use. Safe to call from loader threads.
+        VOIDENGINE_API MaterialHandle Get(const MaterialParameters& parameters);
+
+        // Fills model.materialHandles from model.materials
+        VOIDENGINE_API void Resolve(Model& model);
+
+        // Drawn for submeshes without a material and models without submeshes
+        const MaterialHandle& GetDefault() const { return defaultMaterial; }
+
+        // Call once per frame after submitting it
+        VOIDENGINE_API void EndFrame();
+
+        VOIDENGINE_API Stats GetStats() const;
+
+    private:
+        struct ParametersHash
+        {
+            size_t operator()(const MaterialParameters& parameters) const;
+        };
+
+        struct Entry
+        {
+            MaterialHandle material;
+            DescriptorPool* pool;
+        };
+
+        // Called with the mutex held
+        Entry create(const MaterialParameters& parameters);
+
+        Game* game;
+        std::unique_ptr<DescriptorSetLayout> setLayout;
+
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<DescriptorPool>> pools;
+        std::unordered_map<MaterialParameters, Entry, ParametersHash> materials;
+        RetireQueue<Entry> retiredMaterials;
+        uint64_t frameNumber = 0;
+        uint32_t nextId = 0;
+        uint64_t requests = 0;
+        uint64_t created = 0;
+
+        MaterialHandle defaultMaterial;
+    };
+
+} // VoidEngine
@@ -1,17 +1,407 @@
 #include "VoidEngine.hpp"
 #include "ModelManager.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <filesystem>
 #include <iostream>
-#include <External/tinyobjloader/tinyobjloader.hpp>
 
 namespace VoidEngine {
     ModelManager::ModelManager(Game* game) : game(game)
     {
+        // One thread more than workers, ThreadPool counts the caller of parallelFor
+        loaders = std::make_unique<ThreadPool>(LOADER_THREADS + 1);
+
         std::cerr << "ModelManager created.\n";
     }
 
     ModelManager::~ModelManager()
     {
+        // Finishes the parses already queued, then the uploads they enqueued, whose callbacks point back here
+        loaders.reset();
+        game->uploadQueue->WaitIdle();
+
         std::cerr << "ModelManager destroyed.\n";
     }
-} // VoidEngine
\ No newline at end of file
+
+    size_t ModelManager::KeyHash::operator()(const Key& key) const
+    {
+        size_t seed = 0;
+        hashCombine(seed, key.path, key.weldEpsilonBits, key.optimize, key.generateTangents, static_cast<uint32_t>(key.vertexFormat),
+            key.lodCount, key.lodReductionBits, key.lodMaxErrorBits);
+        return seed;
+    }
+
+    Model::ImportOptions ModelManager::makeOptions(const Key& key)
+    {
+        Model::ImportOptions options{};
+        options.weldEpsilon = std::bit_cast<float>(key.weldEpsilonBits);
+        options.optimize = key.optimize;
+        options.generateTangents = key.generateTangents;
+        options.vertexFormat = key.vertexFormat;
+        options.lodCount = key.lodCount;
+        options.lodReduction = std::bit_cast<float>(key.lodReductionBits);
+        options.lodMaxError = std::bit_cast<float>(key.lodMaxErrorBits);
+        return options;
+    }
+
+    ModelManager::Key ModelManager::makeKey(const std::string& filepath, const Model::ImportOptions& options)
+    {
+        // "models/./vase.obj" and "models/vase.obj" are the same mesh
+        const std::string path = std::filesystem::path(filepath).lexically_normal().generic_string();
+        // -0 and +0 weld identically
+        const float epsilon = options.weldEpsilon == 0.0f ? 0.0f : options.weldEpsilon;
+        return {path, std::bit_cast<uint32_t>(epsilon), options.optimize, options.generateTangents, options.vertexFormat, options.lodCount,
+            std::bit_cast<uint32_t>(options.lodReduction), std::bit_cast<uint32_t>(options.lodMaxError)};
+    }
+
+    ModelHandle ModelManager::Load(const std::string& filepath, const Model::ImportOptions& options)
+    {
+        const Key key = makeKey(filepath, options);
+
+        std::promise<ModelHandle> promise;
+        std::shared_future<ModelHandle> existing;
+        {
+            std::lock_guard lock(mutex);
+            if (const auto it = models.find(key); it != models.end())
+            {
+                existing = it->second;
+            } else
+            {
+                models.emplace(key, promise.get_future().share());
+            }
+        }
+
+        // Waits if another thread is still loading it, rethrows its error if that load failed
+        if (existing.valid()) return existing.get();
+
+        game->fileWatcher->Watch(filepath);
+
+        // Loaded outside the lock so other meshes can load in parallel
+        try
+        {
+            auto model = std::make_shared<Model>(*game->GetDevice());
+            model->LoadModelFromFile(filepath, options);
+            game->materialManager->Resolve(*model);
+            promise.set_value(model);
+            return model;
+        } catch (...)
+        {
+            // Removed before the error is published, so the cache never holds a failed load and later calls retry
+            {
+                std::lock_guard lock(mutex);
+                models.erase(key);
+            }
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    ModelHandle ModelManager::LoadAsync(const std::string& filepath, const Model::ImportOptions& options)
+    {
+        const Key key = makeKey(filepath, options);
+        const auto requested = std::chrono::steady_clock::now();
+
+        ModelHandle model;
+        std::shared_future<ModelHandle> existing;
+        {
+            std::lock_guard lock(mutex);
+            if (const auto it = models.find(key); it != models.end())
+            {
+                existing = it->second;
+            } else
+            {
+                // Cached as ready right away, residency tells renderers whether the buffers can be used
+                model = std::make_shared<Model>(*game->GetDevice());
+                std::promise<ModelHandle> promise;
+                promise.set_value(model);
+                models.emplace(key, promise.get_future().share());
+                pendingLoads++;
+            }
+        }
+
+        if (existing.valid())
+        {
+            // Only waits while a synchronous Load() of the same mesh is running, outside the lock it needs
+            try
+            {
+                return existing.get();
+            } catch (...)
+            {
+                // That load failed and left the cache, stream the mesh like any other request
+                return LoadAsync(filepath, options);
+            }
+        }
+
+        game->fileWatcher->Watch(filepath);
+        loaders->submit([this, key, model, filepath, options, requested]()
+        {
+            stream(key, model, filepath, options, requested);
+        });
+        return model;
+    }
+
+    void ModelManager::stream(const Key& key, const ModelHandle& model, const std::string& filepath,
+        const Model::ImportOptions& options, std::chrono::steady_clock::time_point requested)
+    {
+        std::vector<Model::StagedCopy> copies;
+        try
+        {
+            copies = model->StageModelFromFile(filepath, options);
+            game->materialManager->Resolve(*model);
+        } catch (const std::exception& e)
+        {
+            std::cerr << "Failed to load " << filepath << ": " << e.what() << "\n";
+
+            std::lock_guard lock(mutex);
+            // Only if it is still ours, it may have been evicted and loaded again meanwhile
+            if (const auto it = models.find(key); it != models.end() && it->second.get() == model)
+            {
+                models.erase(it);
+            }
+            pendingLoads--;
+            failedLoads++;
+            return;
+        }
+
+        if (copies.empty())
+        {
+            model->MarkResident();
+            streamFinished(requested);
+            return;
+        }
+
+        // The model is resident once its last copy has executed, copies complete in order
+        for (size_t i = 0; i < copies.size(); i++)
+        {
+            std::function<void()> onComplete;
+            if (i + 1 == copies.size())
+            {
+                onComplete = [this, model, requested]()
+                {
+                    model->MarkResident();
+                    streamFinished(requested);
+                };
+            }
+            game->uploadQueue->Enqueue(std::move(copies[i].staging), copies[i].destination, copies[i].size,
+                std::move(onComplete));
+        }
+    }
+
+    void ModelManager::streamFinished(std::chrono::steady_clock::time_point requested)
+    {
+        const double latencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - requested).count();
+
+        std::lock_guard lock(mutex);
+        pendingLoads--;
+        completedLoads++;
+        lastLatencyMs = latencyMs;
+        totalLatencyMs += latencyMs;
+        maxLatencyMs = std::max(maxLatencyMs, latencyMs);
+    }
+
+    size_t ModelManager::Reload(const std::string& filepath)
+    {
+        const std::string path = std::filesystem::path(filepath).lexically_normal().generic_string();
+        const auto requested = std::chrono::steady_clock::now();
+
+        std::vector<std::pair<ModelHandle, Model::ImportOptions>> started;
+        {
+            std::lock_guard lock(mutex);
+            for (const auto& [key, future] : models)
+            {
+                if (key.path != path || future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+
+                const ModelHandle& model = future.get();
+                if (!model->IsResident()) continue;
+
+                // Already reimporting, which may have read the file before this write. Reloaded again once swapped in.
+                if (const auto it = reloading.find(model.get()); it != reloading.end())
+                {
+                    it->second = true;
+                    continue;
+                }
+                reloading.emplace(model.get(), false);
+                started.emplace_back(model, makeOptions(key));
+            }
+        }
+
+        for (const auto& [model, options] : started)
+        {
+            loaders->submit([this, model, path, options, requested]()
+            {
+                reimport(model, path, options, requested);
+            });
+        }
+        return started.size();
+    }
+
+    void ModelManager::reimport(const ModelHandle& model, const std::string& filepath,
+        const Model::ImportOptions& options, std::chrono::steady_clock::time_point requested)
+    {
+        // Content hashed, so an edited file misses the mesh cache and everything else still hits it
+        auto reimported = std::make_shared<Model>(*game->GetDevice());
+        std::vector<Model::StagedCopy> copies;
+        try
+        {
+            copies = reimported->StageModelFromFile(filepath, options);
+            game->materialManager->Resolve(*reimported);
+        } catch (const std::exception& e)
+        {
+            std::cerr << "Failed to reload " << filepath << ": " << e.what() << "\n";
+
+            std::lock_guard lock(mutex);
+            failedReloads++;
+            // Probably read halfway through a save, the write that finished it asked for another try
+            if (const auto it = reloading.find(model.get()); it->second)
+            {
+                it->second = false;
+                loaders->submit([this, model, filepath, options]()
+                {
+                    reimport(model, filepath, options, std::chrono::steady_clock::now());
+                });
+            } else
+            {
+                reloading.erase(it);
+            }
+            return;
+        }
+
+        auto finish = [this, model, reimported, filepath, options, requested]()
+        {
+            reimported->MarkResident();
+
+            std::lock_guard lock(mutex);
+            finishedReloads.push_back({model, reimported, filepath, options, requested});
+        };
+
+        if (copies.empty())
+        {
+            finish();
+            return;
+        }
+
+        for (size_t i = 0; i < copies.size(); i++)
+        {
+            std::function<void()> onComplete;
+            if (i + 1 == copies.size()) onComplete = finish;
+            game->uploadQueue->Enqueue(std::move(copies[i].staging), copies[i].destination, copies[i].size,
+                std::move(onComplete));
+        }
+    }
+
+    ModelHandle ModelManager::Create()
+    {
+        auto model = std::make_shared<Model>(*game->GetDevice());
+
+        std::lock_guard lock(mutex);
+        createdModels.push_back(model);
+        return model;
+    }
+
+    void ModelManager::EndFrame()
+    {
+        std::vector<ModelHandle> destroyed;
+        std::vector<Reimport> restarted;
+        {
+            std::lock_guard lock(mutex);
+            frameNumber++;
+
+            // Between frames nothing records draws, and the frames still in flight keep using the old buffers,
+            // which stay alive in the reimported model until it is destroyed below
+            const auto now = std::chrono::steady_clock::now();
+            for (auto& reload : finishedReloads)
+            {
+                reload.model->Swap(*reload.reimported);
+                retiredModels.Retire(std::move(reload.reimported), frameNumber);
+
+                lastReloadMs = std::chrono::duration<double, std::milli>(now - reload.requested).count();
+                completedReloads++;
+                std::cerr << "Reloaded " << reload.filepath << " in " << lastReloadMs << " ms.\n";
+
+                const auto it = reloading.find(reload.model.get());
+                if (it->second)
+                {
+                    it->second = false;
+                    reload.requested = now;
+                    restarted.push_back(std::move(reload));
+                } else
+                {
+                    reloading.erase(it);
+                }
+            }
+            finishedReloads.clear();
+
+            // Evict meshes whose only reference is the manager's own. Meshes still loading are skipped, and failed
+            // loads never stay in the map, so a ready future always holds a model.
+            for (auto it = models.begin(); it != models.end();)
+            {
+                const auto& future = it->second;
+                if (future.wait_for(std::chrono::seconds(0)) == std::future_status::ready && future.get().use_count() == 1)
+                {
+                    retiredModels.Retire(future.get(), frameNumber);
+                    it = models.erase(it);
+                } else
+                {
+                    ++it;
+                }
+            }
+
+            for (auto it = createdModels.begin(); it != createdModels.end();)
+            {
+                if (it->use_count() == 1)
+                {
+                    retiredModels.Retire(std::move(*it), frameNumber);
+                    it = createdModels.erase(it);
+                } else
+                {
+                    ++it;
+                }
+            }
+
+            retiredModels.Collect(frameNumber, [&](ModelHandle& model)
+            {
+                destroyed.push_back(std::move(model));
+            });
+        }
+        // Buffers are freed here, outside the lock
+
+        for (auto& reload : restarted)
+        {
+            loaders->submit([this, model = std::move(reload.model), filepath = std::move(reload.filepath),
+                options = reload.options, requested = reload.requested]()
+            {
+                reimport(model, filepath, options, requested);
+            });
+        }
+    }
+
+    size_t ModelManager::GetModelCount() const
+    {
+        std::lock_guard lock(mutex);
+        return models.size() + createdModels.size() + retiredModels.Size();
+    }
+
+    ModelManager::StreamingStats ModelManager::GetStreamingStats() const
+    {
+        const UploadQueue::Stats uploads = game->uploadQueue->GetStats();
+
+        std::lock_guard lock(mutex);
+
+        StreamingStats stats{};
+        stats.pendingLoads = pendingLoads;
+        stats.queuedUploads = uploads.queuedCopies;
+        stats.inFlightUploads = uploads.inFlightCopies;
+        stats.queuedUploadBytes = uploads.queuedBytes;
+        stats.completedLoads = completedLoads;
+        stats.failedLoads = failedLoads;
+        stats.lastLatencyMs = lastLatencyMs;
+        stats.averageLatencyMs = completedLoads > 0 ? totalLatencyMs / static_cast<double>(completedLoads) : 0.0;
+        stats.maxLatencyMs = maxLatencyMs;
+        stats.pendingReloads = reloading.size();
+        stats.completedReloads = completedReloads;
+        stats.failedReloads = failedReloads;
+        stats.lastReloadMs = lastReloadMs;
+        return stats;
+    }
+} // VoidEngine
@@ -1,6 +1,17 @@
 #pragma once
 #include "Common.hpp"
 #include "Model.hpp"
+#include "RetireQueue.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace VoidEngine {
     class Game;
@@ -8,20 +19,143 @@ namespace VoidEngine {
     // Forward decleration
     class GameObject;
 
+    // Shared handle to a GPU mesh owned by the ModelManager. Copying it is just a refcount bump.
+    using ModelHandle = std::shared_ptr<Model>;
+
+    // Owns every GPU mesh. Files are loaded once per path and import options and shared between all
+    // objects that use them, so 10,000 copies of a vase hold a single vertex/index buffer pair.
+    //
+    // Meshes nobody holds a handle to anymore are evicted in EndFrame(). Their buffers are destroyed
+    // only after the frames that may still reference them have finished on the GPU.
+    //
+    // LoadAsync() streams meshes in without stalling the frame: files are parsed on loader threads and
+    // their buffers copied through the Game's UploadQueue, which the render loop flushes once per frame.
+    //
+    // Loaded files are watched by the Game's FileWatcher. Reload() reimports an edited file the same way and
+    // EndFrame() swaps the new mesh into the existing Model, so objects keep their handles.
     class ModelManager {
     public:
+        // Worker threads parsing files for LoadAsync()
+        static constexpr size_t LOADER_THREADS = 2;
+
+        struct StreamingStats
+        {
+            size_t pendingLoads = 0;        // Requested, not resident yet (parsing or waiting for upload)
+            size_t queuedUploads = 0;       // Copies waiting for the next UploadQueue::Flush()
+            size_t inFlightUploads = 0;     // Copies submitted to the GPU, not finished yet
+            VkDeviceSize queuedUploadBytes = 0;
+            uint64_t completedLoads = 0;
+            uint64_t failedLoads = 0;
+            // Request to resident
+            double lastLatencyMs = 0.0;
+            double averageLatencyMs = 0.0;
+            double maxLatencyMs = 0.0;
+            size_t pendingReloads = 0;
+            uint64_t completedReloads = 0;
+            uint64_t failedReloads = 0;
+            // Reload() to swapped in
+            double lastReloadMs = 0.0;
+        };
+
         VOIDENGINE_API explicit ModelManager(Game* game);
         VOIDENGINE_API ~ModelManager();
 
-        //void CreateBuffers();
+        // Returns the mesh for `filepath` imported with `options`, loading it on first use. Safe to call
+        // from several threads: concurrent requests for the same mesh wait for a single load and share it,
+        // and uploads of different meshes take turns on the device's single-time commands. Load errors are
+        // rethrown to every waiting caller and nothing is cached. A mesh requested with LoadAsync() earlier
+        // is returned as is, possibly not resident yet.
+        VOIDENGINE_API ModelHandle Load(const std::string& filepath, const Model::ImportOptions& options = {});
+
+        // Returns right away with a mesh that is not resident yet. It is skipped when rendering until its
+        // buffers have been uploaded, so objects simply pop in once they are ready. Shares the cache with
+        // Load(), and waits for a synchronous Load() of the same mesh that is still running. A failed load is
+        // logged, counted in the stats and removed from the cache; the returned mesh then never becomes resident.
+        VOIDENGINE_API ModelHandle LoadAsync(const std::string& filepath, const Model::ImportOptions& options = {});
+
+        // Imports `filepath` again on the loader threads for every set of options it is cached with. Each mesh is
+        // swapped with its reimport in the EndFrame() after the upload finished, without waiting for the GPU. Meshes
+        // still streaming in are skipped, a failed reimport keeps the old mesh. Returns the number of reloads started.
+        VOIDENGINE_API size_t Reload(const std::string& filepath);
+
+        // Empty model for procedural geometry (AddVertex + CreateBuffers). Owned and evicted like loaded
+        // meshes, but never shared.
+        VOIDENGINE_API ModelHandle Create();
+
+        // Call once per frame after submitting it. Swaps in finished reloads, evicts unreferenced meshes and
+        // destroys the ones evicted or replaced SwapChain::MAX_FRAMES_IN_FLIGHT frames ago.
+        VOIDENGINE_API void EndFrame();
+
+        // Meshes currently cached or created, including ones waiting for eviction
+        VOIDENGINE_API size_t GetModelCount() const;
 
-        //VOIDENGINE_API void LoadModelFromFile(const std::string &filepathfilepath, GameObject& object);
-        VOIDENGINE_API Model& GetModel(const std::string &modelPathName) { return *models[modelPathName]; }
+        VOIDENGINE_API StreamingStats GetStreamingStats() const;
 
     private:
+        struct Key
+        {
+            std::string path;
+            uint32_t weldEpsilonBits;
+            bool optimize;
+            bool generateTangents;
+            Model::VertexFormat vertexFormat;
+            uint32_t lodCount;
+            uint32_t lodReductionBits;
+            uint32_t lodMaxErrorBits;
+
+            bool operator==(const Key& other) const = default;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Reimport
+        {
+            ModelHandle model;
+            ModelHandle reimported;     // Resident, swapped into `model` by EndFrame()
+            std::string filepath;
+            Model::ImportOptions options;
+            std::chrono::steady_clock::time_point requested;
+        };
+
+        static Key makeKey(const std::string& filepath, const Model::ImportOptions& options);
+        static Model::ImportOptions makeOptions(const Key& key);
+
+        // Runs on a loader thread
+        void stream(const Key& key, const ModelHandle& model, const std::string& filepath,
+            const Model::ImportOptions& options, std::chrono::steady_clock::time_point requested);
+        void streamFinished(std::chrono::steady_clock::time_point requested);
+        // Runs on a loader thread
+        void reimport(const ModelHandle& model, const std::string& filepath, const Model::ImportOptions& options,
+            std::chrono::steady_clock::time_point requested);
+
         Game* game;
 
-        std::unordered_map<std::string, std::unique_ptr<Model>> models;
+        mutable std::mutex mutex;
+        // A future per mesh, so callers arriving while it loads wait on the same result
+        std::unordered_map<Key, std::shared_future<ModelHandle>, KeyHash> models;
+        std::vector<ModelHandle> createdModels;
+        RetireQueue<ModelHandle> retiredModels;
+        uint64_t frameNumber = 0;
+
+        // Models being reimported, and whether their file changed again meanwhile so they need another reload
+        std::unordered_map<const Model*, bool> reloading;
+        std::vector<Reimport> finishedReloads;
+        uint64_t completedReloads = 0;
+        uint64_t failedReloads = 0;
+        double lastReloadMs = 0.0;
+
+        size_t pendingLoads = 0;
+        uint64_t completedLoads = 0;
+        uint64_t failedLoads = 0;
+        double lastLatencyMs = 0.0;
+        double totalLatencyMs = 0.0;
+        double maxLatencyMs = 0.0;
+
+        // Declared last so it is destroyed first, nothing is parsing once the members above go away
+        std::unique_ptr<ThreadPool> loaders;
     };
 
-} // VoidEngine
\ No newline at end of file
+} // VoidEngine
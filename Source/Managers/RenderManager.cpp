@@ -1,12 +1,17 @@
 #include "RenderManager.hpp"
 #include "RenderPipeline.hpp"
 #include "SceneManager.hpp"
+#include "ThreadPool.hpp"
 #include "VoidEngine.hpp"
 #include "WindowManager.hpp"
 #include "FrameInfo.hpp"
 #include "GameObject.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <functional>
+#include <iostream>
 #include <stdexcept>
 
 #define GLM_FORCE_RADIANS
@@ -23,7 +28,7 @@ namespace VoidEngine
 
     void RenderQueue::AddToQueue(const GameObject &gameObject)
     {
-        gameObjectIDs.push_back(gameObject.getId());
+        gameObjects.push_back(gameObject.GetHandle());
     }
 
     void RenderManager::createFrameBuffers(Device& device, SwapChain& swapChain, VkRenderPass pass)
@@ -68,10 +73,16 @@ namespace VoidEngine
          * Command buffer recording
          */
 
+        // The SceneManager is created first, see Game::Game()
+        drawQuery = std::make_unique<Query<const WorldMatrix, const MeshRenderer, const RenderQueueMember>>(game_.sceneManager->GetWorld());
+        occluderQuery = std::make_unique<Query<const WorldMatrix, const Occluder>>(game_.sceneManager->GetWorld());
+
         renderQueue[RenderQueueType::OPAQUE] = std::make_unique<RenderQueue>();
+        renderQueue[RenderQueueType::OPAQUE]->type = RenderQueueType::OPAQUE;
         renderQueue[RenderQueueType::OPAQUE]->pipeline = std::make_unique<RenderPipeline>(device);
 
         renderQueue[RenderQueueType::LIGHT] = std::make_unique<RenderQueue>();
+        renderQueue[RenderQueueType::LIGHT]->type = RenderQueueType::LIGHT;
         renderQueue[RenderQueueType::LIGHT]->pipeline = std::make_unique<RenderPipeline>(device);
 
         createRenderPass(renderQueue[RenderQueueType::OPAQUE]->pipeline->configInfo.renderPass);
@@ -97,16 +108,32 @@ namespace VoidEngine
         createPipelineLayout(*renderQueue[RenderQueueType::OPAQUE], setLayoutLight->getDescriptorSetLayout());
 
         renderQueue[RenderQueueType::OPAQUE]->pipeline->CreateGraphicsPipeline("Shaders/Simple_shader.vert.spv", "Shaders/Simple_shader.frag.spv");
+        renderQueue[RenderQueueType::OPAQUE]->packedPipeline = std::make_unique<RenderPipeline>(device, Model::VertexFormat::PACKED);
+        renderQueue[RenderQueueType::OPAQUE]->packedPipeline->configInfo.renderPass = renderQueue[RenderQueueType::OPAQUE]->pipeline->configInfo.renderPass;
+        renderQueue[RenderQueueType::OPAQUE]->packedPipeline->CreateGraphicsPipeline("Shaders/Simple_shader_packed.vert.spv", "Shaders/Simple_shader.frag.spv");
         //renderQueue[RenderQueueType::OPAQUE]->pipeline->CreateGraphicsPipeline("Shaders/Simple_Flat.vert.spv", "Shaders/Simple_Flat.frag.spv");
         renderQueue[RenderQueueType::LIGHT]->pipeline->CreateGraphicsPipeline("Shaders/Point_Light.vert.spv", "Shaders/Point_Light.frag.spv");
 
+        for (const auto& [type, queue] : renderQueue)
+        {
+            for (const RenderPipeline* pipeline : {queue->pipeline.get(), queue->packedPipeline.get()})
+            {
+                if (pipeline == nullptr) continue;
+                game_.fileWatcher->Watch(pipeline->GetVertShaderPath());
+                game_.fileWatcher->Watch(pipeline->GetFragShaderPath());
+            }
+        }
+
         swapChain_ = std::make_unique<SwapChain>(device_, resolution, FindDepthFormat(device_));
 
         createFrameBuffers(device, *swapChain_, renderQueue[RenderQueueType::OPAQUE]->pipeline->configInfo.renderPass);
         createFrameBuffers(device, *swapChain_, renderQueue[RenderQueueType::LIGHT]->pipeline->configInfo.renderPass);
 
-        allocateDescriptorSet(setLayoutOpaque->getDescriptorSetLayout(), renderQueue[RenderQueueType::OPAQUE]->descriptorSet);
-        allocateDescriptorSet(setLayoutLight->getDescriptorSetLayout(), renderQueue[RenderQueueType::LIGHT]->descriptorSet);
+        for (uint32_t frame = 0; frame < SwapChain::MAX_FRAMES_IN_FLIGHT; frame++)
+        {
+            allocateDescriptorSet(setLayoutOpaque->getDescriptorSetLayout(), renderQueue[RenderQueueType::OPAQUE]->descriptorSets[frame]);
+            allocateDescriptorSet(setLayoutLight->getDescriptorSetLayout(), renderQueue[RenderQueueType::LIGHT]->descriptorSets[frame]);
+        }
 
         allocateCommandBuffers(commandBuffer);
     }
@@ -128,6 +155,97 @@ namespace VoidEngine
         */
 
         //vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+
+        for (auto& rebuild : pipelineRebuilds)
+        {
+            try
+            {
+                vkDestroyPipeline(device.device(), rebuild.result.get(), nullptr);
+            } catch (const std::exception&)
+            {
+                // Failed, nothing was created
+            }
+        }
+        retiredPipelines.Clear([this](VkPipeline pipeline) { vkDestroyPipeline(device.device(), pipeline, nullptr); });
+    }
+
+    void RenderManager::ReloadShaders(const std::string& filepath)
+    {
+        const auto requested = std::chrono::steady_clock::now();
+
+        for (const auto& [type, queue] : renderQueue)
+        {
+            for (RenderPipeline* pipeline : {queue->pipeline.get(), queue->packedPipeline.get()})
+            {
+                if (pipeline == nullptr || !pipeline->UsesShader(filepath)) continue;
+
+                // The running rebuild may have read the file before this write, it is rebuilt again once done
+                const auto it = std::find_if(pipelineRebuilds.begin(), pipelineRebuilds.end(), [&](const PipelineRebuild& rebuild)
+                {
+                    return rebuild.pipeline == pipeline;
+                });
+                if (it != pipelineRebuilds.end())
+                {
+                    it->again = true;
+                    continue;
+                }
+                startRebuild(pipeline, requested);
+            }
+        }
+    }
+
+    void RenderManager::startRebuild(RenderPipeline* pipeline, std::chrono::steady_clock::time_point requested)
+    {
+        auto task = std::make_shared<std::packaged_task<VkPipeline()>>([pipeline]()
+        {
+            return pipeline->Rebuild();
+        });
+        pipelineRebuilds.push_back({pipeline, task->get_future(), requested});
+        ThreadPool::getInstance().submit([task]()
+        {
+            (*task)();
+        });
+    }
+
+    void RenderManager::EndFrame()
+    {
+        frameNumber++;
+
+        const auto now = std::chrono::steady_clock::now();
+        std::vector<RenderPipeline*> restarted;
+        for (auto it = pipelineRebuilds.begin(); it != pipelineRebuilds.end();)
+        {
+            if (it->result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                ++it;
+                continue;
+            }
+
+            try
+            {
+                // Recorded from the next frame on, the frames in flight keep the old one until it is destroyed below
+                retiredPipelines.Retire(it->pipeline->ReplacePipeline(it->result.get()), frameNumber);
+                std::cerr << "Reloaded " << it->pipeline->GetVertShaderPath() << " and " << it->pipeline->GetFragShaderPath()
+                    << " in " << std::chrono::duration<double, std::milli>(now - it->requested).count() << " ms.\n";
+            } catch (const std::exception& e)
+            {
+                std::cerr << "Failed to reload " << it->pipeline->GetVertShaderPath() << " and "
+                    << it->pipeline->GetFragShaderPath() << ": " << e.what() << "\n";
+            }
+
+            if (it->again) restarted.push_back(it->pipeline);
+            it = pipelineRebuilds.erase(it);
+        }
+
+        for (RenderPipeline* pipeline : restarted)
+        {
+            startRebuild(pipeline, now);
+        }
+
+        retiredPipelines.Collect(frameNumber, [this](VkPipeline pipeline)
+        {
+            vkDestroyPipeline(device.device(), pipeline, nullptr);
+        });
     }
 
     void RenderManager::createPipelineLayout(RenderQueue& renderQueue, VkDescriptorSetLayout layout)
@@ -146,7 +264,10 @@ namespace VoidEngine
         {
             glfwWaitEvents();
         }
-        vkDeviceWaitIdle(device.device());
+        {
+            auto queueLock = device.lockQueues();
+            vkDeviceWaitIdle(device.device());
+        }
 
         if (swapChain_ == nullptr)
         {
@@ -168,13 +289,13 @@ namespace VoidEngine
         // Set up pool sizes for types of descriptors (e.g., uniform buffers)
         VkDescriptorPoolSize poolSize{};
         poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        poolSize.descriptorCount = static_cast<int>(RenderQueueType::COUNT);
+        poolSize.descriptorCount = static_cast<int>(RenderQueueType::COUNT) * SwapChain::MAX_FRAMES_IN_FLIGHT;
 
         VkDescriptorPoolCreateInfo poolInfo{};
         poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
         poolInfo.poolSizeCount = 1;
         poolInfo.pPoolSizes = &poolSize;
-        poolInfo.maxSets = static_cast<int>(RenderQueueType::COUNT);
+        poolInfo.maxSets = static_cast<int>(RenderQueueType::COUNT) * SwapChain::MAX_FRAMES_IN_FLIGHT;
 
         vkCreateDescriptorPool(device.device(), &poolInfo, nullptr, &descriptorPool);
     }
@@ -190,10 +311,10 @@ namespace VoidEngine
         vkAllocateDescriptorSets(device.device(), &allocInfo, &descriptorSet);
     }
 
-    void RenderManager::UpdateDescriptorSet(VkDescriptorSet destSet, const std::vector<std::unique_ptr<Buffer>>& uboBuffers, uint32_t currentFrame) const
+    void RenderManager::UpdateDescriptorSet(VkDescriptorSet destSet, const std::vector<std::unique_ptr<Buffer>>& uboBuffers, uint32_t frame) const
     {
         VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = uboBuffers[currentFrame]->getBuffer();  // Your uniform buffer handle
+        bufferInfo.buffer = uboBuffers[frame]->getBuffer();  // Your uniform buffer handle
         bufferInfo.offset = 0;
         bufferInfo.range = sizeof(GlobalUbo);
 
@@ -213,52 +334,302 @@ namespace VoidEngine
     {
         if (queue.pipeline == nullptr) return;
 
-        //queue.pipeline->bind(commandBuffer);
+        const Camera* camera = queue.camera != nullptr ? queue.camera : game_.mainCamera;
+        const Material* defaultMaterial = game_.materialManager->GetDefault().get();
+
+        drawCandidates.clear();
+        candidateSpheres.Clear();
+        drawItems.clear();
+        drawTransforms.clear();
+
+        // Straight over the World's component arrays, no GameObject is touched
+        const uint32_t queueBit = 1u << static_cast<uint32_t>(queue.type);
+        drawQuery->ForEach([&](const WorldMatrix& worldMatrix, const MeshRenderer& meshRenderer, const RenderQueueMember& member)
+        {
+            if ((member.queues & queueBit) == 0) return;
+            // Still streaming in, nothing of it may be read before it is resident
+            if (meshRenderer.model == nullptr || !meshRenderer.model->IsResident()) return;
+
+            RenderPipeline* pipeline = queue.pipeline.get();
+            if (meshRenderer.model->vertexFormat == Model::VertexFormat::PACKED)
+            {
+                if (queue.packedPipeline == nullptr) return;
+                pipeline = queue.packedPipeline.get();
+            }
+            drawCandidates.push_back({&worldMatrix, meshRenderer.model.get(), pipeline});
+
+            // The model's sphere in world space, scaled by the largest axis of the transform
+            const glm::mat4& modelMatrix = worldMatrix.model;
+            const glm::vec4& sphere = meshRenderer.model->boundingSphere;
+            const float scale = std::max({glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])),
+                glm::length(glm::vec3(modelMatrix[2]))});
+            candidateSpheres.Push(modelMatrix * glm::vec4(glm::vec3(sphere), 1.0f), sphere.w * scale);
+        });
+
+        candidateVisible.assign(drawCandidates.size(), 1);
+        if (camera != nullptr)
+        {
+            const glm::mat4 viewProjection = camera->getProjection() * camera->getView();
+            const Frustum frustum = Frustum::FromViewProjection(viewProjection);
+            const size_t visibleCount = FrustumCuller::Cull(frustum, candidateSpheres, candidateVisible.data());
+            stats.frustumVisible += static_cast<uint32_t>(visibleCount);
+            stats.frustumCulled += static_cast<uint32_t>(drawCandidates.size() - visibleCount);
+
+            if (occlusionCulling && visibleCount > 0)
+            {
+                occlusionCuller.BeginFrame(viewProjection);
+                occluderQuery->ForEach([this](const WorldMatrix& worldMatrix, const Occluder& occluder)
+                {
+                    if (occluder.mesh != nullptr) occlusionCuller.AddOccluder(*occluder.mesh, worldMatrix.model);
+                });
+
+                if (occlusionCuller.GetOccluderTriangleCount() > 0)
+                {
+                    occlusionCuller.Rasterize();
+                    for (size_t candidateIndex = 0; candidateIndex < drawCandidates.size(); candidateIndex++)
+                    {
+                        if (!candidateVisible[candidateIndex]) continue;
+
+                        const glm::vec3 center{candidateSpheres.x[candidateIndex], candidateSpheres.y[candidateIndex],
+                            candidateSpheres.z[candidateIndex]};
+                        if (occlusionCuller.IsVisible(Aabb::FromSphere(center, candidateSpheres.radius[candidateIndex]))) continue;
+
+                        candidateVisible[candidateIndex] = 0;
+                        stats.occlusionCulled++;
+                    }
+                }
+            }
+        } else
+        {
+            stats.frustumVisible += static_cast<uint32_t>(drawCandidates.size());
+        }
+
+        for (size_t candidateIndex = 0; candidateIndex < drawCandidates.size(); candidateIndex++)
+        {
+            if (!candidateVisible[candidateIndex]) continue;
+            const DrawCandidate& candidate = drawCandidates[candidateIndex];
+
+            const Model& model = *candidate.model;
+            RenderPipeline* pipeline = candidate.pipeline;
+            const uint64_t pipelineKey = static_cast<uint64_t>(pipeline == queue.packedPipeline.get()) << 32;
+            // Computed by the SceneManager's TransformSystem when the Transform last changed
+            const glm::mat4& modelMatrix = candidate.worldMatrix->model;
+            const glm::mat4& normalMatrix = candidate.worldMatrix->normal;
+
+            auto addTransform = [&](const glm::mat4& nodeMatrix, const glm::mat4& nodeNormalMatrix)
+            {
+                // Packed positions are relative to the model bounds, the dequantization rides along in the model matrix
+                drawTransforms.push_back({modelMatrix * nodeMatrix * model.GetDequantizeMatrix(), normalMatrix * nodeNormalMatrix});
+                return static_cast<uint32_t>(drawTransforms.size() - 1);
+            };
+
+            auto addDraw = [&](uint32_t transform, uint32_t material, uint32_t firstIndex, uint32_t count, int32_t vertexOffset)
+            {
+                const Material* drawMaterial = material < model.materialHandles.size() ? model.materialHandles[material].get() : defaultMaterial;
+                drawItems.push_back({pipelineKey | drawMaterial->GetId(), &model, pipeline, drawMaterial, transform,
+                    firstIndex, count, vertexOffset});
+            };
 
+            if (!model.nodes.empty())
+            {
+                // Imported scene: one draw per submesh of every node, with the node transform applied
+                for (const auto& node : model.nodes)
+                {
+                    if (node.submeshCount == 0) continue;
+
+                    const uint32_t transform = addTransform(node.worldMatrix, node.normalMatrix);
+                    for (uint32_t i = node.firstSubmesh; i < node.firstSubmesh + node.submeshCount; i++)
+                    {
+                        const auto& submesh = model.submeshes[i];
+                        addDraw(transform, submesh.material, submesh.firstIndex, submesh.indexCount, submesh.vertexOffset);
+                    }
+                }
+                stats.objects++;
+                stats.objectsPerLod[0]++;
+                continue;
+            }
+
+            const uint32_t transform = addTransform(glm::mat4{1.0f}, glm::mat4{1.0f});
+            if (!model.lods.empty())
+            {
+                const uint32_t lodIndex = camera != nullptr ? selectLod(model, modelMatrix, *camera) : 0;
+                const auto& lod = model.lods[lodIndex];
+                stats.objectsPerLod[std::min<size_t>(lodIndex, RenderStats::MAX_LODS - 1)]++;
+
+                const bool cullMeshlets = lodIndex == 0 && meshletCulling && camera != nullptr && !model.meshlets.empty();
+                glm::mat4 modelViewProjection{1.0f};
+                glm::vec3 cameraPosition{0.0f};
+                // Cones only say which faces point away, they can skip them only if the rasterizer would
+                const bool cullBackfaces = (pipeline->configInfo.rasterizationInfo.cullMode & VK_CULL_MODE_BACK_BIT) != 0;
+                if (cullMeshlets)
+                {
+                    modelViewProjection = camera->getProjection() * camera->getView() * modelMatrix;
+                    cameraPosition = glm::inverse(modelMatrix) * camera->getInverseView()[3];
+                }
+
+                for (uint32_t i = lod.firstSubmesh; i < lod.firstSubmesh + lod.submeshCount; i++)
+                {
+                    const auto& submesh = model.submeshes[i];
+                    if (!cullMeshlets || submesh.meshletCount == 0)
+                    {
+                        if (submesh.indexCount > 0)
+                        {
+                            addDraw(transform, submesh.material, submesh.firstIndex, submesh.indexCount, submesh.vertexOffset);
+                        }
+                        continue;
+                    }
+
+                    visibleRanges.clear();
+                    MeshletCuller::Cull(model.meshlets.data() + submesh.firstMeshlet, submesh.meshletCount,
+                        modelViewProjection, cameraPosition, cullBackfaces, visibleRanges, stats.meshlets);
+                    for (const auto& range : visibleRanges)
+                    {
+                        addDraw(transform, submesh.material, range.firstIndex, range.indexCount, submesh.vertexOffset);
+                    }
+                }
+            } else
+            {
+                addDraw(transform, Model::Submesh::NO_MATERIAL, 0, model.hasIndexBuffer ? model.indexCount : model.vertexCount, 0);
+                stats.objectsPerLod[0]++;
+            }
+            stats.objects++;
+        }
+
+        // Within a mesh, draws of the same transform stay together so it is pushed once
+        std::sort(drawItems.begin(), drawItems.end(), [](const DrawItem& a, const DrawItem& b)
+        {
+            if (a.sortKey != b.sortKey) return a.sortKey < b.sortKey;
+            if (a.model != b.model) return std::less<const Model*>{}(a.model, b.model);
+            if (a.transform != b.transform) return a.transform < b.transform;
+            return a.firstIndex < b.firstIndex;
+        });
+
+        // Set 0 is the same for every pipeline of the queue, and their layouts are compatible, so it stays bound
         vkCmdBindDescriptorSets(
             cmdBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             queue.pipeline->configInfo.pipelineLayout,
             0,
             1,
-            &queue.descriptorSet,
+            &queue.descriptorSets[swapChain_->GetCurrentFrame()],
             0,
             nullptr);
 
-        for (auto& id : queue.gameObjectIDs)
+        RenderPipeline* boundPipeline = nullptr;
+        const Material* boundMaterial = nullptr;
+        const Model* boundModel = nullptr;
+        uint32_t pushedTransform = UINT32_MAX;
+
+        for (const auto& item : drawItems)
         {
-            auto obj = game_.sceneManager->FindGameObject(id);
-            if (obj->model == nullptr) continue;
-            SimplePushConstantData push{};
-            push.modelMatrix = obj->transform.mat4();
-            push.normalMatrix = obj->transform.normalMatrix();
-
-            vkCmdPushConstants(
-                cmdBuffer,
-                queue.pipeline->configInfo.pipelineLayout,
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                0,
-                sizeof(SimplePushConstantData),
-                &push);
-
-            VkBuffer buffers[] = {obj->model->vertexBuffer->getBuffer()};
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(cmdBuffer, 0, 1, buffers, offsets);
-
-            if (obj->model->hasIndexBuffer)
+            const VkPipelineLayout layout = item.pipeline->configInfo.pipelineLayout;
+
+            if (item.pipeline != boundPipeline)
             {
-                vkCmdBindIndexBuffer(cmdBuffer, obj->model->indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-                vkCmdDrawIndexed(cmdBuffer, obj->model->indexCount, 1, 0, 0, 0);
+                item.pipeline->bind(cmdBuffer);
+                boundPipeline = item.pipeline;
+                stats.pipelineBinds++;
+            }
+
+            if (item.material != boundMaterial)
+            {
+                const VkDescriptorSet materialSet = item.material->GetDescriptorSet();
+                vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, Material::DESCRIPTOR_SET, 1,
+                    &materialSet, 0, nullptr);
+                boundMaterial = item.material;
+                stats.materialBinds++;
+            }
+
+            if (item.model != boundModel)
+            {
+                VkBuffer buffers[] = {item.model->vertexBuffer->getBuffer()};
+                VkDeviceSize offsets[] = {0};
+                vkCmdBindVertexBuffers(cmdBuffer, 0, 1, buffers, offsets);
+
+                // Only read by pipelines that declare the tangent stream
+                if (item.model->tangentBuffer)
+                {
+                    VkBuffer tangentBuffers[] = {item.model->tangentBuffer->getBuffer()};
+                    vkCmdBindVertexBuffers(cmdBuffer, Model::PackedTangent::BINDING, 1, tangentBuffers, offsets);
+                }
+
+                if (item.model->hasIndexBuffer)
+                {
+                    vkCmdBindIndexBuffer(cmdBuffer, item.model->indexBuffer->getBuffer(), 0, item.model->indexType);
+                }
+                boundModel = item.model;
+                stats.meshBinds++;
+            }
+
+            if (item.transform != pushedTransform)
+            {
+                const DrawTransform& transform = drawTransforms[item.transform];
+                SimplePushConstantData push{};
+                push.modelMatrix = transform.modelMatrix;
+                push.normalMatrix = transform.normalMatrix;
+
+                vkCmdPushConstants(
+                    cmdBuffer,
+                    layout,
+                    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                    0,
+                    sizeof(SimplePushConstantData),
+                    &push);
+                pushedTransform = item.transform;
+                stats.transformPushes++;
+            }
+
+            if (item.model->hasIndexBuffer)
+            {
+                vkCmdDrawIndexed(cmdBuffer, item.count, 1, item.firstIndex, item.vertexOffset, 0);
             } else
             {
-                vkCmdDraw(cmdBuffer, obj->model->vertexCount, 1, 0, 0);
+                vkCmdDraw(cmdBuffer, item.count, 1, 0, 0);
             }
+            stats.drawCalls++;
+            stats.triangles += item.count / 3;
         }
     }
 
+    uint32_t RenderManager::selectLod(const Model& model, const glm::mat4& modelMatrix, const Camera& camera) const
+    {
+        // Bounding sphere of the model bounds, scaled by the largest axis of the transform
+        const glm::vec3 center = (model.boundsMin + model.boundsMax) * 0.5f;
+        const float scale = std::max({glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])),
+            glm::length(glm::vec3(modelMatrix[2]))});
+        const float radius = glm::length(model.boundsMax - model.boundsMin) * 0.5f * scale;
+
+        const glm::vec3 viewCenter = camera.getView() * modelMatrix * glm::vec4(center, 1.0f);
+        const float distance = glm::length(viewCenter);
+        if (distance <= radius) return 0;
+
+        // Projected diameter over the viewport height, both in NDC units
+        const float screenSize = radius * std::abs(camera.getProjection()[1][1]) / distance;
+
+        const auto coarser = static_cast<uint32_t>(std::count_if(lodThresholds.begin(), lodThresholds.end(),
+            [screenSize](float threshold) { return screenSize < threshold; }));
+        return std::min(coarser, static_cast<uint32_t>(model.lods.size() - 1));
+    }
+
+    void RenderManager::SetLodThresholds(std::vector<float> thresholds)
+    {
+        std::sort(thresholds.begin(), thresholds.end(), std::greater<>());
+        lodThresholds = std::move(thresholds);
+    }
+
+    void RenderManager::SetFramesInFlight(uint32_t count)
+    {
+        swapChain_->SetFramesInFlight(count);
+    }
+
     void RenderManager::AddToRenderQueue(const GameObject& gameObject, RenderQueueType queueType)
     {
         renderQueue[queueType]->AddToQueue(gameObject);
+
+        World& world = game_.sceneManager->GetWorld();
+        const uint32_t queues = world.Has<RenderQueueMember>(gameObject.GetEntity())
+            ? world.Get<RenderQueueMember>(gameObject.GetEntity())->queues : 0;
+        world.Add(gameObject.GetEntity(), RenderQueueMember{queues | 1u << static_cast<uint32_t>(queueType)});
     }
 
     VkFormat RenderManager::FindDepthFormat(Device& device)
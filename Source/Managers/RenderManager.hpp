@@ -1,11 +1,20 @@
 #pragma once
 #include <complex.h>
+#include <array>
+#include <chrono>
+#include <future>
 #include <memory>
 #include <optional>
 
 #include "Buffer.hpp"
 #include "Camera.hpp"
+#include "FrustumCuller.hpp"
+#include "MeshletCuller.hpp"
+#include "OcclusionCuller.hpp"
+#include "RetireQueue.hpp"
+#include "SlotMap.hpp"
 #include "SwapChain.hpp"
+#include "World.hpp"
 #include "../Core/Device.hpp"
 #include "../Core/RenderPipeline.hpp"
 #include "Common.hpp"
@@ -15,6 +24,10 @@ namespace VoidEngine
     // Forward declerations
     class Game;
     class GameObject;
+    class Material;
+    class Model;
+    struct MeshRenderer;
+    struct WorldMatrix;
 
     /*
     enum class RenderQueueType
@@ -39,22 +52,55 @@ namespace VoidEngine
         COUNT
     };
 
+    // Which render queues an entity is drawn in, one bit per RenderQueueType
+    struct RenderQueueMember
+    {
+        uint32_t queues = 0;
+    };
+
     struct RenderQueue
     {
         RenderQueue() = default;
         ~RenderQueue() = default;
 
+        RenderQueueType type = RenderQueueType::OPAQUE;
         Camera* camera = nullptr;
-        std::vector<unsigned int> gameObjectIDs;
+        // Handles of the objects added, stale once an object is removed from the scene
+        std::vector<SlotHandle> gameObjects;
 
-        VkDescriptorSet descriptorSet;
+        // One per frame slot, each pointing at that slot's uniform buffer, so a frame still on the GPU keeps its own
+        std::array<VkDescriptorSet, SwapChain::MAX_FRAMES_IN_FLIGHT> descriptorSets{};
 
         std::unique_ptr<RenderPipeline> pipeline;
+        // Same pass and shading as `pipeline`, for models uploaded with Model::VertexFormat::PACKED
+        std::unique_ptr<RenderPipeline> packedPipeline;
 
         void AddToQueue(const GameObject& gameObject);
 
-        unsigned int GetNumObjects() const { return gameObjectIDs.size(); }
-        void SetDescriptor(VkDescriptorSet ds) { descriptorSet = ds; }
+        unsigned int GetNumObjects() const { return gameObjects.size(); }
+        void SetDescriptor(uint32_t frame, VkDescriptorSet ds) { descriptorSets[frame] = ds; }
+    };
+
+    // Counters of what RenderManager::RenderObjectsInQueue() recorded
+    struct RenderStats
+    {
+        static constexpr size_t MAX_LODS = 8;
+
+        uint32_t objects = 0;
+        uint32_t drawCalls = 0;
+        uint64_t triangles = 0;
+        // State changes between draws, which are sorted so each happens once per group
+        uint32_t pipelineBinds = 0;
+        uint32_t materialBinds = 0;
+        uint32_t meshBinds = 0;     // Vertex and index buffers
+        uint32_t transformPushes = 0;
+        uint32_t objectsPerLod[MAX_LODS]{}; // The last entry also counts any coarser levels
+        MeshletCuller::Stats meshlets{};
+        // Objects tested against the camera frustum before any draw is recorded for them
+        uint32_t frustumVisible = 0;
+        uint32_t frustumCulled = 0;
+        // Of the frustum visible ones, hidden behind occluders
+        uint32_t occlusionCulled = 0;
     };
 
     class RenderManager
@@ -70,6 +116,10 @@ namespace VoidEngine
         //RenderManager(RenderManager&&) noexcept = default;
         //RenderManager& operator=(RenderManager&&) noexcept = default;
 
+        // Records every resident object of the queue inside the camera frustum and not hidden by an Occluder.
+        // Bounding spheres are culled in one batch first, then tested against the occluders. The draws left are
+        // gathered and recorded sorted by pipeline, then material, then mesh, so pipelines, material sets and
+        // vertex/index buffers are bound once per group instead of once per object.
         VOIDENGINE_API void RenderObjectsInQueue(const RenderQueue& queue, VkCommandBuffer cmdBuffer);
         VOIDENGINE_API void AddToRenderQueue(const GameObject& gameObject, RenderQueueType queueType);
 
@@ -78,11 +128,44 @@ namespace VoidEngine
         float GetAspectRatio() const { return swapChain_->extentAspectRatio(); }
         SwapChain& GetSwapChain() const { return *swapChain_; }
         VkCommandBuffer& GetQueueCommandBuffer(RenderQueueType queue) { return commandBuffer; }
-        void UpdateDescriptorSet(VkDescriptorSet destSet, const std::vector<std::unique_ptr<Buffer>> &uboBuffers, uint32_t currentFrame) const;
-        VkDescriptorSet GetDescriptorSet(RenderQueueType queue) { return renderQueue[queue]->descriptorSet; }
+        // Points the set at the uniform buffer of frame slot `frame`. Once per slot, not while a frame uses the set.
+        void UpdateDescriptorSet(VkDescriptorSet destSet, const std::vector<std::unique_ptr<Buffer>> &uboBuffers, uint32_t frame) const;
+        VkDescriptorSet GetDescriptorSet(RenderQueueType queue, uint32_t frame) { return renderQueue[queue]->descriptorSets[frame]; }
         RenderQueue& GetRenderQueue(const RenderQueueType queue) const { return *renderQueue.at(queue); }
         std::vector<VkFramebuffer>& GetFramebuffers() { return framebuffers; }
 
+        // Screen sizes, as the fraction of the viewport height an object's bounding sphere covers, below which
+        // the next coarser LOD is drawn. An object uses LOD n when n thresholds are larger than its size, so
+        // {0.5, 0.25, 0.125} switches to LOD 1 at half the screen height and so on. Sorted on assignment.
+        VOIDENGINE_API void SetLodThresholds(std::vector<float> thresholds);
+        const std::vector<float>& GetLodThresholds() const { return lodThresholds; }
+
+        // Frames the CPU may record ahead of the GPU, SwapChain::DEFAULT_FRAMES_IN_FLIGHT until set. More hide GPU
+        // stalls at the cost of latency. Kept when the swap chain is recreated, call it between frames.
+        VOIDENGINE_API void SetFramesInFlight(uint32_t count);
+        uint32_t GetFramesInFlight() const { return swapChain_->GetFramesInFlight(); }
+
+        // Culls the meshlets of objects drawn at full detail, on by default
+        void SetMeshletCulling(bool enabled) { meshletCulling = enabled; }
+        bool IsMeshletCullingEnabled() const { return meshletCulling; }
+
+        // Skips objects hidden behind entities with an Occluder component, on by default. The occluders are
+        // rasterized on the CPU for every RenderObjectsInQueue() call.
+        void SetOcclusionCulling(bool enabled) { occlusionCulling = enabled; }
+        bool IsOcclusionCullingEnabled() const { return occlusionCulling; }
+
+        // Rebuilds the pipelines created from the SPIR-V file `filepath` on a worker thread. They are swapped in by
+        // the EndFrame() after the rebuild finished, a failed one keeps the old pipeline.
+        VOIDENGINE_API void ReloadShaders(const std::string& filepath);
+
+        // Call once per frame after submitting it. Swaps in rebuilt pipelines and destroys the ones replaced
+        // SwapChain::MAX_FRAMES_IN_FLIGHT frames ago.
+        VOIDENGINE_API void EndFrame();
+
+        // Accumulated until ResetStats(), which the game loop calls at the start of every frame
+        const RenderStats& GetStats() const { return stats; }
+        void ResetStats() { stats = {}; }
+
     private:
         void allocateCommandBuffers(VkCommandBuffer& commandBuffer);
         void createRenderPass(VkRenderPass& renderPass, VkFormat imageFormat = VK_FORMAT_B8G8R8A8_UNORM);
@@ -90,6 +173,7 @@ namespace VoidEngine
         void createSwapChain(VkFormat depthFormat, VkRenderPass renderPass, VkExtent2D extent);
         void createDescriptorSetPool();
         void allocateDescriptorSet(VkDescriptorSetLayout layout, VkDescriptorSet& decriptorSet);
+        uint32_t selectLod(const Model& model, const glm::mat4& modelMatrix, const Camera& camera) const;
 
         Game& game_;
         Device& device;
@@ -102,5 +186,65 @@ namespace VoidEngine
 
         std::unique_ptr<SwapChain> swapChain_{};
         VkCommandBuffer commandBuffer;
+
+        std::vector<float> lodThresholds{0.5f, 0.25f, 0.125f};
+        RenderStats stats{};
+
+        struct DrawTransform
+        {
+            glm::mat4 modelMatrix;
+            glm::mat4 normalMatrix;
+        };
+
+        // Resident object of the queue, drawn if its bounding sphere passes the frustum test
+        struct DrawCandidate
+        {
+            const WorldMatrix* worldMatrix;
+            const Model* model;
+            RenderPipeline* pipeline;
+        };
+
+        struct DrawItem
+        {
+            uint64_t sortKey;           // Pipeline in the high bits, material id in the low ones
+            const Model* model;
+            RenderPipeline* pipeline;
+            const Material* material;
+            uint32_t transform;         // Into drawTransforms
+            uint32_t firstIndex;
+            uint32_t count;             // Indices, or vertices when the model has no index buffer
+            int32_t vertexOffset;
+        };
+
+        struct PipelineRebuild
+        {
+            RenderPipeline* pipeline;
+            std::future<VkPipeline> result;
+            std::chrono::steady_clock::time_point requested;
+            bool again = false;         // A shader changed again after the rebuild had started
+        };
+
+        void startRebuild(RenderPipeline* pipeline, std::chrono::steady_clock::time_point requested);
+
+        std::vector<PipelineRebuild> pipelineRebuilds;
+        RetireQueue<VkPipeline> retiredPipelines;
+        uint64_t frameNumber = 0;
+
+        bool meshletCulling = true;
+        std::vector<MeshletCuller::Range> visibleRanges;
+
+        bool occlusionCulling = true;
+        OcclusionCuller occlusionCuller;
+
+        // Entities with something to draw, matched against the World once per new archetype
+        std::unique_ptr<Query<const WorldMatrix, const MeshRenderer, const RenderQueueMember>> drawQuery;
+        std::unique_ptr<Query<const WorldMatrix, const Occluder>> occluderQuery;
+
+        // Reused every frame
+        std::vector<DrawCandidate> drawCandidates;
+        SphereSoA candidateSpheres;
+        std::vector<uint8_t> candidateVisible;
+        std::vector<DrawItem> drawItems;
+        std::vector<DrawTransform> drawTransforms;
     };
 }
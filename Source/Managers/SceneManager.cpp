@@ -4,30 +4,104 @@
 #include <iostream>
 
 namespace VoidEngine {
-    void SceneManager::AddGameObject(std::unique_ptr<GameObject> gameObject)
+    SlotHandle SceneManager::AddGameObject(std::unique_ptr<GameObject> gameObject)
     {
         assert(gameObject != nullptr && "Invalid GameObject passed to AddGameObject.");
 
-        auto id = gameObject->getId();
-
-        if (gameObjects_.contains(id))
+        if (!gameObject->handle.IsNull())
         {
-            throw std::runtime_error("GameObject with the same ID already exists.");
+            throw std::runtime_error("GameObject was already added to the scene.");
         }
 
+        GameObject* object = gameObject.get();
         try
         {
-            gameObjects_.emplace(id, std::move(gameObject));
+            object->handle = gameObjects_.Insert(std::move(gameObject));
         } catch (const std::exception &e)
         {
             std::cerr << "Exception in SceneManager::AddGameObject: " << e.what() << "\n";
             throw;
         }
+        return object->handle;
+    }
+
+    bool SceneManager::RemoveGameObject(SlotHandle handle)
+    {
+        if (!updating) return gameObjects_.Remove(handle);
+
+        if (!gameObjects_.Contains(handle)) return false;
+        pendingRemovals.push_back(handle);
+        return true;
+    }
+
+    void SceneManager::applyRemovals()
+    {
+        // Removing an object twice during the update is harmless, the second handle is stale by then
+        for (const SlotHandle handle : pendingRemovals) gameObjects_.Remove(handle);
+        pendingRemovals.clear();
+    }
+
+    GameObject* SceneManager::FindGameObject(SlotHandle handle)
+    {
+        auto* gameObject = gameObjects_.Get(handle);
+        return gameObject != nullptr ? gameObject->get() : nullptr;
+    }
+
+    void SceneManager::Update()
+    {
+        updating = true;
+        try
+        {
+            updateObjects();
+        } catch (...)
+        {
+            updating = false;
+            applyRemovals();
+            throw;
+        }
+        updating = false;
+        applyRemovals();
+
+        transformSystem.Update();
+        spatialIndex.Update();
     }
 
-    GameObject* SceneManager::FindGameObject(unsigned int id)
+    void SceneManager::updateObjects()
     {
-        auto it = gameObjects_.find(id);
-        return it != gameObjects_.end() ? it->second.get() : nullptr;
+        // Collected first, the World doesn't allow structural changes while a query iterates
+        updateList.clear();
+        gameObjectQuery.ForEach([this](const GameObjectRef& ref) { updateList.push_back(ref.object); });
+
+        for (GameObject* gameObject : updateList)
+        {
+            gameObject->Update();
+        }
+
+        // Again, Update() may have added or removed objects
+        updateList.clear();
+        gameObjectQuery.ForEach([this](const GameObjectRef& ref) { updateList.push_back(ref.object); });
+
+        ThreadPool& pool = ThreadPool::getInstance();
+        while (commandBuffers.size() < pool.getConcurrency()) commandBuffers.emplace_back(world);
+
+        // Structural changes throw instead of racing with the other threads while the phase runs
+        world.BeginIteration();
+        try
+        {
+            pool.parallelFor(updateList.size(), [this, &pool](size_t i)
+            {
+                updateList[i]->ParallelUpdate(commandBuffers[pool.getThreadIndex()]);
+            });
+        } catch (...)
+        {
+            world.EndIteration();
+            throw;
+        }
+        world.EndIteration();
+
+        for (auto& commands : commandBuffers)
+        {
+            commands.Apply();
+        }
     }
 } // VoidEngine
\ No newline at end of file
@@ -1,5 +1,11 @@
 #pragma once
+#include "GameObject.hpp"
 #include "RenderManager.hpp"
+#include "SlotMap.hpp"
+#include "SpatialIndex.hpp"
+#include "ThreadPool.hpp"
+#include "TransformSystem.hpp"
+#include "World.hpp"
 
 namespace VoidEngine
 {
@@ -9,9 +15,26 @@ namespace VoidEngine
         VOIDENGINE_API SceneManager() = default;
         VOIDENGINE_API ~SceneManager() = default;
 
-        VOIDENGINE_API void AddGameObject(std::unique_ptr<GameObject> gameObject);
+        // Takes ownership and returns the object's handle, also available from GameObject::GetHandle().
+        // Throws std::runtime_error if the object was already added.
+        VOIDENGINE_API SlotHandle AddGameObject(std::unique_ptr<GameObject> gameObject);
+        // Destroys the object, returns false if the handle is stale. During Update() the object is only destroyed
+        // once every object has been updated, so objects may remove themselves and each other; until then it is
+        // still found and updated.
+        VOIDENGINE_API bool RemoveGameObject(SlotHandle handle);
 
-        VOIDENGINE_API GameObject* FindGameObject(unsigned int id);
+        // nullptr for stale handles, including those of removed objects whose slot was reused
+        VOIDENGINE_API GameObject* FindGameObject(SlotHandle handle);
+
+        // Calls Update() on every GameObject, then ParallelUpdate() spread over the ThreadPool and applies the
+        // command buffers they recorded into, thread by thread. Then recomputes the WorldMatrix of the transforms
+        // that changed and brings the SpatialIndex up to date. Update() may add or remove components and objects,
+        // ParallelUpdate() only through its command buffer.
+        VOIDENGINE_API void Update();
+
+        World& GetWorld() { return world; }
+        TransformHierarchy& GetTransformHierarchy() { return transformSystem.GetHierarchy(); }
+        SpatialIndex& GetSpatialIndex() { return spatialIndex; }
 
         //std::unordered_map<unsigned int, std::unique_ptr<GameObject>> GetGameObjects() { return gameObjects_; }
 
@@ -23,6 +46,22 @@ namespace VoidEngine
         }
 
     private:
-        std::unordered_map<unsigned int, std::unique_ptr<GameObject>> gameObjects_{};
+        // Both update phases, Update() wraps them to apply the removals deferred meanwhile
+        void updateObjects();
+        void applyRemovals();
+
+        // Declared first so it outlives the GameObjects destroying their entities
+        World world;
+        Query<const GameObjectRef> gameObjectQuery{world};
+        TransformSystem transformSystem{world};
+        SpatialIndex spatialIndex{world};
+        std::vector<GameObject*> updateList;
+        // One per ThreadPool thread
+        std::vector<CommandBuffer> commandBuffers;
+
+        SlotMap<std::unique_ptr<GameObject>> gameObjects_{};
+        // Objects removed during Update(), updateList still points at them
+        bool updating = false;
+        std::vector<SlotHandle> pendingRemovals;
     };
 } // VoidEngine
\ No newline at end of file
@@ -0,0 +1,364 @@
+#include "VoidEngine.hpp"
+#include "TextureManager.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+namespace VoidEngine {
+    TextureManager::TextureManager(Game* game) : game(game)
+    {
+        // Decoding is the slowest part of loading a level, use every core but the render thread's
+        loaders = std::make_unique<ThreadPool>(std::max(2u, std::thread::hardware_concurrency()));
+
+        std::cerr << "TextureManager created.\n";
+    }
+
+    TextureManager::~TextureManager()
+    {
+        // Finishes the imports already queued, then the uploads they enqueued, whose callbacks point back here
+        loaders.reset();
+        game->uploadQueue->WaitIdle();
+
+        std::cerr << "TextureManager destroyed.\n";
+    }
+
+    size_t TextureManager::KeyHash::operator()(const Key& key) const
+    {
+        size_t seed = 0;
+        hashCombine(seed, key.path, static_cast<uint32_t>(key.colorSpace), key.generateMips,
+            static_cast<uint32_t>(key.mipFilter), static_cast<uint32_t>(key.compression),
+            static_cast<uint32_t>(key.compressionQuality));
+        return seed;
+    }
+
+    TextureManager::Key TextureManager::makeKey(const std::string& filepath, const Texture::ImportOptions& options)
+    {
+        const std::string path = std::filesystem::path(filepath).lexically_normal().generic_string();
+        return {path, options.colorSpace, options.generateMips, options.mipFilter, options.compression,
+            options.compressionQuality};
+    }
+
+    Texture::ImportOptions TextureManager::makeOptions(const Key& key)
+    {
+        Texture::ImportOptions options{};
+        options.colorSpace = key.colorSpace;
+        options.generateMips = key.generateMips;
+        options.mipFilter = key.mipFilter;
+        options.compression = key.compression;
+        options.compressionQuality = key.compressionQuality;
+        return options;
+    }
+
+    TextureHandle TextureManager::Load(const std::string& filepath, const Texture::ImportOptions& options)
+    {
+        const Key key = makeKey(filepath, options);
+
+        std::promise<TextureHandle> promise;
+        std::shared_future<TextureHandle> existing;
+        {
+            std::lock_guard lock(mutex);
+            if (const auto it = textures.find(key); it != textures.end())
+            {
+                existing = it->second;
+            } else
+            {
+                textures.emplace(key, promise.get_future().share());
+            }
+        }
+
+        if (existing.valid()) return existing.get();
+
+        game->fileWatcher->Watch(filepath);
+        try
+        {
+            auto texture = std::make_shared<Texture>(*game->GetDevice());
+            texture->Upload(import(*texture, filepath, options));
+            {
+                std::lock_guard lock(mutex);
+                completedLoads++;
+            }
+            promise.set_value(texture);
+            return texture;
+        } catch (...)
+        {
+            {
+                std::lock_guard lock(mutex);
+                textures.erase(key);
+                failedLoads++;
+            }
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    TextureHandle TextureManager::LoadAsync(const std::string& filepath, const Texture::ImportOptions& options)
+    {
+        const Key key = makeKey(filepath, options);
+
+        TextureHandle texture;
+        std::shared_future<TextureHandle> existing;
+        {
+            std::lock_guard lock(mutex);
+            if (const auto it = textures.find(key); it != textures.end())
+            {
+                existing = it->second;
+            } else
+            {
+                texture = std::make_shared<Texture>(*game->GetDevice());
+                std::promise<TextureHandle> promise;
+                promise.set_value(texture);
+                textures.emplace(key, promise.get_future().share());
+                pendingLoads++;
+            }
+        }
+
+        if (existing.valid())
+        {
+            // Only waits while a synchronous Load() of the same texture is running, outside the lock it needs
+            try
+            {
+                return existing.get();
+            } catch (...)
+            {
+                // That load failed and left the cache, stream the texture like any other request
+                return LoadAsync(filepath, options);
+            }
+        }
+
+        game->fileWatcher->Watch(filepath);
+        loaders->submit([this, key, texture, filepath, options]()
+        {
+            stream(key, texture, filepath, options);
+        });
+        return texture;
+    }
+
+    Texture::StagedUpload TextureManager::import(Texture& texture, const std::string& filepath,
+        const Texture::ImportOptions& options)
+    {
+        const Texture::ImportOptions supported = Texture::SupportedOptions(*game->GetDevice(), options);
+
+        const auto start = std::chrono::steady_clock::now();
+        const MipChain chain = Texture::Import(filepath, supported);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::error_code error;
+        const auto fileSize = std::filesystem::file_size(filepath, error);
+        {
+            std::lock_guard lock(mutex);
+            importCount++;
+            importMs += ms;
+            lastImportMs = ms;
+            sourceBytes += error ? 0 : fileSize;
+            uploadedBytes += chain.data.size();
+            if (chain.format != TextureFormat::RGBA8)
+            {
+                lowestPsnr = compressedCount > 0 ? std::min(lowestPsnr, static_cast<double>(chain.psnr)) : chain.psnr;
+                compressedCount++;
+                psnrSum += chain.psnr;
+            }
+        }
+
+        return texture.StageMipChain(chain, supported);
+    }
+
+    void TextureManager::stream(const Key& key, const TextureHandle& texture, const std::string& filepath,
+        const Texture::ImportOptions& options)
+    {
+        Texture::StagedUpload upload;
+        try
+        {
+            upload = import(*texture, filepath, options);
+        } catch (const std::exception& e)
+        {
+            std::cerr << "Failed to load " << filepath << ": " << e.what() << "\n";
+
+            std::lock_guard lock(mutex);
+            if (const auto it = textures.find(key); it != textures.end() && it->second.get() == texture)
+            {
+                textures.erase(it);
+            }
+            pendingLoads--;
+            failedLoads++;
+            return;
+        }
+
+        // All levels in one copy, resident once it has executed
+        game->uploadQueue->EnqueueImage(std::move(upload.staging), upload.image, upload.mipLevels,
+            std::move(upload.regions), [this, texture]()
+            {
+                texture->MarkResident();
+
+                std::lock_guard lock(mutex);
+                pendingLoads--;
+                completedLoads++;
+            });
+    }
+
+    size_t TextureManager::Reload(const std::string& filepath)
+    {
+        const std::string path = std::filesystem::path(filepath).lexically_normal().generic_string();
+        const auto requested = std::chrono::steady_clock::now();
+
+        std::vector<std::pair<TextureHandle, Texture::ImportOptions>> started;
+        {
+            std::lock_guard lock(mutex);
+            for (const auto& [key, future] : textures)
+            {
+                if (key.path != path || future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+
+                const TextureHandle& texture = future.get();
+                if (!texture->IsResident()) continue;
+
+                if (const auto it = reloading.find(texture.get()); it != reloading.end())
+                {
+                    it->second = true;
+                    continue;
+                }
+                reloading.emplace(texture.get(), false);
+                started.emplace_back(texture, makeOptions(key));
+            }
+        }
+
+        for (const auto& [texture, options] : started)
+        {
+            loaders->submit([this, texture, path, options, requested]()
+            {
+                reimport(texture, path, options, requested);
+            });
+        }
+        return started.size();
+    }
+
+    void TextureManager::reimport(const TextureHandle& texture, const std::string& filepath,
+        const Texture::ImportOptions& options, std::chrono::steady_clock::time_point requested)
+    {
+        auto reimported = std::make_shared<Texture>(*game->GetDevice());
+        Texture::StagedUpload upload;
+        try
+        {
+            upload = import(*reimported, filepath, options);
+        } catch (const std::exception& e)
+        {
+            std::cerr << "Failed to reload " << filepath << ": " << e.what() << "\n";
+
+            std::lock_guard lock(mutex);
+            failedReloads++;
+            // Probably read halfway through a save, the write that finished it asked for another try
+            if (const auto it = reloading.find(texture.get()); it->second)
+            {
+                it->second = false;
+                loaders->submit([this, texture, filepath, options]()
+                {
+                    reimport(texture, filepath, options, std::chrono::steady_clock::now());
+                });
+            } else
+            {
+                reloading.erase(it);
+            }
+            return;
+        }
+
+        game->uploadQueue->EnqueueImage(std::move(upload.staging), upload.image, upload.mipLevels,
+            std::move(upload.regions), [this, texture, reimported, filepath, options, requested]()
+            {
+                reimported->MarkResident();
+
+                std::lock_guard lock(mutex);
+                finishedReloads.push_back({texture, reimported, filepath, options, requested});
+            });
+    }
+
+    void TextureManager::EndFrame()
+    {
+        std::vector<TextureHandle> destroyed;
+        std::vector<Reimport> restarted;
+        {
+            std::lock_guard lock(mutex);
+            frameNumber++;
+
+            // The frames still in flight keep sampling the old image, which the reimported texture holds on to
+            const auto now = std::chrono::steady_clock::now();
+            for (auto& reload : finishedReloads)
+            {
+                reload.texture->Swap(*reload.reimported);
+                retiredTextures.Retire(std::move(reload.reimported), frameNumber);
+
+                lastReloadMs = std::chrono::duration<double, std::milli>(now - reload.requested).count();
+                completedReloads++;
+                std::cerr << "Reloaded " << reload.filepath << " in " << lastReloadMs << " ms.\n";
+
+                const auto it = reloading.find(reload.texture.get());
+                if (it->second)
+                {
+                    it->second = false;
+                    reload.requested = now;
+                    restarted.push_back(std::move(reload));
+                } else
+                {
+                    reloading.erase(it);
+                }
+            }
+            finishedReloads.clear();
+
+            for (auto it = textures.begin(); it != textures.end();)
+            {
+                const auto& future = it->second;
+                if (future.wait_for(std::chrono::seconds(0)) == std::future_status::ready && future.get().use_count() == 1)
+                {
+                    retiredTextures.Retire(future.get(), frameNumber);
+                    it = textures.erase(it);
+                } else
+                {
+                    ++it;
+                }
+            }
+
+            retiredTextures.Collect(frameNumber, [&](TextureHandle& texture)
+            {
+                destroyed.push_back(std::move(texture));
+            });
+        }
+        // Images are freed here, outside the lock
+
+        for (auto& reload : restarted)
+        {
+            loaders->submit([this, texture = std::move(reload.texture), filepath = std::move(reload.filepath),
+                options = reload.options, requested = reload.requested]()
+            {
+                reimport(texture, filepath, options, requested);
+            });
+        }
+    }
+
+    size_t TextureManager::GetTextureCount() const
+    {
+        std::lock_guard lock(mutex);
+        return textures.size() + retiredTextures.Size();
+    }
+
+    TextureManager::ImportStats TextureManager::GetImportStats() const
+    {
+        std::lock_guard lock(mutex);
+
+        ImportStats stats{};
+        stats.pendingLoads = pendingLoads;
+        stats.completedLoads = completedLoads;
+        stats.failedLoads = failedLoads;
+        stats.sourceBytes = sourceBytes;
+        stats.uploadedBytes = uploadedBytes;
+        stats.importMs = importMs;
+        stats.lastImportMs = lastImportMs;
+        stats.averageImportMs = importCount > 0 ? importMs / static_cast<double>(importCount) : 0.0;
+        stats.megabytesPerSecond = importMs > 0.0 ? static_cast<double>(sourceBytes) / (1024.0 * 1024.0) / (importMs / 1000.0) : 0.0;
+        stats.compressedLoads = compressedCount;
+        stats.averagePsnr = compressedCount > 0 ? psnrSum / static_cast<double>(compressedCount) : 0.0;
+        stats.lowestPsnr = lowestPsnr;
+        stats.pendingReloads = reloading.size();
+        stats.completedReloads = completedReloads;
+        stats.failedReloads = failedReloads;
+        stats.lastReloadMs = lastReloadMs;
+        return stats;
+    }
+} // VoidEngine
@@ -0,0 +1,147 @@
+#pragma once
+#include "Common.hpp"
+#include "RetireQueue.hpp"
+#include "Texture.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace VoidEngine {
+    class Game;
+
+    // Shared handle to a GPU texture owned by the TextureManager
+    using TextureHandle = std::shared_ptr<Texture>;
+
+    // Owns every GPU texture, loaded once per path and import options. Works like the ModelManager: LoadAsync()
+    // decodes files, builds their mip chains and block compresses them on a pool of loader threads, then uploads
+    // them through the Game's UploadQueue. Unreferenced textures are evicted in EndFrame(), and edited files are
+    // reloaded in place with Reload() like meshes.
+    class TextureManager {
+    public:
+        struct ImportStats
+        {
+            size_t pendingLoads = 0;        // Requested, not resident yet
+            uint64_t completedLoads = 0;
+            uint64_t failedLoads = 0;
+            uint64_t sourceBytes = 0;       // Image files read
+            uint64_t uploadedBytes = 0;     // Every mip level, compressed or not
+            // Decoding, mip generation and compression on the loader threads, summed over textures
+            double importMs = 0.0;
+            double lastImportMs = 0.0;
+            double averageImportMs = 0.0;
+            // Source bytes per second of import time, so per loader thread
+            double megabytesPerSecond = 0.0;
+            // Block compressed imports and their Texture::psnr
+            uint64_t compressedLoads = 0;
+            double averagePsnr = 0.0;
+            double lowestPsnr = 0.0;
+            size_t pendingReloads = 0;
+            uint64_t completedReloads = 0;
+            uint64_t failedReloads = 0;
+            double lastReloadMs = 0.0;      // Reload() to swapped in
+        };
+
+        VOIDENGINE_API explicit TextureManager(Game* game);
+        VOIDENGINE_API ~TextureManager();
+
+        // Returns the texture for `filepath` imported with `options`, loading it on first use. Safe to call from
+        // several threads, concurrent requests for the same texture share a single load and uploads of different
+        // textures take turns on the device's single-time commands. Errors are rethrown to every waiting caller
+        // and nothing is cached.
+        VOIDENGINE_API TextureHandle Load(const std::string& filepath, const Texture::ImportOptions& options = {});
+
+        // Returns right away with a texture that is not resident yet. Shares the cache with Load(), and waits for
+        // a synchronous Load() of the same texture that is still running. A failed load is logged, counted in
+        // the stats and removed from the cache.
+        VOIDENGINE_API TextureHandle LoadAsync(const std::string& filepath, const Texture::ImportOptions& options = {});
+
+        // Imports `filepath` again for every set of options it is cached with and swaps each texture with its
+        // reimport in the EndFrame() after the upload finished, see ModelManager::Reload(). Returns the number of
+        // reloads started.
+        VOIDENGINE_API size_t Reload(const std::string& filepath);
+
+        // Call once per frame after submitting it. Swaps in finished reloads, evicts unreferenced textures and
+        // destroys the ones evicted or replaced SwapChain::MAX_FRAMES_IN_FLIGHT frames ago.
+        VOIDENGINE_API void EndFrame();
+
+        VOIDENGINE_API size_t GetTextureCount() const;
+
+        VOIDENGINE_API ImportStats GetImportStats() const;
+
+    private:
+        struct Key
+        {
+            std::string path;
+            Texture::ColorSpace colorSpace;
+            bool generateMips;
+            MipFilter mipFilter;
+            Texture::Compression compression;
+            CompressionQuality compressionQuality;
+
+            bool operator==(const Key& other) const = default;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Reimport
+        {
+            TextureHandle texture;
+            TextureHandle reimported;   // Resident, swapped into `texture` by EndFrame()
+            std::string filepath;
+            Texture::ImportOptions options;
+            std::chrono::steady_clock::time_point requested;
+        };
+
+        static Key makeKey(const std::string& filepath, const Texture::ImportOptions& options);
+        static Texture::ImportOptions makeOptions(const Key& key);
+
+        // Imports and stages the texture, recording the import in the stats. Runs on a loader thread for
+        // LoadAsync().
+        Texture::StagedUpload import(Texture& texture, const std::string& filepath, const Texture::ImportOptions& options);
+        void stream(const Key& key, const TextureHandle& texture, const std::string& filepath,
+            const Texture::ImportOptions& options);
+        // Runs on a loader thread
+        void reimport(const TextureHandle& texture, const std::string& filepath, const Texture::ImportOptions& options,
+            std::chrono::steady_clock::time_point requested);
+
+        Game* game;
+
+        mutable std::mutex mutex;
+        std::unordered_map<Key, std::shared_future<TextureHandle>, KeyHash> textures;
+        RetireQueue<TextureHandle> retiredTextures;
+        uint64_t frameNumber = 0;
+
+        // Textures being reimported, and whether their file changed again meanwhile
+        std::unordered_map<const Texture*, bool> reloading;
+        std::vector<Reimport> finishedReloads;
+        uint64_t completedReloads = 0;
+        uint64_t failedReloads = 0;
+        double lastReloadMs = 0.0;
+
+        size_t pendingLoads = 0;
+        uint64_t completedLoads = 0;
+        uint64_t failedLoads = 0;
+        uint64_t importCount = 0;
+        uint64_t sourceBytes = 0;
+        uint64_t uploadedBytes = 0;
+        double importMs = 0.0;
+        double lastImportMs = 0.0;
+        uint64_t compressedCount = 0;
+        double psnrSum = 0.0;
+        double lowestPsnr = 0.0;
+
+        // Declared last so it is destroyed first, nothing is decoding once the members above go away
+        std::unique_ptr<ThreadPool> loaders;
+    };
+
+} // VoidEngine
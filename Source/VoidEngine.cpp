@@ -1,5 +1,6 @@
 #include "VoidEngine.hpp"
 
+#include "AssetArchive.hpp"
 #include "InputManager.hpp"
 #include "Camera.hpp"
 #include "RenderManager.hpp"
@@ -7,7 +8,9 @@
 #include "PointLight.hpp"
 #include "GameObject.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <filesystem>
 #include <vector>
 #include <iostream>
 
@@ -27,13 +30,30 @@
 
 #define DEBUG_PROJECTION
 
+#ifdef DEBUG
+// Prints frame, CPU wait and GPU busy times once a second
+#define REPORT_FRAME_TIMINGS
+#endif
+
 namespace VoidEngine
 {
     Game::Game(VkExtent2D resolution)
     {
+        if (std::filesystem::exists(ASSET_ARCHIVE))
+        {
+            AssetArchive::Mount(ASSET_ARCHIVE);
+            std::cerr << "Mounted " << ASSET_ARCHIVE << ".\n";
+        }
+
+        fileWatcher = std::make_unique<FileWatcher>();
+        // Before the RenderManager, which queries its World
+        sceneManager = std::make_unique<SceneManager>();
         //renderManager = std::make_unique<RenderManager>(*device, *this, resolution);
         renderManager = new RenderManager(*device, *this, resolution);
-        sceneManager = std::make_unique<SceneManager>();
+        uploadQueue = std::make_unique<UploadQueue>(*device);
+        materialManager = std::make_unique<MaterialManager>(this);
+        modelManager = std::make_unique<ModelManager>(this);
+        textureManager = std::make_unique<TextureManager>(this);
         lightSourceManager = std::make_unique<LightSourceManager>(*this);
         //lightSourceManager = new LightSourceManager(*this);
 
@@ -64,7 +84,8 @@ namespace VoidEngine
                 1,
                 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-            //uboBuffers[i]->map();
+            // Stays mapped, only written by the frame using the slot after its fence signaled
+            uboBuffers[i]->map();
         }
 
         auto globalSetLayout = DescriptorSetLayout::Builder(*device)
@@ -80,24 +101,41 @@ namespace VoidEngine
                 .build(globalDescriptorSets[i]);
         }
 
+        // Every slot's sets point at that slot's uniform buffer for good, nothing is rewritten while in flight
+        for (uint32_t frame = 0; frame < SwapChain::MAX_FRAMES_IN_FLIGHT; frame++)
+        {
+            for (const RenderQueueType queueType : {RenderQueueType::OPAQUE, RenderQueueType::LIGHT})
+            {
+                renderManager->UpdateDescriptorSet(renderManager->GetDescriptorSet(queueType, frame), uboBuffers, frame);
+            }
+        }
+
         auto viewerObject = new GameObject(this);
-        viewerObject->transform.translation.z = -2.5f;
+        viewerObject->GetTransform().translation.z = -2.5f;
         InputManager cameraController{};
 
         auto currentTime = std::chrono::high_resolution_clock::now();
 
         float timer = 0;
+#ifdef REPORT_FRAME_TIMINGS
+        FrameTimings timingSum{};
+        int timedFrames = 0;
+        float timingTimer = 0;
+#endif
 
         while (!window->shouldClose())
         {
             glfwPollEvents();
 
-            /*
-            for (auto& [id, gameObject] : sceneManager->FindGameObject())
+            // Reimported in the background and swapped in by the EndFrame() calls below once ready
+            for (const auto& path : fileWatcher->Poll())
             {
-                gameObject->Update();
+                modelManager->Reload(path);
+                textureManager->Reload(path);
+                renderManager->ReloadShaders(path);
             }
-            */
+
+            sceneManager->Update();
 
             auto newTime = std::chrono::high_resolution_clock::now();
             float deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
@@ -107,11 +145,16 @@ namespace VoidEngine
             timer += deltaTime;
 
             cameraController.moveInPlaneXZ(window->getGLFWwindow(), deltaTime, *viewerObject);
-            mainCamera->setViewYXZ(viewerObject->transform.translation, viewerObject->transform.rotation);
+            const Transform& viewerTransform = viewerObject->GetTransform();
+            mainCamera->setViewYXZ(viewerTransform.translation, viewerTransform.rotation);
 
             float aspect = renderManager->GetAspectRatio();
             mainCamera->setPerspectiveProjection(glm::radians(50.0f), aspect, 0.1f, 10.0f);
 
+            // Meshes streamed in by worker threads, one submission for all of them
+            uploadQueue->Flush();
+            renderManager->ResetStats();
+
             // vkBeginCommandBuffer
             if (auto commandBuffer = renderer->beginFrame(renderManager->GetSwapChain()); commandBuffer != VK_NULL_HANDLE)
             {
@@ -129,8 +172,7 @@ namespace VoidEngine
                 }
 #endif
 
-                uboBuffers[frameIndex]->map(sizeof(ubo));
-                uboBuffers[frameIndex]->writeToBuffer(&ubo);
+                uboBuffers[frameIndex]->writeToBuffer(ubo.get(), sizeof(GlobalUbo));
                 uboBuffers[frameIndex]->flush();
 
 #ifdef DEBUG_PROJECTION
@@ -150,11 +192,13 @@ namespace VoidEngine
 
                     if ((queueToRender == RenderQueueType::LIGHT) && (queue.GetNumObjects() > 0))
                     {
-                        for (int j = 0; j < renderManager->GetRenderQueue(queueToRender).gameObjectIDs.size(); j++)
+                        int lightIndex = 0;
+                        for (SlotHandle handle : renderManager->GetRenderQueue(RenderQueueType::LIGHT).gameObjects)
                         {
-                            auto id = renderManager->GetRenderQueue(RenderQueueType::LIGHT).gameObjectIDs[j];
-                            auto light = sceneManager->FindGameObject(id)->GetAs<PointLight>();
-                            light->UpdateLight(*ubo, j);
+                            // Lights removed from the scene leave a stale handle behind
+                            auto* gameObject = sceneManager->FindGameObject(handle);
+                            if (gameObject == nullptr) continue;
+                            gameObject->GetAs<PointLight>()->UpdateLight(*ubo, lightIndex++);
                         }
                     }
 
@@ -166,8 +210,6 @@ namespace VoidEngine
                             renderManager->GetSwapChain(),
                             renderManager->GetFramebuffers());
 
-                        renderManager->UpdateDescriptorSet(queue.descriptorSet, uboBuffers, renderManager->GetSwapChain().GetCurrentFrame());
-                        queue.pipeline->bind(commandBuffer);
                         renderManager->RenderObjectsInQueue(queue, commandBuffer);
 
                         //vkCmdEndRenderPass
@@ -176,9 +218,38 @@ namespace VoidEngine
                 }
                 // vkEndCommandBuffer
                 renderer->endFrame(renderManager->GetSwapChain(), commandBuffer);
+
+#ifdef REPORT_FRAME_TIMINGS
+                const FrameTimings& timings = renderer->GetFrameTimings();
+                timingSum.frameMs += timings.frameMs;
+                timingSum.cpuWaitMs += timings.cpuWaitMs;
+                timingSum.gpuBusyMs += timings.gpuBusyMs;
+                timedFrames++;
+                timingTimer += deltaTime;
+                if (timingTimer >= 1)
+                {
+                    // GPU time the CPU didn't spend waiting for is time both worked at once
+                    const double frameMs = timingSum.frameMs / timedFrames;
+                    const double cpuWaitMs = timingSum.cpuWaitMs / timedFrames;
+                    const double gpuBusyMs = timingSum.gpuBusyMs / timedFrames;
+                    std::cout << renderManager->GetFramesInFlight() << " frames in flight, frame " << frameMs
+                              << " ms, CPU waited " << cpuWaitMs << " ms, GPU busy " << gpuBusyMs << " ms, overlapped "
+                              << std::max(gpuBusyMs - cpuWaitMs, 0.0) << " ms\n";
+
+                    timingSum = {};
+                    timedFrames = 0;
+                    timingTimer = 0;
+                }
+#endif
             }
+
+            modelManager->EndFrame();
+            materialManager->EndFrame();
+            textureManager->EndFrame();
+            renderManager->EndFrame();
         }
 
+        auto queueLock = device->lockQueues();
         vkDeviceWaitIdle(device->device());
     }
 
@@ -192,8 +263,9 @@ namespace VoidEngine
         T* rawPtr = gameObject.get();
 */
         std::unique_ptr<GameObject>ugo(gameObject);
-        renderManager->AddToRenderQueue(*gameObject, renderQueue);
+        // Added to the scene first, the render queue stores the handle it gets there
         sceneManager->AddGameObject(std::move(ugo));
+        renderManager->AddToRenderQueue(*gameObject, renderQueue);
 
 //        return rawPtr;
     }
@@ -4,14 +4,18 @@
 #include "Window.hpp"
 #include "Renderer.hpp"
 #include "Descriptors.hpp"
+#include "FileWatcher.hpp"
 #include "GameObject.hpp"
 #include "CameraManager.hpp"
 #include "FrameInfo.hpp"
 #include "InputManager.hpp"
 #include "LightSourceManager.hpp"
+#include "MaterialManager.hpp"
 #include "ModelManager.hpp"
 #include "SceneManager.hpp"
+#include "TextureManager.hpp"
 #include "UIManager.hpp"
+#include "UploadQueue.hpp"
 #include "WindowManager.hpp"
 
 namespace VoidEngine
@@ -21,6 +25,9 @@ namespace VoidEngine
     public:
         static constexpr int WIDTH = 800;
         static constexpr int HEIGHT = 600;
+        // Mounted at startup when present, see AssetArchive. Without it assets load as loose files, which is what
+        // hot reloading edits.
+        static constexpr const char* ASSET_ARCHIVE = "Assets.vpak";
 
         VOIDENGINE_API explicit Game(VkExtent2D resolution = {WIDTH, HEIGHT});
         VOIDENGINE_API ~Game();
@@ -32,18 +39,29 @@ namespace VoidEngine
 
         VOIDENGINE_API inline SceneManager* GetSceneManager() const { return sceneManager.get(); }
 
+        // See RenderManager::SetFramesInFlight(). Safe anywhere outside of rendering, e.g. in a GameObject's Update().
+        VOIDENGINE_API inline void SetFramesInFlight(uint32_t count) const { renderManager->SetFramesInFlight(count); }
+
         //template <typename T, typename... Args>
         //VOIDENGINE_API T* AddGameObject(RenderQueueType renderQueue = RenderQueueType::OPAQUE, Args&&... args);
         VOIDENGINE_API void AddGameObject(GameObject* gameObject, RenderQueueType renderQueue = RenderQueueType::OPAQUE) const;
 
+        // Declared first so it outlives the managers that enqueue copies into it
+        std::unique_ptr<UploadQueue> uploadQueue;
+        // Files loaded by the managers, polled once per frame to hot reload the edited ones
+        std::unique_ptr<FileWatcher> fileWatcher;
+
         std::unique_ptr<CameraManager> cameraManager;
         std::unique_ptr<InputManager> inputManager;
         std::unique_ptr<LightSourceManager> lightSourceManager;
         //LightSourceManager* lightSourceManager;
+        // Declared before the ModelManager so it outlives the models holding materials
+        std::unique_ptr<MaterialManager> materialManager;
         std::unique_ptr<ModelManager> modelManager;
         //std::unique_ptr<RenderManager> renderManager;
         RenderManager* renderManager;
         std::unique_ptr<SceneManager> sceneManager;
+        std::unique_ptr<TextureManager> textureManager;
         std::unique_ptr<UIManager> uiManager;
         std::unique_ptr<WindowManager> windowManager;
 
@@ -0,0 +1,1494 @@
+// Loader benchmarks. Run from the repository root, optionally passing the files to load:
+//   Benchmark [file.obj | file.gltf | file.glb | file.png | file.bmp ...]
+// Without arguments every .obj, .gltf, .glb, .png and .bmp in models/ is used.
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <AssetArchive.hpp>
+#include <BlockCompressor.hpp>
+#include <DynamicAabbTree.hpp>
+#include <FrustumCuller.hpp>
+#include <GameObject.hpp>
+#include <GltfParser.hpp>
+#include <ImageDecoder.hpp>
+#include <MappedFile.hpp>
+#include <MeshletBuilder.hpp>
+#include <MeshletCuller.hpp>
+#include <MeshOptimizer.hpp>
+#include <MeshSimplifier.hpp>
+#include <MipGenerator.hpp>
+#include <ObjParser.hpp>
+#include <OcclusionCuller.hpp>
+#include <SlotMap.hpp>
+#include <TangentGenerator.hpp>
+#include <TextureCache.hpp>
+#include <ThreadPool.hpp>
+#include <TransformSystem.hpp>
+#include <VertexWelder.hpp>
+#include <World.hpp>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <External/tinyobjloader/tinyobjloader.hpp>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <External/glm/gtx/hash.hpp>
+#include <External/glm/gtc/matrix_transform.hpp>
+
+// The hash the importer used before VertexWelder, kept here as the baseline
+template<>
+struct std::hash<VoidEngine::Model::Vertex>
+{
+    size_t operator()(VoidEngine::Model::Vertex const& vertex) const noexcept
+    {
+        size_t seed = 0;
+        VoidEngine::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+        return seed;
+    }
+};
+
+namespace
+{
+    constexpr int ITERATIONS = 5;
+
+    template<typename F>
+    double bestOf(int iterations, F&& function)
+    {
+        double best = 1e30;
+        for (int i = 0; i < iterations; i++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const auto end = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return best;
+    }
+
+    // Same sequence on every run so timings stay comparable between builds
+    struct Random
+    {
+        uint32_t seed;
+
+        uint32_t next()
+        {
+            seed = seed * 1664525u + 1013904223u;
+            return seed;
+        }
+
+        // Uniform in [0, 1)
+        float operator()() { return static_cast<float>(next() >> 8) / static_cast<float>(1u << 24); }
+    };
+
+    // Validation checks that failed, main() exits with an error if there were any
+    int failedChecks = 0;
+
+    // Counts a failed check, its message is streamed into the returned stream
+    std::ostream& fail()
+    {
+        failedChecks++;
+        return std::cerr << "FAILED: ";
+    }
+
+    // Compares the triangulated corners of both loaders attribute by attribute
+    bool sameGeometry(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+        const VoidEngine::ObjData& obj)
+    {
+        size_t corner = 0;
+        for (const auto& shape : shapes)
+        {
+            for (const auto& index : shape.mesh.indices)
+            {
+                if (corner >= obj.indices.size()) return false;
+                const auto& other = obj.indices[corner++];
+
+                if ((index.vertex_index >= 0) != (other.position >= 0)) return false;
+                if ((index.normal_index >= 0) != (other.normal >= 0)) return false;
+                if ((index.texcoord_index >= 0) != (other.texcoord >= 0)) return false;
+
+                for (int k = 0; k < 3 && index.vertex_index >= 0; k++)
+                {
+                    if (attrib.vertices[3 * index.vertex_index + k] != obj.positions[3 * other.position + k]) return false;
+                    if (attrib.colors[3 * index.vertex_index + k] != obj.colors[3 * other.position + k]) return false;
+                }
+                for (int k = 0; k < 3 && index.normal_index >= 0; k++)
+                {
+                    if (attrib.normals[3 * index.normal_index + k] != obj.normals[3 * other.normal + k]) return false;
+                }
+                for (int k = 0; k < 2 && index.texcoord_index >= 0; k++)
+                {
+                    if (attrib.texcoords[2 * index.texcoord_index + k] != obj.texcoords[2 * other.texcoord + k]) return false;
+                }
+            }
+        }
+        return corner == obj.indices.size();
+    }
+
+    std::vector<VoidEngine::Model::Vertex> buildCorners(const VoidEngine::ObjData& obj)
+    {
+        std::vector<VoidEngine::Model::Vertex> corners(obj.indices.size());
+        for (size_t i = 0; i < obj.indices.size(); i++)
+        {
+            const auto& index = obj.indices[i];
+            auto& vertex = corners[i];
+            vertex.position = {obj.positions[3 * index.position], obj.positions[3 * index.position + 1], obj.positions[3 * index.position + 2]};
+            vertex.color = {obj.colors[3 * index.position], obj.colors[3 * index.position + 1], obj.colors[3 * index.position + 2]};
+            if (index.normal >= 0)
+            {
+                vertex.normal = {obj.normals[3 * index.normal], obj.normals[3 * index.normal + 1], obj.normals[3 * index.normal + 2]};
+            }
+            if (index.texcoord >= 0)
+            {
+                vertex.uv = {obj.texcoords[2 * index.texcoord], obj.texcoords[2 * index.texcoord + 1]};
+            }
+        }
+        return corners;
+    }
+
+    // Same chain as Model::generateLods() with the default import options
+    void benchmarkLods(const std::vector<VoidEngine::Model::Vertex>& vertices, std::vector<uint32_t> indices)
+    {
+        const VoidEngine::Model::ImportOptions options{};
+
+        std::vector<size_t> triangles{indices.size() / 3};
+        float totalError = 0.0f;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t level = 1; level < options.lodCount; level++)
+        {
+            const auto targetCount = static_cast<size_t>(static_cast<float>(indices.size() / 3) * options.lodReduction) * 3;
+
+            float error = 0.0f;
+            const size_t count = VoidEngine::MeshSimplifier::Simplify(indices.data(), indices.data(), indices.size(),
+                &vertices[0].position.x, vertices.size(), sizeof(VoidEngine::Model::Vertex), targetCount,
+                options.lodMaxError, &error);
+            if (count == 0 || count > indices.size() * 9 / 10) break;
+
+            indices.resize(count);
+            triangles.push_back(count / 3);
+            totalError += error;
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        std::cout << "  LOD chain: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms, triangles";
+        for (const size_t count : triangles) std::cout << " " << count;
+        std::cout << ", error " << totalError * 100.0f << "% of extent\n";
+    }
+
+    // Builds meshlets, then culls them from cameras circling the mesh and checks that nothing visible was culled
+    void benchmarkMeshlets(const std::vector<VoidEngine::Model::Vertex>& vertices, std::vector<uint32_t> indices)
+    {
+        using VoidEngine::Meshlet;
+        using VoidEngine::MeshletCuller;
+
+        const float* positions = &vertices[0].position.x;
+        constexpr size_t stride = sizeof(VoidEngine::Model::Vertex);
+
+        const auto before = VoidEngine::MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+        const std::vector<uint32_t> original = indices;
+        std::vector<Meshlet> meshlets;
+        const double buildTime = bestOf(ITERATIONS, [&]()
+        {
+            indices = original;
+            meshlets = VoidEngine::MeshletBuilder::Build(indices.data(), indices.size(), positions, vertices.size(), stride);
+            // Like Model, restore the vertex cache order inside each meshlet
+            for (const auto& meshlet : meshlets)
+            {
+                VoidEngine::MeshOptimizer::OptimizeVertexCache(indices.data() + meshlet.firstIndex, meshlet.indexCount,
+                    vertices.size());
+            }
+        });
+        const auto after = VoidEngine::MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+        size_t withCone = 0;
+        glm::vec3 minimum{FLT_MAX};
+        glm::vec3 maximum{-FLT_MAX};
+        for (const auto& meshlet : meshlets) withCone += meshlet.coneCutoff < 1.0f;
+        for (const auto& vertex : vertices)
+        {
+            minimum = glm::min(minimum, vertex.position);
+            maximum = glm::max(maximum, vertex.position);
+        }
+        const glm::vec3 center = (minimum + maximum) * 0.5f;
+        const float extent = glm::length(maximum - minimum);
+
+        // Close enough that part of the mesh is off screen
+        constexpr int VIEWS = 32;
+        MeshletCuller::Stats stats{};
+        size_t drawnTriangles = 0;
+        size_t wronglyCulled = 0;
+        double cullTime = 0.0;
+        std::vector<MeshletCuller::Range> ranges;
+        for (int view = 0; view < VIEWS; view++)
+        {
+            const float angle = 6.2831853f * static_cast<float>(view) / VIEWS;
+            const glm::vec3 eye = center + glm::vec3{std::cos(angle), 0.3f, std::sin(angle)} * extent * 0.6f;
+            const glm::mat4 viewMatrix = glm::lookAt(eye, center + glm::vec3{0.0f, extent * 0.2f, 0.0f}, glm::vec3{0.0f, 1.0f, 0.0f});
+            const glm::mat4 projection = glm::perspective(glm::radians(50.0f), 1.333f, 0.01f * extent, 10.0f * extent);
+            const glm::mat4 viewProjection = projection * viewMatrix;
+
+            MeshletCuller::Stats viewStats{};
+            cullTime += bestOf(ITERATIONS, [&]()
+            {
+                ranges.clear();
+                viewStats = {};
+                MeshletCuller::Cull(meshlets.data(), meshlets.size(), viewProjection, eye, true, ranges, viewStats);
+            });
+            stats.visible += viewStats.visible;
+            stats.frustumCulled += viewStats.frustumCulled;
+            stats.backfaceCulled += viewStats.backfaceCulled;
+            for (const auto& range : ranges) drawnTriangles += range.indexCount / 3;
+
+            // Every triangle outside the ranges has to be back facing or entirely off screen
+            std::vector<bool> drawn(indices.size() / 3, false);
+            for (const auto& range : ranges)
+            {
+                std::fill(drawn.begin() + range.firstIndex / 3, drawn.begin() + (range.firstIndex + range.indexCount) / 3, true);
+            }
+            for (size_t t = 0; t < drawn.size(); t++)
+            {
+                if (drawn[t]) continue;
+
+                const glm::vec3 p0 = vertices[indices[t * 3 + 0]].position;
+                const glm::vec3 p1 = vertices[indices[t * 3 + 1]].position;
+                const glm::vec3 p2 = vertices[indices[t * 3 + 2]].position;
+                const bool backFacing = glm::dot(glm::cross(p1 - p0, p2 - p0), p0 - eye) >= -1e-6f * extent * extent * extent;
+
+                bool offScreen = false;
+                for (int axis = 0; axis < 3 && !offScreen; axis++)
+                {
+                    for (const float side : {-1.0f, 1.0f})
+                    {
+                        bool allOutside = true;
+                        for (const glm::vec3& p : {p0, p1, p2})
+                        {
+                            const glm::vec4 clip = viewProjection * glm::vec4(p, 1.0f);
+                            const float bound = axis == 2 && side < 0.0f ? 0.0f : clip.w;
+                            allOutside &= side * clip[axis] > bound;
+                        }
+                        offScreen |= allOutside;
+                    }
+                }
+                wronglyCulled += !backFacing && !offScreen;
+            }
+        }
+
+        if (wronglyCulled > 0) fail() << "meshlet culling dropped " << wronglyCulled << " visible triangles\n";
+
+        const size_t totalTriangles = indices.size() / 3 * VIEWS;
+        std::cout << "  meshlets: " << meshlets.size() << " built in " << buildTime << " ms, "
+                  << static_cast<double>(indices.size() / 3) / static_cast<double>(meshlets.size()) << " triangles each, "
+                  << 100.0 * static_cast<double>(withCone) / static_cast<double>(meshlets.size()) << "% with a normal cone, ACMR "
+                  << before.acmr << " -> " << after.acmr << "\n"
+                  << "    culling: " << cullTime / VIEWS * 1000.0 << " us per view, " << stats.frustumCulled << " frustum + "
+                  << stats.backfaceCulled << " backface of " << meshlets.size() * VIEWS << " culled, "
+                  << 100.0 * static_cast<double>(totalTriangles - drawnTriangles) / static_cast<double>(totalTriangles)
+                  << "% of triangles skipped, " << wronglyCulled << " visible ones culled\n";
+    }
+
+    void benchmarkOptimize(std::vector<VoidEngine::Model::Vertex> vertices, std::vector<uint32_t> indices)
+    {
+        using VoidEngine::MeshOptimizer;
+
+        const auto before = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+        const auto start = std::chrono::steady_clock::now();
+        MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+        MeshOptimizer::OptimizeOverdraw(indices.data(), indices.size(), &vertices[0].position.x, vertices.size(),
+            sizeof(VoidEngine::Model::Vertex));
+        vertices.resize(MeshOptimizer::OptimizeVertexFetch(vertices.data(), vertices.size(),
+            sizeof(VoidEngine::Model::Vertex), indices.data(), indices.size()));
+        const auto end = std::chrono::steady_clock::now();
+
+        const auto after = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+        std::cout << "  optimizing: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms, ACMR "
+                  << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << "\n";
+
+        // What Model uploads for each vertex format, 16-bit indices whenever the vertex count allows
+        const size_t fullBytes = vertices.size() * sizeof(VoidEngine::Model::Vertex) + indices.size() * sizeof(uint32_t);
+        const size_t indexSize = vertices.size() <= 0xFFFF ? sizeof(uint16_t) : sizeof(uint32_t);
+        const size_t packedBytes = vertices.size() * sizeof(VoidEngine::Model::PackedVertex) + indices.size() * indexSize;
+        std::cout << "  GPU geometry: " << fullBytes / 1024 << " KB full, " << packedBytes / 1024 << " KB packed ("
+                  << 100.0 * static_cast<double>(packedBytes) / static_cast<double>(fullBytes) << "%)\n";
+
+        benchmarkLods(vertices, indices);
+        benchmarkMeshlets(vertices, indices);
+    }
+
+    // Checks that every tangent is a unit vector perpendicular to its normal, within snorm8 precision once packed
+    void benchmarkTangents(const std::vector<VoidEngine::Model::Vertex>& vertices, const std::vector<uint32_t>& indices)
+    {
+        std::vector<VoidEngine::Model::Vertex> splitVertices;
+        std::vector<uint32_t> splitIndices;
+        std::vector<glm::vec4> tangents;
+        const double time = bestOf(ITERATIONS, [&]()
+        {
+            splitVertices = vertices;
+            splitIndices = indices;
+            tangents = VoidEngine::TangentGenerator::Generate(splitVertices, splitIndices);
+        });
+
+        float worstLength = 0.0f;
+        float worstDot = 0.0f;
+        size_t mirrored = 0;
+        for (size_t i = 0; i < tangents.size(); i++)
+        {
+            const glm::vec3 tangent{tangents[i]};
+            const glm::vec3 normal = glm::normalize(splitVertices[i].normal);
+            worstLength = std::max(worstLength, std::abs(glm::length(tangent) - 1.0f));
+            worstDot = std::max(worstDot, std::abs(glm::dot(tangent, normal)));
+            if (tangents[i].w < 0.0f) mirrored++;
+        }
+
+        std::cout << "  tangents: " << time << " ms, " << splitVertices.size() - vertices.size()
+                  << " vertices split by handedness, " << mirrored << " mirrored, worst length error " << worstLength
+                  << ", worst dot with the normal " << worstDot << "\n";
+    }
+
+    void benchmarkWeld(const VoidEngine::ObjData& obj)
+    {
+        using VoidEngine::Model;
+
+        const std::vector<Model::Vertex> corners = buildCorners(obj);
+
+        std::vector<Model::Vertex> mapVertices;
+        std::vector<uint32_t> mapIndices;
+        const double mapTime = bestOf(ITERATIONS, [&]()
+        {
+            mapVertices.clear();
+            mapIndices.clear();
+            std::unordered_map<Model::Vertex, uint32_t> uniqueVertices{};
+            for (const auto& vertex : corners)
+            {
+                if (!uniqueVertices.contains(vertex))
+                {
+                    uniqueVertices[vertex] = static_cast<uint32_t>(mapVertices.size());
+                    mapVertices.push_back(vertex);
+                }
+                mapIndices.push_back(uniqueVertices[vertex]);
+            }
+        });
+
+        std::vector<Model::Vertex> weldVertices;
+        std::vector<uint32_t> weldIndices;
+        const double weldTime = bestOf(ITERATIONS, [&]()
+        {
+            weldVertices.clear();
+            weldIndices.clear();
+            VoidEngine::VertexWelder welder{weldVertices, corners.size()};
+            welder.Add(corners.data(), corners.size(), weldIndices);
+        });
+
+        std::vector<Model::Vertex> epsilonVertices;
+        std::vector<uint32_t> epsilonIndices;
+        VoidEngine::VertexWelder epsilonWelder{epsilonVertices, corners.size(), 1e-4f};
+        epsilonWelder.Add(corners.data(), corners.size(), epsilonIndices);
+
+        const bool matches = mapIndices == weldIndices && mapVertices.size() == weldVertices.size() &&
+            std::equal(mapVertices.begin(), mapVertices.end(), weldVertices.begin());
+
+        std::cout << "  welding " << corners.size() << " corners into " << weldVertices.size() << " vertices ("
+                  << epsilonVertices.size() << " with epsilon 1e-4)\n"
+                  << "    unordered_map: " << mapTime << " ms\n"
+                  << "    VertexWelder:  " << weldTime << " ms, " << mapTime / weldTime << "x, output "
+                  << (matches ? "matches" : "DIFFERS") << "\n";
+
+        if (!obj.normals.empty() && !obj.texcoords.empty()) benchmarkTangents(weldVertices, weldIndices);
+        benchmarkOptimize(weldVertices, weldIndices);
+    }
+
+    void benchmarkObj(const std::string& path)
+    {
+        const double megabytes = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warn, err;
+
+        const double tinyobjTime = bestOf(ITERATIONS, [&]()
+        {
+            attrib = {};
+            shapes.clear();
+            materials.clear();
+            if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str()))
+            {
+                throw std::runtime_error(warn + err);
+            }
+        });
+
+        VoidEngine::ObjData obj;
+        const double parserTime = bestOf(ITERATIONS, [&]() { obj = VoidEngine::ObjParser::Parse(path); });
+
+        std::cout << path << " (" << megabytes << " MB, " << obj.indices.size() / 3 << " triangles, "
+                  << obj.materialNames.size() << " materials)\n"
+                  << "  tinyobj:   " << tinyobjTime << " ms (" << megabytes / (tinyobjTime / 1000.0) << " MB/s)\n"
+                  << "  ObjParser: " << parserTime << " ms (" << megabytes / (parserTime / 1000.0) << " MB/s), "
+                  << tinyobjTime / parserTime << "x, output "
+                  << (sameGeometry(attrib, shapes, obj) ? "matches" : "DIFFERS") << "\n";
+
+        benchmarkWeld(obj);
+    }
+
+    // Compares a glTF import up to the staging copy with just reading the file and copying its bytes once.
+    // The staging buffer is plain memory here, the copy into it is the same one Model does.
+    void benchmarkGltf(const std::string& path)
+    {
+        using VoidEngine::GltfParser;
+        using VoidEngine::Model;
+
+        const size_t fileSize = std::filesystem::file_size(path);
+        std::vector<char> fileData(fileSize);
+        std::vector<char> fileCopy(fileSize);
+
+        const double ioTime = bestOf(ITERATIONS, [&]()
+        {
+            std::ifstream file(path, std::ios::binary);
+            file.read(fileData.data(), static_cast<std::streamsize>(fileSize));
+            std::memcpy(fileCopy.data(), fileData.data(), fileSize);
+        });
+
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+        std::vector<uint8_t> vertexStaging;
+        std::vector<uint8_t> indexStaging;
+
+        const double importTime = bestOf(ITERATIONS, [&]()
+        {
+            const VoidEngine::GltfData gltf = GltfParser::Parse(path);
+
+            vertexCount = 0;
+            indexCount = 0;
+            for (const auto& mesh : gltf.meshes)
+            {
+                for (const auto& primitive : mesh.primitives)
+                {
+                    vertexCount += GltfParser::GetVertexCount(gltf, primitive);
+                    indexCount += GltfParser::GetIndexCount(gltf, primitive);
+                }
+            }
+            vertexStaging.resize(vertexCount * sizeof(Model::PackedVertex));
+            indexStaging.resize(indexCount * sizeof(uint32_t));
+
+            size_t vertexOffset = 0;
+            size_t indexOffset = 0;
+            for (const auto& mesh : gltf.meshes)
+            {
+                for (const auto& primitive : mesh.primitives)
+                {
+                    GltfParser::CopyVertices(gltf, primitive, Model::VertexFormat::PACKED, glm::vec3{0.0f},
+                        glm::vec3{1.0f}, vertexStaging.data() + vertexOffset * sizeof(Model::PackedVertex));
+                    GltfParser::CopyIndices(gltf, primitive, VK_INDEX_TYPE_UINT32, indexStaging.data() + indexOffset * sizeof(uint32_t));
+                    vertexOffset += GltfParser::GetVertexCount(gltf, primitive);
+                    indexOffset += GltfParser::GetIndexCount(gltf, primitive);
+                }
+            }
+        });
+
+        const VoidEngine::GltfData gltf = GltfParser::Parse(path);
+        std::cout << path << " (" << static_cast<double>(fileSize) / (1024.0 * 1024.0) << " MB, " << vertexCount << " vertices, "
+                  << indexCount / 3 << " triangles, " << gltf.meshes.size() << " meshes, " << gltf.nodes.size() << " nodes, "
+                  << gltf.materials.size() << " materials)\n"
+                  << "  read + copy:      " << ioTime << " ms\n"
+                  << "  import + staging: " << importTime << " ms, " << importTime / ioTime << "x\n";
+    }
+
+    bool isImagePath(const std::filesystem::path& path)
+    {
+        const auto extension = path.extension();
+        return extension == ".png" || extension == ".bmp";
+    }
+
+    // What a texture import costs on the CPU: decoding, then the sRGB mip chain. Every file once on this thread
+    // for the per texture times, then all of them spread over the ThreadPool like a level load.
+    void benchmarkTextures(const std::vector<std::string>& paths)
+    {
+        using VoidEngine::MipFilter;
+        constexpr double MB = 1024.0 * 1024.0;
+
+        double sourceBytes = 0.0;
+        double decodedBytes = 0.0;
+        double chainBytes = 0.0;
+        double decodeTotal = 0.0;
+        double boxTotal = 0.0;
+        double kaiserTotal = 0.0;
+
+        for (const auto& path : paths)
+        {
+            const auto fileSize = static_cast<double>(std::filesystem::file_size(path));
+
+            VoidEngine::Image image;
+            const double decodeTime = bestOf(1, [&]() { image = VoidEngine::ImageDecoder::Load(path); });
+
+            VoidEngine::MipChain chain;
+            const double boxTime = bestOf(1, [&]() { chain = VoidEngine::MipGenerator::Generate(image, true, MipFilter::BOX); });
+            const double kaiserTime = bestOf(1, [&]() { VoidEngine::MipGenerator::Generate(image, true, MipFilter::KAISER); });
+
+            std::cout << "  " << path << " (" << image.width << "x" << image.height << ", " << fileSize / MB << " MB, "
+                      << chain.levels.size() << " levels): decode " << decodeTime << " ms, mips " << boxTime
+                      << " ms box / " << kaiserTime << " ms Kaiser\n";
+
+            sourceBytes += fileSize;
+            decodedBytes += static_cast<double>(image.pixels.size());
+            chainBytes += static_cast<double>(chain.data.size());
+            decodeTotal += decodeTime;
+            boxTotal += boxTime;
+            kaiserTotal += kaiserTime;
+        }
+
+        const double count = static_cast<double>(paths.size());
+        std::cout << "  " << paths.size() << " textures, " << sourceBytes / MB << " MB of files, " << decodedBytes / MB
+                  << " MB decoded, " << chainBytes / MB << " MB with mips (" << (VoidEngine::MipGenerator::IsSimd() ? "SSE2" : "scalar")
+                  << ")\n"
+                  << "  decode:        " << decodeTotal << " ms, " << decodeTotal / count << " ms per texture, "
+                  << sourceBytes / MB / (decodeTotal / 1000.0) << " MB/s in, " << decodedBytes / MB / (decodeTotal / 1000.0) << " MB/s out\n"
+                  << "  mips (box):    " << boxTotal << " ms, " << boxTotal / count << " ms per texture, "
+                  << decodedBytes / MB / (boxTotal / 1000.0) << " MB/s\n"
+                  << "  mips (Kaiser): " << kaiserTotal << " ms, " << kaiserTotal / count << " ms per texture, "
+                  << decodedBytes / MB / (kaiserTotal / 1000.0) << " MB/s\n";
+
+        // Decode plus box filtered sRGB mips, what TextureManager does per texture
+        auto import = [&](size_t i)
+        {
+            const VoidEngine::Image image = VoidEngine::ImageDecoder::Load(paths[i]);
+            VoidEngine::MipGenerator::Generate(image, true, MipFilter::BOX);
+        };
+
+        const double serialTime = bestOf(1, [&]()
+        {
+            for (size_t i = 0; i < paths.size(); i++) import(i);
+        });
+        auto& pool = VoidEngine::ThreadPool::getInstance();
+        const double parallelTime = bestOf(1, [&]() { pool.parallelFor(paths.size(), import); });
+
+        std::cout << "  import, 1 thread:  " << serialTime << " ms, " << serialTime / count << " ms per texture, "
+                  << sourceBytes / MB / (serialTime / 1000.0) << " MB/s\n"
+                  << "  import, " << pool.getConcurrency() << " threads: " << parallelTime << " ms, "
+                  << sourceBytes / MB / (parallelTime / 1000.0) << " MB/s, " << serialTime / parallelTime << "x\n";
+
+        // Black and white averaged in linear light is 188 in sRGB, a plain average of the encoded values gives 128
+        VoidEngine::Image checker;
+        checker.width = 2;
+        checker.height = 2;
+        checker.pixels = {0, 0, 0, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 255};
+        const auto srgb = VoidEngine::MipGenerator::Generate(checker, true);
+        const auto linear = VoidEngine::MipGenerator::Generate(checker, false);
+        std::cout << "  black/white checker 1x1 level: " << int(srgb.data[srgb.levels[1].offset]) << " sRGB, "
+                  << int(linear.data[linear.levels[1].offset]) << " linear\n";
+    }
+
+    void benchmarkCompression(const std::vector<std::string>& paths)
+    {
+        using VoidEngine::BlockCompressor;
+        using VoidEngine::CompressionQuality;
+        using VoidEngine::TextureFormat;
+        constexpr double MB = 1024.0 * 1024.0;
+
+        std::vector<VoidEngine::MipChain> chains;
+        double chainBytes = 0.0;
+        for (const auto& path : paths)
+        {
+            chains.push_back(VoidEngine::MipGenerator::Generate(VoidEngine::ImageDecoder::Load(path), true));
+            chainBytes += static_cast<double>(chains.back().data.size());
+        }
+
+        const std::pair<TextureFormat, const char*> formats[] = {
+            {TextureFormat::BC1, "BC1"}, {TextureFormat::BC3, "BC3"}, {TextureFormat::BC4, "BC4"},
+            {TextureFormat::BC5, "BC5"}, {TextureFormat::BC7, "BC7"},
+        };
+        const std::pair<CompressionQuality, const char*> qualities[] = {
+            {CompressionQuality::FAST, "fast"}, {CompressionQuality::NORMAL, "normal"}, {CompressionQuality::HIGH, "high"},
+        };
+
+        std::cout << "  " << paths.size() << " textures, " << chainBytes / MB << " MB of RGBA8 mip chains, "
+                  << VoidEngine::ThreadPool::getInstance().getConcurrency() << " threads ("
+                  << (BlockCompressor::IsSimd() ? "SSE2" : "scalar") << ")\n";
+
+        for (const auto& [format, formatName] : formats)
+        {
+            for (const auto& [quality, qualityName] : qualities)
+            {
+                double encodeTime = 0.0;
+                double compressedBytes = 0.0;
+                double psnrSum = 0.0;
+                float lowestPsnr = BlockCompressor::MAX_PSNR;
+                for (const auto& chain : chains)
+                {
+                    VoidEngine::MipChain compressed;
+                    encodeTime += bestOf(1, [&]() { compressed = BlockCompressor::Compress(chain, format, quality); });
+
+                    const float psnr = BlockCompressor::ComputePsnr(chain, compressed);
+                    compressedBytes += static_cast<double>(compressed.data.size());
+                    psnrSum += psnr;
+                    lowestPsnr = std::min(lowestPsnr, psnr);
+                }
+
+                std::cout << "  " << formatName << " " << qualityName << ": " << encodeTime << " ms, "
+                          << chainBytes / MB / (encodeTime / 1000.0) << " MB/s, " << compressedBytes / MB << " MB ("
+                          << chainBytes / compressedBytes << ":1), PSNR " << psnrSum / static_cast<double>(chains.size())
+                          << " dB average, " << lowestPsnr << " dB lowest\n";
+            }
+        }
+
+        // What a second import of the same file costs: mapping the cache instead of decoding and encoding
+        const std::string cachePath = (std::filesystem::temp_directory_path() / "Benchmark.vtex").string();
+        double encodeTime = 0.0;
+        double cacheTime = 0.0;
+        for (const auto& chain : chains)
+        {
+            VoidEngine::MipChain compressed;
+            encodeTime += bestOf(1, [&]() { compressed = BlockCompressor::Compress(chain, TextureFormat::BC7); });
+            VoidEngine::TextureCache::Write(cachePath, 1, compressed);
+
+            VoidEngine::MipChain cached;
+            cacheTime += bestOf(ITERATIONS, [&]()
+            {
+                if (const auto cache = VoidEngine::TextureCache::Open(cachePath, 1)) cached = cache->GetMipChain();
+            });
+            if (cached.data != compressed.data) fail() << "texture cache round trip failed\n";
+        }
+        std::filesystem::remove(cachePath);
+        std::cout << "  BC7 normal from the cache: " << cacheTime << " ms instead of " << encodeTime << " ms, "
+                  << encodeTime / cacheTime << "x\n";
+    }
+    // Reading every file once, loose and from an archive stored as is and with LZ4
+    void benchmarkArchive(const std::vector<std::string>& paths)
+    {
+        using VoidEngine::AssetArchive;
+        constexpr double MB = 1024.0 * 1024.0;
+
+        std::vector<AssetArchive::SourceFile> sources;
+        for (const auto& path : paths)
+        {
+            sources.push_back({path, path});
+        }
+
+        auto readAll = [&](bool searchArchives, std::vector<std::vector<uint8_t>>* contents)
+        {
+            for (size_t i = 0; i < paths.size(); i++)
+            {
+                const VoidEngine::MappedFile file(paths[i], searchArchives);
+                if (contents != nullptr) (*contents)[i].assign(file.data(), file.data() + file.size());
+            }
+        };
+
+        std::vector<std::vector<uint8_t>> loose(paths.size());
+        readAll(false, &loose);
+        const double looseTime = bestOf(ITERATIONS, [&]() { readAll(false, nullptr); });
+        std::cout << "  loose: " << looseTime << " ms\n";
+
+        const std::string archivePath = (std::filesystem::temp_directory_path() / "Benchmark.vpak").string();
+        for (const bool compress : {false, true})
+        {
+            AssetArchive::WriteStats stats;
+            const double writeTime = bestOf(1, [&]() { stats = AssetArchive::Write(archivePath, sources, compress); });
+
+            AssetArchive::Mount(archivePath);
+            std::vector<std::vector<uint8_t>> packed(paths.size());
+            readAll(true, &packed);
+            if (packed != loose) fail() << "archive round trip failed\n";
+
+            const double readTime = bestOf(ITERATIONS, [&]() { readAll(true, nullptr); });
+            AssetArchive::UnmountAll();
+
+            const double sourceBytes = static_cast<double>(stats.sourceBytes);
+            const double storedBytes = static_cast<double>(stats.storedBytes);
+            std::cout << "  " << (compress ? "LZ4" : "stored") << ": " << readTime << " ms, "
+                      << sourceBytes / MB / (readTime / 1000.0) << " MB/s, " << storedBytes / MB << " of "
+                      << sourceBytes / MB << " MB (" << sourceBytes / storedBytes
+                      << ":1), packed in " << writeTime << " ms\n";
+        }
+        std::filesystem::remove(archivePath);
+    }
+
+    // What SceneManager stored before the World: one heap allocation per object, looked up by id for every draw
+    struct LegacyGameObject
+    {
+        virtual ~LegacyGameObject() = default;
+        virtual void Update() {}
+
+        VoidEngine::Transform transform;
+        std::shared_ptr<VoidEngine::Model> model;
+    };
+
+    void benchmarkEcs()
+    {
+        using VoidEngine::Transform;
+        using VoidEngine::MeshRenderer;
+        constexpr uint32_t COUNT = 1'000'000;
+
+        auto makeTransform = [](uint32_t i)
+        {
+            Transform transform;
+            transform.translation = {static_cast<float>(i % 1000), 0.0f, static_cast<float>(i / 1000)};
+            transform.rotation = {0.0f, static_cast<float>(i) * 0.001f, 0.0f};
+            return transform;
+        };
+
+        std::unordered_map<unsigned int, std::unique_ptr<LegacyGameObject>> legacyObjects;
+        std::vector<unsigned int> legacyQueue;
+        const double legacyCreateTime = bestOf(1, [&]()
+        {
+            for (uint32_t i = 0; i < COUNT; i++)
+            {
+                auto object = std::make_unique<LegacyGameObject>();
+                object->transform = makeTransform(i);
+                legacyObjects.emplace(i, std::move(object));
+                legacyQueue.push_back(i);
+            }
+        });
+
+        VoidEngine::World world;
+        const double createTime = bestOf(1, [&]()
+        {
+            for (uint32_t i = 0; i < COUNT; i++) world.Create(makeTransform(i), MeshRenderer{});
+        });
+
+        // What RenderObjectsInQueue does per object before recording draws
+        float legacySum = 0.0f;
+        const double legacyTime = bestOf(ITERATIONS, [&]()
+        {
+            for (const unsigned int id : legacyQueue)
+            {
+                const LegacyGameObject* object = legacyObjects.find(id)->second.get();
+                if (object->model != nullptr) continue;
+                legacySum += object->transform.mat4()[3][0];
+            }
+        });
+
+        VoidEngine::Query<const Transform, const MeshRenderer> query(world);
+        float sum = 0.0f;
+        const double queryTime = bestOf(ITERATIONS, [&]()
+        {
+            query.ForEach([&](const Transform& transform, const MeshRenderer& renderer)
+            {
+                if (renderer.model != nullptr) return;
+                sum += transform.mat4()[3][0];
+            });
+        });
+        if (sum != legacySum) fail() << "ECS iteration visited different objects\n";
+
+        // Translations only, where the memory layout rather than the matrix math decides
+        const double legacyTouchTime = bestOf(ITERATIONS, [&]()
+        {
+            for (const unsigned int id : legacyQueue) legacyObjects.find(id)->second->transform.translation.y += 1.0f;
+        });
+        const double touchTime = bestOf(ITERATIONS, [&]()
+        {
+            VoidEngine::Query<Transform>(world).ForEachChunk([](size_t count, const VoidEngine::Entity*, Transform* transforms)
+            {
+                for (size_t i = 0; i < count; i++) transforms[i].translation.y += 1.0f;
+            });
+        });
+
+        // Every entity gains a component and loses it again, recorded while iterating and applied afterwards
+        struct Tag { uint32_t value; };
+        VoidEngine::CommandBuffer commands(world);
+        const double structuralTime = bestOf(1, [&]()
+        {
+            query.ForEach([&](VoidEngine::Entity entity, const Transform&, const MeshRenderer&) { commands.Add(entity, Tag{1}); });
+            commands.Apply();
+            VoidEngine::Query<Tag>(world).ForEach([&](VoidEngine::Entity entity, Tag&) { commands.Remove<Tag>(entity); });
+            commands.Apply();
+        });
+
+        std::cout << "  " << COUNT << " transform+mesh objects, " << world.GetArchetypes().size() << " archetypes\n"
+                  << "  create: " << legacyCreateTime << " ms as heap objects, " << createTime << " ms in the World\n"
+                  << "  matrices: " << legacyTime << " ms by id lookup, " << queryTime << " ms by query, "
+                  << legacyTime / queryTime << "x\n"
+                  << "  translations: " << legacyTouchTime << " ms by id lookup, " << touchTime << " ms by chunk, "
+                  << legacyTouchTime / touchTime << "x\n"
+                  << "  add and remove a component on all: " << structuralTime << " ms through a CommandBuffer\n";
+    }
+
+    void benchmarkTransforms()
+    {
+        using VoidEngine::Transform;
+        using VoidEngine::TransformSystem;
+        using VoidEngine::WorldMatrix;
+        constexpr uint32_t COUNT = 100'000;
+
+        std::vector<Transform> transforms(COUNT);
+        VoidEngine::TransformSoA soa;
+        soa.Resize(COUNT);
+        for (uint32_t i = 0; i < COUNT; i++)
+        {
+            const float f = static_cast<float>(i);
+            transforms[i].translation = {f, f * 0.5f, -f};
+            transforms[i].rotation = {std::sin(f) * 3.0f, f * 0.01f, std::cos(f) * 6.0f};
+            transforms[i].scale = {1.0f + (i % 7) * 0.25f, 1.0f, 0.5f + (i % 3) * 0.5f};
+            soa.Set(i, transforms[i]);
+        }
+
+        // What RenderObjectsInQueue computed per object every frame
+        std::vector<glm::mat4> scalarModels(COUNT);
+        std::vector<glm::mat4> scalarNormals(COUNT);
+        const double scalarTime = bestOf(ITERATIONS, [&]()
+        {
+            for (uint32_t i = 0; i < COUNT; i++)
+            {
+                scalarModels[i] = transforms[i].mat4();
+                scalarNormals[i] = transforms[i].normalMatrix();
+            }
+        });
+
+        std::vector<glm::mat4> models(COUNT);
+        std::vector<glm::mat4> normals(COUNT);
+        const double batchTime = bestOf(ITERATIONS, [&]()
+        {
+            TransformSystem::ComputeMatrices(soa, models.data(), normals.data());
+        });
+
+        float largestError = 0.0f;
+        for (uint32_t i = 0; i < COUNT; i++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                for (int row = 0; row < 4; row++)
+                {
+                    largestError = std::max(largestError, std::abs(models[i][column][row] - scalarModels[i][column][row]) /
+                        std::max(1.0f, std::abs(scalarModels[i][column][row])));
+                    largestError = std::max(largestError, std::abs(normals[i][column][row] - scalarNormals[i][column][row]));
+                }
+            }
+        }
+
+        // Through the World: everything dirty once, then nothing, then every tenth object moved
+        VoidEngine::World world;
+        for (const auto& transform : transforms) world.Create(transform, WorldMatrix{});
+        TransformSystem system(world);
+        size_t updated = 0;
+        const double firstTime = bestOf(1, [&]() { updated = system.Update(); });
+        const double staticTime = bestOf(ITERATIONS, [&]() { system.Update(); });
+
+        VoidEngine::Query<Transform> moving(world);
+        double movedTime = 1e30;
+        size_t moved = 0;
+        for (int iteration = 0; iteration < ITERATIONS; iteration++)
+        {
+            uint32_t index = 0;
+            moving.ForEach([&](Transform& transform)
+            {
+                if (index++ % 10 == 0) transform.translation.y += 1.0f;
+            });
+            movedTime = std::min(movedTime, bestOf(1, [&]() { moved = system.Update(); }));
+        }
+
+        std::cout << "  " << COUNT << " transforms (" << (TransformSystem::IsSimd() ? "SSE2" : "scalar") << ")\n"
+                  << "  Transform::mat4() + normalMatrix(): " << scalarTime << " ms\n"
+                  << "  ComputeMatrices: " << batchTime << " ms, " << scalarTime / batchTime << "x, largest error "
+                  << largestError << "\n"
+                  << "  TransformSystem, all " << updated << " dirty: " << firstTime << " ms, none dirty: " << staticTime
+                  << " ms, " << moved << " dirty: " << movedTime << " ms\n";
+    }
+
+    void benchmarkHierarchy()
+    {
+        using VoidEngine::Entity;
+        using VoidEngine::Transform;
+        using VoidEngine::WorldMatrix;
+        // Every root has 9 children with 10 children each
+        constexpr uint32_t ROOTS = 1000;
+        constexpr uint32_t CHILDREN = 9;
+        constexpr uint32_t GRANDCHILDREN = 10;
+
+        VoidEngine::World world;
+        VoidEngine::TransformSystem system(world);
+        auto& hierarchy = system.GetHierarchy();
+
+        auto create = [&](float offset)
+        {
+            Transform transform;
+            transform.translation = {offset, 1.0f, 0.0f};
+            transform.rotation = {0.0f, offset * 0.1f, 0.0f};
+            return world.Create(transform, WorldMatrix{});
+        };
+
+        std::vector<Entity> roots;
+        Entity leaf;
+        const double buildTime = bestOf(1, [&]()
+        {
+            for (uint32_t r = 0; r < ROOTS; r++)
+            {
+                roots.push_back(create(static_cast<float>(r)));
+                for (uint32_t c = 0; c < CHILDREN; c++)
+                {
+                    const Entity child = create(static_cast<float>(c));
+                    hierarchy.SetParent(child, roots.back());
+                    for (uint32_t g = 0; g < GRANDCHILDREN; g++)
+                    {
+                        leaf = create(static_cast<float>(g));
+                        hierarchy.SetParent(leaf, child);
+                    }
+                }
+            }
+        });
+
+        size_t swept = 0;
+        const double firstTime = bestOf(1, [&]() { swept = system.Update(); });
+        const double staticTime = bestOf(ITERATIONS, [&]() { system.Update(); });
+
+        // The leaf's world matrix is the product down its path
+        const Entity child = hierarchy.GetParent(leaf);
+        const glm::mat4 expected = world.Get<const Transform>(roots.back())->mat4() *
+            world.Get<const Transform>(child)->mat4() * world.Get<const Transform>(leaf)->mat4();
+        const glm::mat4& actual = world.Get<const WorldMatrix>(leaf)->model;
+        float largestError = 0.0f;
+        for (int column = 0; column < 4; column++)
+        {
+            for (int row = 0; row < 4; row++) largestError = std::max(largestError, std::abs(actual[column][row] - expected[column][row]));
+        }
+        if (largestError > 1e-4f) fail() << "hierarchy world matrix off by " << largestError << "\n";
+
+        // A tenth of the roots move, their subtrees follow
+        size_t movedSwept = 0;
+        double movedTime = 1e30;
+        for (int iteration = 0; iteration < ITERATIONS; iteration++)
+        {
+            for (uint32_t r = 0; r < ROOTS; r += 10) world.Get<Transform>(roots[r])->translation.y += 1.0f;
+            movedTime = std::min(movedTime, bestOf(1, [&]() { movedSwept = system.Update(); }));
+        }
+
+        const double reparentTime = bestOf(1, [&]() { hierarchy.SetParent(child, roots.front()); });
+
+        std::cout << "  " << hierarchy.GetNodeCount() << " nodes, built in " << buildTime << " ms\n"
+                  << "  first update, " << swept << " matrices: " << firstTime << " ms, static: " << staticTime << " ms\n"
+                  << "  " << ROOTS / 10 << " roots moved, " << movedSwept << " matrices: " << movedTime << " ms\n"
+                  << "  reparenting a subtree: " << reparentTime << " ms\n";
+    }
+    void benchmarkHandles()
+    {
+        constexpr uint32_t COUNT = 100000;
+        struct Object
+        {
+            float value = 1.0f;
+        };
+
+        // Lookups in a shuffled order, the way render queues and gameplay code look objects up
+        std::vector<uint32_t> order(COUNT);
+        for (uint32_t i = 0; i < COUNT; i++) order[i] = i;
+        Random random{1u};
+        for (uint32_t i = COUNT - 1; i > 0; i--) std::swap(order[i], order[random.next() % (i + 1)]);
+
+        std::unordered_map<unsigned int, std::unique_ptr<Object>> map;
+        VoidEngine::SlotMap<std::unique_ptr<Object>> slotMap;
+        std::vector<VoidEngine::SlotHandle> handles;
+        for (uint32_t i = 0; i < COUNT; i++)
+        {
+            map.emplace(i, std::make_unique<Object>());
+            handles.push_back(slotMap.Insert(std::make_unique<Object>()));
+        }
+
+        float mapSum = 0.0f;
+        const double mapTime = bestOf(ITERATIONS, [&]()
+        {
+            mapSum = 0.0f;
+            for (uint32_t i : order) mapSum += map.find(i)->second->value;
+        });
+        float slotSum = 0.0f;
+        const double slotTime = bestOf(ITERATIONS, [&]()
+        {
+            slotSum = 0.0f;
+            for (uint32_t i : order) slotSum += (*slotMap.Get(handles[i]))->value;
+        });
+        if (mapSum != slotSum) fail() << "slot map lookups disagree\n";
+
+        // Half the objects are removed and replaced, reusing their slots
+        const double churnTime = bestOf(1, [&]()
+        {
+            for (uint32_t i = 0; i < COUNT; i += 2) slotMap.Remove(handles[i]);
+            for (uint32_t i = 0; i < COUNT; i += 2) slotMap.Insert(std::make_unique<Object>());
+        });
+        size_t stale = 0;
+        for (uint32_t i = 0; i < COUNT; i += 2) stale += slotMap.Get(handles[i]) == nullptr;
+        if (stale != COUNT / 2) fail() << "stale handles still resolve\n";
+
+        std::cout << "  " << COUNT << " lookups\n"
+                  << "    unordered_map: " << mapTime << " ms\n"
+                  << "    slot map: " << slotTime << " ms\n"
+                  << "  " << COUNT / 2 << " removed and reinserted: " << churnTime << " ms, " << stale
+                  << " stale handles rejected\n";
+    }
+    void benchmarkJobs()
+    {
+        using VoidEngine::Entity;
+        using VoidEngine::Transform;
+        constexpr uint32_t COUNT = 100000;
+
+        // What a GameObject::ParallelUpdate() does: moves its own transform and now and then records a change to
+        // shared state
+        struct Orbit
+        {
+            float speed;
+            float radius;
+        };
+
+        VoidEngine::World world;
+        std::vector<Entity> entities;
+        for (uint32_t i = 0; i < COUNT; i++)
+        {
+            entities.push_back(world.Create(Transform{}, Orbit{0.5f + static_cast<float>(i % 7), 1.0f + static_cast<float>(i % 13)}));
+        }
+
+        size_t events = 0;
+        auto update = [&](Entity entity, VoidEngine::CommandBuffer& commands)
+        {
+            Transform& transform = *world.Get<Transform>(entity);
+            const Orbit& orbit = *world.Get<const Orbit>(entity);
+            float angle = transform.rotation.y;
+            for (int step = 0; step < 8; step++)
+            {
+                angle += orbit.speed * 0.002f;
+                transform.translation = {std::cos(angle) * orbit.radius, std::sin(angle * 0.5f), std::sin(angle) * orbit.radius};
+            }
+            transform.rotation.y = angle;
+            if (entity.index % 1000 == 0) commands.Run([&events](VoidEngine::World&) { events++; });
+        };
+
+        std::vector<size_t> threadCounts;
+        const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t threads = 1; threads < hardwareThreads; threads *= 2) threadCounts.push_back(threads);
+        threadCounts.push_back(hardwareThreads);
+
+        double singleTime = 0.0;
+        for (size_t threads : threadCounts)
+        {
+            VoidEngine::ThreadPool pool(threads);
+            std::vector<VoidEngine::CommandBuffer> commandBuffers;
+            for (size_t i = 0; i < pool.getConcurrency(); i++) commandBuffers.emplace_back(world);
+
+            events = 0;
+            const double time = bestOf(ITERATIONS, [&]()
+            {
+                world.BeginIteration();
+                pool.parallelFor(entities.size(), [&](size_t i) { update(entities[i], commandBuffers[pool.getThreadIndex()]); });
+                world.EndIteration();
+                for (auto& commands : commandBuffers) commands.Apply();
+            });
+            if (events != static_cast<size_t>(ITERATIONS) * (COUNT / 1000)) fail() << "deferred commands lost\n";
+
+            if (threads == 1) singleTime = time;
+            std::cout << "  " << threads << (threads == 1 ? " thread: " : " threads: ") << time << " ms, "
+                      << singleTime / time << "x\n";
+        }
+
+        // A chain of dependent jobs runs in order
+        VoidEngine::ThreadPool& pool = VoidEngine::ThreadPool::getInstance();
+        VoidEngine::JobCounter first;
+        VoidEngine::JobCounter second;
+        std::vector<int> order;
+        std::mutex orderMutex;
+        for (int i = 0; i < 4; i++)
+        {
+            pool.submit([&]() { std::lock_guard lock(orderMutex); order.push_back(1); }, first);
+        }
+        pool.submit([&]() { std::lock_guard lock(orderMutex); order.push_back(2); }, second, &first);
+        pool.wait(second);
+        if (order.size() != 5 || order.back() != 2) fail() << "job dependency ran early\n";
+    }
+    void benchmarkFrustum()
+    {
+        using VoidEngine::FrustumCuller;
+        constexpr uint32_t COUNT = 100'000;
+
+        // Objects scattered around a camera looking down -z, most of them outside its 60 degree view
+        const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+        const glm::mat4 view = glm::lookAt(glm::vec3{0.0f}, glm::vec3{0.0f, 0.0f, -1.0f}, glm::vec3{0.0f, 1.0f, 0.0f});
+        const auto frustum = VoidEngine::Frustum::FromViewProjection(projection * view);
+
+        VoidEngine::SphereSoA spheres;
+        Random random{7u};
+        for (uint32_t i = 0; i < COUNT; i++)
+        {
+            spheres.Push({random() * 1000.0f - 500.0f, random() * 200.0f - 100.0f, random() * 1000.0f - 500.0f},
+                random() * 5.0f);
+        }
+
+        std::vector<uint8_t> scalarVisible(COUNT);
+        std::vector<uint8_t> simdVisible(COUNT);
+        size_t scalarCount = 0;
+        size_t simdCount = 0;
+        const double scalarTime = bestOf(ITERATIONS, [&]() { scalarCount = FrustumCuller::CullScalar(frustum, spheres, scalarVisible.data()); });
+        const double simdTime = bestOf(ITERATIONS, [&]() { simdCount = FrustumCuller::Cull(frustum, spheres, simdVisible.data()); });
+
+        // Validates the SIMD path against the scalar one, and both against a sphere that is obviously in view
+        const size_t mismatches = static_cast<size_t>(std::inner_product(scalarVisible.begin(), scalarVisible.end(),
+            simdVisible.begin(), 0, std::plus<>(), std::not_equal_to<>()));
+        if (mismatches > 0 || scalarCount != simdCount) fail() << "frustum culling paths disagree on " << mismatches << " spheres\n";
+        VoidEngine::SphereSoA ahead;
+        ahead.Push({0.0f, 0.0f, -10.0f}, 1.0f);
+        ahead.Push({0.0f, 0.0f, 10.0f}, 1.0f);
+        uint8_t aheadVisible[2];
+        FrustumCuller::Cull(frustum, ahead, aheadVisible);
+        if (aheadVisible[0] != 1 || aheadVisible[1] != 0) fail() << "frustum culling rejects the wrong side\n";
+
+        std::cout << "  " << COUNT << " spheres, " << simdCount << " visible, " << COUNT - simdCount << " culled ("
+                  << (FrustumCuller::IsSimd() ? "SSE2" : "scalar") << ")\n"
+                  << "  scalar: " << scalarTime << " ms\n"
+                  << "  Cull: " << simdTime << " ms, " << scalarTime / simdTime << "x, " << mismatches << " mismatches\n";
+    }
+
+    void benchmarkSpatialIndex()
+    {
+        using VoidEngine::Aabb;
+        using VoidEngine::DynamicAabbTree;
+        constexpr uint32_t COUNT = 1'000'000;
+        constexpr uint32_t MOVING = COUNT / 10;
+        constexpr float WORLD_SIZE = 2000.0f;
+
+        Random random{3u};
+
+        std::vector<glm::vec3> positions(COUNT);
+        std::vector<float> radii(COUNT);
+        for (uint32_t i = 0; i < COUNT; i++)
+        {
+            positions[i] = {random() * WORLD_SIZE, random() * WORLD_SIZE * 0.1f, random() * WORLD_SIZE};
+            radii[i] = 0.5f + random() * 2.0f;
+        }
+
+        DynamicAabbTree tree(0.5f);
+        std::vector<uint32_t> proxies(COUNT);
+        const double insertTime = bestOf(1, [&]()
+        {
+            for (uint32_t i = 0; i < COUNT; i++) proxies[i] = tree.Insert(Aabb::FromSphere(positions[i], radii[i]), i);
+        });
+
+        // Every frame the same tenth of the objects moves by up to half a unit, a few of them teleport
+        std::vector<glm::vec3> velocities(MOVING);
+        for (auto& velocity : velocities) velocity = glm::vec3{random() - 0.5f, random() - 0.5f, random() - 0.5f};
+        size_t reinserted = 0;
+        double moveTime = 1e30;
+        for (int frame = 0; frame < ITERATIONS; frame++)
+        {
+            moveTime = std::min(moveTime, bestOf(1, [&]()
+            {
+                reinserted = 0;
+                for (uint32_t i = 0; i < MOVING; i++)
+                {
+                    const uint32_t object = i * 10;
+                    positions[object] += velocities[i];
+                    if (i % 1000 == 0) positions[object] = {random() * WORLD_SIZE, positions[object].y, random() * WORLD_SIZE};
+                    reinserted += tree.Move(proxies[object], Aabb::FromSphere(positions[object], radii[object]));
+                }
+            }));
+        }
+
+        // Queries in the middle of the world, each compared against a linear scan over the same boxes
+        const glm::vec3 center{WORLD_SIZE * 0.5f, WORLD_SIZE * 0.05f, WORLD_SIZE * 0.5f};
+        size_t sphereHits = 0;
+        const double sphereTime = bestOf(ITERATIONS, [&]()
+        {
+            sphereHits = 0;
+            tree.QuerySphere(center, 50.0f, [&](uint32_t) { sphereHits++; });
+        });
+        size_t scanHits = 0;
+        const double scanTime = bestOf(ITERATIONS, [&]()
+        {
+            scanHits = 0;
+            for (uint32_t i = 0; i < COUNT; i++)
+            {
+                const Aabb& box = tree.GetFatBounds(proxies[i]);
+                const glm::vec3 offset = center - glm::clamp(center, box.min, box.max);
+                scanHits += glm::dot(offset, offset) <= 50.0f * 50.0f;
+            }
+        });
+        if (sphereHits != scanHits) fail() << "sphere query found " << sphereHits << ", a scan " << scanHits << "\n";
+
+        size_t boxHits = 0;
+        const Aabb queryBox{center - glm::vec3{100.0f, 20.0f, 100.0f}, center + glm::vec3{100.0f, 20.0f, 100.0f}};
+        const double boxTime = bestOf(ITERATIONS, [&]()
+        {
+            boxHits = 0;
+            tree.QueryAabb(queryBox, [&](uint32_t) { boxHits++; });
+        });
+
+        const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+        const glm::mat4 view = glm::lookAt(center, center + glm::vec3{1.0f, 0.0f, 0.0f}, glm::vec3{0.0f, 1.0f, 0.0f});
+        const auto frustum = VoidEngine::Frustum::FromViewProjection(projection * view);
+        size_t frustumHits = 0;
+        const double frustumTime = bestOf(ITERATIONS, [&]()
+        {
+            frustumHits = 0;
+            tree.QueryFrustum(frustum, [&](uint32_t) { frustumHits++; });
+        });
+
+        // Picking: the closest box along a ray across the whole world
+        uint32_t picked = DynamicAabbTree::NULL_NODE;
+        const glm::vec3 rayOrigin{0.0f, center.y, center.z};
+        const double rayTime = bestOf(ITERATIONS, [&]()
+        {
+            picked = DynamicAabbTree::NULL_NODE;
+            tree.QueryRay(rayOrigin, glm::vec3{1.0f, 0.0f, 0.0f}, WORLD_SIZE, [&](uint32_t object, float distance)
+            {
+                picked = object;
+                return distance;
+            });
+        });
+
+        std::cout << "  " << COUNT << " objects, tree height " << tree.GetHeight() << "\n"
+                  << "  insert: " << insertTime << " ms\n"
+                  << "  " << MOVING << " moving: " << moveTime << " ms per frame, " << reinserted << " reinserted\n"
+                  << "  sphere query, " << sphereHits << " found: " << sphereTime << " ms, linear scan " << scanTime << " ms\n"
+                  << "  box query, " << boxHits << " found: " << boxTime << " ms\n"
+                  << "  frustum query, " << frustumHits << " found: " << frustumTime << " ms\n"
+                  << "  closest along a ray" << (picked != DynamicAabbTree::NULL_NODE ? "" : " (none)") << ": " << rayTime << " ms\n";
+    }
+    void benchmarkOcclusion()
+    {
+        using VoidEngine::Aabb;
+        using VoidEngine::OccluderMesh;
+        using VoidEngine::OcclusionCuller;
+        constexpr uint32_t BUILDINGS = 200;
+        constexpr uint32_t OBJECTS = 20'000;
+
+        // A street of box buildings in front of a camera looking down -z, objects scattered between and behind them
+        const glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 1.0f, 500.0f);
+        const glm::mat4 view = glm::lookAt(glm::vec3{0.0f, 2.0f, 0.0f}, glm::vec3{0.0f, 2.0f, -1.0f}, glm::vec3{0.0f, 1.0f, 0.0f});
+        const glm::mat4 viewProjection = projection * view;
+
+        Random random{11u};
+
+        std::vector<OccluderMesh> buildings;
+        for (uint32_t i = 0; i < BUILDINGS; i++)
+        {
+            const glm::vec3 size{4.0f + random() * 16.0f, 5.0f + random() * 25.0f, 4.0f + random() * 16.0f};
+            const glm::vec3 position{random() * 200.0f - 100.0f, 0.0f, -10.0f - random() * 300.0f};
+            buildings.push_back(OccluderMesh::Box(position, position + size));
+        }
+        buildings.push_back(OccluderMesh::Box({-200.0f, -1.0f, -400.0f}, {200.0f, 0.0f, -2.0f}));
+
+        std::vector<Aabb> objects;
+        for (uint32_t i = 0; i < OBJECTS; i++)
+        {
+            const glm::vec3 center{random() * 200.0f - 100.0f, random() * 10.0f, -5.0f - random() * 350.0f};
+            objects.push_back(Aabb::FromSphere(center, 0.5f + random() * 2.0f));
+        }
+
+        OcclusionCuller culler;
+        auto rasterize = [&](bool simd)
+        {
+            culler.BeginFrame(viewProjection);
+            for (const auto& building : buildings) culler.AddOccluder(building, glm::mat4{1.0f});
+            if (simd) culler.Rasterize();
+            else culler.RasterizeScalar();
+        };
+
+        std::vector<float> scalarDepth;
+        std::vector<float> simdDepth;
+        const double scalarTime = bestOf(ITERATIONS, [&]() { rasterize(false); });
+        culler.ResolveDepth(scalarDepth);
+        const double simdTime = bestOf(ITERATIONS, [&]() { rasterize(true); });
+        culler.ResolveDepth(simdDepth);
+
+        size_t hidden = 0;
+        std::vector<uint8_t> visible(OBJECTS);
+        const double testTime = bestOf(ITERATIONS, [&]()
+        {
+            hidden = 0;
+            for (uint32_t i = 0; i < OBJECTS; i++)
+            {
+                visible[i] = culler.IsVisible(objects[i]);
+                hidden += !visible[i];
+            }
+        });
+
+        // Reference image: the exact nearest occluder depth at every pixel center
+        const uint32_t width = culler.GetWidth();
+        const uint32_t height = culler.GetHeight();
+        auto toScreen = [&](const glm::vec3& position)
+        {
+            const glm::vec4 clip = viewProjection * glm::vec4(position, 1.0f);
+            return glm::vec4{(clip.x / clip.w * 0.5f + 0.5f) * static_cast<float>(width),
+                (clip.y / clip.w * 0.5f + 0.5f) * static_cast<float>(height), clip.z / clip.w, clip.w};
+        };
+        std::vector<float> reference(static_cast<size_t>(width) * height, 1.0f);
+        for (const auto& building : buildings)
+        {
+            for (size_t i = 0; i < building.indices.size(); i += 3)
+            {
+                const glm::vec4 a = toScreen(building.positions[building.indices[i]]);
+                const glm::vec4 b = toScreen(building.positions[building.indices[i + 1]]);
+                const glm::vec4 c = toScreen(building.positions[building.indices[i + 2]]);
+                if (a.w <= 0.0f || b.w <= 0.0f || c.w <= 0.0f || a.z < 0.0f || b.z < 0.0f || c.z < 0.0f) continue;
+
+                const float area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+                if (std::abs(area) < 1e-6f) continue;
+                const int minX = std::max(static_cast<int>(std::min({a.x, b.x, c.x})), 0);
+                const int maxX = std::min(static_cast<int>(std::max({a.x, b.x, c.x})), static_cast<int>(width) - 1);
+                const int minY = std::max(static_cast<int>(std::min({a.y, b.y, c.y})), 0);
+                const int maxY = std::min(static_cast<int>(std::max({a.y, b.y, c.y})), static_cast<int>(height) - 1);
+                for (int y = minY; y <= maxY; y++)
+                {
+                    for (int x = minX; x <= maxX; x++)
+                    {
+                        const float px = static_cast<float>(x) + 0.5f;
+                        const float py = static_cast<float>(y) + 0.5f;
+                        const float wa = ((b.x - px) * (c.y - py) - (c.x - px) * (b.y - py)) / area;
+                        const float wb = ((c.x - px) * (a.y - py) - (a.x - px) * (c.y - py)) / area;
+                        const float wc = 1.0f - wa - wb;
+                        if (wa < 0.0f || wb < 0.0f || wc < 0.0f) continue;
+
+                        float& depth = reference[static_cast<size_t>(y) * width + x];
+                        depth = std::min(depth, wa * a.z + wb * b.z + wc * c.z);
+                    }
+                }
+            }
+        }
+
+        // The buffer may only be farther than the reference, and SIMD and scalar must agree exactly
+        constexpr float EPSILON = 1e-5f;
+        size_t pathMismatches = 0;
+        size_t violations = 0;
+        size_t coveredPixels = 0;
+        for (size_t i = 0; i < reference.size(); i++)
+        {
+            pathMismatches += scalarDepth[i] != simdDepth[i];
+            violations += simdDepth[i] < reference[i] - EPSILON;
+            coveredPixels += simdDepth[i] < 1.0f;
+        }
+
+        // Every hidden object must be behind the reference depth at each pixel its box touches
+        size_t falseHides = 0;
+        for (uint32_t i = 0; i < OBJECTS; i++)
+        {
+            if (visible[i]) continue;
+
+            glm::vec2 low{FLT_MAX};
+            glm::vec2 high{-FLT_MAX};
+            float nearest = FLT_MAX;
+            for (int corner = 0; corner < 8; corner++)
+            {
+                const glm::vec4 screen = toScreen({corner & 1 ? objects[i].max.x : objects[i].min.x,
+                    corner & 2 ? objects[i].max.y : objects[i].min.y, corner & 4 ? objects[i].max.z : objects[i].min.z});
+                low = glm::min(low, glm::vec2(screen));
+                high = glm::max(high, glm::vec2(screen));
+                nearest = std::min(nearest, screen.z);
+            }
+
+            bool seen = false;
+            for (int y = std::max(static_cast<int>(low.y), 0); y <= std::min(static_cast<int>(high.y), static_cast<int>(height) - 1); y++)
+            {
+                for (int x = std::max(static_cast<int>(low.x), 0); x <= std::min(static_cast<int>(high.x), static_cast<int>(width) - 1); x++)
+                {
+                    seen |= reference[static_cast<size_t>(y) * width + x] >= nearest;
+                }
+            }
+            falseHides += seen;
+        }
+        if (pathMismatches > 0 || violations > 0 || falseHides > 0)
+        {
+            fail() << "occlusion buffer wrong: " << pathMismatches << " path mismatches, " << violations
+                   << " pixels nearer than the reference, " << falseHides << " visible objects hidden\n";
+        }
+
+        std::cout << "  " << culler.GetOccluderTriangleCount() << " occluder triangles, " << width << "x" << height << " buffer, "
+                  << coveredPixels * 100 / reference.size() << "% covered ("
+                  << (OcclusionCuller::IsSimd() ? "SSE2" : "scalar") << ", "
+                  << VoidEngine::ThreadPool::getInstance().getConcurrency() << " threads)\n"
+                  << "  rasterize scalar: " << scalarTime << " ms\n"
+                  << "  rasterize: " << simdTime << " ms, " << scalarTime / simdTime << "x, " << pathMismatches << " mismatches, "
+                  << violations << " pixels nearer than the reference\n"
+                  << "  " << OBJECTS << " boxes tested: " << testTime << " ms, " << hidden << " hidden, " << falseHides
+                  << " wrongly\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++)
+    {
+        files.emplace_back(argv[i]);
+    }
+
+    if (files.empty())
+    {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator("models"))
+        {
+            const auto extension = entry.path().extension();
+            if (entry.is_regular_file() && (extension == ".obj" || VoidEngine::GltfParser::IsGltfPath(entry.path().string()) ||
+                isImagePath(entry.path())))
+            {
+                files.push_back(entry.path().generic_string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+    }
+
+    std::vector<std::string> objFiles;
+    std::vector<std::string> gltfFiles;
+    std::vector<std::string> imageFiles;
+    for (const auto& path : files)
+    {
+        if (isImagePath(path)) imageFiles.push_back(path);
+        else (VoidEngine::GltfParser::IsGltfPath(path) ? gltfFiles : objFiles).push_back(path);
+    }
+
+    std::cout << "OBJ loading, best of " << ITERATIONS << " runs\n";
+    for (const auto& path : objFiles)
+    {
+        benchmarkObj(path);
+    }
+
+    std::cout << "\nglTF loading, best of " << ITERATIONS << " runs\n";
+    for (const auto& path : gltfFiles)
+    {
+        benchmarkGltf(path);
+    }
+
+    if (!imageFiles.empty())
+    {
+        std::cout << "\nTexture import\n";
+        benchmarkTextures(imageFiles);
+
+        std::cout << "\nTexture compression\n";
+        benchmarkCompression(imageFiles);
+    }
+
+    std::cout << "\nAsset archive, best of " << ITERATIONS << " runs\n";
+    benchmarkArchive(files);
+
+    std::cout << "\nEntity storage, best of " << ITERATIONS << " runs\n";
+    benchmarkEcs();
+
+    std::cout << "\nTransforms, best of " << ITERATIONS << " runs\n";
+    benchmarkTransforms();
+
+    std::cout << "\nTransform hierarchy, best of " << ITERATIONS << " runs\n";
+    benchmarkHierarchy();
+
+    std::cout << "\nObject handles, best of " << ITERATIONS << " runs\n";
+    benchmarkHandles();
+
+    std::cout << "\nParallel update, best of " << ITERATIONS << " runs\n";
+    benchmarkJobs();
+
+    std::cout << "\nFrustum culling, best of " << ITERATIONS << " runs\n";
+    benchmarkFrustum();
+
+    std::cout << "\nSpatial index, best of " << ITERATIONS << " runs\n";
+    benchmarkSpatialIndex();
+
+    std::cout << "\nOcclusion culling, best of " << ITERATIONS << " runs\n";
+    benchmarkOcclusion();
+
+    if (failedChecks > 0)
+    {
+        std::cerr << "\n" << failedChecks << " checks failed\n";
+        return 1;
+    }
+    return 0;
+}
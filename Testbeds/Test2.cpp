@@ -31,19 +31,20 @@ int main()
     //Vase*  smoothVase = new Vase(&game);
     //NotVase* floor = new NotVase(&game);
 
-    flatVase->model->LoadModelFromFile("models/flat_vase.obj");
-    //smoothVase->model->LoadModelFromFile("models/smooth_vase.obj");
-    //floor->model->LoadModelFromFile("models/quad.obj");
+    // Streams in, the vase shows up once its buffers are on the GPU
+    flatVase->SetModel(game.modelManager->LoadAsync("models/flat_vase.obj"));
+    //smoothVase->SetModel(game.modelManager->Load("models/smooth_vase.obj"));
+    //floor->SetModel(game.modelManager->Load("models/quad.obj"));
 
-    flatVase->transform.translation = {0.5f, 0.5f, 1.0f};
-    //flatVase->transform.rotation = {1.0f, 0.5f, 0.3f};
-    //flatVase->transform.scale = {3.0f, 1.5f, 3.0f};
+    flatVase->GetTransform().translation = {0.5f, 0.5f, 1.0f};
+    //flatVase->GetTransform().rotation = {1.0f, 0.5f, 0.3f};
+    //flatVase->GetTransform().scale = {3.0f, 1.5f, 3.0f};
 
-    //smoothVase->transform.translation = {0.5f, 0.5f, 1.0f};
-    //smoothVase->transform.scale = {3.0f, 1.5f, 3.0f};
+    //smoothVase->GetTransform().translation = {0.5f, 0.5f, 1.0f};
+    //smoothVase->GetTransform().scale = {3.0f, 1.5f, 3.0f};
 
-    //floor->transform.translation = {0.0f, 0.5f, 0.0f};
-    //floor->transform.scale = {3.0f, 1.0f, 3.0f};
+    //floor->GetTransform().translation = {0.0f, 0.5f, 0.0f};
+    //floor->GetTransform().scale = {3.0f, 1.0f, 3.0f};
 
 
     game.AddGameObject(flatVase);
@@ -69,6 +70,9 @@ int main()
     VoidEngine::Camera camera{&game};
     game.mainCamera = &camera;
 
+    // One more frame than the default, the scene is light on the CPU so the GPU is the one to keep busy
+    game.SetFramesInFlight(3);
+
     game.run();
 
     return 0;
@@ -0,0 +1,87 @@
+// Packs asset files into an archive the engine mounts at startup, see AssetArchive. Run from the directory the
+// game runs in, entries are named by their path relative to it, which is how the engine asks for them:
+//   AssetPacker [--lz4] Assets.vpak models Shaders
+// Directories are added recursively. Mesh and texture caches next to the sources are packed like any other file,
+// so a shipped build maps them instead of importing the sources.
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <AssetArchive.hpp>
+
+namespace
+{
+    void addFile(const std::filesystem::path& path, std::vector<VoidEngine::AssetArchive::SourceFile>& files)
+    {
+        // Half written caches
+        if (path.extension() == ".tmp") return;
+
+        const std::string name = path.lexically_normal().generic_string();
+        files.push_back({name, name});
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool compress = false;
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        if (argument == "--lz4") compress = true;
+        else arguments.push_back(argument);
+    }
+
+    if (arguments.size() < 2)
+    {
+        std::cerr << "Usage: AssetPacker [--lz4] <archive> <file or directory>...\n";
+        return 1;
+    }
+
+    std::vector<VoidEngine::AssetArchive::SourceFile> files;
+    for (size_t i = 1; i < arguments.size(); i++)
+    {
+        const std::filesystem::path path = arguments[i];
+        if (std::filesystem::is_directory(path))
+        {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(path))
+            {
+                if (entry.is_regular_file()) addFile(entry.path(), files);
+            }
+        } else if (std::filesystem::is_regular_file(path))
+        {
+            addFile(path, files);
+        } else
+        {
+            std::cerr << "Not found: " << path.string() << "\n";
+            return 1;
+        }
+    }
+
+    // The same file reached through two arguments
+    std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return a.path < b.path; });
+    files.erase(std::unique(files.begin(), files.end(), [](const auto& a, const auto& b) { return a.path == b.path; }),
+        files.end());
+
+    try
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const auto stats = VoidEngine::AssetArchive::Write(arguments[0], files, compress);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        constexpr double MB = 1024.0 * 1024.0;
+        std::cout << "Packed " << stats.files << " files, " << static_cast<double>(stats.sourceBytes) / MB << " MB into "
+                  << arguments[0] << " (" << static_cast<double>(stats.archiveBytes) / MB << " MB, "
+                  << static_cast<double>(stats.storedBytes) / MB << " MB of data) in " << ms << " ms\n";
+    } catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}